@@ -0,0 +1,529 @@
+#include "aggregate.h"
+#include "error.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <mutex>
+
+extern const Status createHeapFile(const string fileName);
+extern const Status destroyHeapFile(const string fileName);
+
+// the running state of one aggregate of a group.  a group is a row of
+// rowSize bytes: its key, padded to 8 bytes, then an AggState for
+// every aggregate.  partitions hold the rows as they are
+struct AggState
+{
+  long long	cnt;		// records or values taken in
+  long long	isum;		// sum of INTEGER values
+  double	fval;		// sum of FLOAT values, or the MIN or MAX
+};
+
+struct AggSlot
+{
+  unsigned	hash;		// hash of the key of the group
+  int		row;		// the group, -1 if the slot is empty
+};
+
+// an open addressing hash table.  at most three quarters of the slots
+// are in use, so probes stay short and there is always an empty slot
+// to stop at
+struct AggTable
+{
+  vector<AggSlot> slots;	// a power of two of them
+  char*		rows;		// maxRows rows
+  int		rowCnt;
+  int		maxRows;
+  vector<char>	key;		// key being looked up
+};
+
+// state shared by the threads of the scan
+struct AggJob
+{
+  HashAggregate* agg;
+  vector<Status> status;	// of each thread
+  mutex		spillLock;	// HeapFileLoader is not thread safe
+};
+
+// a table in budget bytes: the most slots, a power of two, that leave
+// room for rows for half of them, and as many rows as the rest of the
+// budget holds, up to three quarters of them.  NULL if not even one
+// row fits
+
+static AggTable* newTable(const long budget, const int rowSize,
+                          const int keyLen)
+{
+    long	n = 2, rows;
+    AggSlot	empty = { 0, -1 };
+
+    while(2 * n * (long) sizeof(AggSlot) + n * rowSize <= budget) n *= 2;
+    rows = (budget - n * (long) sizeof(AggSlot)) / rowSize;
+    if(rows > 3 * n / 4) rows = 3 * n / 4;
+    if(rows < 1) return NULL;
+
+    AggTable* t = new AggTable;
+    t->slots.assign(n, empty);
+    t->maxRows = rows;
+    t->rows = new char[(long) t->maxRows * rowSize];
+    t->rowCnt = 0;
+    t->key.resize(keyLen);
+    return t;
+}
+
+static void deleteTable(AggTable* t)
+{
+    if(!t) return;
+    delete [] t->rows;
+    delete t;
+}
+
+static void clearTable(AggTable* t)
+{
+    AggSlot	empty = { 0, -1 };
+
+    t->slots.assign(t->slots.size(), empty);
+    t->rowCnt = 0;
+}
+
+// HashAggregate::next as a RecordSourceFn
+
+static const Status nextGroup(void* agg, Record & rec)
+{
+    return ((HashAggregate*) agg)->next(rec);
+}
+
+// partition of a group with hash h at level.  every level mixes the
+// hash differently, so a partition that is split again spreads out
+
+static int partOf(const unsigned h, const int level)
+{
+    unsigned	x = (h ^ (level * 0x9E3779B9u)) * 0x85ebca6bu;
+
+    x ^= x >> 15;
+    return (int) (((unsigned long long) x * MAXAGGPARTS) >> 32);
+}
+
+HashAggregate::HashAggregate(HeapFileScan* scan, const ScanColumn* groupBy,
+                             const int groupCnt, const AggSpec* aggs,
+                             const int aggCnt, const int memPages,
+                             const int nThreads, Status & status)
+{
+    static int	groupings = 0;	// tells the partitions of different ones apart
+    char	buf[32];
+    int		i;
+
+    keyLen = 0;
+    rowSize = 0;
+    partCnt = 0;
+    spillLevel = 0;
+    spilled = false;
+    table = NULL;
+    outPos = 0;
+    this->memPages = memPages;
+
+    if(!scan || groupCnt < 0 || (groupCnt > 0 && !groupBy) || aggCnt < 1 ||
+       !aggs || nThreads < 1){
+	status = BADSCANPARM;
+	return;
+    }
+    for(i = 0; i < groupCnt; i++){
+	const ScanColumn & c = groupBy[i];
+	if(c.offset < 0 || c.length < 1 ||
+	   (c.type != STRING && c.type != INTEGER && c.type != FLOAT) ||
+	   (c.type != STRING && c.length != sizeof(int))){
+	    status = BADSCANPARM;
+	    return;
+	}
+	keyLen += c.length;
+    }
+    for(i = 0; i < aggCnt; i++)
+	if(aggs[i].func < COUNT || aggs[i].func > AVG ||
+	   (aggs[i].func != COUNT &&
+	    (aggs[i].offset < 0 ||
+	     (aggs[i].type != INTEGER && aggs[i].type != FLOAT)))){
+	    status = BADSCANPARM;
+	    return;
+	}
+    this->groupBy.assign(groupBy, groupBy + groupCnt);
+    this->aggs.assign(aggs, aggs + aggCnt);
+    rowSize = ((keyLen + 7) & ~7) + aggCnt * sizeof(AggState);
+
+    table = newTable((long) memPages * PAGESIZE, rowSize, keyLen);
+    for(i = 0; i < nThreads && table; i++){
+	tables.push_back(newTable((long) memPages * PAGESIZE / nThreads,
+				  rowSize, keyLen));
+	if(!tables.back()) break;
+    }
+    if(!table || !tables.back()){
+	status = INSUFMEM;
+	return;
+    }
+    sprintf(buf, ".agg%d.", groupings++);
+    partPrefix = scan->getFileName() + buf;
+
+    // the threads cannot make partitions while the pool is theirs, so
+    // they are made up front if a thread might see more groups than
+    // its table holds
+    if(scan->getRecCnt() > tables[0]->maxRows){
+	status = openSpill(0);
+	if(status != OK) return;
+    }
+    AggJob job;
+    job.agg = this;
+    job.status.assign(nThreads, OK);
+    status = scan->parallelScan(nThreads, aggBatch, &job);
+    if(status == FILEEOF) status = OK;
+    for(i = 0; i < nThreads && status == OK; i++) status = job.status[i];
+
+    // merge the partial tables, freeing each as soon as it is merged
+    for(i = 0; i < nThreads; i++){
+	AggTable* t = tables[i];
+	for(unsigned s = 0; s < t->slots.size() && status == OK; s++)
+	    if(t->slots[s].row != -1)
+		status = addRow(table, t->rows + t->slots[s].row * rowSize,
+				t->slots[s].hash, 0);
+	deleteTable(t);
+	tables[i] = NULL;
+    }
+    tables.clear();
+    if(status != OK || spill.empty()) return;
+    if(!spilled){
+	status = dropSpill();
+	return;
+    }
+    status = spillTable(table);
+    if(status == OK) status = closeSpill();
+}
+
+HashAggregate::~HashAggregate()
+{
+    unsigned	i;
+
+    for(i = 0; i < spill.size(); i++) delete spill[i];
+    for(i = 0; i < spillNames.size(); i++) destroyHeapFile(spillNames[i]);
+    for(i = 0; i < todo.size(); i++) destroyHeapFile(todo[i]);
+    for(i = 0; i < tables.size(); i++) deleteTable(tables[i]);
+    deleteTable(table);
+}
+
+const Status HashAggregate::next(Record & group)
+{
+    Status	status;
+    AggState	s;
+    double	v;
+    int		a;
+
+    if(!table) return FILEEOF;
+    while(outPos == table->rowCnt){
+	if(todo.empty()) return FILEEOF;
+	status = aggregatePart();
+	if(status != OK) return status;
+    }
+
+    const char* row = table->rows + outPos++ * rowSize;
+    const char* states = row + rowSize - aggs.size() * sizeof(AggState);
+    outBuf.resize(keyLen + aggs.size() * sizeof(double));
+    memcpy(outBuf.data(), row, keyLen);
+    for(a = 0; a < (int) aggs.size(); a++){
+	memcpy(&s, states + a * sizeof(AggState), sizeof(AggState));
+	if(aggs[a].func == COUNT) v = s.cnt;
+	else if(s.cnt == 0) v = NAN;
+	else if(aggs[a].func == MIN || aggs[a].func == MAX) v = s.fval;
+	else{
+	    v = (aggs[a].type == INTEGER) ? (double) s.isum : s.fval;
+	    if(aggs[a].func == AVG) v /= s.cnt;
+	}
+	memcpy(outBuf.data() + getAggOffset(a), &v, sizeof(double));
+    }
+    group.data = outBuf.data();
+    group.length = outBuf.size();
+    return OK;
+}
+
+const Status HashAggregate::writeTo(const string & outName)
+{
+    return loadHeapFile(outName, nextGroup, this);
+}
+
+const int HashAggregate::getAggOffset(const int a) const
+{
+    return keyLen + a * sizeof(double);
+}
+
+const int HashAggregate::getPartCnt() const
+{
+    return partCnt;
+}
+
+// a thread that fills its table spills it under the lock and goes on
+// with an empty one.  after a failure it only returns
+
+void HashAggregate::aggBatch(void* arg, const int worker, const RID* rids,
+                             const Record* recs, const int cnt)
+{
+    AggJob*	job = (AggJob*) arg;
+    HashAggregate* agg = job->agg;
+    AggTable*	t = agg->tables[worker];
+    char*	key = t->key.data();
+    char*	row;
+    Status	status;
+
+    if(job->status[worker] != OK) return;
+    for(int k = 0; k < cnt; k++){
+	if(!agg->makeKey(recs[k], key)) continue;
+	unsigned h = hashBytes(key, agg->keyLen);
+	row = agg->findGroup(t, key, h);
+	if(!row){
+	    {
+		lock_guard<mutex> guard(job->spillLock);
+		status = agg->spillTable(t);
+	    }
+	    if(status != OK){
+		job->status[worker] = status;
+		return;
+	    }
+	    row = agg->findGroup(t, key, h);
+	}
+	agg->accumulate(row, recs[k]);
+    }
+}
+
+// a STRING is copied up to its first NUL and padded with NULs, -0 is
+// made 0 and every NaN the same NaN, so keys that compare equal are
+// the same bytes
+
+const bool HashAggregate::makeKey(const Record & rec, char* key) const
+{
+    float	f;
+
+    for(unsigned i = 0; i < groupBy.size(); i++){
+	const ScanColumn & c = groupBy[i];
+	if(rec.length < c.offset + c.length) return false;
+	const char* p = (const char*) rec.data + c.offset;
+	if(c.type == STRING){
+	    int n = strnlen(p, c.length);
+	    memcpy(key, p, n);
+	    memset(key + n, 0, c.length - n);
+	}
+	else if(c.type == INTEGER) memcpy(key, p, sizeof(int));
+	else{
+	    memcpy(&f, p, sizeof(float));
+	    if(f != f) f = NAN;
+	    else if(f == 0) f = 0;
+	    memcpy(key, &f, sizeof(float));
+	}
+	key += c.length;
+    }
+    return true;
+}
+
+void HashAggregate::accumulate(char* row, const Record & rec) const
+{
+    AggState*	s = (AggState*) (row + rowSize) - aggs.size();
+    int		ival;
+    float	fval;
+    double	v;
+
+    for(unsigned a = 0; a < aggs.size(); a++, s++){
+	const AggSpec & spec = aggs[a];
+	if(spec.func == COUNT){
+	    s->cnt++;
+	    continue;
+	}
+	if(rec.length < spec.offset + (int) sizeof(int)) continue;
+	if(spec.type == INTEGER){
+	    memcpy(&ival, (char*) rec.data + spec.offset, sizeof(int));
+	    v = ival;
+	}
+	else{
+	    memcpy(&fval, (char*) rec.data + spec.offset, sizeof(float));
+	    if(fval != fval) continue;
+	    v = fval;
+	}
+	if(spec.func == MIN){
+	    if(s->cnt == 0 || v < s->fval) s->fval = v;
+	}
+	else if(spec.func == MAX){
+	    if(s->cnt == 0 || v > s->fval) s->fval = v;
+	}
+	else if(spec.type == INTEGER) s->isum += ival;
+	else s->fval += v;
+	s->cnt++;
+    }
+}
+
+// other may come straight from a partition page, so it is copied out
+// rather than read in place
+
+void HashAggregate::combine(char* row, const char* other) const
+{
+    AggState*	s = (AggState*) (row + rowSize) - aggs.size();
+    const char*	o = other + rowSize - aggs.size() * sizeof(AggState);
+    AggState	t;
+
+    for(unsigned a = 0; a < aggs.size(); a++, s++, o += sizeof(AggState)){
+	memcpy(&t, o, sizeof(AggState));
+	if(t.cnt == 0) continue;
+	if(aggs[a].func == MIN){
+	    if(s->cnt == 0 || t.fval < s->fval) s->fval = t.fval;
+	}
+	else if(aggs[a].func == MAX){
+	    if(s->cnt == 0 || t.fval > s->fval) s->fval = t.fval;
+	}
+	else{
+	    s->isum += t.isum;
+	    s->fval += t.fval;
+	}
+	s->cnt += t.cnt;
+    }
+}
+
+// linear probing from the slot the low bits of the hash pick
+
+char* HashAggregate::findGroup(AggTable* t, const char* key,
+                               const unsigned hash) const
+{
+    unsigned	mask = t->slots.size() - 1;
+    unsigned	i;
+    char*	row;
+
+    for(i = hash & mask; t->slots[i].row != -1; i = (i + 1) & mask){
+	row = t->rows + (long) t->slots[i].row * rowSize;
+	if(t->slots[i].hash == hash && memcmp(row, key, keyLen) == 0)
+	    return row;
+    }
+    if(t->rowCnt == t->maxRows) return NULL;
+
+    t->slots[i].hash = hash;
+    t->slots[i].row = t->rowCnt;
+    row = t->rows + (long) t->rowCnt++ * rowSize;
+    memcpy(row, key, keyLen);
+    memset(row + keyLen, 0, rowSize - keyLen);
+    return row;
+}
+
+const Status HashAggregate::addRow(AggTable* t, const char* row,
+                                   const unsigned hash, const int level)
+{
+    Status	status;
+    char*	group;
+
+    group = findGroup(t, row, hash);
+    if(!group){
+	if(spill.empty()){
+	    status = openSpill(level);
+	    if(status != OK) return status;
+	}
+	status = spillTable(t);
+	if(status != OK) return status;
+	group = findGroup(t, row, hash);
+    }
+    combine(group, row);
+    return OK;
+}
+
+const Status HashAggregate::openSpill(const int level)
+{
+    Status	status = OK;
+    char	buf[16];
+
+    if(level > MAXAGGLEVELS) return INSUFMEM;
+    spillLevel = level;
+    spilled = false;
+    for(int p = 0; p < MAXAGGPARTS && status == OK; p++){
+	sprintf(buf, "%d", partCnt);
+	status = createHeapFile(partPrefix + buf);
+	if(status != OK) break;
+	partCnt++;
+	spillNames.push_back(partPrefix + buf);
+	spill.push_back(new HeapFileLoader(spillNames.back(), status,
+					   AGGSTAGEPAGES));
+    }
+    return status;
+}
+
+const Status HashAggregate::spillTable(AggTable* t)
+{
+    Status	status = OK;
+    Record	rec;
+    RID		rid;
+
+    if((int) spill.size() != MAXAGGPARTS) return INSUFMEM;
+    rec.length = rowSize;
+    for(unsigned s = 0; s < t->slots.size() && status == OK; s++){
+	if(t->slots[s].row == -1) continue;
+	rec.data = t->rows + (long) t->slots[s].row * rowSize;
+	status = spill[partOf(t->slots[s].hash, spillLevel)]->insertRecord(rec,
+									    rid);
+    }
+    spilled = true;
+    clearTable(t);
+    return status;
+}
+
+const Status HashAggregate::closeSpill()
+{
+    Status	status = OK, finishstatus;
+
+    for(unsigned p = 0; p < spill.size(); p++){
+	finishstatus = spill[p]->finish();
+	if(status == OK) status = finishstatus;
+	delete spill[p];
+	todo.push_back(spillNames[p]);
+	todoLevel.push_back(spillLevel);
+    }
+    spill.clear();
+    spillNames.clear();
+    return status;
+}
+
+const Status HashAggregate::dropSpill()
+{
+    Status	status = OK, finishstatus;
+
+    for(unsigned p = 0; p < spill.size(); p++){
+	finishstatus = spill[p]->finish();
+	if(status == OK) status = finishstatus;
+	delete spill[p];
+	finishstatus = destroyHeapFile(spillNames[p]);
+	if(status == OK) status = finishstatus;
+    }
+    partCnt -= spill.size();
+    spill.clear();
+    spillNames.clear();
+    return status;
+}
+
+// the partition is destroyed once read.  if its groups do not all fit
+// they go on to partitions of the next level, to be taken up later
+
+const Status HashAggregate::aggregatePart()
+{
+    Status	status, endstatus;
+    RID		rids[MAXSLOTS];
+    Record	recs[MAXSLOTS];
+    int		n, k;
+    string	name = todo.back();
+    int		level = todoLevel.back();
+
+    todo.pop_back();
+    todoLevel.pop_back();
+    clearTable(table);
+    outPos = 0;
+
+    HeapFileScan* scan = new HeapFileScan(name, status);
+    if(status == OK) status = scan->startScan(NULL, 0);
+    while(status == OK &&
+	  (status = scan->scanBatch(MAXSLOTS, rids, recs, n)) == OK)
+	for(k = 0; k < n && status == OK; k++)
+	    status = addRow(table, (const char*) recs[k].data,
+			    hashBytes((const char*) recs[k].data, keyLen),
+			    level + 1);
+    delete scan;
+    endstatus = destroyHeapFile(name);
+    if(status == FILEEOF) status = endstatus;
+    if(status != OK || spill.empty()) return status;
+
+    status = spillTable(table);
+    endstatus = closeSpill();
+    return (status != OK) ? status : endstatus;
+}
@@ -0,0 +1,142 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include "heapfile.h"
+
+// Grouping and aggregation of the records a heap file scan returns, by
+// hashing.  The scan is run on several threads with parallelScan, and
+// each thread aggregates what it finds into a hash table of its own;
+// the partial tables are then merged into one.  The tables use open
+// addressing with linear probing, so a lookup mostly touches one
+// cache line of slots.  A table that runs out of room has its groups,
+// partially aggregated, written to partitions, temporary heap files
+// split by the hash of the group, and each partition is aggregated
+// again on its own afterwards, split further if it still has too many
+// groups.  Group attributes compare as a scan with EQ compares them,
+// except that all NaNs are one group.  Records too short to hold a
+// group attribute are left out.
+
+// aggregate functions
+enum AggFunc { COUNT, SUM, MIN, MAX, AVG };
+
+// an aggregate to compute for every group.  COUNT counts the records
+// of the group and has no attribute; the others take an INTEGER or a
+// FLOAT, leaving out records too short to hold it and FLOAT NaNs.
+// over no values at all they give NaN.  sums of INTEGERs are exact
+struct AggSpec
+{
+  AggFunc	func;
+  int		offset;		// byte offset of the attribute
+  Datatype	type;		// INTEGER or FLOAT
+};
+
+// partitions the groups of a table that runs out of room are split into
+const int MAXAGGPARTS = 16;
+
+// times a partition may be split again before INSUFMEM
+const int MAXAGGLEVELS = 6;
+
+// pages the HeapFileLoader of each partition stages its records in
+const int AGGSTAGEPAGES = 4;
+
+struct AggTable;		// see aggregate.cpp
+
+class HashAggregate
+{
+public:
+  // group the records scan has yet to return, the scan being started
+  // with the filter wanted, on the groupCnt attributes of groupBy and
+  // compute the aggCnt aggregates of aggs for every group.  none groups
+  // all records together.  the scan runs on nThreads threads, each of
+  // which hashes into memPages / nThreads pages, and is at its end
+  // afterwards; the partial tables are then merged into one of memPages
+  // pages.  BADSCANPARM if an attribute or aggregate is not valid,
+  // INSUFMEM if a table cannot hold a group
+  HashAggregate(HeapFileScan* scan, const ScanColumn* groupBy,
+                const int groupCnt, const AggSpec* aggs, const int aggCnt,
+                const int memPages, const int nThreads, Status & status);
+
+  // destroys the partitions
+  ~HashAggregate();
+
+  // the next group, FILEEOF after the last one: its group attributes one
+  // after the other, then the value of every aggregate as a double, see
+  // getAggOffset.  STRINGs are padded with NULs after their first NUL.
+  // the groups come in no particular order, and the record stays valid
+  // until the next call
+  const Status next(Record & group);
+
+  // write the groups next has yet to return to the new heap file outName
+  const Status writeTo(const string & outName);
+
+  // offset in the records next returns of the value of aggregate a
+  const int getAggOffset(const int a) const;
+
+  // number of partitions written, 0 if every table had room
+  const int getPartCnt() const;
+
+private:
+  vector<ScanColumn> groupBy;
+  vector<AggSpec> aggs;
+  int		keyLen;		// bytes of the group attributes
+  int		rowSize;	// bytes of a group in a table, see aggregate.cpp
+  int		memPages;
+  string	partPrefix;	// partition n is partPrefix + n
+  int		partCnt;	// partitions made so far
+
+  // the partitions being written, MAXAGGPARTS of them, and the level
+  // they are split at; empty when none are
+  vector<HeapFileLoader*> spill;
+  vector<string> spillNames;
+  int		spillLevel;
+  bool		spilled;	// true once a group went to them
+
+  // partitions yet to aggregate, and the level each was split at
+  vector<string> todo;
+  vector<int>	todoLevel;
+
+  vector<AggTable*> tables;	// one for each thread during the scan
+  AggTable*	table;		// the groups next hands out
+  int		outPos;		// next of them to hand out
+
+  vector<char>	outBuf;		// the last record next returned
+
+  // body of a parallelScan thread, for a page of records
+  static void aggBatch(void* arg, const int worker, const RID* rids,
+                       const Record* recs, const int cnt);
+
+  // put the group attributes of rec into key, false if it is too short
+  const bool makeKey(const Record & rec, char* key) const;
+
+  // fold the values of rec into the aggregates of group row
+  void accumulate(char* row, const Record & rec) const;
+
+  // fold the aggregates of group row other into those of row
+  void combine(char* row, const char* other) const;
+
+  // the group of key in t, NULL if it is new and t is full.  a new
+  // group starts with nothing aggregated
+  char* findGroup(AggTable* t, const char* key, const unsigned hash) const;
+
+  // fold group row, with the hash of its key, into t.  if t is full it
+  // is spilled first, to partitions at level
+  const Status addRow(AggTable* t, const char* row, const unsigned hash,
+                      const int level);
+
+  // make MAXAGGPARTS partitions at level, INSUFMEM past MAXAGGLEVELS
+  const Status openSpill(const int level);
+
+  // write the groups of t to the partitions and empty it
+  const Status spillTable(AggTable* t);
+
+  // finish the partitions and leave them to be aggregated
+  const Status closeSpill();
+
+  // finish the partitions and destroy them, for when none was used
+  const Status dropSpill();
+
+  // aggregate the last partition of todo into table, or split it up
+  const Status aggregatePart();
+};
+
+#endif
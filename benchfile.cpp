@@ -0,0 +1,1713 @@
+#include <stdio.h>
+#include <sys/time.h>
+#include "heapfile.h"
+#include "import.h"
+#include "filter.h"
+#include "btree.h"
+#include "hashindex.h"
+#include "bitmap.h"
+#include "sort.h"
+#include "join.h"
+#include "aggregate.h"
+#include <unistd.h>
+#include <string.h>
+#include "stdlib.h"
+#include <map>
+
+// Microbenchmarks for the page and heap file layers.  Every benchmark
+// prints the elapsed time of its timed section so runs before and
+// after a change can be compared side by side.
+
+extern Status createHeapFile(string FileName);
+extern Status destroyHeapFile(string FileName);
+
+// globals
+DB db;
+BufMgr* bufMgr;
+
+// records asked for per scanBatch call
+const int SCANBATCH = 256;
+
+// wall clock time in seconds
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void report(const char* name, const int ops, const double secs)
+{
+    printf("%-40s %10d ops %10.3f ms %10.1f ns/op\n",
+           name, ops, secs * 1e3, ops ? secs * 1e9 / ops : 0.0);
+}
+
+// fill a page with small records and delete all of them front to
+// back, the order that makes an eager compaction move the most bytes
+static void benchPageDelete(const int rounds)
+{
+    Page	page;
+    Record	rec;
+    RID		rid;
+    char	buf[16];
+    int		ops = 0;
+
+    memset(buf, 'x', sizeof(buf));
+    rec.data = buf;
+    rec.length = sizeof(buf);
+
+    double start = now();
+    for (int r = 0; r < rounds; r++)
+    {
+        int n = 0;
+        page.init(1);
+        while (page.insertRecord(rec, rid) == OK) n++;
+        for (int i = 0; i < n; i++)
+        {
+            rid.slotNo = i;
+            page.deleteRecord(rid);
+        }
+        ops += n;
+    }
+    report("page delete front to back", ops, now() - start);
+}
+
+// delete every other record on a full page and refill it, so that
+// the holes have to be reclaimed by inserts
+static void benchPageChurn(const int rounds)
+{
+    Page	page;
+    Record	rec;
+    RID		rid;
+    char	buf[16];
+    int		n = 0, ops = 0;
+
+    memset(buf, 'x', sizeof(buf));
+    rec.data = buf;
+    rec.length = sizeof(buf);
+
+    page.init(1);
+    while (page.insertRecord(rec, rid) == OK) n++;
+
+    double start = now();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int i = r % 2; i < n; i += 2)
+        {
+            rid.slotNo = i;
+            page.deleteRecord(rid);
+            ops++;
+        }
+        while (page.insertRecord(rec, rid) == OK) ops++;
+    }
+    report("page delete/refill churn", ops, now() - start);
+}
+
+// fixed-layout record used by the heap file benchmarks, same as
+// the one in testfile.cpp
+typedef struct {
+    int i;
+    float f;
+    char s[64];
+} RECORD;
+
+// create fileName and fill it with num records
+static void loadFile(const string & fileName, const int num)
+{
+    Status	status;
+    RECORD	rec;
+    Record	dbrec;
+    RID		rid;
+
+    destroyHeapFile(fileName);
+    createHeapFile(fileName);
+    InsertFileScan* iScan = new InsertFileScan(fileName, status);
+    memset(&rec, ' ', sizeof(rec));
+    dbrec.data = &rec;
+    dbrec.length = sizeof(RECORD);
+    for (int i = 0; i < num; i++)
+    {
+        sprintf(rec.s, "This is record %05d", i);
+        rec.i = i;
+        rec.f = i;
+        iScan->insertRecord(dbrec, rid);
+    }
+    delete iScan;
+}
+
+// unfiltered scans over a file in which all but one record in
+// every ten has been deleted
+static void benchScanSparse(const int num, const int rounds)
+{
+    Status	status;
+    RID		rid;
+    int		i, ops = 0;
+
+    loadFile("bench.01", num);
+    HeapFileScan* scan = new HeapFileScan("bench.01", status);
+    scan->startScan(0, 0, STRING, NULL, EQ);
+    for (i = 0; scan->scanNext(rid) == OK; i++)
+        if (i % 10 != 0) scan->deleteRecord();
+    delete scan;
+
+    double start = now();
+    for (int r = 0; r < rounds; r++)
+    {
+        scan = new HeapFileScan("bench.01", status);
+        scan->startScan(0, 0, STRING, NULL, EQ);
+        while (scan->scanNext(rid) == OK) ops++;
+        delete scan;
+    }
+    report("scan with 90% of records deleted", ops, now() - start);
+    destroyHeapFile("bench.01");
+}
+
+// a scan of bench.01 kept open across the rounds of a benchmark, so
+// that its pages stay cached and opening the file is not measured.
+// resetScan() takes it back to the start of the file
+static HeapFileScan* openScan(const int offset, const int length,
+                              const Datatype type, const char* filter,
+                              const Operator op)
+{
+    Status	status;
+
+    HeapFileScan* scan = new HeapFileScan("bench.01", status);
+    scan->startScan(offset, length, type, filter, op);
+    scan->markScan();
+    return scan;
+}
+
+// full scans, with and without a filter on the integer attribute that
+// one record in ten passes, one record at a time and in batches.  the
+// file fits in the buffer pool so that the scan itself is measured
+static void benchScanBatch(const int num, const int rounds)
+{
+    RID		rid;
+    Record	rec;
+    RID*	rids = new RID[SCANBATCH];
+    Record*	recs = new Record[SCANBATCH];
+    int		r, k, cnt, bound = num / 10;
+    long	sum = 0;
+
+    loadFile("bench.01", num);
+    for (int filtered = 0; filtered < 2; filtered++)
+    {
+        const char* filter = filtered ? (char*)&bound : NULL;
+
+        HeapFileScan* scan = openScan(0, sizeof(int), INTEGER, filter, LT);
+        double start = now();
+        for (r = 0; r < rounds; r++)
+        {
+            scan->resetScan();
+            while (scan->scanNext(rid) == OK)
+            {
+                scan->getRecord(rec);
+                sum += rec.length;
+            }
+        }
+        report(filtered ? "filtered scan, scanNext" : "scan, scanNext",
+               num * rounds, now() - start);
+        delete scan;
+
+        scan = openScan(0, sizeof(int), INTEGER, filter, LT);
+        start = now();
+        for (r = 0; r < rounds; r++)
+        {
+            scan->resetScan();
+            while (scan->scanBatch(SCANBATCH, rids, recs, cnt) == OK)
+                for (k = 0; k < cnt; k++) sum += recs[k].length;
+        }
+        report(filtered ? "filtered scan, scanBatch" : "scan, scanBatch",
+               num * rounds, now() - start);
+        delete scan;
+    }
+    if (sum == 0) printf("no records scanned\n");
+    destroyHeapFile("bench.01");
+    delete [] rids;
+    delete [] recs;
+}
+
+// filtered batch scans over a cached file for every attribute type
+// and comparison operator, the filter passing about half the records
+static void benchPredicates(const int num, const int rounds)
+{
+    static const char* typeNames[] = { "STRING", "INTEGER", "FLOAT" };
+    static const char* opNames[] = { "LT", "LTE", "EQ", "GTE", "GT", "NE" };
+    RID*	rids = new RID[SCANBATCH];
+    Record*	recs = new Record[SCANBATCH];
+    int		cnt, matched = 0;
+    int		ival = num / 2;
+    float	fval = num / 2;
+    char	sval[32];
+    char	name[64];
+
+    sprintf(sval, "This is record %05d", num / 2);
+    loadFile("bench.01", num);
+    for (int t = STRING; t <= FLOAT; t++)
+    {
+        int offset = (t == STRING) ? 8 : (t == INTEGER) ? 0 : 4;
+        int length = (t == STRING) ? 20 : 4;
+        const char* filter = (t == STRING) ? sval
+                           : (t == INTEGER) ? (char*)&ival : (char*)&fval;
+        for (int op = LT; op <= NE; op++)
+        {
+            HeapFileScan* scan = openScan(offset, length, (Datatype)t, filter,
+                                          (Operator)op);
+            double start = now();
+            for (int r = 0; r < rounds; r++)
+            {
+                scan->resetScan();
+                while (scan->scanBatch(SCANBATCH, rids, recs, cnt) == OK)
+                    matched += cnt;
+            }
+            sprintf(name, "filtered scan, %s %s", typeNames[t], opNames[op]);
+            report(name, num * rounds, now() - start);
+            delete scan;
+        }
+    }
+    if (matched == 0) printf("no records matched\n");
+    destroyHeapFile("bench.01");
+    delete [] rids;
+    delete [] recs;
+}
+
+// cost of one filter kernel call over a full page of values at each
+// level, then whole scans with a filter passing 1% and 99% of the
+// records: per record through scanNext, and a page at a time through
+// scanBatch at each level
+static void benchFilterKernels(const int num, const int rounds)
+{
+    static const char* levelNames[] = { "scalar", "SSE", "AVX2" };
+    int		vals[MAXSLOTS];
+    unsigned long long sel[SLOTMAPWORDS];
+    RID		rid;
+    RID*	rids = new RID[SCANBATCH];
+    Record*	recs = new Record[SCANBATCH];
+    char	name[64];
+    int		i, r, cnt, filter, level;
+    long	matched = 0;
+
+    for (i = 0; i < (int) MAXSLOTS; i++) vals[i] = rand();
+    filter = RAND_MAX / 2;
+    for (level = FILTERSCALAR; level <= bestFilterLevel(); level++)
+    {
+        setFilterLevel((FilterLevel) level);
+        FilterFn fn = pickFilter(INTEGER, LT);
+        double start = now();
+        for (r = 0; r < rounds * 1000; r++)
+        {
+            vals[r % MAXSLOTS] ^= 1;
+            fn(vals, MAXSLOTS, &filter, sel);
+            matched += sel[0] & 1;
+        }
+        sprintf(name, "filter %d ints, %s", MAXSLOTS, levelNames[level]);
+        report(name, rounds * 1000, now() - start);
+    }
+
+    loadFile("bench.01", num);
+    for (int pct = 1; pct <= 99; pct += 98)
+    {
+        filter = num * pct / 100;
+        HeapFileScan* scan = openScan(0, sizeof(int), INTEGER,
+                                      (char*)&filter, LT);
+        double start = now();
+        for (r = 0; r < rounds; r++)
+        {
+            scan->resetScan();
+            while (scan->scanNext(rid) == OK) matched++;
+        }
+        sprintf(name, "scan passing %d%%, scanNext", pct);
+        report(name, num * rounds, now() - start);
+        delete scan;
+
+        for (level = FILTERSCALAR; level <= bestFilterLevel(); level++)
+        {
+            setFilterLevel((FilterLevel) level);
+            HeapFileScan* scan = openScan(0, sizeof(int), INTEGER,
+                                      (char*)&filter, LT);
+            start = now();
+            for (r = 0; r < rounds; r++)
+            {
+                scan->resetScan();
+                while (scan->scanBatch(SCANBATCH, rids, recs, cnt) == OK)
+                    matched += cnt;
+            }
+            sprintf(name, "scan passing %d%%, scanBatch %s", pct,
+                    levelNames[level]);
+            report(name, num * rounds, now() - start);
+            delete scan;
+        }
+    }
+    setFilterLevel(bestFilterLevel());
+    if (matched == 0) printf("no records matched\n");
+    destroyHeapFile("bench.01");
+    delete [] rids;
+    delete [] recs;
+}
+
+// STRING operators on a 20-byte prefix of RECORD.s and on all 64 bytes
+// of it, with the plain and the SSE kernels.  the 64-byte values have
+// no NUL, so every kernel goes through the whole field.  CONTAINS is
+// also done the old way, by the caller on every record of a full scan
+static void benchStringOps(const int num, const int rounds)
+{
+    static const char* levelNames[] = { "scalar", "SSE", "AVX2" };
+    static const char* opNames[] = { "EQ", "PREFIX", "CONTAINS", "LIKE" };
+    static const Operator ops[] = { EQ, PREFIX, CONTAINS, LIKE };
+    Status	status;
+    RECORD	rec;
+    Record	dbrec;
+    RID		rid;
+    RID*	rids = new RID[SCANBATCH];
+    Record*	recs = new Record[SCANBATCH];
+    char	name[80], eq[64];
+    int		r, k, cnt, matched = 0;
+
+    destroyHeapFile("bench.01");
+    createHeapFile("bench.01");
+    InsertFileScan* iScan = new InsertFileScan("bench.01", status);
+    dbrec.data = &rec;
+    dbrec.length = sizeof(RECORD);
+    for (int i = 0; i < num; i++)
+    {
+        char text[64];
+        rec.i = i;
+        rec.f = i;
+        memset(rec.s, '.', sizeof(rec.s));
+        memcpy(rec.s, text, sprintf(text, "This is record %05d of the bench file", i));
+        iScan->insertRecord(dbrec, rid);
+    }
+    delete iScan;
+
+    for (int len = 20; len <= 64; len += 44)
+    {
+        memset(eq, '.', sizeof(eq));
+        memcpy(eq, "This is record 00500 of the bench file", 38);
+        if (len < 64) eq[len] = '\0';
+        const char* filters[] = { eq, "This is rec", "d 0050", "%rec_rd%050%" };
+
+        for (int o = 0; o < 4; o++)
+            for (int level = FILTERSCALAR; level <= FILTERSSE; level++)
+            {
+                setFilterLevel((FilterLevel) level);
+                HeapFileScan* scan = openScan(8, len, STRING, filters[o], ops[o]);
+                double start = now();
+                for (r = 0; r < rounds; r++)
+                {
+                    scan->resetScan();
+                    while (scan->scanBatch(SCANBATCH, rids, recs, cnt) == OK)
+                        matched += cnt;
+                }
+                sprintf(name, "%d-byte STRING %s, %s", len, opNames[o],
+                        levelNames[level]);
+                report(name, num * rounds, now() - start);
+                delete scan;
+            }
+
+        HeapFileScan* scan = openScan(0, 0, STRING, NULL, EQ);
+        double start = now();
+        for (r = 0; r < rounds; r++)
+        {
+            scan->resetScan();
+            while (scan->scanBatch(SCANBATCH, rids, recs, cnt) == OK)
+                for (k = 0; k < cnt; k++)
+                    matched += memmem((char*)recs[k].data + 8,
+                                      strnlen((char*)recs[k].data + 8, len),
+                                      "d 0050", 6) != NULL;
+        }
+        sprintf(name, "%d-byte CONTAINS in caller", len);
+        report(name, num * rounds, now() - start);
+        delete scan;
+    }
+    setFilterLevel(bestFilterLevel());
+    if (matched == 0) printf("no records matched\n");
+    destroyHeapFile("bench.01");
+    delete [] rids;
+    delete [] recs;
+}
+
+// a three-condition AND and a three-condition OR as one scan
+// predicate, against scanning with the first condition and checking
+// the other two in the caller, as was needed before startScan took
+// more than one condition.  the AND is given in its worst order: a
+// LIKE passing 10% of the records, a FLOAT test passing all of them
+// and an INTEGER BETWEEN passing 5%
+static void benchPredicateExpr(const int num, const int rounds)
+{
+    RID*	rids = new RID[SCANBATCH];
+    Record*	recs = new Record[SCANBATCH];
+    int		r, k, cnt, matched[4] = { 0, 0, 0, 0 };
+    int		range[2] = { num / 10, num / 10 + num / 20 - 1 };
+    int		lo = num / 20, hi = num - num / 20;
+    float	zero = 0;
+    RECORD	rec;
+
+    loadFile("bench.01", num);
+    ScanCond conds[3] = {
+        { 8, 20, STRING, LIKE, "%record 0_5%", 0, 0 },
+        { 4, 4, FLOAT, GTE, (char*)&zero, 0, 1 },
+        { 0, 4, INTEGER, BETWEEN, (char*)range, 0, 2 } };
+    ScanCond ors[3] = {
+        { 0, 4, INTEGER, LT, (char*)&lo, 0, 0 },
+        { 0, 4, INTEGER, GT, (char*)&hi, 0, 0 },
+        { 8, 20, STRING, PREFIX, "This is record 005", 0, 0 } };
+
+    for (int e = 0; e < 2; e++)
+    {
+        Status status;
+        HeapFileScan* scan = new HeapFileScan("bench.01", status);
+        scan->startScan(e == 0 ? conds : ors, 3);
+        scan->markScan();
+        double start = now();
+        for (r = 0; r < rounds; r++)
+        {
+            scan->resetScan();
+            while (scan->scanBatch(SCANBATCH, rids, recs, cnt) == OK)
+                matched[e * 2] += cnt;
+        }
+        report(e == 0 ? "3-way AND in the scan" : "3-way OR in the scan",
+               num * rounds, now() - start);
+        delete scan;
+
+        scan = (e == 0) ? openScan(8, 20, STRING, "%record 0_5%", LIKE)
+                        : openScan(0, 0, INTEGER, NULL, EQ);
+        start = now();
+        for (r = 0; r < rounds; r++)
+        {
+            scan->resetScan();
+            while (scan->scanBatch(SCANBATCH, rids, recs, cnt) == OK)
+                for (k = 0; k < cnt; k++)
+                {
+                    memcpy(&rec, recs[k].data, 8);
+                    if (e == 0)
+                        matched[1] += rec.f >= zero &&
+                                      rec.i >= range[0] && rec.i <= range[1];
+                    else
+                        matched[3] += rec.i < lo || rec.i > hi ||
+                                      !strncmp((char*)recs[k].data + 8,
+                                               "This is record 005", 18);
+                }
+        }
+        report(e == 0 ? "3-way AND, 2 in the caller" : "3-way OR in the caller",
+               num * rounds, now() - start);
+        delete scan;
+    }
+    if (matched[0] != matched[1] || matched[2] != matched[3])
+        printf("predicate and caller disagree\n");
+    destroyHeapFile("bench.01");
+    delete [] rids;
+    delete [] recs;
+}
+
+// sum of i, and of f and of the first byte of s for three columns,
+// over a cached file: from whole records one at a time and a batch at
+// a time, and from column arrays filled by scanColumns
+static void benchProjection(const int num, const int rounds)
+{
+    const int	batch = 1024;
+    RID*	rids = new RID[batch];
+    Record*	recs = new Record[batch];
+    int*	icol = new int[batch];
+    float*	fcol = new float[batch];
+    char*	scol = new char[batch * 20];
+    char*	out[3] = { (char*)icol, (char*)fcol, scol };
+    ScanColumn	cols[3] = { { 0, 4, INTEGER }, { 4, 4, FLOAT }, { 8, 20, STRING } };
+    RECORD	rec;
+    RID		rid;
+    Record	dbrec;
+    int		r, k, cnt;
+    char	name[64];
+    double	sum = 0;
+
+    loadFile("bench.01", num);
+    HeapFileScan* scan = openScan(0, 0, INTEGER, NULL, EQ);
+    for (int ncol = 1; ncol <= 3; ncol += 2)
+    {
+        double start = now();
+        for (r = 0; r < rounds; r++)
+        {
+            scan->resetScan();
+            while (scan->scanNext(rid) == OK && scan->getRecord(dbrec) == OK)
+            {
+                memcpy(&rec, dbrec.data, 9);
+                sum += rec.i;
+                if (ncol == 3) sum += rec.f + rec.s[0];
+            }
+        }
+        sprintf(name, "%d of 3 attributes, scanNext", ncol);
+        report(name, num * rounds, now() - start);
+
+        start = now();
+        for (r = 0; r < rounds; r++)
+        {
+            scan->resetScan();
+            while (scan->scanBatch(SCANBATCH, rids, recs, cnt) == OK)
+                for (k = 0; k < cnt; k++)
+                {
+                    memcpy(&rec, recs[k].data, 9);
+                    sum += rec.i;
+                    if (ncol == 3) sum += rec.f + rec.s[0];
+                }
+        }
+        sprintf(name, "%d of 3 attributes, scanBatch", ncol);
+        report(name, num * rounds, now() - start);
+
+        start = now();
+        for (r = 0; r < rounds; r++)
+        {
+            scan->resetScan();
+            while (scan->scanColumns(cols, ncol, out, batch, NULL, cnt) == OK)
+            {
+                long long isum = 0;
+                for (k = 0; k < cnt; k++) isum += icol[k];
+                sum += isum;
+                if (ncol == 3)
+                {
+                    float fsum = 0;
+                    for (k = 0; k < cnt; k++) fsum += fcol[k] + scol[k * 20];
+                    sum += fsum;
+                }
+            }
+        }
+        sprintf(name, "%d of 3 attributes, scanColumns", ncol);
+        report(name, num * rounds, now() - start);
+    }
+    delete scan;
+    if (sum == 0) printf("nothing summed\n");
+    destroyHeapFile("bench.01");
+    delete [] rids;
+    delete [] recs;
+    delete [] icol;
+    delete [] fcol;
+    delete [] scol;
+}
+
+// per-worker sums of i for benchParallelScan, a cache line apart
+struct WorkerSum
+{
+    long long	sum;
+    char	pad[56];
+};
+
+static void sumWorker(void* arg, const int worker, const RID*,
+                      const Record* recs, const int cnt)
+{
+    WorkerSum* sums = (WorkerSum*) arg;
+    int i;
+    for (int k = 0; k < cnt; k++)
+    {
+        memcpy(&i, recs[k].data, sizeof(int));
+        sums[worker].sum += i;
+    }
+}
+
+// sum of i over a file that fits in a buffer pool made large enough
+// for it, by a batch scan and by parallelScan on 1 to 8 threads, each
+// keeping a partial sum
+static void benchParallelScan(const int num, const int rounds)
+{
+    RID*	rids = new RID[SCANBATCH];
+    Record*	recs = new Record[SCANBATCH];
+    WorkerSum	sums[8];
+    char	name[64];
+    int		r, k, cnt, i;
+    long long	sum = 0, total = 0;
+
+    delete bufMgr;
+    bufMgr = new BufMgr(num / 10);
+    loadFile("bench.01", num);
+
+    HeapFileScan* scan = openScan(0, 0, INTEGER, NULL, EQ);
+    double start = now();
+    for (r = 0; r < rounds; r++)
+    {
+        scan->resetScan();
+        while (scan->scanBatch(SCANBATCH, rids, recs, cnt) == OK)
+            for (k = 0; k < cnt; k++)
+            {
+                memcpy(&i, recs[k].data, sizeof(int));
+                sum += i;
+            }
+    }
+    report("sum by scanBatch", num * rounds, now() - start);
+
+    // resetScan brings the scan back after parallelScan has ended it
+    for (int nThreads = 1; nThreads <= 8; nThreads *= 2)
+    {
+        start = now();
+        for (r = 0; r < rounds; r++)
+        {
+            scan->resetScan();
+            memset(sums, 0, sizeof(sums));
+            scan->parallelScan(nThreads, sumWorker, sums);
+            for (k = 0; k < nThreads; k++) total += sums[k].sum;
+        }
+        sprintf(name, "sum by parallelScan, %d threads", nThreads);
+        report(name, num * rounds, now() - start);
+    }
+    delete scan;
+    if (total != sum * 4) printf("parallel sums disagree\n");
+
+    destroyHeapFile("bench.01");
+    delete bufMgr;
+    bufMgr = new BufMgr(101);
+    delete [] rids;
+    delete [] recs;
+}
+
+// position a scan at a random data page, through the page directory
+// and by following the page chain from the first page as before it
+// existed, then full scans of a file larger than the buffer pool with
+// and without read-ahead
+static void benchPageDirectory(const int num, const int seeks)
+{
+    Status	status;
+    RID		rid;
+    int		i, k, pageNo, cnt;
+    double	start;
+
+    loadFile("bench.01", num);
+    HeapFileScan* scan = new HeapFileScan("bench.01", status);
+    scan->startScan(0, 0, INTEGER, NULL, EQ);
+    cnt = scan->getPageCnt();
+
+    srand(40);
+    start = now();
+    for (i = 0; i < seeks; i++)
+        scan->seekPage(rand() % cnt);
+    report("seekPage to a random page", seeks, now() - start);
+
+    // the chain walk needs a page of its own; only the page numbers
+    // are followed, as a seek without a directory would
+    File* file;
+    db.openFile("bench.01", file);
+    vector<int> pageNos;
+    scan->getPageNos(pageNos);
+    start = now();
+    for (i = 0; i < seeks / 100; i++)
+    {
+        Page* page;
+        k = rand() % cnt;
+        pageNo = pageNos[0];
+        for (int p = 0; p < k; p++)
+        {
+            bufMgr->readPage(file, pageNo, page);
+            int next;
+            page->getNextPage(next);
+            bufMgr->unPinPage(file, pageNo, false);
+            pageNo = next;
+        }
+    }
+    report("page chain walk to a random page", seeks / 100, now() - start);
+    db.closeFile(file);
+
+    for (int ahead = 0; ahead <= 64; ahead += 64)
+    {
+        scan->seekPage(0);
+        scan->setReadAhead(ahead);
+        start = now();
+        for (i = 0; scan->scanNext(rid) == OK; i++) ;
+        report(ahead ? "uncached scan, read-ahead of 64 pages"
+                     : "uncached scan, no read-ahead", i, now() - start);
+    }
+    delete scan;
+    destroyHeapFile("bench.01");
+}
+
+// look up a list of RIDs one at a time with getRecord and all at once
+// with getRecords, for RIDs in random order and for every 7th record in
+// file order.  the file is much larger than the buffer pool
+static void benchPointLookups(const int num, const int lookups)
+{
+    Status	status;
+    RID		rid;
+    Record	dbrec;
+    vector<RID>	all, want[2];
+    double	start;
+    long	sum;
+    int		i, k;
+
+    loadFile("bench.01", num);
+    HeapFile* file = new HeapFile("bench.01", status);
+    HeapFileScan* scan = new HeapFileScan("bench.01", status);
+    scan->startScan(0, 0, INTEGER, NULL, EQ);
+    while (scan->scanNext(rid) == OK) all.push_back(rid);
+    delete scan;
+
+    srand(41);
+    for (i = 0; i < lookups; i++)
+        want[0].push_back(all[rand() % all.size()]);
+    for (i = 0; i < (int) all.size(); i += 7)
+        want[1].push_back(all[i]);
+
+    for (k = 0; k < 2; k++)
+    {
+        const char* what = k ? "every 7th RID" : "random RIDs";
+        vector<Record> recs(want[k].size());
+        char name[80];
+
+        sum = 0;
+        start = now();
+        for (i = 0; i < (int) want[k].size(); i++)
+        {
+            file->getRecord(want[k][i], dbrec);
+            sum += ((RECORD*) dbrec.data)->i;
+        }
+        sprintf(name, "getRecord, %s", what);
+        report(name, want[k].size(), now() - start);
+
+        for (int prefetch = 0; prefetch < 2; prefetch++)
+        {
+            long check = 0;
+            start = now();
+            status = file->getRecords(&want[k][0], want[k].size(), &recs[0],
+                                      prefetch == 1);
+            for (i = 0; i < (int) recs.size(); i++)
+                check += ((RECORD*) recs[i].data)->i;
+            sprintf(name, "getRecords%s, %s", prefetch ? " with prefetch" : "",
+                    what);
+            report(name, want[k].size(), now() - start);
+            if (status != OK || check != sum)
+                cout << "getRecords returned different records" << endl;
+        }
+    }
+    delete file;
+    destroyHeapFile("bench.01");
+}
+
+// build a B+tree on RECORD.i and find the records with one key, and
+// with a range of num / 1000 keys, through it and with a filtered scan
+static void benchBTree(const int num, const int lookups)
+{
+    Status	status;
+    RID		rid;
+    Record	dbrec;
+    string	indexName;
+    double	start;
+    int		i, key, cnt;
+    vector<RID>	rids;
+
+    loadFile("bench.01", num);
+    start = now();
+    BTreeIndex* index = new BTreeIndex("bench.01", 0, sizeof(int), INTEGER,
+                                       indexName, status);
+    report("B+tree build", num, now() - start);
+    HeapFile* file = new HeapFile("bench.01", status);
+
+    srand(44);
+    start = now();
+    for (i = cnt = 0; i < lookups; i++)
+    {
+        key = rand() % num;
+        index->startScan((char*) &key, EQ);
+        while (index->scanNext(rid) == OK)
+        {
+            file->getRecord(rid, dbrec);
+            cnt++;
+        }
+    }
+    report("B+tree EQ lookup", lookups, now() - start);
+
+    HeapFileScan* scan = openScan(0, sizeof(int), INTEGER, (char*) &key, EQ);
+    start = now();
+    for (i = 0; i < lookups / 100; i++)
+    {
+        key = rand() % num;
+        scan->startScan(0, sizeof(int), INTEGER, (char*) &key, EQ);
+        scan->resetScan();
+        while (scan->scanNext(rid) == OK) scan->getRecord(dbrec);
+    }
+    report("filtered scan EQ lookup", lookups / 100, now() - start);
+
+    int range[2];
+    start = now();
+    for (i = 0; i < lookups; i++)
+    {
+        range[0] = rand() % (num - num / 1000);
+        range[1] = range[0] + num / 1000 - 1;
+        index->startScan((char*) range, BETWEEN);
+        rids.clear();
+        while (index->scanNext(rid) == OK) rids.push_back(rid);
+        vector<Record> recs(rids.size());
+        file->getRecords(&rids[0], rids.size(), &recs[0]);
+    }
+    report("B+tree BETWEEN, 0.1% of keys", lookups, now() - start);
+
+    ScanCond cond = { 0, sizeof(int), INTEGER, BETWEEN, (char*) range, 0, 0 };
+    start = now();
+    for (i = 0; i < lookups / 100; i++)
+    {
+        range[0] = rand() % (num - num / 1000);
+        range[1] = range[0] + num / 1000 - 1;
+        scan->startScan(&cond, 1);
+        scan->resetScan();
+        while (scan->scanNext(rid) == OK) scan->getRecord(dbrec);
+    }
+    report("filtered scan BETWEEN, 0.1% of keys", lookups / 100, now() - start);
+
+    delete scan;
+    delete file;
+    delete index;
+    db.destroyFile(indexName);
+    destroyHeapFile("bench.01");
+}
+
+// delete half of a file: every other record, one at a time from a scan
+// as testfile.cpp does and then with deleteRecords, and the first half,
+// from a filtered scan and then with deleteWhere.  the times include
+// closing the file, which writes the pages back
+// EQ lookups of random keys through a hash index and a B+tree on the
+// same attribute, and inserts with the hash index attached or not
+
+static void benchHashIndex(const int num, const int lookups)
+{
+    Status	status;
+    RID		rid;
+    Record	dbrec;
+    RECORD	rec;
+    string	hashName, treeName;
+    double	start;
+    int		i, key, cnt;
+
+    loadFile("bench.01", num);
+    start = now();
+    HashIndex* hash = new HashIndex("bench.01", 0, sizeof(int), INTEGER,
+                                    hashName, status);
+    report("hash index build", num, now() - start);
+    BTreeIndex* tree = new BTreeIndex("bench.01", 0, sizeof(int), INTEGER,
+                                      treeName, status);
+    HeapFile* file = new HeapFile("bench.01", status);
+
+    srand(45);
+    start = now();
+    for (i = cnt = 0; i < lookups; i++)
+    {
+        key = rand() % num;
+        hash->startScan((char*) &key);
+        while (hash->scanNext(rid) == OK) cnt++;
+    }
+    report("hash EQ lookup, RIDs only", lookups, now() - start);
+
+    srand(45);
+    start = now();
+    for (i = cnt = 0; i < lookups; i++)
+    {
+        key = rand() % num;
+        tree->startScan((char*) &key, EQ);
+        while (tree->scanNext(rid) == OK) cnt++;
+    }
+    report("B+tree EQ lookup, RIDs only", lookups, now() - start);
+
+    srand(45);
+    start = now();
+    for (i = cnt = 0; i < lookups; i++)
+    {
+        key = rand() % num;
+        hash->startScan((char*) &key);
+        while (hash->scanNext(rid) == OK)
+        {
+            file->getRecord(rid, dbrec);
+            cnt++;
+        }
+    }
+    report("hash EQ lookup", lookups, now() - start);
+
+    srand(45);
+    start = now();
+    for (i = cnt = 0; i < lookups; i++)
+    {
+        key = rand() % num;
+        tree->startScan((char*) &key, EQ);
+        while (tree->scanNext(rid) == OK)
+        {
+            file->getRecord(rid, dbrec);
+            cnt++;
+        }
+    }
+    report("B+tree EQ lookup", lookups, now() - start);
+    delete file;
+    delete tree;
+    db.destroyFile(treeName);
+
+    memset(&rec, ' ', sizeof(rec));
+    dbrec.data = &rec;
+    dbrec.length = sizeof(RECORD);
+    for (int attached = 0; attached < 2; attached++)
+    {
+        InsertFileScan* iScan = new InsertFileScan("bench.01", status);
+        if (attached) hash->attachTo(*iScan);
+        start = now();
+        for (i = 0; i < num / 10; i++)
+        {
+            rec.i = num * (attached + 1) + i;
+            iScan->insertRecord(dbrec, rid);
+        }
+        report(attached ? "insert, hash index attached" : "insert, no index",
+               num / 10, now() - start);
+        delete iScan;
+    }
+
+    delete hash;
+    db.destroyFile(hashName);
+    destroyHeapFile("bench.01");
+}
+
+// queries combining equality tests on three low-cardinality
+// attributes, answered by ANDing bitmap indexes and fetching the
+// records a batch at a time, and by a filtered scan
+
+static void benchBitmapIndex(const int num, const int rounds)
+{
+    Status	status;
+    RECORD	rec;
+    Record	dbrec;
+    RID		rid, rids[256];
+    Record	recs[256];
+    string	aName, bName, cName;
+    const char*	regions[6] = { "north", "south", "east", "west", "up", "down" };
+    char	east[64];
+    int		i, n, cnt, three = 3;
+    float	one = 1;
+    unsigned	from;
+    double	start;
+
+    destroyHeapFile("bench.01");
+    createHeapFile("bench.01");
+    InsertFileScan* iScan = new InsertFileScan("bench.01", status);
+    memset(&rec, 0, sizeof(rec));
+    dbrec.data = &rec;
+    dbrec.length = sizeof(RECORD);
+    srand(46);
+    for (i = 0; i < num; i++)
+    {
+        rec.i = rand() % 8;
+        rec.f = rand() % 4;
+        strcpy(rec.s, regions[rand() % 6]);
+        iScan->insertRecord(dbrec, rid);
+    }
+    delete iScan;
+    memset(east, 0, sizeof(east));
+    strcpy(east, "east");
+
+    start = now();
+    BitmapIndex* a = new BitmapIndex("bench.01", 0, sizeof(int), INTEGER,
+                                     aName, status);
+    BitmapIndex* b = new BitmapIndex("bench.01", sizeof(int), sizeof(float),
+                                     FLOAT, bName, status);
+    BitmapIndex* c = new BitmapIndex("bench.01", 2 * sizeof(int), 64, STRING,
+                                     cName, status);
+    report("bitmap index build, 3 attributes", num, now() - start);
+    HeapFile* file = new HeapFile("bench.01", status);
+
+    ScanCond conds[3] = {
+        { 0, sizeof(int), INTEGER, EQ, (char*) &three, 0, 0 },
+        { sizeof(int), sizeof(float), FLOAT, EQ, (char*) &one, 0, 1 },
+        { 2 * sizeof(int), 64, STRING, EQ, east, 0, 2 } };
+    for (int q = 0; q < 2; q++)
+    {
+        // q 0: i = 3 AND f = 1 AND s = east, q 1: the same with s <> east
+        Bitmap sel, other;
+        start = now();
+        for (i = cnt = 0; i < rounds; i++)
+        {
+            a->select((char*) &three, EQ, sel);
+            b->select((char*) &one, EQ, other);
+            sel.intersect(other);
+            c->select(east, EQ, other);
+            if (q) sel.subtract(other);
+            else sel.intersect(other);
+            from = 0;
+            while ((n = sel.nextRids(from, rids, 256)) > 0)
+            {
+                file->getRecords(rids, n, recs);
+                cnt += n;
+            }
+        }
+        report(q ? "bitmap AND NOT, 2.6% of records"
+                 : "bitmap AND, 0.5% of records", rounds, now() - start);
+
+        conds[2].op = q ? NE : EQ;
+        HeapFileScan* scan = new HeapFileScan("bench.01", status);
+        start = now();
+        for (i = 0; i < rounds; i++)
+        {
+            scan->startScan(conds, 3);
+            scan->seekPage(0);
+            while (scan->scanNext(rid) == OK) scan->getRecord(dbrec);
+        }
+        report(q ? "filtered scan, 2.6% of records"
+                 : "filtered scan, 0.5% of records", rounds, now() - start);
+        delete scan;
+    }
+
+    delete file;
+    delete a;
+    delete b;
+    delete c;
+    db.destroyFile(aName);
+    db.destroyFile(bName);
+    db.destroyFile(cName);
+    destroyHeapFile("bench.01");
+}
+
+// range scans over records inserted in key order, so that every page
+// holds a narrow band of keys, with and without zone maps on the key.
+// also what keeping the zone maps adds to an insert
+static void benchZoneMaps(const int num, const int rounds)
+{
+    Status	status;
+    RECORD	rec;
+    Record	dbrec;
+    RID		rid;
+    ZoneAttr	attrs[2] = { { 0, INTEGER }, { sizeof(int), FLOAT } };
+    int		i, cnt, range[2];
+    double	start;
+    char	name[64];
+
+    destroyHeapFile("bench.01");
+    createHeapFile("bench.01");
+    InsertFileScan* iScan = new InsertFileScan("bench.01", status);
+    memset(&rec, 0, sizeof(rec));
+    dbrec.data = &rec;
+    dbrec.length = sizeof(RECORD);
+    start = now();
+    for (i = 0; i < num; i++)
+    {
+        rec.i = i;
+        rec.f = i;
+        iScan->insertRecord(dbrec, rid);
+    }
+    report("insert, no zone maps", num, now() - start);
+
+    start = now();
+    iScan->declareZones(attrs, 2);
+    report("zone map build, 2 attributes", num, now() - start);
+    start = now();
+    for (i = num; i < num + num / 5; i++)
+    {
+        rec.i = i;
+        rec.f = i;
+        iScan->insertRecord(dbrec, rid);
+    }
+    report("insert, zone maps kept", num / 5, now() - start);
+    delete iScan;
+
+    // 0.1% of the keys, somewhere different every round
+    HeapFileScan* scan = new HeapFileScan("bench.01", status);
+    for (int zoned = 1; zoned >= 0; zoned--)
+    {
+        if (!zoned) scan->declareZones(NULL, 0);
+        srand(47);
+        bufMgr->clearBufStats();
+        start = now();
+        for (i = cnt = 0; i < rounds; i++)
+        {
+            range[0] = rand() % num;
+            range[1] = range[0] + num / 1000 - 1;
+            scan->startScan(0, sizeof(int), INTEGER, (char*) range, BETWEEN);
+            scan->seekPage(0);
+            while (scan->scanNext(rid) == OK) cnt++;
+        }
+        sprintf(name, "range scan 0.1%%, %s, %d reads",
+                zoned ? "zone maps" : "no zones",
+                bufMgr->getBufStats().diskreads / rounds);
+        report(name, rounds, now() - start);
+    }
+    delete scan;
+    destroyHeapFile("bench.01");
+}
+
+// external sort of records in random order on an INTEGER key, with a
+// budget of a tenth of the input, on 1 to 4 threads, and the same with
+// a budget the whole input fits in.  the sorted records are written to
+// a heap file, or just streamed for the last one
+static void benchSort(const int num)
+{
+    Status	status;
+    RECORD	rec;
+    Record	dbrec;
+    RID		rid;
+    SortKey	key = { 0, sizeof(int), INTEGER };
+    int		i, pages, runs;
+    double	start;
+    char	name[64];
+
+    destroyHeapFile("bench.01");
+    createHeapFile("bench.01");
+    InsertFileScan* iScan = new InsertFileScan("bench.01", status);
+    memset(&rec, 0, sizeof(rec));
+    dbrec.data = &rec;
+    dbrec.length = sizeof(RECORD);
+    srand(48);
+    for (i = 0; i < num; i++)
+    {
+        rec.i = rand();
+        rec.f = i;
+        iScan->insertRecord(dbrec, rid);
+    }
+    pages = iScan->getPageCnt();
+    delete iScan;
+
+    for (int t = 0; t < 4; t++)
+    {
+        int threads = (t < 3) ? 1 << t : 1;
+        int memPages = (t < 3) ? pages / 10 : 2 * pages;
+        destroyHeapFile("bench.02");
+        start = now();
+        SortedFile* sf = new SortedFile("bench.01", &key, 1, memPages,
+                                        threads, status);
+        if (status == OK) status = sf->writeTo("bench.02");
+        runs = sf->getRunCnt();
+        delete sf;
+        sprintf(name, "sort to file, %d thr, %d runs", threads, runs);
+        report(name, num, now() - start);
+        if (status != OK) cerr << "sort failed\n";
+    }
+
+    start = now();
+    SortedFile* sf = new SortedFile("bench.01", &key, 1, pages / 10, 1,
+                                    status);
+    for (i = 0; sf->next(dbrec) == OK; i++) ;
+    delete sf;
+    report("sort streamed, 1 thr", i, now() - start);
+
+    destroyHeapFile("bench.02");
+    destroyHeapFile("bench.01");
+}
+
+// fill heap file name with num records whose INTEGER is drawn from
+// 0 .. keys-1, the keys in turn if keys is num
+static int loadJoinFile(const char* name, const int num, const int keys)
+{
+    Status	status;
+    RECORD	rec;
+    Record	dbrec;
+    RID		rid;
+    int		pages;
+
+    destroyHeapFile(name);
+    createHeapFile(name);
+    InsertFileScan* iScan = new InsertFileScan(name, status);
+    memset(&rec, 0, sizeof(rec));
+    dbrec.data = &rec;
+    dbrec.length = sizeof(RECORD);
+    for (int i = 0; i < num; i++)
+    {
+        rec.i = (keys == num) ? i : rand() % keys;
+        rec.f = i;
+        iScan->insertRecord(dbrec, rid);
+    }
+    pages = iScan->getPageCnt();
+    delete iScan;
+    return pages;
+}
+
+// join a file of num records with one of a tenth as many on an INTEGER
+// that half of them match, with a budget the smaller file fits in and
+// with a tenth of that, and the same on files a hundredth the size as
+// a nested loop join, rescanning the smaller file for every record of
+// the larger
+static void benchHashJoin(const int num)
+{
+    Status	status;
+    ScanColumn	attr = { 0, sizeof(int), INTEGER };
+    Record	b, p;
+    RID		rid;
+    int		pages, n, key;
+    double	start;
+    char	name[64];
+
+    srand(49);
+    pages = loadJoinFile("bench.01", num / 10, num / 10);
+    loadJoinFile("bench.02", num, num / 5);
+    for (int t = 0; t < 2; t++)
+    {
+        start = now();
+        HashJoin* hj = new HashJoin("bench.01", attr, "bench.02", attr,
+                                    t ? pages / 10 : 2 * pages, status);
+        for (n = 0; status == OK && hj->next(b, p) == OK; n++) ;
+        sprintf(name, "hash join, %d partitions, %d pairs",
+                hj->getPartCnt(), n);
+        delete hj;
+        report(name, num, now() - start);
+        if (status != OK) cerr << "join failed\n";
+    }
+
+    loadJoinFile("bench.01", num / 1000, num / 1000);
+    loadJoinFile("bench.02", num / 100, num / 500);
+    start = now();
+    HashJoin* hj = new HashJoin("bench.01", attr, "bench.02", attr, 1000,
+                                status);
+    for (n = 0; status == OK && hj->next(b, p) == OK; n++) ;
+    delete hj;
+    sprintf(name, "hash join, small files, %d pairs", n);
+    report(name, num / 100, now() - start);
+
+    start = now();
+    n = 0;
+    HeapFileScan* outer = new HeapFileScan("bench.02", status);
+    HeapFileScan* inner = new HeapFileScan("bench.01", status);
+    outer->startScan(NULL, 0);
+    while (outer->scanNext(rid) == OK)
+    {
+        outer->getRecord(p);
+        memcpy(&key, p.data, sizeof(int));
+        inner->startScan(0, sizeof(int), INTEGER, (char*) &key, EQ);
+        inner->seekPage(0);
+        while (inner->scanNext(rid) == OK)
+        {
+            inner->getRecord(b);
+            n++;
+        }
+    }
+    delete inner;
+    delete outer;
+    sprintf(name, "nested loop join, small files, %d pairs", n);
+    report(name, num / 100, now() - start);
+
+    destroyHeapFile("bench.02");
+    destroyHeapFile("bench.01");
+}
+
+// per group totals kept by the manual aggregation
+struct ManualGroup
+{
+    long long cnt, sum;
+    float min;
+};
+
+// COUNT, SUM of the INTEGER and MIN of the FLOAT of num records grouped
+// on an INTEGER with few and with many distinct values: by hand, with
+// scanNext, getRecord and a map, then with HashAggregate on 1 to 4
+// threads with a budget every thread has room for all groups in, and
+// on one with a budget too small for the many
+static void benchHashAggregate(const int num)
+{
+    Status	status;
+    RECORD	rec;
+    Record	dbrec;
+    RID		rid;
+    ScanColumn	groupBy = { 0, sizeof(int), INTEGER };
+    AggSpec	aggs[3] = { { COUNT, 0, INTEGER }, { SUM, 0, INTEGER },
+                            { MIN, sizeof(int), FLOAT } };
+    int		i, n, groupCnts[2] = { 100, num / 2 };
+    double	start;
+    char	name[64];
+
+    for (int g = 0; g < 2; g++)
+    {
+        destroyHeapFile("bench.01");
+        createHeapFile("bench.01");
+        InsertFileScan* iScan = new InsertFileScan("bench.01", status);
+        memset(&rec, 0, sizeof(rec));
+        dbrec.data = &rec;
+        dbrec.length = sizeof(RECORD);
+        srand(50);
+        for (i = 0; i < num; i++)
+        {
+            rec.i = rand() % groupCnts[g];
+            rec.f = rand() % 1000;
+            iScan->insertRecord(dbrec, rid);
+        }
+        delete iScan;
+
+        start = now();
+        map<int, ManualGroup> groups;
+        HeapFileScan* scan = new HeapFileScan("bench.01", status);
+        scan->startScan(NULL, 0);
+        while (scan->scanNext(rid) == OK)
+        {
+            scan->getRecord(dbrec);
+            memcpy(&rec, dbrec.data, sizeof(RECORD));
+            map<int, ManualGroup>::iterator it = groups.find(rec.i);
+            if (it == groups.end())
+            {
+                ManualGroup mg = { 1, rec.i, rec.f };
+                groups[rec.i] = mg;
+                continue;
+            }
+            it->second.cnt++;
+            it->second.sum += rec.i;
+            if (rec.f < it->second.min) it->second.min = rec.f;
+        }
+        delete scan;
+        sprintf(name, "manual group by, %d groups", (int) groups.size());
+        report(name, num, now() - start);
+
+        for (int t = 0; t < 4; t++)
+        {
+            int threads = (t < 3) ? 1 << t : 1;
+            int memPages = (t < 3) ? num / 5 : 100;
+            start = now();
+            scan = new HeapFileScan("bench.01", status);
+            scan->startScan(NULL, 0);
+            HashAggregate* ha = new HashAggregate(scan, &groupBy, 1, aggs, 3,
+                                                  memPages, threads, status);
+            for (n = 0; status == OK && ha->next(dbrec) == OK; n++) ;
+            sprintf(name, "hash group by, %d thr, %d parts", threads,
+                    ha->getPartCnt());
+            delete ha;
+            delete scan;
+            report(name, num, now() - start);
+            if (status != OK || n != (int) groups.size())
+                cerr << "group by failed\n";
+        }
+    }
+    destroyHeapFile("bench.01");
+}
+
+static void benchBatchDelete(const int num)
+{
+    Status	status;
+    RID		rid;
+    vector<RID>	odd;
+    double	start;
+    int		i, deleted;
+    int		half = num / 2;
+
+    loadFile("bench.01", num);
+    start = now();
+    HeapFileScan* scan = new HeapFileScan("bench.01", status);
+    scan->startScan(0, 0, INTEGER, NULL, EQ);
+    for (i = 0; scan->scanNext(rid) == OK; i++)
+        if (i % 2) scan->deleteRecord();
+    delete scan;
+    report("scan deleteRecord, every other record", num / 2, now() - start);
+
+    loadFile("bench.01", num);
+    scan = new HeapFileScan("bench.01", status);
+    scan->startScan(0, 0, INTEGER, NULL, EQ);
+    for (i = 0; scan->scanNext(rid) == OK; i++)
+        if (i % 2) odd.push_back(rid);
+    delete scan;
+    start = now();
+    HeapFile* file = new HeapFile("bench.01", status);
+    file->deleteRecords(&odd[0], odd.size(), deleted);
+    delete file;
+    report("deleteRecords, every other record", deleted, now() - start);
+
+    loadFile("bench.01", num);
+    start = now();
+    scan = new HeapFileScan("bench.01", status);
+    scan->startScan(0, sizeof(int), INTEGER, (char*) &half, LT);
+    while (scan->scanNext(rid) == OK)
+        scan->deleteRecord();
+    delete scan;
+    report("filtered scan deleteRecord, first half", half, now() - start);
+
+    loadFile("bench.01", num);
+    start = now();
+    scan = new HeapFileScan("bench.01", status);
+    scan->startScan(0, sizeof(int), INTEGER, (char*) &half, LT);
+    scan->deleteWhere(deleted);
+    delete scan;
+    report("deleteWhere, first half", deleted, now() - start);
+    destroyHeapFile("bench.01");
+}
+
+// rewrite every record of a file once, either in place through
+// HeapFileScan::updateRecord or by deleting it and inserting the new
+// version at the end of the file
+static void benchUpdate(const int num)
+{
+    Status	status;
+    RID		rid, newRid;
+    Record	dbrec;
+    RECORD	rec;
+    int		i;
+
+    loadFile("bench.01", num);
+    double start = now();
+    HeapFileScan* scan = new HeapFileScan("bench.01", status);
+    scan->startScan(0, 0, STRING, NULL, EQ);
+    for (i = 0; i < num && scan->scanNext(rid) == OK; i++)
+    {
+        scan->getRecord(dbrec);
+        memcpy(&rec, dbrec.data, sizeof(RECORD));
+        rec.f += 1;
+        dbrec.data = &rec;
+        scan->updateRecord(dbrec);
+    }
+    report("update in place", i, now() - start);
+    delete scan;
+
+    start = now();
+    scan = new HeapFileScan("bench.01", status);
+    InsertFileScan* iScan = new InsertFileScan("bench.01", status);
+    scan->startScan(0, 0, STRING, NULL, EQ);
+    for (i = 0; i < num && scan->scanNext(rid) == OK; i++)
+    {
+        scan->getRecord(dbrec);
+        memcpy(&rec, dbrec.data, sizeof(RECORD));
+        rec.f += 1;
+        dbrec.data = &rec;
+        scan->deleteRecord();
+        iScan->insertRecord(dbrec, newRid);
+    }
+    delete iScan;
+    report("update by delete+insert", i, now() - start);
+    delete scan;
+    destroyHeapFile("bench.01");
+}
+
+// UpdateFn adding 1 to RECORD.f in place
+static bool bumpFloat(void*, const Record & rec, Record &)
+{
+    ((RECORD*) rec.data)->f += 1;
+    return false;
+}
+
+// the same updates as benchUpdate done by updateWhere, with a callback
+// and with an assignment, and an assignment that makes every record
+// longer so that some of them have to move
+static void benchUpdateWhere(const int num)
+{
+    Status	status;
+    int		updated;
+    double	start;
+    ScanSet	set = { offsetof(RECORD, s), 8, "updated!" };
+    ScanSet	grow = { sizeof(RECORD), 8, "appended" };
+
+    loadFile("bench.01", num);
+    start = now();
+    HeapFileScan* scan = new HeapFileScan("bench.01", status);
+    scan->startScan(0, 0, STRING, NULL, EQ);
+    scan->updateWhere(bumpFloat, NULL, updated);
+    delete scan;
+    report("updateWhere, callback in place", updated, now() - start);
+
+    start = now();
+    scan = new HeapFileScan("bench.01", status);
+    scan->startScan(0, 0, STRING, NULL, EQ);
+    scan->updateWhere(&set, 1, updated);
+    delete scan;
+    report("updateWhere, assignment in place", updated, now() - start);
+
+    start = now();
+    scan = new HeapFileScan("bench.01", status);
+    scan->startScan(0, 0, STRING, NULL, EQ);
+    scan->updateWhere(&grow, 1, updated);
+    delete scan;
+    report("updateWhere, assignment growing", updated, now() - start);
+    destroyHeapFile("bench.01");
+}
+
+// read back large records stored natively in overflow pages and the
+// same payload split by the application into page-sized records
+static void benchLargeRecords(const int num, const int size)
+{
+    Status	status;
+    Record	dbrec;
+    RID		rid;
+    int		i, j;
+    const int	chunk = 800;
+    const int	chunks = (size + chunk - 1) / chunk;
+    char*	buf = new char[size];
+    RID*	rids = new RID[num];
+    RID*	chunkRids = new RID[num * chunks];
+
+    memset(buf, 'x', size);
+    destroyHeapFile("bench.01");
+    createHeapFile("bench.01");
+    InsertFileScan* iScan = new InsertFileScan("bench.01", status);
+    dbrec.data = buf;
+    for (i = 0; i < num; i++)
+    {
+        dbrec.length = size;
+        iScan->insertRecord(dbrec, rids[i]);
+        for (j = 0; j < chunks; j++)
+        {
+            dbrec.length = (j == chunks - 1) ? size - j * chunk : chunk;
+            iScan->insertRecord(dbrec, chunkRids[i * chunks + j]);
+        }
+    }
+    delete iScan;
+
+    HeapFile* file = new HeapFile("bench.01", status);
+    double start = now();
+    long bytes = 0;
+    for (i = 0; i < num; i++)
+    {
+        file->getRecord(rids[i], dbrec);
+        bytes += dbrec.length;
+    }
+    report("large record getRecord", num, now() - start);
+
+    start = now();
+    for (i = 0; i < num; i++)
+    {
+        for (j = 0; j < size; j += dbrec.length)
+        {
+            int got;
+            file->readRecord(rids[i], j, buf, chunk, got);
+            dbrec.length = got;
+        }
+    }
+    report("large record readRecord in chunks", num, now() - start);
+
+    start = now();
+    for (i = 0; i < num; i++)
+    {
+        for (j = 0; j < chunks; j++)
+        {
+            file->getRecord(chunkRids[i * chunks + j], dbrec);
+            memcpy(buf + j * chunk, dbrec.data, dbrec.length);
+        }
+    }
+    report("application chunked records", num, now() - start);
+    delete file;
+
+    // drop everything again, overflow pages included
+    HeapFileScan* scan = new HeapFileScan("bench.01", status);
+    scan->startScan(0, 0, STRING, NULL, EQ);
+    while (scan->scanNext(rid) == OK) scan->deleteRecord();
+    delete scan;
+    destroyHeapFile("bench.01");
+    delete [] buf;
+    delete [] rids;
+    delete [] chunkRids;
+}
+
+// load the same records one insertRecord call at a time and in
+// batches through insertRecords
+static void benchLoad(const int num, const int batch)
+{
+    Status	status;
+    RID*	rids = new RID[num];
+    Record*	recs = new Record[num];
+    RECORD*	data = new RECORD[num];
+    int		i;
+
+    memset(data, ' ', num * sizeof(RECORD));
+    for (i = 0; i < num; i++)
+    {
+        sprintf(data[i].s, "This is record %05d", i);
+        data[i].i = i;
+        data[i].f = i;
+        recs[i].data = &data[i];
+        recs[i].length = sizeof(RECORD);
+    }
+
+    destroyHeapFile("bench.01");
+    createHeapFile("bench.01");
+    double start = now();
+    InsertFileScan* iScan = new InsertFileScan("bench.01", status);
+    for (i = 0; i < num; i++) iScan->insertRecord(recs[i], rids[i]);
+    delete iScan;
+    report("load, per record insert", num, now() - start);
+    destroyHeapFile("bench.01");
+
+    createHeapFile("bench.01");
+    start = now();
+    iScan = new InsertFileScan("bench.01", status);
+    for (i = 0; i < num; i += batch)
+        iScan->insertRecords(recs + i, (num - i < batch) ? num - i : batch,
+                             rids + i);
+    delete iScan;
+    report("load, batch insert", num, now() - start);
+    destroyHeapFile("bench.01");
+
+    createHeapFile("bench.01");
+    start = now();
+    HeapFileLoader* loader = new HeapFileLoader("bench.01", status);
+    for (i = 0; i < num; i++) loader->insertRecord(recs[i], rids[i]);
+    delete loader;
+    report("load, bulk loader", num, now() - start);
+    destroyHeapFile("bench.01");
+
+    delete [] rids;
+    delete [] recs;
+    delete [] data;
+}
+
+// CSV import of num rows with a growing number of threads, against
+// parsing on one thread and inserting row by row
+static void benchImport(const int num)
+{
+    Status	status;
+    ImportAttr	attrs[3] = { { INTEGER, 0 }, { FLOAT, 0 }, { STRING, 20 } };
+    char	line[80];
+    int		i, rowCnt;
+
+    FILE* csv = fopen("bench.csv", "w");
+    for (i = 0; i < num; i++)
+        fprintf(csv, "%d,%d.5,This is row %d\n", i, i % 1000, i);
+    fclose(csv);
+
+    createHeapFile("bench.01");
+    double start = now();
+    InsertFileScan* iScan = new InsertFileScan("bench.01", status);
+    csv = fopen("bench.csv", "r");
+    char rec[28];
+    Record r;
+    RID rid;
+    r.data = rec;
+    r.length = sizeof(rec);
+    while (fgets(line, sizeof(line), csv))
+    {
+        int n;
+        float f;
+        char* str = strrchr(line, ',') + 1;
+        str[strlen(str) - 1] = '\0';
+        n = atoi(line);
+        f = atof(strchr(line, ',') + 1);
+        memcpy(rec, &n, sizeof(int));
+        memcpy(rec + 4, &f, sizeof(float));
+        memset(rec + 8, 0, 20);
+        memcpy(rec + 8, str, strlen(str));
+        iScan->insertRecord(r, rid);
+    }
+    fclose(csv);
+    delete iScan;
+    report("import, parse and insertRecord", num, now() - start);
+    destroyHeapFile("bench.01");
+
+    for (int t = 1; t <= 8; t *= 2)
+    {
+        char name[64];
+        createHeapFile("bench.01");
+        start = now();
+        importFile("bench.csv", "bench.01", CSV, attrs, 3, t, rowCnt);
+        sprintf(name, "import, importFile %d thread%s", t, t > 1 ? "s" : "");
+        report(name, rowCnt, now() - start);
+        destroyHeapFile("bench.01");
+    }
+    unlink("bench.csv");
+}
+
+int main(int argc, char **argv)
+{
+    int scale = (argc > 1) ? atoi(argv[1]) : 1;
+    if (scale < 1) scale = 1;
+
+    bufMgr = new BufMgr(101);
+
+    benchPageDelete(20000 * scale);
+    benchPageChurn(20000 * scale);
+    benchScanSparse(100000, 20 * scale);
+    benchScanBatch(1000, 2000 * scale);
+    benchPredicates(1000, 1000 * scale);
+    benchFilterKernels(1000, 1000 * scale);
+    benchStringOps(1000, 1000 * scale);
+    benchPredicateExpr(1000, 1000 * scale);
+    benchProjection(1000, 1000 * scale);
+    benchParallelScan(20000, 50 * scale);
+    benchPageDirectory(100000 * scale, 10000);
+    benchPointLookups(100000 * scale, 20000);
+    benchBatchDelete(100000 * scale);
+    benchBTree(100000 * scale, 2000);
+    benchHashIndex(100000 * scale, 20000);
+    benchBitmapIndex(100000 * scale, 20);
+    benchZoneMaps(100000 * scale, 20);
+    benchSort(100000 * scale);
+    benchHashJoin(100000 * scale);
+    benchHashAggregate(100000 * scale);
+    benchUpdate(100000 * scale);
+    benchUpdateWhere(100000 * scale);
+    benchLargeRecords(200 * scale, 64 * 1024);
+    benchLoad(200000 * scale, 1000);
+    benchImport(500000 * scale);
+
+    delete bufMgr;
+    return 0;
+}
@@ -0,0 +1,692 @@
+#include "bitmap.h"
+#include "error.h"
+
+#include <stdio.h>
+#include <algorithm>
+
+// bit pattern every FLOAT NaN key is stored as
+static const unsigned CANONICALNAN = 0x7fc00000;
+
+static inline bool testBit(const BMContainer & c, const unsigned short lo)
+{
+    return c.bits[lo >> 6] >> (lo & 63) & 1;
+}
+
+static bool inContainer(const BMContainer & c, const unsigned short lo)
+{
+    if(!c.bits.empty()) return testBit(c, lo);
+    return binary_search(c.vals.begin(), c.vals.end(), lo);
+}
+
+static void toBits(BMContainer & c)
+{
+    if(!c.bits.empty()) return;
+    c.bits.assign(BMWORDS, 0);
+    for(unsigned i = 0; i < c.vals.size(); i++)
+	c.bits[c.vals[i] >> 6] |= 1ULL << (c.vals[i] & 63);
+    vector<unsigned short>().swap(c.vals);
+}
+
+static void toArray(BMContainer & c)
+{
+    unsigned long long word;
+
+    if(c.bits.empty()) return;
+    c.vals.clear();
+    c.vals.reserve(c.card);
+    for(int w = 0; w < BMWORDS; w++)
+	for(word = c.bits[w]; word; word &= word - 1)
+	    c.vals.push_back(w * 64 + __builtin_ctzll(word));
+    vector<unsigned long long>().swap(c.bits);
+}
+
+// count the bits of a container kept as bits, and give it the form
+// its count calls for
+static void settle(BMContainer & c)
+{
+    if(!c.bits.empty()){
+	c.card = 0;
+	for(int w = 0; w < BMWORDS; w++) c.card += __builtin_popcountll(c.bits[w]);
+	if(c.card <= BMARRAYMAX) toArray(c);
+    }
+    else if(c.card > BMARRAYMAX) toBits(c);
+}
+
+const int Bitmap::find(const unsigned short key) const
+{
+    int		lo = 0, hi = conts.size(), mid;
+
+    while(lo < hi){
+	mid = (lo + hi) / 2;
+	if(conts[mid].key < key) lo = mid + 1;
+	else hi = mid;
+    }
+    return lo;
+}
+
+void Bitmap::add(const unsigned pos)
+{
+    const unsigned short key = pos >> 16, lo = pos & 0xffff;
+    int		i = find(key);
+
+    if(i == (int) conts.size() || conts[i].key != key){
+	conts.insert(conts.begin() + i, BMContainer());
+	conts[i].key = key;
+	conts[i].card = 0;
+    }
+    BMContainer & c = conts[i];
+    if(!c.bits.empty()){
+	if(testBit(c, lo)) return;
+	c.bits[lo >> 6] |= 1ULL << (lo & 63);
+	c.card++;
+	return;
+    }
+    vector<unsigned short>::iterator it = lower_bound(c.vals.begin(),
+						      c.vals.end(), lo);
+    if(it != c.vals.end() && *it == lo) return;
+    c.vals.insert(it, lo);
+    c.card++;
+    if(c.card > BMARRAYMAX) toBits(c);
+}
+
+bool Bitmap::remove(const unsigned pos)
+{
+    const unsigned short key = pos >> 16, lo = pos & 0xffff;
+    int		i = find(key);
+
+    if(i == (int) conts.size() || conts[i].key != key) return false;
+    BMContainer & c = conts[i];
+    if(!c.bits.empty()){
+	if(!testBit(c, lo)) return false;
+	c.bits[lo >> 6] &= ~(1ULL << (lo & 63));
+	if(--c.card <= BMARRAYMAX) toArray(c);
+    }
+    else{
+	vector<unsigned short>::iterator it = lower_bound(c.vals.begin(),
+							  c.vals.end(), lo);
+	if(it == c.vals.end() || *it != lo) return false;
+	c.vals.erase(it);
+	c.card--;
+    }
+    if(c.card == 0) conts.erase(conts.begin() + i);
+    return true;
+}
+
+bool Bitmap::contains(const unsigned pos) const
+{
+    int		i = find(pos >> 16);
+
+    if(i == (int) conts.size() || conts[i].key != (pos >> 16)) return false;
+    return inContainer(conts[i], pos & 0xffff);
+}
+
+const unsigned Bitmap::count() const
+{
+    unsigned	n = 0;
+
+    for(unsigned i = 0; i < conts.size(); i++) n += conts[i].card;
+    return n;
+}
+
+void Bitmap::clear()
+{
+    conts.clear();
+}
+
+// containers are matched up by key.  two arrays are merged as sorted
+// lists, an array and bits by testing each value of the array, and
+// two sets of bits a word at a time
+
+void Bitmap::intersect(const Bitmap & other)
+{
+    vector<BMContainer> out;
+    unsigned	i = 0, j = 0, k;
+    int		w;
+
+    while(i < conts.size() && j < other.conts.size()){
+	const BMContainer & a = conts[i];
+	const BMContainer & b = other.conts[j];
+	if(a.key != b.key){
+	    if(a.key < b.key) i++;
+	    else j++;
+	    continue;
+	}
+	out.push_back(BMContainer());
+	BMContainer & r = out.back();
+	r.key = a.key;
+	if(a.bits.empty() && b.bits.empty()){
+	    r.vals.resize(min(a.vals.size(), b.vals.size()));
+	    r.vals.erase(set_intersection(a.vals.begin(), a.vals.end(),
+					  b.vals.begin(), b.vals.end(),
+					  r.vals.begin()), r.vals.end());
+	    r.card = r.vals.size();
+	}
+	else if(a.bits.empty() || b.bits.empty()){
+	    const BMContainer & arr = a.bits.empty() ? a : b;
+	    const BMContainer & bits = a.bits.empty() ? b : a;
+	    for(k = 0; k < arr.vals.size(); k++)
+		if(testBit(bits, arr.vals[k])) r.vals.push_back(arr.vals[k]);
+	    r.card = r.vals.size();
+	}
+	else{
+	    r.bits.resize(BMWORDS);
+	    for(w = 0; w < BMWORDS; w++) r.bits[w] = a.bits[w] & b.bits[w];
+	    settle(r);
+	}
+	if(r.card == 0) out.pop_back();
+	i++;
+	j++;
+    }
+    conts.swap(out);
+}
+
+void Bitmap::unite(const Bitmap & other)
+{
+    vector<BMContainer> out;
+    unsigned	i = 0, j = 0, k;
+    int		w;
+
+    while(i < conts.size() || j < other.conts.size()){
+	if(j == other.conts.size() ||
+	   (i < conts.size() && conts[i].key < other.conts[j].key)){
+	    out.push_back(conts[i++]);
+	    continue;
+	}
+	if(i == conts.size() || other.conts[j].key < conts[i].key){
+	    out.push_back(other.conts[j++]);
+	    continue;
+	}
+	const BMContainer & a = conts[i];
+	const BMContainer & b = other.conts[j];
+	if(a.bits.empty() && b.bits.empty()){
+	    out.push_back(BMContainer());
+	    BMContainer & r = out.back();
+	    r.key = a.key;
+	    r.vals.resize(a.vals.size() + b.vals.size());
+	    r.vals.erase(set_union(a.vals.begin(), a.vals.end(),
+				   b.vals.begin(), b.vals.end(),
+				   r.vals.begin()), r.vals.end());
+	    r.card = r.vals.size();
+	    settle(r);
+	}
+	else{
+	    out.push_back(a.bits.empty() ? b : a);
+	    BMContainer & r = out.back();
+	    const BMContainer & s = a.bits.empty() ? a : b;
+	    if(s.bits.empty())
+		for(k = 0; k < s.vals.size(); k++)
+		    r.bits[s.vals[k] >> 6] |= 1ULL << (s.vals[k] & 63);
+	    else
+		for(w = 0; w < BMWORDS; w++) r.bits[w] |= s.bits[w];
+	    settle(r);
+	}
+	i++;
+	j++;
+    }
+    conts.swap(out);
+}
+
+void Bitmap::subtract(const Bitmap & other)
+{
+    vector<BMContainer> out;
+    unsigned	i, k;
+    int		j, w;
+
+    for(i = 0; i < conts.size(); i++){
+	BMContainer & a = conts[i];
+	j = other.find(a.key);
+	if(j == (int) other.conts.size() || other.conts[j].key != a.key){
+	    out.push_back(BMContainer());
+	    out.back().key = a.key;
+	    out.back().card = a.card;
+	    out.back().vals.swap(a.vals);
+	    out.back().bits.swap(a.bits);
+	    continue;
+	}
+	const BMContainer & b = other.conts[j];
+	if(a.bits.empty()){
+	    for(k = w = 0; k < a.vals.size(); k++)
+		if(!inContainer(b, a.vals[k])) a.vals[w++] = a.vals[k];
+	    a.vals.resize(w);
+	    a.card = w;
+	}
+	else{
+	    if(b.bits.empty())
+		for(k = 0; k < b.vals.size(); k++)
+		    a.bits[b.vals[k] >> 6] &= ~(1ULL << (b.vals[k] & 63));
+	    else
+		for(w = 0; w < BMWORDS; w++) a.bits[w] &= ~b.bits[w];
+	    settle(a);
+	}
+	if(a.card == 0) continue;
+	out.push_back(BMContainer());
+	out.back().key = a.key;
+	out.back().card = a.card;
+	out.back().vals.swap(a.vals);
+	out.back().bits.swap(a.bits);
+    }
+    conts.swap(out);
+}
+
+const int Bitmap::nextRids(unsigned & from, RID* rids, const int max) const
+{
+    unsigned	i, start, base, last = 0;
+    unsigned long long word;
+    int		n = 0, w;
+
+    for(i = find(from >> 16); i < conts.size() && n < max; i++){
+	const BMContainer & c = conts[i];
+	base = (unsigned) c.key << 16;
+	start = (c.key == (from >> 16)) ? (from & 0xffff) : 0;
+	if(!c.bits.empty()){
+	    for(w = start >> 6; w < BMWORDS && n < max; w++){
+		word = c.bits[w];
+		if(w == (int) (start >> 6)) word &= ~0ULL << (start & 63);
+		for(; word && n < max; word &= word - 1){
+		    last = base + w * 64 + __builtin_ctzll(word);
+		    rids[n++] = posToRid(last);
+		}
+	    }
+	}
+	else{
+	    vector<unsigned short>::const_iterator it =
+		lower_bound(c.vals.begin(), c.vals.end(), start);
+	    for(; it != c.vals.end() && n < max; ++it){
+		last = base + *it;
+		rids[n++] = posToRid(last);
+	    }
+	}
+    }
+    if(n > 0) from = last + 1;
+    return n;
+}
+
+static void put(vector<char> & buf, const void* p, const int n)
+{
+    buf.insert(buf.end(), (const char*) p, (const char*) p + n);
+}
+
+// the number of containers, then for each its key, count and form,
+// followed by its array or its bits
+
+void Bitmap::save(vector<char> & buf) const
+{
+    int		n = conts.size();
+    char	isBits;
+
+    put(buf, &n, sizeof(int));
+    for(unsigned i = 0; i < conts.size(); i++){
+	const BMContainer & c = conts[i];
+	isBits = !c.bits.empty();
+	put(buf, &c.key, sizeof(c.key));
+	put(buf, &c.card, sizeof(c.card));
+	put(buf, &isBits, 1);
+	if(isBits) put(buf, &c.bits[0], BMWORDS * sizeof(unsigned long long));
+	else if(c.card > 0) put(buf, &c.vals[0], c.card * sizeof(unsigned short));
+    }
+}
+
+void Bitmap::load(const char* & p)
+{
+    int		n;
+    char	isBits;
+
+    memcpy(&n, p, sizeof(int));
+    p += sizeof(int);
+    conts.assign(n, BMContainer());
+    for(int i = 0; i < n; i++){
+	BMContainer & c = conts[i];
+	memcpy(&c.key, p, sizeof(c.key));
+	p += sizeof(c.key);
+	memcpy(&c.card, p, sizeof(c.card));
+	p += sizeof(c.card);
+	isBits = *p++;
+	if(isBits){
+	    c.bits.resize(BMWORDS);
+	    memcpy(&c.bits[0], p, BMWORDS * sizeof(unsigned long long));
+	    p += BMWORDS * sizeof(unsigned long long);
+	}
+	else if(c.card > 0){
+	    c.vals.resize(c.card);
+	    memcpy(&c.vals[0], p, c.card * sizeof(unsigned short));
+	    p += c.card * sizeof(unsigned short);
+	}
+    }
+}
+
+// the index of relName is read in if it exists.  otherwise the records
+// of the relation are added to an empty one
+
+BitmapIndex::BitmapIndex(const string & relName, const int offset,
+                         const int length, const Datatype type,
+                         string & indexName, Status & status)
+{
+    Page*	page;
+    char	suffix[24];
+
+    file = NULL;
+    headerPage = NULL;
+    dirtyFlag = false;
+    keyOffset = offset;
+    keyLen = length;
+    keyType = type;
+    entryCnt = 0;
+
+    sprintf(suffix, ".%d.bitmap", offset);
+    indexName = relName + suffix;
+    if(offset < 0 || relName.size() >= MAXNAMESIZE ||
+       (type == INTEGER && length != sizeof(int)) ||
+       (type == FLOAT && length != sizeof(float)) ||
+       (type == STRING && (length < 1 || length > BMMAXKEYLEN))){
+	status = BADINDEXPARM;
+	return;
+    }
+
+    if(db.openFile(indexName, file) == OK){
+	status = file->getFirstPage(headerPageNo);
+	if(status == OK) status = bufMgr->readPage(file, headerPageNo, page);
+	if(status != OK) return;
+	headerPage = (BMHdrPage*) page;
+	if(strcmp(headerPage->relName, relName.c_str()) ||
+	   headerPage->offset != offset || headerPage->length != length ||
+	   headerPage->type != type){
+	    status = BADINDEXPARM;
+	    return;
+	}
+	status = readValues();
+	return;
+    }
+    file = NULL;
+
+    status = db.createFile(indexName);
+    if(status != OK) return;
+    status = db.openFile(indexName, file);
+    if(status != OK){
+	file = NULL;
+	return;
+    }
+    status = bufMgr->allocPage(file, headerPageNo, page);
+    if(status != OK) return;
+    headerPage = (BMHdrPage*) page;
+    strcpy(headerPage->relName, relName.c_str());
+    headerPage->offset = offset;
+    headerPage->length = length;
+    headerPage->type = type;
+    headerPage->valueCnt = 0;
+    headerPage->byteCnt = 0;
+    headerPage->firstPage = -1;
+    dirtyFlag = true;
+
+    // an index that could not be built is not left behind
+    status = build(relName);
+    if(status != OK){
+	bufMgr->unPinPage(file, headerPageNo, true);
+	headerPage = NULL;
+	db.closeFile(file);
+	file = NULL;
+	db.destroyFile(indexName);
+    }
+}
+
+const Status BitmapIndex::build(const string & relName)
+{
+    Status	status;
+    RID		rid;
+    Record	rec;
+
+    HeapFileScan* scan = new HeapFileScan(relName, status);
+    if(status == OK) status = scan->startScan(0, 0, STRING, NULL, EQ);
+    while(status == OK && (status = scan->scanNext(rid)) == OK){
+	status = scan->getRecord(rec);
+	if(status != OK || rec.length < keyOffset + keyLen) continue;
+	status = insertEntry((char*) rec.data + keyOffset, rid);
+    }
+    delete scan;
+    return (status == FILEEOF) ? OK : status;
+}
+
+BitmapIndex::~BitmapIndex()
+{
+    Status status;
+
+    if(headerPage && dirtyFlag){
+	status = writeValues();
+	if(status != OK) cerr << "error in write of bitmap index\n";
+    }
+    if(headerPage){
+	status = bufMgr->unPinPage(file, headerPageNo, true);
+	if(status != OK) cerr << "error in unpin of index header page\n";
+    }
+    if(file){
+	status = db.closeFile(file);
+	if(status != OK){
+	    cerr << "error in closefile call\n";
+	    Error e;
+	    e.print(status);
+	}
+    }
+}
+
+const int BitmapIndex::getEntryCnt() const
+{
+    return entryCnt;
+}
+
+const int BitmapIndex::getValueCnt() const
+{
+    return values.size();
+}
+
+// the bytes after the first NUL of a STRING are cleared, and -0.0 and
+// the NaNs of a FLOAT each get one bit pattern
+
+const string BitmapIndex::normalize(const char* key) const
+{
+    char	buf[BMMAXKEYLEN];
+    float	f;
+
+    switch(keyType){
+    case STRING:
+	strncpy(buf, key, keyLen);
+	break;
+    case FLOAT:
+	memcpy(&f, key, sizeof(float));
+	if(f == 0) f = 0;
+	if(f != f) memcpy(&f, &CANONICALNAN, sizeof(float));
+	memcpy(buf, &f, sizeof(float));
+	break;
+    default:
+	memcpy(buf, key, keyLen);
+    }
+    return string(buf, keyLen);
+}
+
+// the values and their bitmaps are stored one after the other in
+// pages laid out like OvflPage
+
+const Status BitmapIndex::readValues()
+{
+    Status	status;
+    Page*	page;
+    OvflPage*	dataPage;
+    int		pageNo, next, i;
+    vector<char> buf;
+    const char*	p;
+
+    pageNo = headerPage->firstPage;
+    while(pageNo != -1){
+	status = bufMgr->readPage(file, pageNo, page);
+	if(status != OK) return status;
+	dataPage = (OvflPage*) page;
+	buf.insert(buf.end(), dataPage->data, dataPage->data + dataPage->length);
+	next = dataPage->nextPage;
+	status = bufMgr->unPinPage(file, pageNo, false);
+	if(status != OK) return status;
+	pageNo = next;
+    }
+    if((int) buf.size() != headerPage->byteCnt) return BADINDEXPARM;
+
+    p = buf.data();
+    for(i = 0; i < headerPage->valueCnt; i++){
+	Bitmap & b = values[string(p, keyLen)];
+	p += keyLen;
+	b.load(p);
+	entryCnt += b.count();
+    }
+    return OK;
+}
+
+// the old pages go back to the file and the bitmaps are written to
+// new ones
+
+const Status BitmapIndex::writeValues()
+{
+    Status	status = OK, unpinstatus;
+    Page*	page;
+    OvflPage*	dataPage;
+    OvflPage*	prev = NULL;
+    int		pageNo, prevPageNo = -1, next, n;
+    unsigned	pos;
+    vector<char> buf;
+    map<string, Bitmap>::const_iterator it;
+
+    for(it = values.begin(); it != values.end(); ++it){
+	buf.insert(buf.end(), it->first.begin(), it->first.end());
+	it->second.save(buf);
+    }
+
+    pageNo = headerPage->firstPage;
+    while(pageNo != -1){
+	status = bufMgr->readPage(file, pageNo, page);
+	if(status != OK) return status;
+	next = ((OvflPage*) page)->nextPage;
+	status = bufMgr->unPinPage(file, pageNo, false);
+	if(status == OK) status = bufMgr->disposePage(file, pageNo);
+	if(status != OK) return status;
+	pageNo = next;
+    }
+    headerPage->firstPage = -1;
+
+    for(pos = 0; pos < buf.size(); pos += n){
+	status = bufMgr->allocPage(file, pageNo, page);
+	if(status != OK) break;
+	dataPage = (OvflPage*) page;
+	n = buf.size() - pos;
+	if(n > (int) OVFLDATASIZE) n = OVFLDATASIZE;
+	memcpy(dataPage->data, &buf[pos], n);
+	dataPage->length = n;
+	dataPage->nextPage = -1;
+	if(prev){
+	    prev->nextPage = pageNo;
+	    status = bufMgr->unPinPage(file, prevPageNo, true);
+	    if(status != OK) break;
+	}
+	else headerPage->firstPage = pageNo;
+	prev = dataPage;
+	prevPageNo = pageNo;
+    }
+    if(prev){
+	unpinstatus = bufMgr->unPinPage(file, prevPageNo, true);
+	if(status == OK) status = unpinstatus;
+    }
+    if(status != OK) return status;
+    headerPage->valueCnt = values.size();
+    headerPage->byteCnt = buf.size();
+    dirtyFlag = false;
+    return OK;
+}
+
+const Status BitmapIndex::insertEntry(const char* key, const RID & rid)
+{
+    if(!key) return BADINDEXPARM;
+    Bitmap & b = values[normalize(key)];
+    if(b.contains(ridToPos(rid))) return NONUNIQUEENTRY;
+    b.add(ridToPos(rid));
+    entryCnt++;
+    dirtyFlag = true;
+    return OK;
+}
+
+const Status BitmapIndex::deleteEntry(const char* key, const RID & rid)
+{
+    map<string, Bitmap>::iterator it;
+
+    if(!key) return BADINDEXPARM;
+    it = values.find(normalize(key));
+    if(it == values.end() || !it->second.remove(ridToPos(rid)))
+	return RECNOTFOUND;
+    if(it->second.count() == 0) values.erase(it);
+    entryCnt--;
+    dirtyFlag = true;
+    return OK;
+}
+
+// the filter is compiled as for a scan and tried on every value.  an
+// EQ filter only needs the one value, unless it is a NaN, which equals
+// nothing
+
+const Status BitmapIndex::select(const char* filter, const Operator op,
+                                 Bitmap & out, const int valCnt) const
+{
+    ScanCond	cond;
+    ScanTerm	term;
+    Status	status;
+    map<string, Bitmap>::const_iterator it;
+
+    out.clear();
+    cond.offset = 0;
+    cond.length = keyLen;
+    cond.type = keyType;
+    cond.op = op;
+    cond.filter = filter;
+    cond.valCnt = valCnt;
+    cond.group = 0;
+    status = compileCond(cond, term);
+    if(status != OK) return status;
+
+    if(term.op == EQ){
+	it = values.find(normalize(term.value.data()));
+	if(it != values.end() &&
+	   term.match(it->first.data(), term.value.data(), keyLen))
+	    out = it->second;
+	return OK;
+    }
+    for(it = values.begin(); it != values.end(); ++it)
+	if(term.match(it->first.data(), term.value.data(), keyLen))
+	    out.unite(it->second);
+    return OK;
+}
+
+const Status BitmapIndex::complement(Bitmap & b) const
+{
+    Bitmap	all;
+    map<string, Bitmap>::const_iterator it;
+
+    for(it = values.begin(); it != values.end(); ++it) all.unite(it->second);
+    all.subtract(b);
+    b = all;
+    return OK;
+}
+
+const Status BitmapIndex::attachTo(HeapFile & file)
+{
+    return file.attachIndex(fileChanged, this);
+}
+
+const Status BitmapIndex::detachFrom(HeapFile & file)
+{
+    return file.detachIndex(this);
+}
+
+// records too short to hold the attribute are not in the index
+
+const Status BitmapIndex::fileChanged(void* index, const Record & rec,
+                                      const RID & rid, const bool inserted)
+{
+    BitmapIndex* ix = (BitmapIndex*) index;
+
+    if(rec.length < ix->keyOffset + ix->keyLen) return OK;
+    if(inserted)
+	return ix->insertEntry((char*) rec.data + ix->keyOffset, rid);
+    return ix->deleteEntry((char*) rec.data + ix->keyOffset, rid);
+}
@@ -0,0 +1,168 @@
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <map>
+#include "heapfile.h"
+
+// Compressed bitmaps of record positions and a bitmap index built on
+// them.  The position of a record is pageNo * MAXSLOTS + slotNo, so a
+// set of records and a set of RIDs are the same thing.  A Bitmap is
+// split into containers of 2^16 positions each, in the manner of
+// roaring bitmaps: a container holding up to BMARRAYMAX positions keeps
+// them as a sorted array, a fuller one as 2^16 bits.
+
+// most positions a container keeps as an array
+const int BMARRAYMAX = 4096;
+
+// 64 bit words of a container kept as bits
+const int BMWORDS = 65536 / 64;
+
+// position of the record with RID rid, and the RID at position pos
+inline unsigned ridToPos(const RID & rid)
+{
+    return (unsigned) rid.pageNo * MAXSLOTS + rid.slotNo;
+}
+
+inline RID posToRid(const unsigned pos)
+{
+    RID rid;
+    rid.pageNo = pos / MAXSLOTS;
+    rid.slotNo = pos % MAXSLOTS;
+    return rid;
+}
+
+// the positions of a Bitmap from key * 2^16 up to key * 2^16 + 65535,
+// in vals or, when there are more than BMARRAYMAX of them, in bits
+struct BMContainer
+{
+  unsigned short	key;
+  int			card;		// number of positions
+  vector<unsigned short> vals;		// sorted, if bits is empty
+  vector<unsigned long long> bits;	// BMWORDS words, or none
+};
+
+class Bitmap
+{
+public:
+  // add position pos, which may be there already
+  void add(const unsigned pos);
+
+  // take position pos out.  false if it was not there
+  bool remove(const unsigned pos);
+
+  bool contains(const unsigned pos) const;
+
+  // number of positions
+  const unsigned count() const;
+
+  void clear();
+
+  // keep the positions that are in other as well, add those of other,
+  // and take out those of other
+  void intersect(const Bitmap & other);
+  void unite(const Bitmap & other);
+  void subtract(const Bitmap & other);
+
+  // the RIDs of up to max positions from 'from' on, in position order,
+  // from setting from to the one after the last.  returns their number,
+  // 0 once the bitmap is used up
+  const int nextRids(unsigned & from, RID* rids, const int max) const;
+
+  // append the bitmap to buf, and read one back from p, moving p past it
+  void save(vector<char> & buf) const;
+  void load(const char* & p);
+
+private:
+  vector<BMContainer> conts;	// by key
+
+  // index of the container for key, or where it would go
+  const int find(const unsigned short key) const;
+};
+
+
+// An index of the records of a heap file by the value of one of their
+// attributes, meant for attributes with few distinct values.  It holds
+// a Bitmap of the records for every value, all of them in memory while
+// the index is open.  On disk they are kept in a File named after the
+// relation and the offset of the attribute with ".bitmap" added: a
+// header page and a chain of pages holding the bitmaps one after the
+// other, written back when the index is closed if they have changed.
+
+// layout of the header page of a bitmap index file
+struct BMHdrPage
+{
+  char		relName[MAXNAMESIZE];	// relation indexed
+  int		offset;		// offset of the attribute indexed
+  int		length;		// its length
+  Datatype	type;		// and datatype
+  int		valueCnt;	// number of distinct values
+  int		byteCnt;	// bytes the bitmaps take
+  int		firstPage;	// first page of the bitmaps, -1 if none
+};
+
+// longest STRING attribute that can be indexed
+const int BMMAXKEYLEN = 128;
+
+class BitmapIndex
+{
+public:
+  // open the index on attribute (offset, length, type) of relation
+  // relName, setting indexName to the name of its file.  if there is
+  // none yet it is created and built from the records of the relation,
+  // leaving out those too short to hold the attribute
+  BitmapIndex(const string & relName, const int offset, const int length,
+              const Datatype type, string & indexName, Status & status);
+  ~BitmapIndex();
+
+  // add entry (key, rid), where key is the attribute's length bytes.
+  // NONUNIQUEENTRY if the entry is there already
+  const Status insertEntry(const char* key, const RID & rid);
+
+  // remove entry (key, rid), RECNOTFOUND if it is not there
+  const Status deleteEntry(const char* key, const RID & rid);
+
+  // set out to the records whose attribute satisfies "attr op filter",
+  // filter as in ScanCond with valCnt values for IN.  every distinct
+  // value is tested once, EQ just looks its value up
+  const Status select(const char* filter, const Operator op,
+                      Bitmap & out, const int valCnt = 0) const;
+
+  // set b to the records in the index that are not in b
+  const Status complement(Bitmap & b) const;
+
+  // keep the index up to date with the records inserted, deleted and
+  // updated through file from now on, see HeapFile::attachIndex
+  const Status attachTo(HeapFile & file);
+  const Status detachFrom(HeapFile & file);
+
+  const int getEntryCnt() const;
+  const int getValueCnt() const;
+
+private:
+  File*		file;
+  int		headerPageNo;
+  BMHdrPage*	headerPage;	// pinned while the index is open
+  bool		dirtyFlag;	// true if values differ from the file's
+  int		keyOffset;
+  int		keyLen;
+  Datatype	keyType;
+  int		entryCnt;
+  map<string, Bitmap> values;	// records of every value, by value
+
+  // the key at key in the form it is stored in, so that keys a scan
+  // with EQ finds equal are the same string
+  const string normalize(const char* key) const;
+
+  // read the bitmaps in from the file, and write them back
+  const Status readValues();
+  const Status writeValues();
+
+  // fill the new, empty index from the records of relName
+  const Status build(const string & relName);
+
+  // the IndexFn attachTo registers
+  static const Status fileChanged(void* index, const Record & rec,
+                                  const RID & rid, const bool inserted);
+};
+
+#endif
@@ -0,0 +1,712 @@
+#include "btree.h"
+#include "error.h"
+
+#include <stdio.h>
+#include <limits.h>
+#include <algorithm>
+
+// what an insert passes back up when it splits a node: the first entry
+// of the new node, which goes to the right of the old one
+struct BTSplit
+{
+  bool		happened;
+  char		key[BTMAXKEYLEN];
+  RID		rid;
+  int		pageNo;
+};
+
+// RIDs before and after all real ones, for a scan to start before or
+// after every entry of a key
+static const RID MINRID = { -1, -1 };
+static const RID MAXRID = { INT_MAX, INT_MAX };
+
+// keys are ordered as the scan operators compare them: numbers by
+// value, a NaN after all others, and strings by strncmp
+
+static int compareKeys(const Datatype type, const int length,
+                       const char* a, const char* b)
+{
+    switch(type){
+    case INTEGER: {
+	int x, y;
+	memcpy(&x, a, sizeof(int));
+	memcpy(&y, b, sizeof(int));
+	return (x < y) ? -1 : (x > y);
+    }
+    case FLOAT: {
+	float x, y;
+	memcpy(&x, a, sizeof(float));
+	memcpy(&y, b, sizeof(float));
+	if(x < y) return -1;
+	if(x > y) return 1;
+	if(x == y) return 0;
+	return (x != x) - (y != y);
+    }
+    default:
+	return strncmp(a, b, length);
+    }
+}
+
+static int compareRids(const RID & a, const RID & b)
+{
+    if(a.pageNo != b.pageNo) return (a.pageNo < b.pageNo) ? -1 : 1;
+    return (a.slotNo < b.slotNo) ? -1 : (a.slotNo > b.slotNo);
+}
+
+// index order of the entries of a bulk build, by their position
+struct BTEntryLess
+{
+  Datatype	type;
+  int		length;
+  const char*	keys;
+  const RID*	rids;
+
+  bool operator()(const int a, const int b) const
+  {
+      int c = compareKeys(type, length, keys + a * length, keys + b * length);
+      return c < 0 || (c == 0 && compareRids(rids[a], rids[b]) < 0);
+  }
+};
+
+// the index of relName is opened if it exists.  otherwise the keys of
+// all records are collected and sorted in memory and bulk loaded
+
+BTreeIndex::BTreeIndex(const string & relName, const int offset,
+                       const int length, const Datatype type,
+                       string & indexName, Status & status)
+{
+    Page*	page;
+    BTNode*	root;
+    char	suffix[16];
+    int		rootPageNo;
+
+    file = NULL;
+    headerPage = NULL;
+    hdrDirtyFlag = false;
+    scanExecuting = false;
+    curPage = NULL;
+    keyLen = length;
+    keyType = type;
+    leafCap = BTNODEDATASIZE / (length + sizeof(RID));
+    innerCap = BTNODEDATASIZE / (length + sizeof(RID) + sizeof(int));
+
+    sprintf(suffix, ".%d", offset);
+    indexName = relName + suffix;
+    if(offset < 0 || relName.size() >= MAXNAMESIZE ||
+       (type == INTEGER && length != sizeof(int)) ||
+       (type == FLOAT && length != sizeof(float)) ||
+       (type == STRING && (length < 1 || length > BTMAXKEYLEN))){
+	status = BADINDEXPARM;
+	return;
+    }
+
+    if(db.openFile(indexName, file) == OK){
+	status = file->getFirstPage(headerPageNo);
+	if(status == OK) status = bufMgr->readPage(file, headerPageNo, page);
+	if(status != OK) return;
+	headerPage = (BTHdrPage*) page;
+	if(strcmp(headerPage->relName, relName.c_str()) ||
+	   headerPage->offset != offset || headerPage->length != length ||
+	   headerPage->type != type)
+	    status = BADINDEXPARM;
+	return;
+    }
+    file = NULL;
+
+    // a new index file: a header page and an empty leaf as the root
+    status = db.createFile(indexName);
+    if(status != OK) return;
+    status = db.openFile(indexName, file);
+    if(status != OK){
+	file = NULL;
+	return;
+    }
+    status = bufMgr->allocPage(file, headerPageNo, page);
+    if(status != OK) return;
+    headerPage = (BTHdrPage*) page;
+    hdrDirtyFlag = true;
+    status = bufMgr->allocPage(file, rootPageNo, page);
+    if(status != OK) return;
+    root = (BTNode*) page;
+    root->level = 0;
+    root->cnt = 0;
+    root->next = -1;
+    status = bufMgr->unPinPage(file, rootPageNo, true);
+    if(status != OK) return;
+    strcpy(headerPage->relName, relName.c_str());
+    headerPage->offset = offset;
+    headerPage->length = length;
+    headerPage->type = type;
+    headerPage->rootPageNo = rootPageNo;
+    headerPage->height = 1;
+    headerPage->entryCnt = 0;
+
+    // an index that could not be built is not left behind
+    status = build(relName, offset);
+    if(status != OK){
+	bufMgr->unPinPage(file, headerPageNo, true);
+	headerPage = NULL;
+	db.closeFile(file);
+	file = NULL;
+	db.destroyFile(indexName);
+    }
+}
+
+const Status BTreeIndex::build(const string & relName, const int offset)
+{
+    Status	status;
+    RID		rid;
+    Record	rec;
+    vector<char> keys;
+    vector<RID>	rids;
+    int		i;
+
+    HeapFileScan* scan = new HeapFileScan(relName, status);
+    if(status == OK) status = scan->startScan(0, 0, STRING, NULL, EQ);
+    while(status == OK && (status = scan->scanNext(rid)) == OK){
+	status = scan->getRecord(rec);
+	if(status != OK || rec.length < offset + keyLen) continue;
+	keys.insert(keys.end(), (char*) rec.data + offset,
+		    (char*) rec.data + offset + keyLen);
+	rids.push_back(rid);
+    }
+    delete scan;
+    if(status != FILEEOF) return status;
+
+    BTEntryLess less = { keyType, keyLen, keys.data(), rids.data() };
+    vector<int> order(rids.size());
+    for(i = 0; i < (int) order.size(); i++) order[i] = i;
+    sort(order.begin(), order.end(), less);
+    vector<char> sortedKeys(keys.size());
+    vector<RID> sortedRids(rids.size());
+    for(i = 0; i < (int) order.size(); i++){
+	memcpy(&sortedKeys[i * keyLen], &keys[order[i] * keyLen], keyLen);
+	sortedRids[i] = rids[order[i]];
+    }
+    return bulkLoad(sortedKeys.data(), sortedRids.data(), order.size());
+}
+
+BTreeIndex::~BTreeIndex()
+{
+    Status status;
+
+    endScan();
+    if(headerPage){
+	status = bufMgr->unPinPage(file, headerPageNo, hdrDirtyFlag);
+	if(status != OK) cerr << "error in unpin of index header page\n";
+    }
+    if(file){
+	status = db.closeFile(file);
+	if(status != OK){
+	    cerr << "error in closefile call\n";
+	    Error e;
+	    e.print(status);
+	}
+    }
+}
+
+const int BTreeIndex::getEntryCnt() const
+{
+    return headerPage->entryCnt;
+}
+
+const int BTreeIndex::getHeight() const
+{
+    return headerPage->height;
+}
+
+const int BTreeIndex::compareKey(const char* ent, const char* key) const
+{
+    return compareKeys(keyType, keyLen, ent, key);
+}
+
+const int BTreeIndex::compareEntry(const char* ent, const char* key,
+                                   const RID & rid) const
+{
+    RID		entRid;
+    int		c = compareKeys(keyType, keyLen, ent, key);
+
+    if(c != 0) return c;
+    memcpy(&entRid, ent + keyLen, sizeof(RID));
+    return compareRids(entRid, rid);
+}
+
+const int BTreeIndex::entrySize(const BTNode* node) const
+{
+    return keyLen + sizeof(RID) + (node->level ? sizeof(int) : 0);
+}
+
+char* BTreeIndex::entry(BTNode* node, const int i) const
+{
+    return node->data + i * entrySize(node);
+}
+
+// binary search of a node.  an inner node is searched from its second
+// entry on, as the first one has no key
+
+const int BTreeIndex::findPos(BTNode* node, const char* key,
+                              const RID & rid) const
+{
+    int		lo, hi, mid;
+
+    if(node->level == 0){
+	lo = 0;
+	hi = node->cnt;
+	while(lo < hi){
+	    mid = (lo + hi) / 2;
+	    if(compareEntry(entry(node, mid), key, rid) < 0) lo = mid + 1;
+	    else hi = mid;
+	}
+	return lo;
+    }
+    lo = 1;
+    hi = node->cnt;
+    while(lo < hi){
+	mid = (lo + hi) / 2;
+	if(compareEntry(entry(node, mid), key, rid) <= 0) lo = mid + 1;
+	else hi = mid;
+    }
+    return lo - 1;
+}
+
+// a full node keeps the lower half of its entries, the new one
+// included, and the upper half moves to a new node to its right
+
+const Status BTreeIndex::addToNode(const int pageNo, BTNode* node,
+                                   const int pos, const char* ent,
+                                   BTSplit & split)
+{
+    char	all[BTNODEDATASIZE + BTMAXKEYLEN + sizeof(RID) + sizeof(int)];
+    const int	size = entrySize(node);
+    const int	cap = node->level ? innerCap : leafCap;
+    Status	status;
+    Page*	page;
+    BTNode*	right;
+    int		rightPageNo, total, half;
+
+    split.happened = false;
+    if(node->cnt < cap){
+	memmove(entry(node, pos + 1), entry(node, pos),
+		(node->cnt - pos) * size);
+	memcpy(entry(node, pos), ent, size);
+	node->cnt++;
+	return OK;
+    }
+
+    memcpy(all, node->data, pos * size);
+    memcpy(all + pos * size, ent, size);
+    memcpy(all + (pos + 1) * size, entry(node, pos), (node->cnt - pos) * size);
+    total = node->cnt + 1;
+    half = total / 2;
+
+    status = bufMgr->allocPage(file, rightPageNo, page);
+    if(status != OK) return status;
+    right = (BTNode*) page;
+    right->level = node->level;
+    right->cnt = total - half;
+    right->next = node->next;
+    memcpy(right->data, all + half * size, (total - half) * size);
+    node->cnt = half;
+    node->next = rightPageNo;
+    memcpy(node->data, all, half * size);
+
+    split.happened = true;
+    memcpy(split.key, right->data, keyLen);
+    memcpy(&split.rid, right->data + keyLen, sizeof(RID));
+    split.pageNo = rightPageNo;
+    return bufMgr->unPinPage(file, rightPageNo, true);
+}
+
+// the path from the root down stays pinned, so that a split below can
+// be added to the node above it
+
+const Status BTreeIndex::insertInto(const int pageNo, const char* key,
+                                    const RID & rid, BTSplit & split)
+{
+    char	ent[BTMAXKEYLEN + sizeof(RID) + sizeof(int)];
+    Status	status, unpinstatus;
+    Page*	page;
+    BTNode*	node;
+    BTSplit	below;
+    int		pos, child;
+
+    split.happened = false;
+    status = bufMgr->readPage(file, pageNo, page);
+    if(status != OK) return status;
+    node = (BTNode*) page;
+    pos = findPos(node, key, rid);
+
+    if(node->level == 0){
+	if(pos < node->cnt && compareEntry(entry(node, pos), key, rid) == 0){
+	    bufMgr->unPinPage(file, pageNo, false);
+	    return NONUNIQUEENTRY;
+	}
+	memcpy(ent, key, keyLen);
+	memcpy(ent + keyLen, &rid, sizeof(RID));
+    }
+    else{
+	memcpy(&child, entry(node, pos) + keyLen + sizeof(RID), sizeof(int));
+	status = insertInto(child, key, rid, below);
+	if(status != OK || !below.happened){
+	    unpinstatus = bufMgr->unPinPage(file, pageNo, false);
+	    return (status != OK) ? status : unpinstatus;
+	}
+	memcpy(ent, below.key, keyLen);
+	memcpy(ent + keyLen, &below.rid, sizeof(RID));
+	memcpy(ent + keyLen + sizeof(RID), &below.pageNo, sizeof(int));
+	pos++;
+    }
+
+    status = addToNode(pageNo, node, pos, ent, split);
+    unpinstatus = bufMgr->unPinPage(file, pageNo, true);
+    return (status != OK) ? status : unpinstatus;
+}
+
+const Status BTreeIndex::growRoot(const BTSplit & split)
+{
+    Status	status;
+    Page*	page;
+    BTNode*	root;
+    int		rootPageNo;
+    char*	ent;
+
+    status = bufMgr->allocPage(file, rootPageNo, page);
+    if(status != OK) return status;
+    root = (BTNode*) page;
+    root->level = headerPage->height;
+    root->cnt = 2;
+    root->next = -1;
+    ent = entry(root, 0);
+    memset(ent, 0, keyLen);
+    memcpy(ent + keyLen, &NULLRID, sizeof(RID));
+    memcpy(ent + keyLen + sizeof(RID), &headerPage->rootPageNo, sizeof(int));
+    ent = entry(root, 1);
+    memcpy(ent, split.key, keyLen);
+    memcpy(ent + keyLen, &split.rid, sizeof(RID));
+    memcpy(ent + keyLen + sizeof(RID), &split.pageNo, sizeof(int));
+
+    headerPage->rootPageNo = rootPageNo;
+    headerPage->height++;
+    hdrDirtyFlag = true;
+    return bufMgr->unPinPage(file, rootPageNo, true);
+}
+
+const Status BTreeIndex::insertEntry(const char* key, const RID & rid)
+{
+    Status	status;
+    BTSplit	split;
+
+    if(!key) return BADINDEXPARM;
+    status = insertInto(headerPage->rootPageNo, key, rid, split);
+    if(status != OK) return status;
+    if(split.happened){
+	status = growRoot(split);
+	if(status != OK) return status;
+    }
+    headerPage->entryCnt++;
+    hdrDirtyFlag = true;
+    return OK;
+}
+
+const Status BTreeIndex::findLeaf(const char* key, const RID & rid,
+                                  int & pageNo, Page* & page, int & pos)
+{
+    Status	status;
+    BTNode*	node;
+    int		child;
+
+    pageNo = headerPage->rootPageNo;
+    status = bufMgr->readPage(file, pageNo, page);
+    if(status != OK) return status;
+    node = (BTNode*) page;
+    while(node->level > 0){
+	pos = key ? findPos(node, key, rid) : 0;
+	memcpy(&child, entry(node, pos) + keyLen + sizeof(RID), sizeof(int));
+	status = bufMgr->unPinPage(file, pageNo, false);
+	if(status != OK) return status;
+	pageNo = child;
+	status = bufMgr->readPage(file, pageNo, page);
+	if(status != OK) return status;
+	node = (BTNode*) page;
+    }
+    pos = key ? findPos(node, key, rid) : 0;
+    return OK;
+}
+
+// the entry is taken out of its leaf and nothing else changes.  the
+// keys in the inner nodes only route searches, so they may well be
+// keys that are no longer in the index
+
+const Status BTreeIndex::deleteEntry(const char* key, const RID & rid)
+{
+    Status	status, unpinstatus;
+    Page*	page;
+    BTNode*	node;
+    int		pageNo, pos, size;
+
+    if(!key) return BADINDEXPARM;
+    status = findLeaf(key, rid, pageNo, page, pos);
+    if(status != OK) return status;
+    node = (BTNode*) page;
+    if(pos == node->cnt || compareEntry(entry(node, pos), key, rid) != 0){
+	unpinstatus = bufMgr->unPinPage(file, pageNo, false);
+	return (unpinstatus != OK) ? unpinstatus : RECNOTFOUND;
+    }
+    size = entrySize(node);
+    memmove(entry(node, pos), entry(node, pos + 1),
+	    (node->cnt - pos - 1) * size);
+    node->cnt--;
+    headerPage->entryCnt--;
+    hdrDirtyFlag = true;
+    return bufMgr->unPinPage(file, pageNo, true);
+}
+
+// the tree is built a level at a time from the bottom.  the root of
+// the empty index becomes the first leaf.  every node but the last of
+// a level is full, and the first entry of each node is passed up as
+// the entry for it one level higher
+
+const Status BTreeIndex::bulkLoad(const char* keys, const RID* rids,
+                                  const int cnt)
+{
+    Status	status;
+    Page*	page;
+    BTNode*	node = NULL;
+    int		level, cap, size, i, k, n;
+    int		pageNo, prevPageNo = -1;
+
+    if(cnt < 0 || (cnt > 0 && (!keys || !rids)) ||
+       headerPage->entryCnt != 0 || headerPage->height != 1)
+	return BADINDEXPARM;
+    for(i = 1; i < cnt; i++){
+	int c = compareKeys(keyType, keyLen, keys + (i - 1) * keyLen,
+			    keys + i * keyLen);
+	if(c > 0 || (c == 0 && compareRids(rids[i - 1], rids[i]) >= 0))
+	    return BADINDEXPARM;
+    }
+    if(cnt == 0) return OK;
+
+    vector<char> levelKeys(keys, keys + cnt * keyLen);
+    vector<RID> levelRids(rids, rids + cnt);
+    vector<int> children;		// empty for the leaves
+    for(level = 0; ; level++){
+	vector<char> upKeys;
+	vector<RID> upRids;
+	vector<int> upChildren;
+
+	cap = level ? innerCap : leafCap;
+	size = keyLen + sizeof(RID) + (level ? sizeof(int) : 0);
+	n = levelRids.size();
+	prevPageNo = -1;
+	for(i = 0; i < n; i += cap){
+	    if(level == 0 && i == 0){
+		pageNo = headerPage->rootPageNo;
+		status = bufMgr->readPage(file, pageNo, page);
+	    }
+	    else status = bufMgr->allocPage(file, pageNo, page);
+	    if(status != OK) return status;
+	    if(prevPageNo != -1){
+		node->next = pageNo;
+		status = bufMgr->unPinPage(file, prevPageNo, true);
+		if(status != OK) return status;
+	    }
+	    node = (BTNode*) page;
+	    node->level = level;
+	    node->cnt = min(cap, n - i);
+	    node->next = -1;
+	    for(k = 0; k < node->cnt; k++){
+		char* ent = node->data + k * size;
+		memcpy(ent, &levelKeys[(i + k) * keyLen], keyLen);
+		memcpy(ent + keyLen, &levelRids[i + k], sizeof(RID));
+		if(level) memcpy(ent + keyLen + sizeof(RID), &children[i + k],
+				 sizeof(int));
+	    }
+	    upKeys.insert(upKeys.end(), levelKeys.begin() + i * keyLen,
+			  levelKeys.begin() + (i + 1) * keyLen);
+	    upRids.push_back(levelRids[i]);
+	    upChildren.push_back(pageNo);
+	    prevPageNo = pageNo;
+	}
+	status = bufMgr->unPinPage(file, prevPageNo, true);
+	if(status != OK) return status;
+	if(upChildren.size() == 1) break;
+	levelKeys.swap(upKeys);
+	levelRids.swap(upRids);
+	children.swap(upChildren);
+    }
+
+    headerPage->rootPageNo = prevPageNo;
+    headerPage->height = level + 1;
+    headerPage->entryCnt = cnt;
+    hdrDirtyFlag = true;
+    return OK;
+}
+
+// the filter is compiled as a scan condition on an attribute that
+// starts at offset 0, the key, and tells which keys match.  what the
+// index adds is the ranges of keys outside of which none can
+
+const Status BTreeIndex::startScan(const char* filter, const Operator op,
+                                   const int valCnt)
+{
+    Status	status;
+    ScanCond	cond;
+    BTRange	r;
+    const char*	v;
+    int		i, n;
+
+    endScan();
+    cond.offset = 0;
+    cond.length = keyLen;
+    cond.type = keyType;
+    cond.op = op;
+    cond.filter = filter;
+    cond.valCnt = valCnt;
+    cond.group = 0;
+    status = compileCond(cond, term);
+    if(status != OK) return status;
+
+    ranges.clear();
+    r.hasLow = r.hasHigh = false;
+    r.lowIncl = r.highIncl = true;
+    v = term.value.data();
+    switch(term.op){
+    case LT:
+    case LTE:
+	r.hasHigh = true;
+	r.highIncl = (term.op == LTE);
+	r.high.assign(v, keyLen);
+	break;
+    case GT:
+    case GTE:
+	r.hasLow = true;
+	r.lowIncl = (term.op == GTE);
+	r.low.assign(v, keyLen);
+	break;
+    case EQ:
+	r.hasLow = r.hasHigh = true;
+	r.low.assign(v, keyLen);
+	r.high = r.low;
+	break;
+    case BETWEEN:
+	r.hasLow = r.hasHigh = true;
+	r.low.assign(v, keyLen);
+	r.high.assign(v + keyLen, keyLen);
+	break;
+    case PREFIX:
+    case LIKE:
+	// the keys that start with the literal part of the pattern lie
+	// between it padded with the lowest byte and with the highest
+	n = strcspn(v, term.op == LIKE ? "%_" : "");
+	if(n > keyLen) n = keyLen;
+	if(n > 0){
+	    r.hasLow = r.hasHigh = true;
+	    r.low.assign(v, n);
+	    r.low.resize(keyLen, '\0');
+	    r.high.assign(v, n);
+	    r.high.resize(keyLen, '\xff');
+	}
+	break;
+    default:
+	break;
+    }
+    if(term.op == IN){
+	// a range for each value, in ascending order
+	memcpy(&n, v, sizeof(int));
+	r.hasLow = r.hasHigh = true;
+	for(i = 0; i < n; i++){
+	    r.low.assign(v + sizeof(int) + i * keyLen, keyLen);
+	    r.high = r.low;
+	    ranges.push_back(r);
+	}
+    }
+    else ranges.push_back(r);
+
+    rangeIdx = 0;
+    scanExecuting = true;
+    return OK;
+}
+
+const Status BTreeIndex::startRange()
+{
+    const BTRange & r = ranges[rangeIdx];
+
+    if(!r.hasLow)
+	return findLeaf(NULL, MINRID, curPageNo, curPage, curPos);
+    return findLeaf(r.low.data(), r.lowIncl ? MINRID : MAXRID, curPageNo,
+		    curPage, curPos);
+}
+
+// the entries of a range are taken in order until one is past its
+// high bound, moving along the chain of leaves.  each is checked
+// against the filter itself, which is what NE, CONTAINS and LIKE rely on
+
+const Status BTreeIndex::scanNext(RID & outRid)
+{
+    Status	status;
+    BTNode*	node;
+    char*	ent;
+    int		next, c;
+
+    if(!scanExecuting) return BADINDEXPARM;
+    while(true){
+	if(curPage == NULL){
+	    if(rangeIdx >= ranges.size()) return NOMORERECS;
+	    status = startRange();
+	    if(status != OK){
+		curPage = NULL;
+		return status;
+	    }
+	}
+	node = (BTNode*) curPage;
+	if(curPos >= node->cnt){
+	    next = node->next;
+	    status = bufMgr->unPinPage(file, curPageNo, false);
+	    curPage = NULL;
+	    if(status != OK) return status;
+	    if(next == -1){
+		rangeIdx++;
+		continue;
+	    }
+	    status = bufMgr->readPage(file, next, curPage);
+	    if(status != OK){
+		curPage = NULL;
+		return status;
+	    }
+	    curPageNo = next;
+	    curPos = 0;
+	    continue;
+	}
+
+	ent = entry(node, curPos);
+	const BTRange & r = ranges[rangeIdx];
+	if(r.hasHigh){
+	    c = compareKey(ent, r.high.data());
+	    if(c > 0 || (c == 0 && !r.highIncl)){
+		status = bufMgr->unPinPage(file, curPageNo, false);
+		curPage = NULL;
+		if(status != OK) return status;
+		rangeIdx++;
+		continue;
+	    }
+	}
+	curPos++;
+	if(term.match(ent, term.value.data(), keyLen)){
+	    memcpy(&outRid, ent + keyLen, sizeof(RID));
+	    return OK;
+	}
+    }
+}
+
+const Status BTreeIndex::endScan()
+{
+    Status	status = OK;
+
+    if(curPage != NULL){
+	status = bufMgr->unPinPage(file, curPageNo, false);
+	curPage = NULL;
+    }
+    ranges.clear();
+    scanExecuting = false;
+    return status;
+}
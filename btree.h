@@ -0,0 +1,152 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#include "heapfile.h"
+
+// A B+tree secondary index on one attribute of a heap file.  The index
+// lives in a File of its own, named after the relation and the offset
+// of the attribute, whose pages are cached by BufMgr like those of a
+// heap file.  Entries are (key, RID) pairs ordered by key and then by
+// RID, so a key may occur any number of times while every entry is
+// unique.  The leaves are chained left to right for range scans.
+// Deletes do not merge nodes; an index that has shrunk a lot is best
+// built again.
+
+// longest STRING attribute that can be indexed
+const int BTMAXKEYLEN = 128;
+
+// layout of an index node, overlaid on a Page.  a leaf holds cnt
+// entries (key, RID).  an inner node holds cnt entries (key, RID,
+// child), where child leads to the entries from (key, RID) up to the
+// next entry's; the key and RID of the first entry are not used
+struct BTNode
+{
+  short		level;		// 0 for a leaf
+  short		cnt;		// number of entries in use
+  int		next;		// next node on the same level, -1 if none
+  char		data[PAGESIZE - 2*sizeof(short) - sizeof(int)];
+};
+
+const int BTNODEDATASIZE = PAGESIZE - 2*sizeof(short) - sizeof(int);
+
+// layout of the header page of an index file
+struct BTHdrPage
+{
+  char		relName[MAXNAMESIZE];	// relation indexed
+  int		offset;		// offset of the attribute indexed
+  int		length;		// its length
+  Datatype	type;		// and datatype
+  int		rootPageNo;
+  int		height;		// number of levels, 1 while the root is a leaf
+  int		entryCnt;	// number of entries
+};
+
+// a range of keys a scan goes over.  a missing bound is open
+struct BTRange
+{
+  string	low, high;
+  bool		hasLow, lowIncl;
+  bool		hasHigh, highIncl;
+};
+
+// what an insert passes back up when it splits a node
+struct BTSplit;
+
+class BTreeIndex
+{
+public:
+  // open the index on attribute (offset, length, type) of relation
+  // relName, setting indexName to the name of its file.  if there is
+  // none yet it is created and built from the records of the relation,
+  // leaving out those too short to hold the attribute
+  BTreeIndex(const string & relName, const int offset, const int length,
+             const Datatype type, string & indexName, Status & status);
+  ~BTreeIndex();
+
+  // add entry (key, rid), where key is the attribute's length bytes.
+  // NONUNIQUEENTRY if the entry is there already
+  const Status insertEntry(const char* key, const RID & rid);
+
+  // remove entry (key, rid), RECNOTFOUND if it is not there
+  const Status deleteEntry(const char* key, const RID & rid);
+
+  // fill an empty index with the cnt entries (keys + i * length,
+  // rids[i]), which must be in index order, without duplicates.  the
+  // leaves are packed full and the inner levels built on top of them
+  const Status bulkLoad(const char* keys, const RID* rids, const int cnt);
+
+  // look for the entries whose key satisfies "key op filter", filter
+  // as in ScanCond with valCnt values for IN.  the tree is descended to
+  // the first key in range; NE, CONTAINS and LIKE go over all the keys
+  // their filter leaves possible
+  const Status startScan(const char* filter, const Operator op,
+                         const int valCnt = 0);
+
+  // RID of the next entry, NOMORERECS after the last one
+  const Status scanNext(RID & outRid);
+
+  // terminate the scan
+  const Status endScan();
+
+  const int getEntryCnt() const;
+  const int getHeight() const;
+
+private:
+  File*		file;
+  int		headerPageNo;
+  BTHdrPage*	headerPage;	// pinned while the index is open
+  bool		hdrDirtyFlag;
+  int		keyLen;
+  Datatype	keyType;
+  int		leafCap;	// entries a leaf holds
+  int		innerCap;	// entries an inner node holds
+
+  // state of the scan
+  bool		scanExecuting;
+  ScanTerm	term;		// the compiled filter, checked on every key
+  vector<BTRange> ranges;	// key ranges still to go over
+  unsigned	rangeIdx;
+  int		curPageNo;
+  Page*		curPage;	// leaf the scan is in, pinned; NULL if none
+  int		curPos;		// next entry of curPage
+
+  // order of the key at ent and key, and of the entry at ent and
+  // (key, rid)
+  const int compareKey(const char* ent, const char* key) const;
+  const int compareEntry(const char* ent, const char* key,
+                         const RID & rid) const;
+
+  // size and address of entry i of node
+  const int entrySize(const BTNode* node) const;
+  char* entry(BTNode* node, const int i) const;
+
+  // leaf: first entry not before (key, rid).  inner node: the entry
+  // whose child holds (key, rid)
+  const int findPos(BTNode* node, const char* key, const RID & rid) const;
+
+  // put the entry at ent, of entrySize(node) bytes, at position pos of
+  // node, splitting it if it is full
+  const Status addToNode(const int pageNo, BTNode* node, const int pos,
+                         const char* ent, BTSplit & split);
+
+  // add (key, rid) to the subtree rooted at pageNo
+  const Status insertInto(const int pageNo, const char* key,
+                          const RID & rid, BTSplit & split);
+
+  // pin the leaf that holds (key, rid), or the leftmost leaf if key is
+  // NULL, and set pos to where the entry is or would go
+  const Status findLeaf(const char* key, const RID & rid, int & pageNo,
+                        Page* & page, int & pos);
+
+  // a new root over the old one and the node split off from it
+  const Status growRoot(const BTSplit & split);
+
+  // fill the new, empty index from the records of relName, the key
+  // being at offset in them
+  const Status build(const string & relName, const int offset);
+
+  // pin the leaf where ranges[rangeIdx] starts
+  const Status startRange();
+};
+
+#endif
@@ -252,14 +252,20 @@ const Status BufMgr::disposePage(File* file, const int pageNo)
 
 const Status BufMgr::allocPage(File* file, int& pageNo, Page*& page) 
 {
-    int frameNo;
-
     // allocate a new page in the file
     Status status = file->allocatePage(pageNo);
     if (status != OK)  return status; 
 
+    return pinNewPage(file, pageNo, page);
+}
+
+
+const Status BufMgr::pinNewPage(File* file, const int pageNo, Page*& page) 
+{
+    int frameNo;
+
     // alloc a new frame
-     status = allocBuf(frameNo);
+     Status status = allocBuf(frameNo);
      if (status != OK) return status;
 
      // set up the entry properly
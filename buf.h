@@ -124,6 +124,9 @@ public:
   const Status unPinPage(File* file, const int PageNo, const bool dirty);
   const Status allocPage(File* file, int& PageNo, Page*& page); 
                         // allocates a new, empty page 
+  const Status pinNewPage(File* file, const int PageNo, Page*& page);
+                        // pins a frame for a page just allocated in
+                        // file, without reading it from disk
   const Status flushFile(const File* file); // writing out all dirty pages of the file
   const Status disposePage(File* file, const int PageNo); // dispose of page in file
   void  printSelf();
@@ -12,8 +12,11 @@
 
 int BufHashTbl::hash(const File* file, const int pageNo)
 {
-  int tmp, value;
-  tmp = (long)file;  // cast of pointer to the file object to an integer
+  unsigned long tmp;
+  int value;
+  // cast of pointer to the file object to an integer.  keep it
+  // unsigned so a high address cannot produce a negative bucket
+  tmp = (unsigned long)file;
   value = (tmp + pageNo) % HTSIZE;
   return value;
 }
@@ -283,6 +283,95 @@ Status File::allocatePage(int& pageNo)
 }
 
 
+// Allocate count consecutive pages at the end of the file, numbered
+// firstPageNo onwards, with a single header update.  With zeroFill
+// the pages are cleared with a single write; otherwise nothing is
+// written and the caller must write every page it reads back (see
+// releasePages() for the ones it ends up not using).  The free list
+// is left alone; use allocatePage() to reuse disposed pages.
+
+Status File::allocatePages(int& firstPageNo, const int count,
+                           const bool zeroFill)
+{
+  Page header;
+  Status status;
+
+  if (count < 1)
+    return BADPAGENO;
+  if ((status = intread(0, &header)) != OK)
+    return status;
+
+  firstPageNo = DBP(header).numPages;
+  if (zeroFill) {
+    Page* newPages = new Page[count];
+    memset(newPages, 0, count * sizeof(Page));
+    status = writePages(firstPageNo, newPages, count);
+    delete [] newPages;
+    if (status != OK)
+      return status;
+  }
+
+  DBP(header).numPages += count;
+  if (DBP(header).firstPage == -1)
+    DBP(header).firstPage = firstPageNo;
+
+  if ((status = intwrite(0, &header)) != OK)
+    return status;
+
+#ifdef DEBUGFREE
+  listFree();
+#endif
+
+  return OK;
+}
+
+
+// Give back count consecutive pages, numbered firstPageNo onwards, that
+// were allocated with allocatePages() but are not going to be used.
+// If they are the last pages of the file it is simply shortened,
+// otherwise they are all put on the free list with a single write.
+
+const Status File::releasePages(const int firstPageNo, const int count)
+{
+  Page header;
+  Status status;
+
+  if (count < 1)
+    return OK;
+  if ((status = intread(0, &header)) != OK)
+    return status;
+  if (firstPageNo < 1 || firstPageNo + count > DBP(header).numPages)
+    return BADPAGENO;
+
+  if (firstPageNo + count == DBP(header).numPages) {
+    DBP(header).numPages = firstPageNo;
+    if (ftruncate(unixFile, firstPageNo * sizeof(Page)) < 0)
+      return UNIXERR;
+  }
+  else {
+    Page* away = new Page[count];
+    memset(away, 0, count * sizeof(Page));
+    for (int i = 0; i < count; i++)
+      DBP(away[i]).nextFree = (i + 1 < count) ? firstPageNo + i + 1
+                                              : DBP(header).nextFree;
+    status = writePages(firstPageNo, away, count);
+    delete [] away;
+    if (status != OK)
+      return status;
+    DBP(header).nextFree = firstPageNo;
+  }
+
+  if ((status = intwrite(0, &header)) != OK)
+    return status;
+
+#ifdef DEBUGFREE
+  listFree();
+#endif
+
+  return OK;
+}
+
+
 // Deallocate a page from file. The page will be put on a free
 // list and returned back to the caller upon a subsequent
 // allocPage() call.
@@ -406,6 +495,52 @@ const Status File::writePage(const int pageNo, const Page *pagePtr)
 }
 
 
+// Write count pages, stored one after the other at pages, to the
+// file as pages firstPageNo onwards using a single write.
+
+const Status File::writePages(const int firstPageNo, const Page* pages,
+                              const int count)
+{
+  if (!pages)
+    return BADPAGEPTR;
+  if (firstPageNo < 1 || count < 1)
+    return BADPAGENO;
+
+  if (lseek(unixFile, firstPageNo * sizeof(Page), SEEK_SET) == -1)
+    return UNIXERR;
+
+  int nbytes = write(unixFile, (char*)pages, count * sizeof(Page));
+  if (nbytes != (int) (count * sizeof(Page)))
+    return UNIXERR;
+
+  return OK;
+}
+
+
+// Tell the OS that the count pages listed in pageNos will be read
+// soon, so it can start reading them in.  Runs of consecutive pages
+// are passed on as one range.
+
+const Status File::prefetchPages(const int* pageNos, const int count) const
+{
+  if (!pageNos && count > 0)
+    return BADPAGEPTR;
+
+  for (int i = 0; i < count; ) {
+    int run = 1;
+    while (i + run < count && pageNos[i + run] == pageNos[i] + run)
+      run++;
+    if (pageNos[i] < 1)
+      return BADPAGENO;
+    if (posix_fadvise(unixFile, pageNos[i] * sizeof(Page), run * sizeof(Page),
+                      POSIX_FADV_WILLNEED) != 0)
+      return UNIXERR;
+    i += run;
+  }
+  return OK;
+}
+
+
 // Return the number of the first page in file. It is stored
 // on the file's header page (field firstPage).
 
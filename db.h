@@ -23,12 +23,20 @@ class File {
  public:
 
   Status allocatePage(int& pageNo);     // allocate a new page
+  Status allocatePages(int& firstPageNo, const int count,
+                       const bool zeroFill); // allocate count new pages
+  const Status releasePages(const int firstPageNo,
+                            const int count); // give back unused pages
   const Status disposePage(const int pageNo);       // release space for a page
   const Status readPage(const int pageNo,
 		  Page* pagePtr) const;       // read page from file
   const Status writePage(const int pageNo,
 		   const Page* pagePtr);      // write page to file
+  const Status writePages(const int firstPageNo, const Page* pages,
+                          const int count);   // write consecutive pages
   const Status getFirstPage(int& pageNo) const;     // returns pageNo of first page
+  const Status prefetchPages(const int* pageNos,
+                             const int count) const; // read pages ahead
 
   bool operator == (const File & other) const
     {
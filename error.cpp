@@ -77,6 +77,7 @@ void Error::print(Status status)
     case DUPLATTR:     cerr << "duplicate attribute names"; break;
     case RELEXISTS:    cerr << "relation exists already"; break;
     case NOINDEX:      cerr << "no index exists"; break;
+    case BADIMPORTFMT: cerr << "malformed import input"; break;
     case ATTRTYPEMISMATCH:   cerr << "attribute type mismatch"; break;
     case TMP_RES_EXISTS:    cerr << "temp result already exists"; break;    
     case INDEXEXISTS:  cerr << "index exists already"; break;
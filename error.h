@@ -49,6 +49,8 @@ enum Status {
 
 // Utility errors
 
+       BADIMPORTFMT,
+
 // Query errors
 
        ATTRTYPEMISMATCH, TMP_RES_EXISTS,
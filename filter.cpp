@@ -0,0 +1,434 @@
+#include "filter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FILTERX86
+#endif
+
+// plain C++ kernel, also used for the values past the last full vector
+
+template <Operator op, class T>
+static void filterScalar(const void* vals, const int n, const void* filter,
+                         unsigned long long* sel)
+{
+    const T*	v = (const T*) vals;
+    T		f;
+
+    memcpy(&f, filter, sizeof(T));
+    memset(sel, 0, SLOTMAPWORDS * sizeof(unsigned long long));
+    for (int i = 0; i < n; i++)
+	sel[i / 64] |= (unsigned long long) compareOp<op>(v[i], f) << (i % 64);
+}
+
+// the vector kernels leave values from i onwards to this
+template <Operator op, class T>
+static inline void filterTail(const T* v, int i, const int n, const T f,
+                              unsigned long long* sel)
+{
+    for (; i < n; i++)
+	sel[i / 64] |= (unsigned long long) compareOp<op>(v[i], f) << (i % 64);
+}
+
+#ifdef FILTERX86
+
+// SSE2 is part of every x86-64 CPU, so this level needs no check.
+// comparisons are built from cmpgt/cmpeq; LTE, GTE and NE are the
+// complement of GT, LT and EQ, which is right for ints.  floats use
+// the ordered compares, and an unordered one for NE, to get the same
+// answers for NaN as compareOp
+
+template <Operator op>
+static inline __m128i cmpInt4(const __m128i v, const __m128i f)
+{
+    switch(op) {
+    case LT:  return _mm_cmpgt_epi32(f, v);
+    case LTE: return _mm_xor_si128(_mm_cmpgt_epi32(v, f), _mm_set1_epi32(-1));
+    case EQ:  return _mm_cmpeq_epi32(v, f);
+    case GTE: return _mm_xor_si128(_mm_cmpgt_epi32(f, v), _mm_set1_epi32(-1));
+    case GT:  return _mm_cmpgt_epi32(v, f);
+    case NE:  return _mm_xor_si128(_mm_cmpeq_epi32(v, f), _mm_set1_epi32(-1));
+    }
+    return _mm_setzero_si128();
+}
+
+template <Operator op>
+static inline __m128 cmpFloat4(const __m128 v, const __m128 f)
+{
+    switch(op) {
+    case LT:  return _mm_cmplt_ps(v, f);
+    case LTE: return _mm_cmple_ps(v, f);
+    case EQ:  return _mm_cmpeq_ps(v, f);
+    case GTE: return _mm_cmpge_ps(v, f);
+    case GT:  return _mm_cmpgt_ps(v, f);
+    case NE:  return _mm_cmpneq_ps(v, f);
+    }
+    return _mm_setzero_ps();
+}
+
+template <Operator op>
+static void filterIntSse(const void* vals, const int n, const void* filter,
+                         unsigned long long* sel)
+{
+    const int*	v = (const int*) vals;
+    int		f;
+    int		i;
+
+    memcpy(&f, filter, sizeof(int));
+    memset(sel, 0, SLOTMAPWORDS * sizeof(unsigned long long));
+    __m128i vf = _mm_set1_epi32(f);
+    for (i = 0; i + 4 <= n; i += 4) {
+	__m128i m = cmpInt4<op>(_mm_loadu_si128((const __m128i*) (v + i)), vf);
+	sel[i / 64] |= (unsigned long long)
+		       _mm_movemask_ps(_mm_castsi128_ps(m)) << (i % 64);
+    }
+    filterTail<op>(v, i, n, f, sel);
+}
+
+template <Operator op>
+static void filterFloatSse(const void* vals, const int n, const void* filter,
+                           unsigned long long* sel)
+{
+    const float* v = (const float*) vals;
+    float	f;
+    int		i;
+
+    memcpy(&f, filter, sizeof(float));
+    memset(sel, 0, SLOTMAPWORDS * sizeof(unsigned long long));
+    __m128 vf = _mm_set1_ps(f);
+    for (i = 0; i + 4 <= n; i += 4) {
+	__m128 m = cmpFloat4<op>(_mm_loadu_ps(v + i), vf);
+	sel[i / 64] |= (unsigned long long) _mm_movemask_ps(m) << (i % 64);
+    }
+    filterTail<op>(v, i, n, f, sel);
+}
+
+// AVX2 kernels, eight values at a time.  only called once the CPU
+// has been seen to support AVX2
+
+template <Operator op>
+__attribute__((target("avx2")))
+static inline __m256i cmpInt8(const __m256i v, const __m256i f)
+{
+    switch(op) {
+    case LT:  return _mm256_cmpgt_epi32(f, v);
+    case LTE: return _mm256_xor_si256(_mm256_cmpgt_epi32(v, f),
+				      _mm256_set1_epi32(-1));
+    case EQ:  return _mm256_cmpeq_epi32(v, f);
+    case GTE: return _mm256_xor_si256(_mm256_cmpgt_epi32(f, v),
+				      _mm256_set1_epi32(-1));
+    case GT:  return _mm256_cmpgt_epi32(v, f);
+    case NE:  return _mm256_xor_si256(_mm256_cmpeq_epi32(v, f),
+				      _mm256_set1_epi32(-1));
+    }
+    return _mm256_setzero_si256();
+}
+
+template <Operator op>
+__attribute__((target("avx2")))
+static inline __m256 cmpFloat8(const __m256 v, const __m256 f)
+{
+    switch(op) {
+    case LT:  return _mm256_cmp_ps(v, f, _CMP_LT_OQ);
+    case LTE: return _mm256_cmp_ps(v, f, _CMP_LE_OQ);
+    case EQ:  return _mm256_cmp_ps(v, f, _CMP_EQ_OQ);
+    case GTE: return _mm256_cmp_ps(v, f, _CMP_GE_OQ);
+    case GT:  return _mm256_cmp_ps(v, f, _CMP_GT_OQ);
+    case NE:  return _mm256_cmp_ps(v, f, _CMP_NEQ_UQ);
+    }
+    return _mm256_setzero_ps();
+}
+
+template <Operator op>
+__attribute__((target("avx2")))
+static void filterIntAvx2(const void* vals, const int n, const void* filter,
+                          unsigned long long* sel)
+{
+    const int*	v = (const int*) vals;
+    int		f;
+    int		i;
+
+    memcpy(&f, filter, sizeof(int));
+    memset(sel, 0, SLOTMAPWORDS * sizeof(unsigned long long));
+    __m256i vf = _mm256_set1_epi32(f);
+    for (i = 0; i + 8 <= n; i += 8) {
+	__m256i m = cmpInt8<op>(_mm256_loadu_si256((const __m256i*) (v + i)),
+				vf);
+	sel[i / 64] |= (unsigned long long)
+		       _mm256_movemask_ps(_mm256_castsi256_ps(m)) << (i % 64);
+    }
+    filterTail<op>(v, i, n, f, sel);
+}
+
+template <Operator op>
+__attribute__((target("avx2")))
+static void filterFloatAvx2(const void* vals, const int n, const void* filter,
+                            unsigned long long* sel)
+{
+    const float* v = (const float*) vals;
+    float	f;
+    int		i;
+
+    memcpy(&f, filter, sizeof(float));
+    memset(sel, 0, SLOTMAPWORDS * sizeof(unsigned long long));
+    __m256 vf = _mm256_set1_ps(f);
+    for (i = 0; i + 8 <= n; i += 8) {
+	__m256 m = cmpFloat8<op>(_mm256_loadu_ps(v + i), vf);
+	sel[i / 64] |= (unsigned long long) _mm256_movemask_ps(m) << (i % 64);
+    }
+    filterTail<op>(v, i, n, f, sel);
+}
+
+#endif
+
+// STRING kernels.  the value of an attribute is its bytes up to the
+// first NUL or all length of them.  filter has been padded to at least
+// length bytes by startScan, so the attribute and the filter can both
+// be read in whole vectors as long as they stay within length
+
+// does seg, m bytes in which _ matches any byte, match s
+static inline bool segMatch(const char* s, const char* seg, const int m)
+{
+    for (int i = 0; i < m; i++)
+	if (seg[i] != s[i] && seg[i] != '_') return false;
+    return true;
+}
+
+// leftmost position at which the m bytes of needle occur in the n
+// bytes of hay, or -1.  hay may be read up to hay[limit - 1]
+
+static int findScalar(const char* hay, const int n, const int,
+                      const char* needle, const int m)
+{
+    if (n < m) return -1;
+    const char* at = (const char*) memmem(hay, n, needle, m);
+    return at ? at - hay : -1;
+}
+
+#ifdef FILTERX86
+
+// candidates are positions where the first and the last byte of the
+// needle both match, 16 positions per compare; only those get a memcmp
+
+static int findSse(const char* hay, const int n, const int limit,
+                   const char* needle, const int m)
+{
+    int		i = 0;
+
+    if (m > n) return -1;
+    __m128i first = _mm_set1_epi8(needle[0]);
+    __m128i last = _mm_set1_epi8(needle[m - 1]);
+    for (; i + 16 + m - 1 <= limit && i + m <= n; i += 16) {
+	__m128i a = _mm_loadu_si128((const __m128i*) (hay + i));
+	__m128i b = _mm_loadu_si128((const __m128i*) (hay + i + m - 1));
+	unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first),
+							_mm_cmpeq_epi8(b, last)));
+	for (; mask != 0; mask &= mask - 1) {
+	    int pos = i + __builtin_ctz(mask);
+	    if (pos + m > n) return -1;
+	    if (!memcmp(hay + pos, needle, m)) return pos;
+	}
+    }
+    int pos = findScalar(hay + i, n - i, limit - i, needle, m);
+    return (pos < 0) ? -1 : i + pos;
+}
+
+// strncmp(a, f, length) == 0 a vector at a time: within a vector the
+// first byte that either differs or is a NUL decides
+
+static inline bool strEqSse(const char* a, const char* f, const int length)
+{
+    int		i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+	__m128i va = _mm_loadu_si128((const __m128i*) (a + i));
+	__m128i vf = _mm_loadu_si128((const __m128i*) (f + i));
+	unsigned neq = ~_mm_movemask_epi8(_mm_cmpeq_epi8(va, vf)) & 0xffff;
+	unsigned nul = _mm_movemask_epi8(_mm_cmpeq_epi8(va, _mm_setzero_si128()));
+	unsigned ev = neq | nul;
+	if (ev) return !(neq & ev & -ev);
+    }
+    return !strncmp(a + i, f + i, length - i);
+}
+
+#endif
+
+template <bool vec>
+static inline int findBytes(const char* hay, const int n, const int limit,
+                            const char* needle, const int m)
+{
+#ifdef FILTERX86
+    if (vec) return findSse(hay, n, limit, needle, m);
+#endif
+    return findScalar(hay, n, limit, needle, m);
+}
+
+template <bool vec>
+static inline bool strEq(const char* a, const char* f, const int length)
+{
+#ifdef FILTERX86
+    if (vec) return strEqSse(a, f, length);
+#endif
+    return !strncmp(a, f, length);
+}
+
+template <bool vec, bool eq>
+static bool matchStrEq(const char* attr, const char* filter, const int length)
+{
+    return strEq<vec>(attr, filter, length) == eq;
+}
+
+// the pattern ends at its first NUL, at filter[length] at the latest
+// since filter is the data of a string
+
+static inline bool prefixScalar(const char* attr, const char* filter,
+                                int i, const int length)
+{
+    for (; i < length && filter[i]; i++)
+	if (attr[i] != filter[i]) return false;
+    return filter[i] == '\0';
+}
+
+template <bool vec>
+static bool matchPrefix(const char* attr, const char* filter, const int length)
+{
+    int		i = 0;
+
+#ifdef FILTERX86
+    // the bytes in front of the pattern's NUL have to be equal
+    for (; vec && i + 16 <= length; i += 16) {
+	__m128i va = _mm_loadu_si128((const __m128i*) (attr + i));
+	__m128i vf = _mm_loadu_si128((const __m128i*) (filter + i));
+	unsigned neq = ~_mm_movemask_epi8(_mm_cmpeq_epi8(va, vf)) & 0xffff;
+	unsigned nul = _mm_movemask_epi8(_mm_cmpeq_epi8(vf, _mm_setzero_si128()));
+	if (nul) return !(neq & ((nul & -nul) - 1));
+	if (neq) return false;
+    }
+    if (vec) return prefixScalar(attr, filter, i, length);
+#endif
+    int m = strlen(filter);
+    return m <= length && !memcmp(attr, filter, m);
+}
+
+template <bool vec>
+static bool matchContains(const char* attr, const char* filter,
+                          const int length)
+{
+    int m = strlen(filter);
+    if (m == 0) return true;
+    return findBytes<vec>(attr, strnlen(attr, length), length, filter, m) >= 0;
+}
+
+// the segments of the pattern between %s are matched in turn: the first
+// at the start of the value, the last at its end and every other one
+// at its leftmost place after the one before, which cannot make a match
+// fail that a later place would allow
+
+template <bool vec>
+static bool matchLike(const char* attr, const char* filter, const int length)
+{
+    int		n = strnlen(attr, length);
+    const char*	p = filter;
+    const char*	pct = strchr(p, '%');
+    int		m, pos;
+
+    if (!pct) {
+	m = strlen(p);
+	return m == n && segMatch(attr, p, m);
+    }
+    m = pct - p;
+    if (m > n || !segMatch(attr, p, m)) return false;
+    pos = m;
+
+    for (p = pct + 1; (pct = strchr(p, '%')) != NULL; p = pct + 1) {
+	m = pct - p;
+	int at = -1;
+	if (!memchr(p, '_', m))
+	    at = (m == 0) ? 0 : findBytes<vec>(attr + pos, n - pos,
+					       length - pos, p, m);
+	else
+	    for (int i = pos; i + m <= n && at < 0; i++)
+		if (segMatch(attr + i, p, m)) at = i - pos;
+	if (at < 0) return false;
+	pos += at + m;
+    }
+
+    m = strlen(p);
+    return n - m >= pos && segMatch(attr + n - m, p, m);
+}
+
+// indexed by vec, then EQ, NE, PREFIX, CONTAINS, LIKE
+
+#define STRINGFNS(vec) \
+    { matchStrEq<vec, true>, matchStrEq<vec, false>, matchPrefix<vec>, \
+      matchContains<vec>, matchLike<vec> }
+
+static const MatchFn stringFns[2][5] = { STRINGFNS(false), STRINGFNS(true) };
+
+// indexed by level, then INTEGER/FLOAT, then Operator.  levels the
+// build has no kernels for fall back to the ones below them
+
+#define SCALARFNS(T) \
+    { filterScalar<LT, T>, filterScalar<LTE, T>, filterScalar<EQ, T>, \
+      filterScalar<GTE, T>, filterScalar<GT, T>, filterScalar<NE, T> }
+#define VECTORFNS(fn) \
+    { fn<LT>, fn<LTE>, fn<EQ>, fn<GTE>, fn<GT>, fn<NE> }
+
+static const FilterFn filterFns[3][2][6] = {
+    { SCALARFNS(int), SCALARFNS(float) },
+#ifdef FILTERX86
+    { VECTORFNS(filterIntSse), VECTORFNS(filterFloatSse) },
+    { VECTORFNS(filterIntAvx2), VECTORFNS(filterFloatAvx2) }
+#else
+    { SCALARFNS(int), SCALARFNS(float) },
+    { SCALARFNS(int), SCALARFNS(float) }
+#endif
+};
+
+static FilterLevel detectLevel()
+{
+#ifdef FILTERX86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return FILTERAVX2;
+    return FILTERSSE;
+#else
+    return FILTERSCALAR;
+#endif
+}
+
+static const FilterLevel cpuLevel = detectLevel();
+static FilterLevel curLevel = cpuLevel;
+
+FilterFn pickFilter(const Datatype type, const Operator op)
+{
+    if ((type != INTEGER && type != FLOAT) || op > NE) return NULL;
+    return filterFns[curLevel][type == FLOAT][op];
+}
+
+MatchFn pickStringMatch(const Operator op)
+{
+    bool vec = (curLevel != FILTERSCALAR);
+
+    switch (op) {
+    case EQ:       return stringFns[vec][0];
+    case NE:       return stringFns[vec][1];
+    case PREFIX:   return stringFns[vec][2];
+    case CONTAINS: return stringFns[vec][3];
+    case LIKE:     return stringFns[vec][4];
+    default:       return NULL;
+    }
+}
+
+const FilterLevel bestFilterLevel()
+{
+    return cpuLevel;
+}
+
+const FilterLevel getFilterLevel()
+{
+    return curLevel;
+}
+
+void setFilterLevel(const FilterLevel level)
+{
+    curLevel = (level > cpuLevel) ? cpuLevel : level;
+}
@@ -0,0 +1,45 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "heapfile.h"
+
+// Page-at-a-time evaluation of INTEGER and FLOAT scan filters.  The
+// attribute values of the records of a page are gathered into an array
+// and compared against the filter value in one pass, setting one bit
+// per value in a selection bitmap.  Kernels exist for plain C++, SSE
+// and AVX2; which one is used is decided at run time.  STRING filters
+// that are equality tests or patterns get per-record kernels that
+// match 16 bytes at a time with SSE
+
+// instruction set levels a filter kernel can be built for
+enum FilterLevel { FILTERSCALAR, FILTERSSE, FILTERAVX2 };
+
+// kernel for type (INTEGER or FLOAT) and op at the current level
+extern FilterFn pickFilter(const Datatype type, const Operator op);
+
+// STRING kernel for EQ, NE, PREFIX, CONTAINS or LIKE at the current
+// level, NULL for the other operators
+extern MatchFn pickStringMatch(const Operator op);
+
+// the current level starts out as the best one the CPU supports.  it
+// can be lowered, as tests and benchmarks do to compare kernels
+extern const FilterLevel bestFilterLevel();
+extern const FilterLevel getFilterLevel();
+extern void setFilterLevel(const FilterLevel level);
+
+// a op b, with op known at compile time
+template <Operator op, class T>
+static inline bool compareOp(const T a, const T b)
+{
+    switch(op) {
+    case LT:  return a < b;
+    case LTE: return a <= b;
+    case EQ:  return a == b;
+    case GTE: return a >= b;
+    case GT:  return a > b;
+    case NE:  return a != b;
+    }
+    return false;
+}
+
+#endif
@@ -0,0 +1,564 @@
+#include "hashindex.h"
+#include "error.h"
+
+#include <stdio.h>
+
+// bit pattern every FLOAT NaN key is stored as
+static const unsigned CANONICALNAN = 0x7fc00000;
+
+// the index of relName is opened if it exists.  otherwise it starts
+// out as one empty bucket and the records are inserted one by one
+
+HashIndex::HashIndex(const string & relName, const int offset,
+                     const int length, const Datatype type,
+                     string & indexName, Status & status)
+{
+    Page*	page;
+    HashBucket*	bucket;
+    char	suffix[24];
+    int		bucketPageNo;
+
+    file = NULL;
+    headerPage = NULL;
+    hdrDirtyFlag = false;
+    dirDirtyFlag = false;
+    scanExecuting = false;
+    curPage = NULL;
+    keyOffset = offset;
+    keyLen = length;
+    keyType = type;
+    bucketCap = HASHBUCKETDATASIZE / (length + sizeof(RID));
+
+    sprintf(suffix, ".%d.hash", offset);
+    indexName = relName + suffix;
+    if(offset < 0 || relName.size() >= MAXNAMESIZE ||
+       (type == INTEGER && length != sizeof(int)) ||
+       (type == FLOAT && length != sizeof(float)) ||
+       (type == STRING && (length < 1 || length > HASHMAXKEYLEN))){
+	status = BADINDEXPARM;
+	return;
+    }
+
+    if(db.openFile(indexName, file) == OK){
+	status = file->getFirstPage(headerPageNo);
+	if(status == OK) status = bufMgr->readPage(file, headerPageNo, page);
+	if(status != OK) return;
+	headerPage = (HashHdrPage*) page;
+	if(strcmp(headerPage->relName, relName.c_str()) ||
+	   headerPage->offset != offset || headerPage->length != length ||
+	   headerPage->type != type){
+	    status = BADINDEXPARM;
+	    return;
+	}
+	status = readDirectory();
+	return;
+    }
+    file = NULL;
+
+    // a new index file: a header page and a single empty bucket
+    status = db.createFile(indexName);
+    if(status != OK) return;
+    status = db.openFile(indexName, file);
+    if(status != OK){
+	file = NULL;
+	return;
+    }
+    status = bufMgr->allocPage(file, headerPageNo, page);
+    if(status != OK) return;
+    headerPage = (HashHdrPage*) page;
+    hdrDirtyFlag = true;
+    status = bufMgr->allocPage(file, bucketPageNo, page);
+    if(status != OK) return;
+    bucket = (HashBucket*) page;
+    bucket->depth = 0;
+    bucket->cnt = 0;
+    bucket->next = -1;
+    status = bufMgr->unPinPage(file, bucketPageNo, true);
+    if(status != OK) return;
+    strcpy(headerPage->relName, relName.c_str());
+    headerPage->offset = offset;
+    headerPage->length = length;
+    headerPage->type = type;
+    headerPage->depth = 0;
+    headerPage->entryCnt = 0;
+    headerPage->dirPageCnt = 0;
+    dir.assign(1, bucketPageNo);
+    dirDirtyFlag = true;
+
+    // an index that could not be built is not left behind
+    status = build(relName);
+    if(status != OK){
+	bufMgr->unPinPage(file, headerPageNo, true);
+	headerPage = NULL;
+	db.closeFile(file);
+	file = NULL;
+	db.destroyFile(indexName);
+    }
+}
+
+const Status HashIndex::build(const string & relName)
+{
+    Status	status;
+    RID		rid;
+    Record	rec;
+
+    HeapFileScan* scan = new HeapFileScan(relName, status);
+    if(status == OK) status = scan->startScan(0, 0, STRING, NULL, EQ);
+    while(status == OK && (status = scan->scanNext(rid)) == OK){
+	status = scan->getRecord(rec);
+	if(status != OK || rec.length < keyOffset + keyLen) continue;
+	status = insertEntry((char*) rec.data + keyOffset, rid);
+    }
+    delete scan;
+    return (status == FILEEOF) ? OK : status;
+}
+
+HashIndex::~HashIndex()
+{
+    Status status;
+
+    endScan();
+    if(headerPage && dirDirtyFlag){
+	status = writeDirectory();
+	if(status != OK) cerr << "error in write of index directory\n";
+    }
+    if(headerPage){
+	status = bufMgr->unPinPage(file, headerPageNo, hdrDirtyFlag);
+	if(status != OK) cerr << "error in unpin of index header page\n";
+    }
+    if(file){
+	status = db.closeFile(file);
+	if(status != OK){
+	    cerr << "error in closefile call\n";
+	    Error e;
+	    e.print(status);
+	}
+    }
+}
+
+const int HashIndex::getEntryCnt() const
+{
+    return headerPage->entryCnt;
+}
+
+const int HashIndex::getDepth() const
+{
+    return headerPage->depth;
+}
+
+const Status HashIndex::readDirectory()
+{
+    Status	status;
+    Page*	page;
+    int		i, n, left;
+
+    dir.resize(1 << headerPage->depth);
+    left = dir.size();
+    for(i = 0; i < headerPage->dirPageCnt && left > 0; i++){
+	status = bufMgr->readPage(file, headerPage->dirPageNos[i], page);
+	if(status != OK) return status;
+	n = (left < HASHDIRPAGESIZE) ? left : HASHDIRPAGESIZE;
+	memcpy(&dir[i * HASHDIRPAGESIZE], page, n * sizeof(int));
+	left -= n;
+	status = bufMgr->unPinPage(file, headerPage->dirPageNos[i], false);
+	if(status != OK) return status;
+    }
+    return (left > 0) ? BADINDEXPARM : OK;
+}
+
+// the directory only ever grows, so its pages are only ever added
+
+const Status HashIndex::writeDirectory()
+{
+    Status	status;
+    Page*	page;
+    int		i, n, pageNo;
+    const int	pageCnt = (dir.size() + HASHDIRPAGESIZE - 1) / HASHDIRPAGESIZE;
+
+    for(i = 0; i < pageCnt; i++){
+	if(i < headerPage->dirPageCnt){
+	    pageNo = headerPage->dirPageNos[i];
+	    status = bufMgr->readPage(file, pageNo, page);
+	}
+	else{
+	    status = bufMgr->allocPage(file, pageNo, page);
+	    if(status == OK){
+		headerPage->dirPageNos[i] = pageNo;
+		headerPage->dirPageCnt++;
+		hdrDirtyFlag = true;
+	    }
+	}
+	if(status != OK) return status;
+	n = dir.size() - i * HASHDIRPAGESIZE;
+	if(n > HASHDIRPAGESIZE) n = HASHDIRPAGESIZE;
+	memcpy((char*) page, &dir[i * HASHDIRPAGESIZE], n * sizeof(int));
+	status = bufMgr->unPinPage(file, pageNo, true);
+	if(status != OK) return status;
+    }
+    dirDirtyFlag = false;
+    return OK;
+}
+
+// keys that a scan with EQ finds equal must hash alike: the bytes of
+// a STRING after its first NUL are cleared, and -0.0 and the NaNs of
+// a FLOAT each get one bit pattern
+
+void HashIndex::normalize(const char* key, char* out) const
+{
+    float	f;
+
+    switch(keyType){
+    case STRING:
+	strncpy(out, key, keyLen);
+	break;
+    case FLOAT:
+	memcpy(&f, key, sizeof(float));
+	if(f == 0) f = 0;
+	if(f != f) memcpy(&f, &CANONICALNAN, sizeof(float));
+	memcpy(out, &f, sizeof(float));
+	break;
+    default:
+	memcpy(out, key, keyLen);
+    }
+}
+
+const unsigned HashIndex::hashKey(const char* key) const
+{
+    return hashBytes(key, keyLen);
+}
+
+char* HashIndex::entry(HashBucket* bucket, const int i) const
+{
+    return bucket->data + i * (keyLen + sizeof(RID));
+}
+
+const Status HashIndex::sameHash(const int pageNo, const unsigned hash,
+                                 bool & same)
+{
+    const unsigned mask = (1u << HASHMAXDEPTH) - 1;
+    Status	status;
+    Page*	page;
+    HashBucket*	bucket;
+    int		i, cur, next = pageNo;
+
+    same = true;
+    while(next != -1 && same){
+	status = bufMgr->readPage(file, next, page);
+	if(status != OK) return status;
+	bucket = (HashBucket*) page;
+	for(i = 0; i < bucket->cnt && same; i++)
+	    same = ((hashKey(entry(bucket, i)) ^ hash) & mask) == 0;
+	cur = next;
+	next = bucket->next;
+	status = bufMgr->unPinPage(file, cur, false);
+	if(status != OK) return status;
+    }
+    return OK;
+}
+
+// the entries of the bucket's chain are gathered and dealt out again
+// by the next bit of their hash, the overflow pages going back to the
+// file.  either half may still need overflow pages of its own
+
+const Status HashIndex::splitBucket(const int slot)
+{
+    const int	size = keyLen + sizeof(RID);
+    Status	status, unpinstatus;
+    Page*	page;
+    HashBucket*	halves[2];	// last page of each half's chain
+    HashBucket*	bucket;
+    int		pageNos[2], firstPageNos[2];
+    int		i, n, half, depth, next, newNext;
+    vector<char> ents;
+
+    pageNos[0] = dir[slot];
+    status = bufMgr->readPage(file, pageNos[0], page);
+    if(status != OK) return status;
+    halves[0] = (HashBucket*) page;
+    depth = halves[0]->depth;
+    if(depth == headerPage->depth){
+	if(depth == HASHMAXDEPTH){
+	    bufMgr->unPinPage(file, pageNos[0], false);
+	    return DIROVERFLOW;
+	}
+	n = dir.size();
+	dir.resize(2 * n);
+	for(i = 0; i < n; i++) dir[n + i] = dir[i];
+	headerPage->depth++;
+	hdrDirtyFlag = true;
+    }
+
+    ents.assign(halves[0]->data, halves[0]->data + halves[0]->cnt * size);
+    next = halves[0]->next;
+    while(next != -1){
+	status = bufMgr->readPage(file, next, page);
+	if(status != OK) break;
+	bucket = (HashBucket*) page;
+	ents.insert(ents.end(), bucket->data, bucket->data + bucket->cnt * size);
+	newNext = bucket->next;
+	status = bufMgr->unPinPage(file, next, false);
+	if(status == OK) status = bufMgr->disposePage(file, next);
+	if(status != OK) break;
+	next = newNext;
+    }
+    if(status == OK) status = bufMgr->allocPage(file, pageNos[1], page);
+    if(status != OK){
+	bufMgr->unPinPage(file, pageNos[0], false);
+	return status;
+    }
+    halves[1] = (HashBucket*) page;
+    for(half = 0; half < 2; half++){
+	halves[half]->depth = depth + 1;
+	halves[half]->cnt = 0;
+	halves[half]->next = -1;
+    }
+
+    // a half that fills up continues on a new overflow page
+    firstPageNos[0] = pageNos[0];
+    firstPageNos[1] = pageNos[1];
+    n = ents.size() / size;
+    for(i = 0; i < n && status == OK; i++){
+	half = (hashKey(&ents[i * size]) >> depth) & 1;
+	if(halves[half]->cnt == bucketCap){
+	    status = bufMgr->allocPage(file, newNext, page);
+	    if(status != OK) break;
+	    halves[half]->next = newNext;
+	    status = bufMgr->unPinPage(file, pageNos[half], true);
+	    halves[half] = (HashBucket*) page;
+	    pageNos[half] = newNext;
+	    halves[half]->depth = depth + 1;
+	    halves[half]->cnt = 0;
+	    halves[half]->next = -1;
+	    if(status != OK) break;
+	}
+	memcpy(entry(halves[half], halves[half]->cnt), &ents[i * size], size);
+	halves[half]->cnt++;
+    }
+    for(half = 0; half < 2; half++){
+	unpinstatus = bufMgr->unPinPage(file, pageNos[half], true);
+	if(status == OK) status = unpinstatus;
+    }
+    if(status != OK) return status;
+
+    // the directory entries of the old bucket with the new bit set
+    // now lead to the new one
+    for(i = 0; i < (int) dir.size(); i++)
+	if(dir[i] == firstPageNos[0] && ((i >> depth) & 1))
+	    dir[i] = firstPageNos[1];
+    dirDirtyFlag = true;
+    return OK;
+}
+
+// the chain of the key's bucket is searched for the entry and for
+// room.  a full chain is split until the key's bucket has room, unless
+// its keys all hash alike or the directory is as deep as it can go;
+// then the chain grows by an overflow page
+
+const Status HashIndex::insertEntry(const char* key, const RID & rid)
+{
+    char	k[HASHMAXKEYLEN];
+    Status	status, unpinstatus;
+    Page*	page;
+    HashBucket*	bucket;
+    unsigned	hash;
+    int		i, slot, pageNo, roomPageNo, depth, newPageNo;
+    int		lastPageNo = -1;
+    RID		entRid;
+    bool	same;
+
+    if(!key) return BADINDEXPARM;
+    normalize(key, k);
+    hash = hashKey(k);
+
+    while(true){
+	slot = hash & (dir.size() - 1);
+	pageNo = dir[slot];
+	roomPageNo = -1;
+	depth = -1;
+	while(pageNo != -1){
+	    status = bufMgr->readPage(file, pageNo, page);
+	    if(status != OK) return status;
+	    bucket = (HashBucket*) page;
+	    if(depth < 0) depth = bucket->depth;
+	    for(i = 0; i < bucket->cnt; i++){
+		memcpy(&entRid, entry(bucket, i) + keyLen, sizeof(RID));
+		if(entRid.pageNo == rid.pageNo && entRid.slotNo == rid.slotNo &&
+		   !memcmp(entry(bucket, i), k, keyLen)){
+		    bufMgr->unPinPage(file, pageNo, false);
+		    return NONUNIQUEENTRY;
+		}
+	    }
+	    if(roomPageNo < 0 && bucket->cnt < bucketCap) roomPageNo = pageNo;
+	    lastPageNo = pageNo;
+	    pageNo = bucket->next;
+	    status = bufMgr->unPinPage(file, lastPageNo, false);
+	    if(status != OK) return status;
+	}
+	if(roomPageNo >= 0) break;
+
+	same = true;
+	if(depth < HASHMAXDEPTH){
+	    status = sameHash(dir[slot], hash, same);
+	    if(status != OK) return status;
+	}
+	if(same) break;
+	status = splitBucket(slot);
+	if(status != OK) return status;
+    }
+
+    if(roomPageNo < 0){
+	status = bufMgr->allocPage(file, newPageNo, page);
+	if(status != OK) return status;
+	bucket = (HashBucket*) page;
+	bucket->depth = depth;
+	bucket->cnt = 0;
+	bucket->next = -1;
+	status = bufMgr->unPinPage(file, newPageNo, true);
+	if(status == OK) status = bufMgr->readPage(file, lastPageNo, page);
+	if(status != OK) return status;
+	((HashBucket*) page)->next = newPageNo;
+	status = bufMgr->unPinPage(file, lastPageNo, true);
+	if(status != OK) return status;
+	roomPageNo = newPageNo;
+    }
+
+    status = bufMgr->readPage(file, roomPageNo, page);
+    if(status != OK) return status;
+    bucket = (HashBucket*) page;
+    memcpy(entry(bucket, bucket->cnt), k, keyLen);
+    memcpy(entry(bucket, bucket->cnt) + keyLen, &rid, sizeof(RID));
+    bucket->cnt++;
+    unpinstatus = bufMgr->unPinPage(file, roomPageNo, true);
+    if(unpinstatus != OK) return unpinstatus;
+    headerPage->entryCnt++;
+    hdrDirtyFlag = true;
+    return OK;
+}
+
+// the last entry of the page takes the place of the one deleted.  an
+// overflow page that empties stays in its chain
+
+const Status HashIndex::deleteEntry(const char* key, const RID & rid)
+{
+    char	k[HASHMAXKEYLEN];
+    const int	size = keyLen + sizeof(RID);
+    Status	status;
+    Page*	page;
+    HashBucket*	bucket;
+    int		i, pageNo, next;
+    RID		entRid;
+
+    if(!key) return BADINDEXPARM;
+    normalize(key, k);
+    pageNo = dir[hashKey(k) & (dir.size() - 1)];
+    while(pageNo != -1){
+	status = bufMgr->readPage(file, pageNo, page);
+	if(status != OK) return status;
+	bucket = (HashBucket*) page;
+	for(i = 0; i < bucket->cnt; i++){
+	    memcpy(&entRid, entry(bucket, i) + keyLen, sizeof(RID));
+	    if(entRid.pageNo == rid.pageNo && entRid.slotNo == rid.slotNo &&
+	       !memcmp(entry(bucket, i), k, keyLen))
+		break;
+	}
+	if(i < bucket->cnt){
+	    bucket->cnt--;
+	    memcpy(entry(bucket, i), entry(bucket, bucket->cnt), size);
+	    headerPage->entryCnt--;
+	    hdrDirtyFlag = true;
+	    return bufMgr->unPinPage(file, pageNo, true);
+	}
+	next = bucket->next;
+	status = bufMgr->unPinPage(file, pageNo, false);
+	if(status != OK) return status;
+	pageNo = next;
+    }
+    return RECNOTFOUND;
+}
+
+const Status HashIndex::startScan(const char* key)
+{
+    float	f;
+
+    endScan();
+    if(!key) return BADINDEXPARM;
+    normalize(key, scanKey);
+    scanExecuting = true;
+    nextPageNo = dir[hashKey(scanKey) & (dir.size() - 1)];
+    curPos = 0;
+
+    // a NaN equals nothing, not even itself
+    if(keyType == FLOAT){
+	memcpy(&f, scanKey, sizeof(float));
+	if(f != f) nextPageNo = -1;
+    }
+    return OK;
+}
+
+const Status HashIndex::scanNext(RID & outRid)
+{
+    Status	status;
+    HashBucket*	bucket;
+    char*	ent;
+
+    if(!scanExecuting) return BADSCANPARM;
+    while(true){
+	if(curPage == NULL){
+	    if(nextPageNo == -1) return NOMORERECS;
+	    status = bufMgr->readPage(file, nextPageNo, curPage);
+	    if(status != OK){
+		curPage = NULL;
+		return status;
+	    }
+	    curPageNo = nextPageNo;
+	    curPos = 0;
+	}
+	bucket = (HashBucket*) curPage;
+	while(curPos < bucket->cnt){
+	    ent = entry(bucket, curPos++);
+	    if(!memcmp(ent, scanKey, keyLen)){
+		memcpy(&outRid, ent + keyLen, sizeof(RID));
+		return OK;
+	    }
+	}
+	nextPageNo = bucket->next;
+	curPage = NULL;
+	status = bufMgr->unPinPage(file, curPageNo, false);
+	if(status != OK) return status;
+    }
+}
+
+const Status HashIndex::endScan()
+{
+    Status	status = OK;
+
+    if(curPage){
+	status = bufMgr->unPinPage(file, curPageNo, false);
+	curPage = NULL;
+    }
+    scanExecuting = false;
+    return status;
+}
+
+const Status HashIndex::attachTo(HeapFile & file)
+{
+    return file.attachIndex(fileChanged, this);
+}
+
+const Status HashIndex::detachFrom(HeapFile & file)
+{
+    return file.detachIndex(this);
+}
+
+// records too short to hold the attribute are not in the index
+
+const Status HashIndex::fileChanged(void* index, const Record & rec,
+                                    const RID & rid, const bool inserted)
+{
+    HashIndex*	ix = (HashIndex*) index;
+
+    if(rec.length < ix->keyOffset + ix->keyLen) return OK;
+    if(inserted)
+	return ix->insertEntry((char*) rec.data + ix->keyOffset, rid);
+    return ix->deleteEntry((char*) rec.data + ix->keyOffset, rid);
+}
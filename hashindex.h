@@ -0,0 +1,145 @@
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+#include "heapfile.h"
+
+// An extendible hash index on one attribute of a heap file, for
+// equality lookups.  Like a BTreeIndex it lives in a File of its own,
+// named after the relation and the offset of the attribute with
+// ".hash" added, whose pages are cached by BufMgr.  A directory of
+// 2^depth bucket page numbers is indexed by the low depth bits of the
+// hash of a key; it is kept in memory while the index is open and in
+// directory pages listed by the header page in between.  A lookup thus
+// reads one bucket page, plus the overflow pages of a bucket that
+// holds more entries of one key than fit on a page.  Entries are
+// (key, RID) pairs, a key may occur any number of times.  A full
+// bucket is split in two, doubling the directory when it has to.
+// Deletes do not merge buckets.
+
+// longest STRING attribute that can be indexed
+const int HASHMAXKEYLEN = 128;
+
+// layout of a bucket page, overlaid on a Page.  the cnt entries are
+// (key, RID) pairs in no particular order.  next chains overflow pages
+// to the bucket; only the first page of a chain is in the directory
+struct HashBucket
+{
+  short		depth;		// number of hash bits its keys share
+  short		cnt;		// number of entries in use
+  int		next;		// next page of the chain, -1 if none
+  char		data[PAGESIZE - 2*sizeof(short) - sizeof(int)];
+};
+
+const int HASHBUCKETDATASIZE = PAGESIZE - 2*sizeof(short) - sizeof(int);
+
+// bucket page numbers a directory page holds
+const int HASHDIRPAGESIZE = PAGESIZE / sizeof(int);
+
+// directory pages the header page can list
+const int HASHMAXDIRPAGES = (PAGESIZE - MAXNAMESIZE - 8*sizeof(int))
+                            / sizeof(int);
+
+// deepest directory those pages hold.  beyond it a full bucket gets
+// overflow pages instead of being split
+const int HASHMAXDEPTH = 15;
+
+// layout of the header page of an index file
+struct HashHdrPage
+{
+  char		relName[MAXNAMESIZE];	// relation indexed
+  int		offset;		// offset of the attribute indexed
+  int		length;		// its length
+  Datatype	type;		// and datatype
+  int		depth;		// the directory has 2^depth entries
+  int		entryCnt;	// number of entries
+  int		dirPageCnt;	// directory pages in use
+  int		dirPageNos[HASHMAXDIRPAGES];
+};
+
+class HashIndex
+{
+public:
+  // open the index on attribute (offset, length, type) of relation
+  // relName, setting indexName to the name of its file.  if there is
+  // none yet it is created and built from the records of the relation,
+  // leaving out those too short to hold the attribute
+  HashIndex(const string & relName, const int offset, const int length,
+            const Datatype type, string & indexName, Status & status);
+  ~HashIndex();
+
+  // add entry (key, rid), where key is the attribute's length bytes.
+  // NONUNIQUEENTRY if the entry is there already
+  const Status insertEntry(const char* key, const RID & rid);
+
+  // remove entry (key, rid), RECNOTFOUND if it is not there
+  const Status deleteEntry(const char* key, const RID & rid);
+
+  // look for the entries whose key equals key, compared as a scan with
+  // EQ would: a STRING key ends at its first NUL and may be shorter
+  // than the attribute, and a FLOAT NaN equals nothing
+  const Status startScan(const char* key);
+
+  // RID of the next entry, NOMORERECS after the last one
+  const Status scanNext(RID & outRid);
+
+  // terminate the scan
+  const Status endScan();
+
+  // keep the index up to date with the records inserted, deleted and
+  // updated through file from now on, see HeapFile::attachIndex
+  const Status attachTo(HeapFile & file);
+  const Status detachFrom(HeapFile & file);
+
+  const int getEntryCnt() const;
+  const int getDepth() const;
+
+private:
+  File*		file;
+  int		headerPageNo;
+  HashHdrPage*	headerPage;	// pinned while the index is open
+  bool		hdrDirtyFlag;
+  int		keyOffset;
+  int		keyLen;
+  Datatype	keyType;
+  int		bucketCap;	// entries a bucket page holds
+  vector<int>	dir;		// the directory, 2^depth bucket pageNos
+  bool		dirDirtyFlag;	// true if dir is not in the file as it is
+
+  // state of the scan
+  bool		scanExecuting;
+  char		scanKey[HASHMAXKEYLEN];	// the key looked for
+  int		nextPageNo;	// page of the chain to go to, -1 if none
+  int		curPageNo;
+  Page*		curPage;	// page the scan is in, pinned; NULL if none
+  int		curPos;		// next entry of curPage
+
+  // copy the key at key to out in the form it is stored and hashed in,
+  // so that keys that compare equal are the same bytes
+  void normalize(const char* key, char* out) const;
+
+  const unsigned hashKey(const char* key) const;
+
+  // address of entry i of bucket
+  char* entry(HashBucket* bucket, const int i) const;
+
+  // split the bucket in the directory at position slot in two,
+  // doubling the directory first if the bucket is as deep as it is
+  const Status splitBucket(const int slot);
+
+  // true if the entries of the chain starting at pageNo and the key
+  // all have the same hash, so that no split can separate them
+  const Status sameHash(const int pageNo, const unsigned hash, bool & same);
+
+  // read the directory in from its pages, and write it back
+  const Status readDirectory();
+  const Status writeDirectory();
+
+  // fill the new, empty index from the records of relName
+  const Status build(const string & relName);
+
+  // the IndexFn attachTo registers
+  static const Status fileChanged(void* index, const Record & rec,
+                                  const RID & rid, const bool inserted);
+};
+
+#endif
@@ -1,7 +1,14 @@
 #include "heapfile.h"
+#include "filter.h"
 #include "error.h"
 
 #include <stdio.h>
+#include <math.h>
+#include <limits.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include "stdlib.h"
 
 // routine to create a heapfile
@@ -12,7 +19,9 @@ const Status createHeapFile(const string fileName)
     FileHdrPage*	hdrPage;
     int			hdrPageNo;
     int			newPageNo;
+    int			dirPageNo;
     Page*		newPage;
+    DirPage*		dirPage;
 
     // try to open the file. This should return an error
     status = db.openFile(fileName, file);
@@ -37,16 +46,29 @@ const Status createHeapFile(const string fileName)
 	if(status != OK) return status;	
 	//invoke init() of the new page
 	newPage->init(newPageNo);	
+	//and a page directory listing it
+	status = bufMgr->allocPage(file, dirPageNo, newPage);
+	if(status != OK) return status;
+	dirPage = (DirPage*)newPage;
+	dirPage->nextPage = -1;
+	dirPage->cnt = 1;
+	dirPage->pageNos[0] = newPageNo;
 	//update header parameter	
 	hdrPage->firstPage = newPageNo;
 	hdrPage->lastPage = newPageNo;	
 	hdrPage->pageCnt = 1;
 	hdrPage->recCnt = 0;
-	//unpin both pages and mark them as dirty
+	hdrPage->dirFirst = dirPageNo;
+	hdrPage->dirLast = dirPageNo;
+	hdrPage->zoneAttrCnt = 0;
+	hdrPage->zoneFirst = -1;
+	//unpin the pages and mark them as dirty
 	status = bufMgr->unPinPage(file, hdrPageNo, true);
 	if(status != OK) return status;
 	status = bufMgr->unPinPage(file, newPageNo, true);
 	if(status != OK) return status;
+	status = bufMgr->unPinPage(file, dirPageNo, true);
+	if(status != OK) return status;
 	//close the file
 	//flush the freshly created file to disk
 	status = bufMgr->flushFile(file);
@@ -104,6 +126,8 @@ HeapFile::HeapFile(const string & fileName, Status& returnStatus)
 	curPageNo = headerPage->firstPage;
 	curDirtyFlag = false;
 	curRec = NULLRID;
+	curPageMoved = false;
+	ovflFirst = -1;
 	returnStatus = status;
     }
     else
@@ -153,364 +177,3197 @@ const int HeapFile::getRecCnt() const
   return headerPage->recCnt;
 }
 
-// retrieve an arbitrary record from a file.
-// if record is not on the currently pinned page, the current page
-// is unpinned and the required page is read into the buffer pool
-// and pinned.  returns a pointer to the record via the rec parameter
+// a record with SLOTMOVED set starts with the RID of its stub.
+// strip it off rec and return it in homeRid
+static void unwrapMoved(Record & rec, RID & homeRid)
+{
+    memcpy(&homeRid, rec.data, sizeof(RID));
+    rec.data = (char*)rec.data + sizeof(RID);
+    rec.length -= sizeof(RID);
+}
 
-const Status HeapFile::getRecord(const RID &  rid, Record & rec)
+// unpin the current page and read page pageNo in its place
+const Status HeapFile::switchPage(const int pageNo)
 {
-//	cout<< "getRecord. record (" << rid.pageNo << "." << rid.slotNo << ")" << endl;
     Status 	status;
     Page* 	pagePtr;
-	//if desired record in curPage, get it directly
-    if(rid.pageNo == curPageNo)
-	return (curPage->getRecord(rid, rec));
-    else{
-	//unpin the current page
-	status = bufMgr->unPinPage(filePtr, curPageNo, curDirtyFlag);
-	if((status != OK) && (status != PAGENOTPINNED)) return status;
-	if(status == PAGENOTPINNED) cout<<"page initially not pinned occurred!"<<endl;
-	//read the desired page into bufPool
-	status = bufMgr->readPage(filePtr, rid.pageNo, pagePtr);
+
+    //unpin the current page
+    status = bufMgr->unPinPage(filePtr, curPageNo, curDirtyFlag);
+    if((status != OK) && (status != PAGENOTPINNED)) return status;
+    if(status == PAGENOTPINNED) cout<<"page initially not pinned occurred!"<<endl;
+    //read the desired page into bufPool
+    status = bufMgr->readPage(filePtr, pageNo, pagePtr);
+    if(status != OK) return status;
+    //set the new current parameters
+    curPage = pagePtr;
+    curPageNo = pageNo;
+    curDirtyFlag = false;
+    curPageMoved = true;
+    return OK;
+}
+
+// bring in the page holding the record with RID rid, unpinning the
+// current page if it is a different one.  a forwarding stub is
+// followed to the page the record moved to, which then becomes the
+// current page.  flags are those of the slot rid refers to
+
+const Status HeapFile::fetchRecord(const RID & rid, short & flags,
+                                   Record & rec)
+{
+    Status 	status;
+    RID		target, homeRid;
+
+	//if desired record not in curPage, bring its page in
+    if(rid.pageNo != curPageNo){
+	status = switchPage(rid.pageNo);
 	if(status != OK) return status;
-	//set the new current parameters
 	curRec = rid;				
-	curPage = pagePtr;
-	curPageNo = rid.pageNo;
-	curDirtyFlag = false;				
-	return (curPage->getRecord(rid, rec));		//update rec
+    }
+    status = curPage->getFlags(rid, flags);
+    if(status != OK) return status;
+    status = curPage->getRecord(rid, rec);
+    if(status != OK || !(flags & (SLOTSTUB | SLOTMOVED))) return status;
 
+    if(flags & SLOTSTUB){
+	//follow the stub to the moved version of the record
+	memcpy(&target, rec.data, sizeof(RID));
+	if(target.pageNo != curPageNo){
+	    status = switchPage(target.pageNo);
+	    if(status != OK) return status;
+	}
+	curRec = target;
+	status = curPage->getRecord(target, rec);
+	if(status != OK) return status;
     }
-    // cout<< "getRecord. record (" << rid.pageNo << "." << rid.slotNo << ")" << endl;
+    unwrapMoved(rec, homeRid);
+    return OK;
 }
 
-HeapFileScan::HeapFileScan(const string & name,
-			   Status & status) : HeapFile(name, status)
+const int HeapFile::getPageCnt() const
 {
-    filter = NULL;
+    return headerPage->pageCnt;
 }
 
-const Status HeapFileScan::startScan(const int offset_,
-				     const int length_,
-				     const Datatype type_, 
-				     const char* filter_,
-				     const Operator op_)
+const string HeapFile::getFileName() const
 {
-    if (!filter_) {                        // no filtering requested
-        filter = NULL;
-        return OK;
-    }
-    
-    if ((offset_ < 0 || length_ < 1) ||
-        (type_ != STRING && type_ != INTEGER && type_ != FLOAT) ||
-        ((type_ == INTEGER && length_ != sizeof(int))
-         || (type_ == FLOAT && length_ != sizeof(float))) ||
-        (op_ != LT && op_ != LTE && op_ != EQ && op_ != GTE && op_ != GT && op_ != NE))
-    {
-        return BADSCANPARM;
-    }
+    return string(headerPage->fileName);
+}
 
-    offset = offset_;
-    length = length_;
-    type = type_;
-    filter = filter_;
-    op = op_;
+// follow the directory chain until it reaches the page holding entry
+// idx.  a file of n data pages has about n/DIRPAGESIZE of them
+
+const Status HeapFile::loadDirectory(const int idx)
+{
+    Status	status;
+    Page*	page;
+    int		pageNo;
 
+    if(dirPageNos.empty()) dirPageNos.push_back(headerPage->dirFirst);
+    while((int) dirPageNos.size() <= idx / DIRPAGESIZE){
+	status = bufMgr->readPage(filePtr, dirPageNos.back(), page);
+	if(status != OK) return status;
+	pageNo = ((DirPage*) page)->nextPage;
+	status = bufMgr->unPinPage(filePtr, dirPageNos.back(), false);
+	if(status != OK) return status;
+	if(pageNo == -1) return BADPAGENO;
+	dirPageNos.push_back(pageNo);
+    }
     return OK;
 }
 
+// append an entry to the last directory page, starting a new one
+// when it is full.  called right after a data page is linked in
 
-const Status HeapFileScan::endScan()
+const Status HeapFile::addDirEntry(const int pageNo)
 {
-    Status status;
-    // generally must unpin last page of the scan
-    if (curPage != NULL)
-    {
-        status = bufMgr->unPinPage(filePtr, curPageNo, curDirtyFlag);
-        curPage = NULL;
-        curPageNo = 0;
-		curDirtyFlag = false;
-        return status;
+    Status	status, unpinstatus;
+    Page*	page;
+    Page*	newPage;
+    int		dirPageNo = headerPage->dirLast;
+    int		newPageNo;
+
+    status = bufMgr->readPage(filePtr, dirPageNo, page);
+    if(status != OK) return status;
+    DirPage* dir = (DirPage*) page;
+    if(dir->cnt == DIRPAGESIZE){
+	status = bufMgr->allocPage(filePtr, newPageNo, newPage);
+	if(status != OK){
+	    bufMgr->unPinPage(filePtr, dirPageNo, false);
+	    return status;
+	}
+	dir->nextPage = newPageNo;
+	unpinstatus = bufMgr->unPinPage(filePtr, dirPageNo, true);
+	if(unpinstatus != OK) return unpinstatus;
+	headerPage->dirLast = newPageNo;
+	hdrDirtyFlag = true;
+	dirPageNo = newPageNo;
+	dir = (DirPage*) newPage;
+	dir->nextPage = -1;
+	dir->cnt = 0;
+    }
+    dir->pageNos[dir->cnt++] = pageNo;
+    return bufMgr->unPinPage(filePtr, dirPageNo, true);
+}
+
+// read the data page numbers off the page directory, one directory
+// page at a time
+
+const Status HeapFile::getPageNos(vector<int> & pageNos)
+{
+    Status	status;
+    Page*	page;
+    int		cnt = headerPage->pageCnt;
+
+    pageNos.clear();
+    for(int idx = 0; idx < cnt; idx += DIRPAGESIZE){
+	status = loadDirectory(idx);
+	if(status != OK) return status;
+	int dirPageNo = dirPageNos[idx / DIRPAGESIZE];
+	status = bufMgr->readPage(filePtr, dirPageNo, page);
+	if(status != OK) return status;
+	DirPage* dir = (DirPage*) page;
+	pageNos.insert(pageNos.end(), dir->pageNos, dir->pageNos + dir->cnt);
+	status = bufMgr->unPinPage(filePtr, dirPageNo, false);
+	if(status != OK) return status;
     }
     return OK;
 }
 
-HeapFileScan::~HeapFileScan()
+const Status HeapFile::getPageNo(const int idx, int & pageNo)
 {
-    endScan();
+    Status	status;
+    Page*	page;
+
+    if(idx < 0 || idx >= headerPage->pageCnt) return BADPAGENO;
+    status = loadDirectory(idx);
+    if(status != OK) return status;
+    int dirPageNo = dirPageNos[idx / DIRPAGESIZE];
+    status = bufMgr->readPage(filePtr, dirPageNo, page);
+    if(status != OK) return status;
+    pageNo = ((DirPage*) page)->pageNos[idx % DIRPAGESIZE];
+    return bufMgr->unPinPage(filePtr, dirPageNo, false);
 }
 
-const Status HeapFileScan::markScan()
+// the page numbers come from the directory; the range is cut short at
+// the end of the file
+
+const Status HeapFile::prefetchPages(const int idx, const int count)
 {
-    // make a snapshot of the state of the scan
-    markedPageNo = curPageNo;
-    markedRec = curRec;
+    Status	status;
+    Page*	page;
+    int		i = idx;
+    int		end = idx + count;
+
+    if(idx < 0 || count < 0) return BADPAGENO;
+    if(end > headerPage->pageCnt) end = headerPage->pageCnt;
+    while(i < end){
+	status = loadDirectory(i);
+	if(status != OK) return status;
+	int dirPageNo = dirPageNos[i / DIRPAGESIZE];
+	status = bufMgr->readPage(filePtr, dirPageNo, page);
+	if(status != OK) return status;
+	int first = i % DIRPAGESIZE;
+	int n = (end - i < DIRPAGESIZE - first) ? end - i : DIRPAGESIZE - first;
+	status = filePtr->prefetchPages(((DirPage*) page)->pageNos + first, n);
+	Status unpinstatus = bufMgr->unPinPage(filePtr, dirPageNo, false);
+	if(status != OK) return status;
+	if(unpinstatus != OK) return unpinstatus;
+	i += n;
+    }
     return OK;
 }
 
-const Status HeapFileScan::resetScan()
+// retrieve an arbitrary record from a file.
+// if record is not on the currently pinned page, the current page
+// is unpinned and the required page is read into the buffer pool
+// and pinned.  returns a pointer to the record via the rec parameter
+
+const Status HeapFile::getRecord(const RID &  rid, Record & rec)
 {
-    Status status;
-    if (markedPageNo != curPageNo) 
-    {
-		if (curPage != NULL)
-		{
-			status = bufMgr->unPinPage(filePtr, curPageNo, curDirtyFlag);
-			if (status != OK) return status;
-		}
-		// restore curPageNo and curRec values
-		curPageNo = markedPageNo;
-		curRec = markedRec;
-		// then read the page
-		status = bufMgr->readPage(filePtr, curPageNo, curPage);
-		if (status != OK) return status;
-		curDirtyFlag = false; // it will be clean
-    }
-    else curRec = markedRec;
+//	cout<< "getRecord. record (" << rid.pageNo << "." << rid.slotNo << ")" << endl;
+    Status 	status;
+    short	flags;
+
+    status = fetchRecord(rid, flags, rec);
+    if(status != OK) return status;
+    if(flags & SLOTOVFL) return readLargeRecord(rec, rec);
     return OK;
+    // cout<< "getRecord. record (" << rid.pageNo << "." << rid.slotNo << ")" << endl;
 }
 
+// the RIDs are sorted by page so that each page is pinned once.  the
+// stubs among them lead to moved records on other pages, which take a
+// second, likewise sorted, round.  records are copied out as the pages
+// go by, and recs is pointed at them once fetchBuf has stopped growing
+// and both rounds have succeeded
 
-const Status HeapFileScan::scanNext(RID& outRid)
+const Status HeapFile::getRecords(const RID* rids, const int cnt,
+                                  Record* recs, const bool prefetch)
 {
-    Status 	status = OK;
-//    RID		nextRid;
-    RID		tmpRid;
-    int 	nextPageNo;
-    Record      rec;
-    Page*	newPage;
+    Status	status;
+    vector<pair<pair<int,int>,int> > order, moved;
+    vector<long> offsets;	// where in fetchBuf each record went
+    vector<int>	lengths;
+    int		i;
 
-	
-    nextPageNo = -1;
-    if(curRec.slotNo == -1){
-	status = curPage->firstRecord(tmpRid);
-    	if(status != OK) return status;
+    if(cnt < 0 || (cnt > 0 && (!rids || !recs))) return BADRID;
+    offsets.resize(cnt);
+    lengths.resize(cnt);
+    order.reserve(cnt);
+    for(i = 0; i < cnt; i++)
+	order.push_back(make_pair(make_pair(rids[i].pageNo, rids[i].slotNo), i));
+    sort(order.begin(), order.end());
+
+    if(prefetch && cnt > 0){
+	vector<int> pageNos;
+	for(i = 0; i < cnt; i++)
+	    if(i == 0 || order[i].first.first != order[i - 1].first.first)
+		pageNos.push_back(order[i].first.first);
+	status = filePtr->prefetchPages(&pageNos[0], pageNos.size());
+	if(status != OK) return status;
     }
-    else{
-	status = curPage->nextRecord(curRec, tmpRid);
+
+    fetchBuf.clear();
+    status = fetchRecords(order, offsets, lengths, moved);
+    if(status != OK) return status;
+    if(!moved.empty()){
+	sort(moved.begin(), moved.end());
+	status = fetchRecords(moved, offsets, lengths, order);
+	if(status != OK) return status;
+	if(!order.empty()) return BADRID;	// a stub leading to a stub
     }
-    //if curPage is not the last page in the file
-	while(curPageNo != headerPage->lastPage){
-		while(status != ENDOFPAGE){
-			//convert curRec to a rec
-			curRec = tmpRid;
-			status = curPage->getRecord(tmpRid, rec);
-			if(status != OK) return status;
-			//check if match, if match, return the record
-			if(matchRec(rec)){
-				curRec = tmpRid;
-				outRid = curRec;
-				return OK;
-			}
-			status = curPage->nextRecord(curRec, tmpRid);
-			
-		}
-		do{
-		
-			//all recidrds on the page have been processed, unpin page
-			status = bufMgr->unPinPage(filePtr, curPageNo, curDirtyFlag);
-			if(status != OK) return status;
-			//get the next page
-			status = curPage->getNextPage(nextPageNo);
-			if(status != OK) cerr<<"next page error!\n";
-			//read in the next page, update cur para
-			status = bufMgr->readPage(filePtr, nextPageNo, newPage);
-			if(status != OK) return status;
-			curPageNo = nextPageNo;
-			curPage = newPage;
-			curDirtyFlag = false;
-			status = curPage->firstRecord(tmpRid);
-		} while(status == NORECORDS && curPageNo != headerPage->lastPage);	
-			//basically to prevent norecords from being included in desired records
-			
-		if((status != OK) && (status != NORECORDS)){ cerr<<"more than norecords!"; return status; }
+
+    for(i = 0; i < cnt; i++){
+	recs[i].data = fetchBuf.data() + offsets[i];
+	recs[i].length = lengths[i];
+    }
+    return OK;
+}
+
+const Status HeapFile::fetchRecords(vector<pair<pair<int,int>,int> > & order,
+                                    vector<long> & offsets,
+                                    vector<int> & lengths,
+                                    vector<pair<pair<int,int>,int> > & moved)
+{
+    Status	status = OK, unpinstatus;
+    Page*	page = NULL;
+    int		pageNo = -1;
+    short	flags;
+    Record	rec;
+    RID		rid, target, homeRid;
+
+    moved.clear();
+    for(unsigned i = 0; i < order.size() && status == OK; i++){
+	rid.pageNo = order[i].first.first;
+	rid.slotNo = order[i].first.second;
+	if(rid.pageNo != pageNo){
+	    if(page){
+		status = bufMgr->unPinPage(filePtr, pageNo, false);
+		page = NULL;
+		if(status != OK) return status;
+	    }
+	    status = bufMgr->readPage(filePtr, rid.pageNo, page);
+	    if(status != OK) return status;
+	    pageNo = rid.pageNo;
 	}
-	
-    //if curPage is the last page or prev pages are all processed
-    while((status != ENDOFPAGE) && (status != NORECORDS)){
-	//convert curRec to a rec
-	curRec = tmpRid;
-	status = curPage->getRecord(tmpRid, rec);
-	if(status != OK) return status;
-	//check if match
-	if(matchRec(rec)){
-		curRec = tmpRid;
-		outRid = curRec;
-		return OK;
+
+	status = page->getFlags(rid, flags);
+	if(status == OK) status = page->getRecord(rid, rec);
+	if(status != OK) break;
+	if(flags & SLOTSTUB){
+	    memcpy(&target, rec.data, sizeof(RID));
+	    moved.push_back(make_pair(make_pair(target.pageNo, target.slotNo),
+				      order[i].second));
+	    continue;
 	}
-	status = curPage->nextRecord(curRec, tmpRid);
+	if(flags & SLOTMOVED) unwrapMoved(rec, homeRid);
+	if(flags & SLOTOVFL){
+	    status = readLargeRecord(rec, rec);
+	    if(status != OK) break;
+	}
+	offsets[order[i].second] = fetchBuf.size();
+	lengths[order[i].second] = rec.length;
+	fetchBuf.insert(fetchBuf.end(), (char*) rec.data,
+			(char*) rec.data + rec.length);
     }
-    return FILEEOF;
+    if(page){
+	unpinstatus = bufMgr->unPinPage(filePtr, pageNo, false);
+	if(status == OK) status = unpinstatus;
+    }
+    return status;
 }
 
+// the same two rounds as getRecords: the stubs of moved records are
+// deleted with the pages they are on and lead to the moved records,
+// which are deleted in a second pass over their own pages.  every RID
+// is checked first, so that a bad one leaves the file as it was
 
-// returns pointer to the current record.  page is left pinned
-// and the scan logic is required to unpin the page 
-
-const Status HeapFileScan::getRecord(Record & rec)
+const Status HeapFile::deleteRecords(const RID* rids, const int cnt,
+                                     int & deleted)
 {
-    return curPage->getRecord(curRec, rec);
+    Status	status = OK, unpinstatus, movedstatus;
+    vector<pair<int,int> > order, moved, none;
+    Page*	page = NULL;
+    int		pageNo = -1, i;
+    short	flags;
+    RID		rid;
+
+    deleted = 0;
+    if(cnt < 0 || (cnt > 0 && !rids)) return BADRID;
+    order.reserve(cnt);
+    for(i = 0; i < cnt; i++)
+	order.push_back(make_pair(rids[i].pageNo, rids[i].slotNo));
+    sort(order.begin(), order.end());
+    order.erase(unique(order.begin(), order.end()), order.end());
+
+    for(i = 0; i < (int) order.size() && status == OK; i++){
+	rid.pageNo = order[i].first;
+	rid.slotNo = order[i].second;
+	if(rid.pageNo != pageNo){
+	    if(page){
+		status = bufMgr->unPinPage(filePtr, pageNo, false);
+		page = NULL;
+		if(status != OK) return status;
+	    }
+	    status = bufMgr->readPage(filePtr, rid.pageNo, page);
+	    if(status != OK) return status;
+	    pageNo = rid.pageNo;
+	}
+	status = page->getFlags(rid, flags);
+	// a moved record is only known by the RID of its stub
+	if(status == OK && (flags & SLOTMOVED)) status = BADRID;
+    }
+    if(page){
+	unpinstatus = bufMgr->unPinPage(filePtr, pageNo, false);
+	if(status == OK) status = unpinstatus;
+    }
+    if(status != OK) return status;
+
+    // the indexes need the records that go
+    vector<RID>	homes;
+    vector<Record> recs;
+    if(!indexes.empty() && !order.empty()){
+	homes.resize(order.size());
+	recs.resize(order.size());
+	for(i = 0; i < (int) order.size(); i++){
+	    homes[i].pageNo = order[i].first;
+	    homes[i].slotNo = order[i].second;
+	}
+	status = getRecords(&homes[0], homes.size(), &recs[0]);
+	if(status != OK) return status;
+    }
+
+    // the records whose stubs went are deleted even if the first round
+    // failed part way, as nothing would lead to them any more
+    status = dropRecords(order, true, moved, deleted);
+    if(!moved.empty()){
+	sort(moved.begin(), moved.end());
+	movedstatus = dropRecords(moved, false, none, i);
+	if(status == OK) status = movedstatus;
+    }
+
+    if(deleted > 0){
+	headerPage->recCnt -= deleted;
+	hdrDirtyFlag = true;
+    }
+    for(i = 0; status == OK && i < (int) recs.size(); i++)
+	status = notifyIndexes(recs[i], homes[i], false);
+    return status;
 }
 
-// delete record from fie. 
-const Status HeapFileScan::deleteRecord()
+const Status HeapFile::dropRecords(const vector<pair<int,int> > & order,
+                                   const bool homes,
+                                   vector<pair<int,int> > & moved,
+                                   int & deleted)
 {
-    Status status;
+    Status	status = OK, unpinstatus;
+    Page*	page = NULL;
+    int		pageNo = -1;
+    short	flags;
+    Record	rec;
+    RID		rid, target, homeRid;
+    OvflDesc	desc;
 
-    // delete the "current" record from the page
-    status = curPage->deleteRecord(curRec);
-    curDirtyFlag = true;
+    for(unsigned i = 0; i < order.size() && status == OK; i++){
+	rid.pageNo = order[i].first;
+	rid.slotNo = order[i].second;
+	if(rid.pageNo != pageNo){
+	    if(page){
+		status = rezonePage(pageNo, page);
+		unpinstatus = bufMgr->unPinPage(filePtr, pageNo, true);
+		page = NULL;
+		if(status == OK) status = unpinstatus;
+		if(status != OK) return status;
+	    }
+	    status = bufMgr->readPage(filePtr, rid.pageNo, page);
+	    if(status != OK) return status;
+	    pageNo = rid.pageNo;
+	}
 
-    // reduce count of number of records in the file
-    headerPage->recCnt--;
-    hdrDirtyFlag = true; 
+	status = page->getFlags(rid, flags);
+	if(status == OK) status = page->getRecord(rid, rec);
+	if(status != OK) break;
+	if(homes == ((flags & SLOTMOVED) != 0)){
+	    // a moved record is only known by the RID of its stub
+	    status = BADRID;
+	    break;
+	}
+	if(flags & SLOTSTUB){
+	    memcpy(&target, rec.data, sizeof(RID));
+	    moved.push_back(make_pair(target.pageNo, target.slotNo));
+	}
+	if(flags & SLOTMOVED) unwrapMoved(rec, homeRid);
+	if(flags & SLOTOVFL){
+	    memcpy(&desc, rec.data, sizeof(OvflDesc));
+	    status = freeOverflow(desc);
+	    if(status != OK) break;
+	}
+	status = page->deleteRecord(rid);
+	if(status == OK && homes) deleted++;
+    }
+    if(page){
+	if(status == OK) status = rezonePage(pageNo, page);
+	unpinstatus = bufMgr->unPinPage(filePtr, pageNo, true);
+	if(status == OK) status = unpinstatus;
+    }
     return status;
 }
 
+// copy part of a record into a caller supplied buffer.  bytesRead
+// is less than len when the record ends before offset+len
 
-// mark current page of scan dirty
-const Status HeapFileScan::markDirty()
+const Status HeapFile::readRecord(const RID & rid, const int offset,
+                                  char* buf, const int len, int & bytesRead)
 {
-    curDirtyFlag = true;
+    Status 	status;
+    short	flags;
+    Record	rec;
+    OvflDesc	desc;
+    int		total;
+
+    if (offset < 0 || len < 0) return BADRECPTR;
+
+    status = fetchRecord(rid, flags, rec);
+    if(status != OK) return status;
+    total = rec.length;
+    if(flags & SLOTOVFL){
+	memcpy(&desc, rec.data, sizeof(OvflDesc));
+	total = desc.length;
+    }
+
+    bytesRead = 0;
+    if(offset >= total) return OK;
+    bytesRead = (len < total - offset) ? len : total - offset;
+    if(flags & SLOTOVFL) return readOverflow(desc, offset, buf, bytesRead);
+    memcpy(buf, (char*)rec.data + offset, bytesRead);
     return OK;
 }
 
-const bool HeapFileScan::matchRec(const Record & rec) const
+const Status HeapFile::attachIndex(IndexFn fn, void* index)
 {
-    // no filtering requested
-    if (!filter) return true;
+    if(!fn || !index) return BADINDEXPARM;
+    indexes.push_back(make_pair(fn, index));
+    return OK;
+}
 
-    // see if offset + length is beyond end of record
-    // maybe this should be an error???
-    if ((offset + length -1 ) >= rec.length)
-	return false;
+const Status HeapFile::detachIndex(void* index)
+{
+    for(unsigned i = 0; i < indexes.size(); i++)
+	if(indexes[i].second == index){
+	    indexes.erase(indexes.begin() + i);
+	    return OK;
+	}
+    return BADINDEXPARM;
+}
 
-    float diff = 0;                       // < 0 if attr < fltr
-    switch(type) {
-
-    case INTEGER:
-        int iattr, ifltr;                 // word-alignment problem possible
-        memcpy(&iattr,
-               (char *)rec.data + offset,
-               length);
-        memcpy(&ifltr,
-               filter,
-               length);
-        diff = iattr - ifltr;
-        break;
-
-    case FLOAT:
-        float fattr, ffltr;               // word-alignment problem possible
-        memcpy(&fattr,
-               (char *)rec.data + offset,
-               length);
-        memcpy(&ffltr,
-               filter,
-               length);
-        diff = fattr - ffltr;
-        break;
-
-    case STRING:
-        diff = strncmp((char *)rec.data + offset,
-                       filter,
-                       length);
-        break;
-    }
-
-    switch(op) {
-    case LT:  if (diff < 0.0) return true; break;
-    case LTE: if (diff <= 0.0) return true; break;
-    case EQ:  if (diff == 0.0) return true; break;
-    case GTE: if (diff >= 0.0) return true; break;
-    case GT:  if (diff > 0.0) return true; break;
-    case NE:  if (diff != 0.0) return true; break;
+const Status HeapFile::notifyIndexes(const Record & rec, const RID & rid,
+                                     const bool inserted)
+{
+    Status	status;
+
+    for(unsigned i = 0; i < indexes.size(); i++){
+	status = indexes[i].first(indexes[i].second, rec, rid, inserted);
+	if(status != OK) return status;
     }
+    return OK;
+}
 
-    return false;
+// like fetchRecord, but with the pages pinned just long enough to copy
+// the record out, so that it can be used in the middle of a change
+
+const Status HeapFile::copyRecord(const RID & rid, vector<char> & buf)
+{
+    Status	status, unpinstatus;
+    Page*	page;
+    int		pageNo = rid.pageNo;
+    short	flags = 0;
+    Record	rec;
+    RID		target, homeRid;
+    OvflDesc	desc;
+
+    status = bufMgr->readPage(filePtr, pageNo, page);
+    if(status != OK) return status;
+    status = page->getFlags(rid, flags);
+    if(status == OK) status = page->getRecord(rid, rec);
+    if(status == OK && (flags & SLOTSTUB)){
+	memcpy(&target, rec.data, sizeof(RID));
+	status = bufMgr->unPinPage(filePtr, pageNo, false);
+	if(status != OK) return status;
+	pageNo = target.pageNo;
+	status = bufMgr->readPage(filePtr, pageNo, page);
+	if(status != OK) return status;
+	status = page->getFlags(target, flags);
+	if(status == OK) status = page->getRecord(target, rec);
+    }
+    if(status == OK){
+	if(flags & SLOTMOVED) unwrapMoved(rec, homeRid);
+	if(flags & SLOTOVFL) memcpy(&desc, rec.data, sizeof(OvflDesc));
+	else buf.assign((char*) rec.data, (char*) rec.data + rec.length);
+    }
+    unpinstatus = bufMgr->unPinPage(filePtr, pageNo, false);
+    if(status == OK) status = unpinstatus;
+    if(status != OK || !(flags & SLOTOVFL)) return status;
+    buf.resize(desc.length);
+    return readOverflow(desc, 0, buf.data(), desc.length);
 }
 
-InsertFileScan::InsertFileScan(const string & name,
-                               Status & status) : HeapFile(name, status)
+// zone maps.  the zones go by pageNo, so a zone map page also has zones
+// for the header, directory and overflow pages, which stay empty; in
+// return finding the zone of a data page takes no lookup
+
+const int HeapFile::zoneSize() const
 {
-  //Do nothing. Heapfile constructor will read the header page and the first
-  // data page of the file into the buffer pool
+    return headerPage->zoneAttrCnt * 2 * sizeof(int);
 }
 
-InsertFileScan::~InsertFileScan()
+const int HeapFile::zonesPerPage() const
 {
-    Status status;
-    // unpin last page of the scan
-    if (curPage != NULL)
-    {
-        status = bufMgr->unPinPage(filePtr, curPageNo, true);
-        curPage = NULL;
-        curPageNo = 0;
-        if (status != OK) cerr << "error in unpin of data page\n";
+    return ZONEDATASIZE / zoneSize();
+}
+
+// make zone one with no values, min above max for every attribute
+
+static void emptyZone(const FileHdrPage* hdr, char* zone)
+{
+    int		imin = INT_MAX, imax = INT_MIN;
+    float	fmin = INFINITY, fmax = -INFINITY;
+
+    for(int a = 0; a < hdr->zoneAttrCnt; a++, zone += 2 * sizeof(int)){
+	if(hdr->zoneAttrs[a].type == INTEGER){
+	    memcpy(zone, &imin, sizeof(int));
+	    memcpy(zone + sizeof(int), &imax, sizeof(int));
+	}
+	else{
+	    memcpy(zone, &fmin, sizeof(float));
+	    memcpy(zone + sizeof(float), &fmax, sizeof(float));
+	}
     }
 }
 
-// Insert a record into the file
-const Status InsertFileScan::insertRecord(const Record & rec, RID& outRid)
+// widen the (min, max) pair at range to take in v.  true if it changed
+template <class T>
+static bool widenRange(char* range, const T v)
 {
-    Page*	newPage;
-    int		newPageNo;
-    Status	status, unpinstatus;
-    RID		rid;
+    T		lo, hi;
+    bool	changed = false;
 
-    // check for very large records
-    if ((unsigned int) rec.length > PAGESIZE-DPFIXED)
-    {
-        // will never fit on a page, so don't even bother looking
-        return INVALIDRECLEN;
+    memcpy(&lo, range, sizeof(T));
+    memcpy(&hi, range + sizeof(T), sizeof(T));
+    if(v < lo){
+	memcpy(range, &v, sizeof(T));
+	changed = true;
     }
+    if(v > hi){
+	memcpy(range + sizeof(T), &v, sizeof(T));
+	changed = true;
+    }
+    return changed;
+}
 
-    //the current page is not the last page of the file, unpin it and bring in the last page
-    if(curPageNo != headerPage->lastPage){
-	//unpin the current page
-	unpinstatus = bufMgr->unPinPage(filePtr, curPageNo, curDirtyFlag);
-	if(unpinstatus != OK) cerr<<"error in unpin insertion\n";
-	//bring in the last page
-	status = bufMgr->readPage(filePtr, headerPage->lastPage, newPage);
-	if(status != OK) return status;
-	//update cur para
-	curPage = newPage;
-	curPageNo = headerPage->lastPage;
-	curDirtyFlag = false;
-	curRec = NULLRID;	
+// widen zone to take in the attributes of rec, leaving out those rec
+// is too short to hold.  a NaN, which no range holds, widens its range
+// to all values.  true if the zone changed
+
+static bool widenZoneRec(const FileHdrPage* hdr, char* zone,
+                         const Record & rec)
+{
+    bool	changed = false;
+    int		i;
+    float	f;
+
+    for(int a = 0; a < hdr->zoneAttrCnt; a++, zone += 2 * sizeof(int)){
+	const ZoneAttr & attr = hdr->zoneAttrs[a];
+	if(rec.length < attr.offset + (int) sizeof(int)) continue;
+	const char* p = (const char*) rec.data + attr.offset;
+	if(attr.type == INTEGER){
+	    memcpy(&i, p, sizeof(int));
+	    changed |= widenRange(zone, i);
+	}
+	else{
+	    memcpy(&f, p, sizeof(float));
+	    if(f != f){
+		changed |= widenRange(zone, -INFINITY);
+		changed |= widenRange(zone, INFINITY);
+	    }
+	    else changed |= widenRange(zone, f);
+	}
     }
-    //try to insert
-    status = curPage->insertRecord(rec, rid);
-    //if full, alloc a new page and insert the record into the new page
+    return changed;
+}
+
+// widen zone to take in the ranges of other, leaving out those that
+// are empty
+
+static void widenZoneZone(const FileHdrPage* hdr, char* zone,
+                          const char* other)
+{
+    int		ilo, ihi;
+    float	flo, fhi;
+
+    for(int a = 0; a < hdr->zoneAttrCnt;
+	a++, zone += 2 * sizeof(int), other += 2 * sizeof(int)){
+	if(hdr->zoneAttrs[a].type == INTEGER){
+	    memcpy(&ilo, other, sizeof(int));
+	    memcpy(&ihi, other + sizeof(int), sizeof(int));
+	    if(ilo > ihi) continue;
+	    widenRange(zone, ilo);
+	    widenRange(zone, ihi);
+	}
+	else{
+	    memcpy(&flo, other, sizeof(float));
+	    memcpy(&fhi, other + sizeof(float), sizeof(float));
+	    if(flo > fhi) continue;
+	    widenRange(zone, flo);
+	    widenRange(zone, fhi);
+	}
+    }
+}
+
+// index of the zone attribute term t compares, -1 if there is none or
+// the zones cannot rule t out
+
+static int zoneAttrOf(const FileHdrPage* hdr, const ScanTerm & t)
+{
+    if(t.op >= PREFIX && t.op <= LIKE) return -1;
+    for(int a = 0; a < hdr->zoneAttrCnt; a++)
+	if(hdr->zoneAttrs[a].offset == t.offset &&
+	   hdr->zoneAttrs[a].type == t.type)
+	    return a;
+    return -1;
+}
+
+// follow the zone map chain until it reaches the page holding the
+// zone, adding empty pages at its end if need be.  another HeapFile on
+// the same file may have added some since this one last looked
+
+const Status HeapFile::findZone(const int pageNo, const bool add,
+                                int & zonePageNo, Page* & zonePage,
+                                char* & zone)
+{
+    Status	status;
+    Page*	page;
+    int		nextPageNo;
+    int		per = zonesPerPage();
+
+    zone = NULL;
+    while((int) zonePageNos.size() <= pageNo / per){
+	if(zonePageNos.empty()) nextPageNo = headerPage->zoneFirst;
+	else{
+	    status = bufMgr->readPage(filePtr, zonePageNos.back(), page);
+	    if(status != OK) return status;
+	    nextPageNo = ((ZonePage*) page)->nextPage;
+	    status = bufMgr->unPinPage(filePtr, zonePageNos.back(), false);
+	    if(status != OK) return status;
+	}
+	if(nextPageNo == -1){
+	    if(!add) return OK;
+	    status = bufMgr->allocPage(filePtr, nextPageNo, page);
+	    if(status != OK) return status;
+	    ((ZonePage*) page)->nextPage = -1;
+	    for(int i = 0; i < per; i++)
+		emptyZone(headerPage, ((ZonePage*) page)->data + i * zoneSize());
+	    status = bufMgr->unPinPage(filePtr, nextPageNo, true);
+	    if(status != OK) return status;
+	    if(zonePageNos.empty()){
+		headerPage->zoneFirst = nextPageNo;
+		hdrDirtyFlag = true;
+	    }
+	    else{
+		status = bufMgr->readPage(filePtr, zonePageNos.back(), page);
+		if(status != OK) return status;
+		((ZonePage*) page)->nextPage = nextPageNo;
+		status = bufMgr->unPinPage(filePtr, zonePageNos.back(), true);
+		if(status != OK) return status;
+	    }
+	}
+	zonePageNos.push_back(nextPageNo);
+    }
+
+    zonePageNo = zonePageNos[pageNo / per];
+    status = bufMgr->readPage(filePtr, zonePageNo, zonePage);
+    if(status != OK) return status;
+    zone = ((ZonePage*) zonePage)->data + pageNo % per * zoneSize();
+    return OK;
+}
+
+const Status HeapFile::widenZone(const int pageNo, const Record & rec)
+{
+    Status	status;
+    Page*	zonePage;
+    int		zonePageNo;
+    char*	zone;
+
+    if(headerPage->zoneAttrCnt == 0) return OK;
+    status = findZone(pageNo, true, zonePageNo, zonePage, zone);
+    if(status != OK) return status;
+    return bufMgr->unPinPage(filePtr, zonePageNo,
+			     widenZoneRec(headerPage, zone, rec));
+}
+
+// the zone is built from scratch in a local copy.  stubs are left out,
+// as their records count where they moved to, and of a large record
+// only as much is read as the attributes need
+
+const Status HeapFile::rezonePage(const int pageNo, Page* page)
+{
+    Status	status;
+    RID		rids[MAXSLOTS], homeRid;
+    Record	recs[MAXSLOTS], rec;
+    short	flags[MAXSLOTS];
+    char	fresh[MAXZONEATTRS * 2 * sizeof(int)];
+    vector<char> prefix;
+    OvflDesc	desc;
+    Page*	zonePage;
+    int		zonePageNo, n, k, end = 0;
+    char*	zone;
+    bool	changed;
+
+    if(headerPage->zoneAttrCnt == 0) return OK;
+    for(k = 0; k < headerPage->zoneAttrCnt; k++)
+	if(headerPage->zoneAttrs[k].offset + (int) sizeof(int) > end)
+	    end = headerPage->zoneAttrs[k].offset + sizeof(int);
+
+    emptyZone(headerPage, fresh);
+    status = page->getRecords(0, MAXSLOTS, rids, recs, flags, n);
+    if(status != OK) return status;
+    for(k = 0; k < n; k++){
+	if(flags[k] & SLOTSTUB) continue;
+	rec = recs[k];
+	if(flags[k] & SLOTMOVED) unwrapMoved(rec, homeRid);
+	if(flags[k] & SLOTOVFL){
+	    memcpy(&desc, rec.data, sizeof(OvflDesc));
+	    prefix.resize((desc.length < end) ? desc.length : end);
+	    status = readOverflow(desc, 0, prefix.data(), prefix.size());
+	    if(status != OK) return status;
+	    rec.data = prefix.data();
+	    rec.length = prefix.size();
+	}
+	widenZoneRec(headerPage, fresh, rec);
+    }
+
+    status = findZone(pageNo, true, zonePageNo, zonePage, zone);
+    if(status != OK) return status;
+    changed = memcmp(zone, fresh, zoneSize()) != 0;
+    if(changed) memcpy(zone, fresh, zoneSize());
+    return bufMgr->unPinPage(filePtr, zonePageNo, changed);
+}
+
+const Status HeapFile::dropZones()
+{
+    Status	status;
+    Page*	page;
+    int		pageNo, nextPageNo;
+
+    pageNo = headerPage->zoneFirst;
+    while(pageNo != -1){
+	status = bufMgr->readPage(filePtr, pageNo, page);
+	if(status != OK) return status;
+	nextPageNo = ((ZonePage*) page)->nextPage;
+	status = bufMgr->unPinPage(filePtr, pageNo, false);
+	if(status != OK) return status;
+	status = bufMgr->disposePage(filePtr, pageNo);
+	if(status != OK) return status;
+	pageNo = nextPageNo;
+    }
+    headerPage->zoneFirst = -1;
+    headerPage->zoneAttrCnt = 0;
+    hdrDirtyFlag = true;
+    zonePageNos.clear();
+    return OK;
+}
+
+// the zones are built a data page at a time.  if that fails part way
+// the zone maps are dropped again, as a zone left empty would have
+// scans pass over records that are there
+
+const Status HeapFile::declareZones(const ZoneAttr* attrs, const int cnt)
+{
+    Status	status, unpinstatus;
+    Page*	page;
+    vector<int>	pageNos;
+    int		i;
+
+    if(cnt < 0 || cnt > MAXZONEATTRS || (cnt > 0 && !attrs))
+	return BADINDEXPARM;
+    for(i = 0; i < cnt; i++)
+	if(attrs[i].offset < 0 ||
+	   (attrs[i].type != INTEGER && attrs[i].type != FLOAT))
+	    return BADINDEXPARM;
+
+    status = dropZones();
+    if(status != OK || cnt == 0) return status;
+    headerPage->zoneAttrCnt = cnt;
+    memcpy(headerPage->zoneAttrs, attrs, cnt * sizeof(ZoneAttr));
+
+    status = getPageNos(pageNos);
+    for(i = 0; status == OK && i < (int) pageNos.size(); i++){
+	status = bufMgr->readPage(filePtr, pageNos[i], page);
+	if(status != OK) break;
+	status = rezonePage(pageNos[i], page);
+	unpinstatus = bufMgr->unPinPage(filePtr, pageNos[i], false);
+	if(status == OK) status = unpinstatus;
+    }
+    if(status != OK) dropZones();
+    return status;
+}
+
+// write a large record to a chain of newly allocated overflow pages.
+// at most two of them are pinned at any time
+
+const Status HeapFile::writeOverflow(const Record & rec, OvflDesc & desc)
+{
+    Page*	page;
+    Page*	nextPage;
+    int		pageNo, nextPageNo;
+    OvflPage*	ovflPage;
+    Status	status, unpinstatus;
+    const char*	src = (const char*) rec.data;
+    int		left = rec.length;
+
+    status = bufMgr->allocPage(filePtr, pageNo, page);
+    if(status != OK) return status;
+    desc.firstPage = pageNo;
+    desc.length = rec.length;
+
+    while(true){
+	ovflPage = (OvflPage*) page;
+	ovflPage->length = (left < (int) OVFLDATASIZE) ? left : OVFLDATASIZE;
+	ovflPage->nextPage = -1;
+	memcpy(ovflPage->data, src, ovflPage->length);
+	src += ovflPage->length;
+	left -= ovflPage->length;
+
+	status = OK;
+	if(left > 0){
+	    status = bufMgr->allocPage(filePtr, nextPageNo, nextPage);
+	    if(status == OK) ovflPage->nextPage = nextPageNo;
+	}
+	unpinstatus = bufMgr->unPinPage(filePtr, pageNo, true);
+	if(status != OK){
+	    // give back the part of the chain already written
+	    freeOverflow(desc);
+	    return status;
+	}
+	if(unpinstatus != OK) return unpinstatus;
+	if(left == 0) return OK;
+	pageNo = nextPageNo;
+	page = nextPage;
+    }
+}
+
+// dispose of every page in the overflow chain of a large record
+
+const Status HeapFile::freeOverflow(const OvflDesc & desc)
+{
+    Page*	page;
+    int		pageNo, nextPageNo;
+    Status	status;
+
+    ovflFirst = -1;
+    pageNo = desc.firstPage;
+    while(pageNo != -1){
+	status = bufMgr->readPage(filePtr, pageNo, page);
+	if(status != OK) return status;
+	nextPageNo = ((OvflPage*) page)->nextPage;
+	status = bufMgr->unPinPage(filePtr, pageNo, false);
+	if(status != OK) return status;
+	status = bufMgr->disposePage(filePtr, pageNo);
+	if(status != OK) return status;
+	pageNo = nextPageNo;
+    }
+    return OK;
+}
+
+// copy bytes [offset, offset+len) of a large record into buf.  the
+// walk down the chain resumes from the page the previous call ended
+// on when it is at or before offset
+
+const Status HeapFile::readOverflow(const OvflDesc & desc, const int offset,
+                                   char* buf, const int len)
+{
+    Page*	page;
+    OvflPage*	ovflPage;
+    int		pageNo, pagePos, nextPageNo, start, n;
+    int		pos = offset;
+    int		left = len;
+    Status	status;
+
+    if(offset < 0 || offset + len > desc.length) return BADRECPTR;
+
+    if(ovflFirst == desc.firstPage && offset >= ovflPagePos){
+	pageNo = ovflPageNo;
+	pagePos = ovflPagePos;
+    }
+    else{
+	pageNo = desc.firstPage;
+	pagePos = 0;
+    }
+
+    while(true){
+	status = bufMgr->readPage(filePtr, pageNo, page);
+	if(status != OK) return status;
+	ovflPage = (OvflPage*) page;
+	if(left > 0 && pos < pagePos + ovflPage->length){
+	    start = pos - pagePos;
+	    n = ovflPage->length - start;
+	    if(n > left) n = left;
+	    memcpy(buf, ovflPage->data + start, n);
+	    buf += n;
+	    pos += n;
+	    left -= n;
+	}
+	nextPageNo = ovflPage->nextPage;
+	status = bufMgr->unPinPage(filePtr, pageNo, false);
+	if(status != OK) return status;
+	if(left == 0) break;
+	if(nextPageNo == -1) return BADRECPTR;
+	pagePos += ovflPage->length;
+	pageNo = nextPageNo;
+    }
+
+    // remember where we are for the next piece
+    ovflFirst = desc.firstPage;
+    ovflPageNo = pageNo;
+    ovflPagePos = pagePos;
+    return OK;
+}
+
+// read the whole of a large record into ovflBuf.  descRec is the
+// contents of its slot on the data page
+
+const Status HeapFile::readLargeRecord(const Record & descRec, Record & rec)
+{
+    OvflDesc	desc;
+    Status	status;
+
+    memcpy(&desc, descRec.data, sizeof(OvflDesc));
+    ovflBuf.resize(desc.length);
+    status = readOverflow(desc, 0, &ovflBuf[0], desc.length);
+    if(status != OK) return status;
+    rec.data = &ovflBuf[0];
+    rec.length = desc.length;
+    return OK;
+}
+
+// insert a record on the last page of the file, linking in a new
+// last page when that one is full.  the pages are pinned only for
+// the duration of the call so curPage is left as it is
+
+const Status HeapFile::appendRecord(const Record & rec, const short flags,
+                                    RID & outRid)
+{
+    Page*	page;
+    Page*	newPage;
+    int		pageNo, newPageNo;
+    Status	status, unpinstatus;
+
+    pageNo = headerPage->lastPage;
+    status = bufMgr->readPage(filePtr, pageNo, page);
+    if(status != OK) return status;
+
+    status = page->insertRecord(rec, outRid);
     if(status == NOSPACE){
-	//unpin the last page
+	//last page is full, alloc a new one and link it in
+	status = bufMgr->allocPage(filePtr, newPageNo, newPage);
+	if(status != OK){
+	    bufMgr->unPinPage(filePtr, pageNo, false);
+	    return status;
+	}
+	newPage->init(newPageNo);
+	page->setNextPage(newPageNo);
+	headerPage->lastPage = newPageNo;
+	headerPage->pageCnt++;
+	hdrDirtyFlag = true;
+	unpinstatus = bufMgr->unPinPage(filePtr, pageNo, true);
+	if(unpinstatus != OK) cerr<<"error in unpin of data page during append\n";
+	status = addDirEntry(newPageNo);
+	if(status != OK){
+	    bufMgr->unPinPage(filePtr, newPageNo, true);
+	    return status;
+	}
+	page = newPage;
+	pageNo = newPageNo;
+	status = page->insertRecord(rec, outRid);
+    }
+    if(status == OK && flags != 0) status = page->setFlags(outRid, flags);
+
+    unpinstatus = bufMgr->unPinPage(filePtr, pageNo, status == OK);
+    return (status != OK) ? status : unpinstatus;
+}
+
+// write rec, prefixed by the RID of its stub, at the end of the file
+
+const Status HeapFile::forwardRecord(const RID & homeRid, const Record & rec,
+                                     RID & newRid)
+{
+    char	buf[PAGESIZE];
+    Record	moved;
+
+    if ((unsigned int) rec.length > MAXFWDRECLEN) return INVALIDRECLEN;
+
+    memcpy(buf, &homeRid, sizeof(RID));
+    memcpy(buf + sizeof(RID), rec.data, rec.length);
+    moved.data = buf;
+    moved.length = rec.length + sizeof(RID);
+    return appendRecord(moved, SLOTMOVED, newRid);
+}
+
+// update the moved version of a record, in place if its page still
+// has room and by moving it once more otherwise.  the record never
+// gets more than one hop away from its stub.  a record moved again is
+// appended before anything else changes, so a failure leaves the old
+// version where the stub leads
+
+const Status HeapFile::updateMoved(const RID & homeRid, const RID & target,
+                                   const Record & rec, RID & newTarget)
+{
+    char	buf[PAGESIZE];
+    Record	moved;
+    Page*	page;
+    Status	status, unpinstatus;
+
+    if ((unsigned int) rec.length > MAXFWDRECLEN) return INVALIDRECLEN;
+
+    status = bufMgr->readPage(filePtr, target.pageNo, page);
+    if(status != OK) return status;
+
+    memcpy(buf, &homeRid, sizeof(RID));
+    memcpy(buf + sizeof(RID), rec.data, rec.length);
+    moved.data = buf;
+    moved.length = rec.length + sizeof(RID);
+    status = page->updateRecord(target, moved);
+    if(status == NOSPACE){
+	status = bufMgr->unPinPage(filePtr, target.pageNo, false);
+	if(status != OK) return status;
+	return appendRecord(moved, SLOTMOVED, newTarget);
+    }
+    newTarget = target;
+    unpinstatus = bufMgr->unPinPage(filePtr, target.pageNo, status == OK);
+    return (status != OK) ? status : unpinstatus;
+}
+
+// update a record given its RID.  if the new version does not fit on
+// the record's page it is moved to the end of the file and the slot
+// keeps a stub holding its new RID. updating a moved record brings
+// it back home when it fits there again.  a version larger than
+// MAXINLINERECLEN goes to overflow pages instead
+
+const Status HeapFile::updateRecord(const RID & rid, const Record & rec)
+{
+    Page*	page;
+    Page*	movedPage;
+    Status	status, unpinstatus;
+    short	flags;
+    Record	old, stub;
+    RID		target, newTarget;
+    OvflDesc	oldDesc, newDesc;
+    bool	dropMoved = false;	// old moved version to be deleted
+    bool	dropOvfl = false;	// old overflow chain to be freed
+    vector<char> oldBuf;		// old version, for the indexes
+    int		newPageNo = rid.pageNo;	// page the new version is on
+
+    if (rec.length < 0) return INVALIDRECLEN;
+    if (!indexes.empty()){
+	status = copyRecord(rid, oldBuf);
+	if(status != OK) return status;
+    }
+
+    status = bufMgr->readPage(filePtr, rid.pageNo, page);
+    if(status != OK) return status;
+
+    status = page->getFlags(rid, flags);
+    if(status == OK && (flags & SLOTMOVED)) status = BADRID;
+    if(status == OK){
+	page->getRecord(rid, old);
+	if(flags & SLOTSTUB) memcpy(&target, old.data, sizeof(RID));
+	if(flags & SLOTOVFL) memcpy(&oldDesc, old.data, sizeof(OvflDesc));
+    }
+
+    if(status == OK && (unsigned int) rec.length > MAXINLINERECLEN){
+	// the slot keeps just the descriptor of the overflow chain
+	status = writeOverflow(rec, newDesc);
+	if(status == OK){
+	    stub.data = &newDesc;
+	    stub.length = sizeof(OvflDesc);
+	    status = page->updateRecord(rid, stub);
+	    if(status == OK) status = page->setFlags(rid, SLOTOVFL);
+	    // a chain the slot does not lead to would be unreachable
+	    if(status != OK) freeOverflow(newDesc);
+	}
+	dropMoved = (flags & SLOTSTUB);
+	dropOvfl = (flags & SLOTOVFL);
+    }
+    else if(status == OK && (flags & SLOTSTUB)){
+	// see if the record fits back on its own page
+	status = page->updateRecord(rid, rec);
+	if(status == OK){
+	    status = page->setFlags(rid, 0);
+	    dropMoved = true;
+	}
+	else if(status == NOSPACE){
+	    status = updateMoved(rid, target, rec, newTarget);
+	    if(status == OK) newPageNo = newTarget.pageNo;
+	    if(status == OK && (newTarget.pageNo != target.pageNo ||
+				newTarget.slotNo != target.slotNo)){
+		// moved again: point the stub at the new location, and
+		// only then let the old one go
+		stub.data = &newTarget;
+		stub.length = sizeof(RID);
+		status = page->updateRecord(rid, stub);
+		if(status == OK) dropMoved = true;
+		else if(bufMgr->readPage(filePtr, newTarget.pageNo,
+					 movedPage) == OK){
+		    // nothing leads to the new copy, so it goes again
+		    movedPage->deleteRecord(newTarget);
+		    bufMgr->unPinPage(filePtr, newTarget.pageNo, true);
+		}
+	    }
+	}
+    }
+    else if(status == OK){
+	status = page->updateRecord(rid, rec);
+	if(status == NOSPACE){
+	    // no room left on the page, move the record and leave a stub
+	    status = forwardRecord(rid, rec, newTarget);
+	    if(status == OK){
+		newPageNo = newTarget.pageNo;
+		stub.data = &newTarget;
+		stub.length = sizeof(RID);
+		status = page->updateRecord(rid, stub);
+		if(status == OK) status = page->setFlags(rid, SLOTSTUB);
+	    }
+	}
+	else if(status == OK && flags != 0) status = page->setFlags(rid, 0);
+	dropOvfl = (flags & SLOTOVFL);
+    }
+
+    // get rid of what the old version kept outside of its slot
+    if(status == OK && dropMoved){
+	status = bufMgr->readPage(filePtr, target.pageNo, movedPage);
+	if(status == OK){
+	    status = movedPage->deleteRecord(target);
+	    unpinstatus = bufMgr->unPinPage(filePtr, target.pageNo, true);
+	    if(status == OK) status = unpinstatus;
+	}
+    }
+    if(status == OK && dropOvfl) status = freeOverflow(oldDesc);
+
+    unpinstatus = bufMgr->unPinPage(filePtr, rid.pageNo, true);
+    if(status != OK) return status;
+    if(unpinstatus != OK) return unpinstatus;
+    status = widenZone(newPageNo, rec);
+    if(status != OK || indexes.empty()) return status;
+    old.data = oldBuf.data();
+    old.length = oldBuf.size();
+    status = notifyIndexes(old, rid, false);
+    if(status != OK) return status;
+    return notifyIndexes(rec, rid, true);
+}
+
+// matchRec kernels.  compareOp (filter.h) is resolved at compile time, so every
+// (Datatype, Operator) pair gets its own straight-line function and
+// numbers are compared exactly in their own type
+
+template <Operator op, class T>
+static bool matchNumber(const char* attr, const char* filter, const int)
+{
+    T a, f;                               // word-alignment problem possible
+    memcpy(&a, attr, sizeof(T));
+    memcpy(&f, filter, sizeof(T));
+    return compareOp<op>(a, f);
+}
+
+template <Operator op>
+static bool matchString(const char* attr, const char* filter,
+                        const int length)
+{
+    return compareOp<op>(strncmp(attr, filter, length), 0);
+}
+
+// indexed by Datatype, then Operator
+static const MatchFn matchFns[3][6] = {
+    { matchString<LT>, matchString<LTE>, matchString<EQ>,
+      matchString<GTE>, matchString<GT>, matchString<NE> },
+    { matchNumber<LT, int>, matchNumber<LTE, int>, matchNumber<EQ, int>,
+      matchNumber<GTE, int>, matchNumber<GT, int>, matchNumber<NE, int> },
+    { matchNumber<LT, float>, matchNumber<LTE, float>, matchNumber<EQ, float>,
+      matchNumber<GTE, float>, matchNumber<GT, float>, matchNumber<NE, float> }
+};
+
+// BETWEEN: filter holds the low bound and then the high one
+
+template <class T>
+static bool matchBetween(const char* attr, const char* filter, const int)
+{
+    T a, lo, hi;
+    memcpy(&a, attr, sizeof(T));
+    memcpy(&lo, filter, sizeof(T));
+    memcpy(&hi, filter + sizeof(T), sizeof(T));
+    return lo <= a && a <= hi;
+}
+
+static bool matchBetweenString(const char* attr, const char* filter,
+                               const int length)
+{
+    return strncmp(attr, filter, length) >= 0 &&
+           strncmp(attr, filter + length, length) <= 0;
+}
+
+// IN: filter holds the number of values and then the values, sorted
+// and without duplicates, which are binary searched
+
+template <class T>
+static bool matchIn(const char* attr, const char* filter, const int)
+{
+    T a, v;
+    int lo = 0, hi;
+    memcpy(&a, attr, sizeof(T));
+    memcpy(&hi, filter, sizeof(int));
+    filter += sizeof(int);
+    while (lo < hi) {
+	int mid = (lo + hi) / 2;
+	memcpy(&v, filter + mid * sizeof(T), sizeof(T));
+	if (v < a) lo = mid + 1;
+	else if (a < v) hi = mid;
+	else return true;
+    }
+    return false;
+}
+
+static bool matchInString(const char* attr, const char* filter,
+                          const int length)
+{
+    int lo = 0, hi;
+    memcpy(&hi, filter, sizeof(int));
+    filter += sizeof(int);
+    while (lo < hi) {
+	int mid = (lo + hi) / 2;
+	int c = strncmp(attr, filter + mid * length, length);
+	if (c > 0) lo = mid + 1;
+	else if (c < 0) hi = mid;
+	else return true;
+    }
+    return false;
+}
+
+// indexed by Datatype, BETWEEN and then IN
+static const MatchFn listFns[3][2] = {
+    { matchBetweenString, matchInString },
+    { matchBetween<int>, matchIn<int> },
+    { matchBetween<float>, matchIn<float> }
+};
+
+// fraction of the records a condition is guessed to let through, in
+// the absence of statistics.  the classic System R defaults
+static const double EQSEL = 0.1;
+static const double RANGESEL = 1.0 / 3;
+static const double BETWEENSEL = 0.25;
+static const double PATTERNSEL = 0.25;
+
+// copy value, a STRING of up to length bytes, to the end of buf padded
+// with NULs to length bytes
+
+static void appendPadded(string & buf, const char* value, const int length)
+{
+    buf.append(value, strnlen(value, length));
+    buf.append(length - strnlen(value, length), '\0');
+}
+
+// the value list of an IN term: the number of distinct values and then
+// the values in ascending order
+
+template <class T>
+static void sortValues(vector<T> & vals, string & buf)
+{
+    sort(vals.begin(), vals.end());
+    vals.erase(unique(vals.begin(), vals.end()), vals.end());
+    int cnt = vals.size();
+    buf.assign((const char*) &cnt, sizeof(int));
+    for (int i = 0; i < cnt; i++)
+	buf.append((const char*) &vals[i], sizeof(T));
+}
+
+static void sortValues(vector<string> & vals, string & buf)
+{
+    sort(vals.begin(), vals.end());
+    vals.erase(unique(vals.begin(), vals.end()), vals.end());
+    int cnt = vals.size();
+    buf.assign((const char*) &cnt, sizeof(int));
+    for (int i = 0; i < cnt; i++) buf += vals[i];
+}
+
+// order of the terms within a group: the likeliest to pass, per unit
+// of cost, first
+static bool passesSooner(const ScanTerm & a, const ScanTerm & b)
+{
+    return a.sel / a.cost > b.sel / b.cost;
+}
+
+// check a condition and turn it into a term: keep a copy of its filter,
+// pick the comparison functions and estimate what the term costs and
+// how many records pass it
+
+const Status compileCond(const ScanCond & c, ScanTerm & t)
+{
+    Operator	op = c.op;
+    int		i;
+
+    if ((c.offset < 0 || c.length < 1) || !c.filter ||
+        (c.type != STRING && c.type != INTEGER && c.type != FLOAT) ||
+        ((c.type == INTEGER && c.length != sizeof(int))
+         || (c.type == FLOAT && c.length != sizeof(float))) ||
+        (op < LT || op > IN) ||
+        (op >= PREFIX && op <= LIKE && c.type != STRING) ||
+        (op == IN && c.valCnt < 1))
+    {
+        return BADSCANPARM;
+    }
+
+    t.offset = c.offset;
+    t.length = c.length;
+    t.type = c.type;
+
+    // keep a copy of the filter.  a STRING value is padded with NULs to
+    // the full length, which strncmp cannot tell from the original and
+    // which lets the kernels read all length bytes of it
+    t.value.clear();
+    if (op == IN) {
+	if (c.type == STRING) {
+	    vector<string> vals(c.valCnt);
+	    for (i = 0; i < c.valCnt; i++)
+		appendPadded(vals[i], c.filter + i * c.length, c.length);
+	    sortValues(vals, t.value);
+	}
+	else if (c.type == INTEGER) {
+	    vector<int> vals(c.valCnt);
+	    memcpy(&vals[0], c.filter, c.valCnt * sizeof(int));
+	    sortValues(vals, t.value);
+	}
+	else {
+	    vector<float> vals;
+	    for (i = 0; i < c.valCnt; i++) {
+		float f;
+		memcpy(&f, c.filter + i * sizeof(float), sizeof(float));
+		if (f == f) vals.push_back(f);	// a NaN never matches
+	    }
+	    sortValues(vals, t.value);
+	}
+    }
+    else if (op == BETWEEN) {
+	if (c.type == STRING) {
+	    appendPadded(t.value, c.filter, c.length);
+	    appendPadded(t.value, c.filter + c.length, c.length);
+	}
+	else
+	    t.value.assign(c.filter, 2 * c.length);
+    }
+    else if (op > NE)
+	t.value.assign(c.filter);
+    else if (c.type == STRING)
+	appendPadded(t.value, c.filter, c.length);
+    else
+	t.value.assign(c.filter, c.length);
+    if (t.value.size() < (unsigned) c.length) t.value.resize(c.length, '\0');
+
+    // LIKE patterns of the form abc%, %abc% and abc are the same as
+    // PREFIX, CONTAINS and EQ, which need no pattern matching
+    if (op == LIKE && !strchr(t.value.c_str(), '_'))
+    {
+	string pat = t.value.c_str();
+	size_t pct = pat.find('%');
+	if (pct == string::npos && pat.size() <= (unsigned) c.length)
+	    op = EQ;
+	else if (pct == pat.size() - 1)
+	    op = PREFIX, pat.erase(pct);
+	else if (pct == 0 && pat.size() > 1 &&
+		 pat.find('%', 1) == pat.size() - 1)
+	    op = CONTAINS, pat = pat.substr(1, pat.size() - 2);
+	if (op != LIKE)
+	{
+	    t.value.assign(pat);
+	    if (t.value.size() < (unsigned) c.length)
+		t.value.resize(c.length, '\0');
+	}
+    }
+    t.op = op;
+
+    t.pageFilter = t.pageFilter2 = NULL;
+    if (op == BETWEEN || op == IN)
+	t.match = listFns[t.type][op == IN];
+    else {
+	t.match = (t.type == STRING) ? pickStringMatch(op) : NULL;
+	if (!t.match) t.match = matchFns[t.type][op];
+    }
+    if (op == BETWEEN) {
+	t.pageFilter = pickFilter(t.type, GTE);
+	t.pageFilter2 = pickFilter(t.type, LTE);
+    }
+    else if (op <= NE)
+	t.pageFilter = pickFilter(t.type, op);
+
+    switch (op) {
+    case EQ:      t.sel = EQSEL; break;
+    case NE:      t.sel = 1 - EQSEL; break;
+    case BETWEEN: t.sel = BETWEENSEL; break;
+    case IN:      t.sel = min(0.5, c.valCnt * EQSEL); break;
+    case PREFIX:  t.sel = EQSEL; break;
+    case CONTAINS:
+    case LIKE:    t.sel = PATTERNSEL; break;
+    default:      t.sel = RANGESEL; break;
+    }
+
+    // a vector kernel does a whole page at a cost about that of one
+    // strncmp, and a pattern goes over the whole attribute
+    if (t.pageFilter) t.cost = 0.25;
+    else if (op == CONTAINS || op == LIKE) t.cost = 4;
+    else if (op == IN) t.cost = 1 + log2(t.value.size() / t.length + 1);
+    else t.cost = (t.type == STRING) ? 2 : 1;
+    return OK;
+}
+
+HeapFileScan::HeapFileScan(const string & name,
+			   Status & status) : HeapFile(name, status)
+{
+    prefixLen = 0;
+    useZones = false;
+    curPageIdx = 0;
+    markedPageIdx = 0;
+    markedPageMoved = false;
+    readAhead = 0;
+}
+
+const Status HeapFileScan::startScan(const int offset_,
+				     const int length_,
+				     const Datatype type_, 
+				     const char* filter_,
+				     const Operator op_)
+{
+    ScanCond	cond;
+
+    if (!filter_)                          // no filtering requested
+	return startScan(NULL, 0);
+    if (op_ == IN) return BADSCANPARM;
+
+    cond.offset = offset_;
+    cond.length = length_;
+    cond.type = type_;
+    cond.op = op_;
+    cond.filter = filter_;
+    cond.valCnt = 0;
+    cond.group = 0;
+    return startScan(&cond, 1);
+}
+
+// compile the conditions into terms and put them in the order that
+// should rule records out soonest.  within a group the term most likely
+// to pass comes first, per unit of cost, as one that passes settles
+// the group; the groups go in order of how many records they can be
+// expected to rule out per unit of cost.  a group is evaluated only
+// for the records that passed the ones before it
+
+const Status HeapFileScan::startScan(const ScanCond* conds, const int condCnt)
+{
+    Status	status;
+    int		i, j;
+
+    movedByScan.clear();
+    terms.clear();
+    groupEnd.clear();
+    prefixLen = 0;
+    useZones = false;
+    if (condCnt < 0 || (condCnt > 0 && !conds)) return BADSCANPARM;
+
+    vector<ScanTerm> all(condCnt);
+    for (i = 0; i < condCnt; i++) {
+	status = compileCond(conds[i], all[i]);
+	if (status != OK) return status;
+	if (conds[i].offset + conds[i].length > prefixLen)
+	    prefixLen = conds[i].offset + conds[i].length;
+    }
+
+    // collect the groups and their estimates
+    vector<int> groupOf;		// group number of each entry of groups
+    vector<vector<ScanTerm> > groups;
+    for (i = 0; i < condCnt; i++) {
+	for (j = 0; j < (int) groupOf.size(); j++)
+	    if (groupOf[j] == conds[i].group) break;
+	if (j == (int) groupOf.size()) {
+	    groupOf.push_back(conds[i].group);
+	    groups.push_back(vector<ScanTerm>());
+	}
+	groups[j].push_back(all[i]);
+    }
+
+    vector<pair<double, int> > order;	// (-rank, group)
+    for (j = 0; j < (int) groups.size(); j++) {
+	double fail = 1, cost = 0;
+	stable_sort(groups[j].begin(), groups[j].end(), passesSooner);
+	for (i = 0; i < (int) groups[j].size(); i++) {
+	    cost += fail * groups[j][i].cost;
+	    fail *= 1 - groups[j][i].sel;
+	}
+	order.push_back(make_pair(-fail / cost, j));
+    }
+    stable_sort(order.begin(), order.end());
+
+    for (j = 0; j < (int) order.size(); j++) {
+	vector<ScanTerm> & g = groups[order[j].second];
+	terms.insert(terms.end(), g.begin(), g.end());
+	groupEnd.push_back(terms.size());
+    }
+
+    // a group with a term the zones know nothing of may always pass
+    for (j = 0; j < (int) groupEnd.size() && !useZones; j++) {
+	useZones = true;
+	for (i = j ? groupEnd[j-1] : 0; i < groupEnd[j]; i++)
+	    if (zoneAttrOf(headerPage, terms[i]) < 0) useZones = false;
+    }
+    return OK;
+}
+
+
+const Status HeapFileScan::endScan()
+{
+    Status status;
+    // generally must unpin last page of the scan
+    if (curPage != NULL)
+    {
+        status = bufMgr->unPinPage(filePtr, curPageNo, curDirtyFlag);
+        curPage = NULL;
+        curPageNo = 0;
+		curDirtyFlag = false;
+        return status;
+    }
+    return OK;
+}
+
+HeapFileScan::~HeapFileScan()
+{
+    endScan();
+}
+
+const Status HeapFileScan::markScan()
+{
+    // make a snapshot of the state of the scan
+    markedPageNo = curPageNo;
+    markedRec = curRec;
+    markedPageIdx = curPageIdx;
+    markedPageMoved = curPageMoved;
+    return OK;
+}
+
+const Status HeapFileScan::resetScan()
+{
+    Status status;
+    if (markedPageNo != curPageNo) 
+    {
+		if (curPage != NULL)
+		{
+			status = bufMgr->unPinPage(filePtr, curPageNo, curDirtyFlag);
+			if (status != OK) return status;
+		}
+		// restore curPageNo and curRec values
+		curPageNo = markedPageNo;
+		curRec = markedRec;
+		// then read the page
+		status = bufMgr->readPage(filePtr, curPageNo, curPage);
+		if (status != OK) return status;
+		curDirtyFlag = false; // it will be clean
+    }
+    else curRec = markedRec;
+    curPageIdx = markedPageIdx;
+    curPageMoved = markedPageMoved;
+    return OK;
+}
+
+// the page is looked up in the page directory, so this costs the same
+// for every page of the file
+
+const Status HeapFileScan::seekPage(const int idx)
+{
+    Status	status;
+    int		pageNo;
+    Page*	newPage;
+
+    status = getPageNo(idx, pageNo);
+    if (status != OK) return status;
+    if (curPage != NULL)
+    {
+	status = bufMgr->unPinPage(filePtr, curPageNo, curDirtyFlag);
+	curPage = NULL;
+	if (status != OK) return status;
+    }
+    status = bufMgr->readPage(filePtr, pageNo, newPage);
+    if (status != OK) return status;
+    curPage = newPage;
+    curPageNo = pageNo;
+    curDirtyFlag = false;
+    curRec = NULLRID;
+    curPageIdx = idx;
+    curPageMoved = false;
+    return OK;
+}
+
+const Status HeapFileScan::setReadAhead(const int pages)
+{
+    if (pages < 0) return BADSCANPARM;
+    readAhead = pages;
+    if (readAhead > 0 && curPage != NULL)
+	return prefetchPages(curPageIdx + 1, 2 * readAhead);
+    return OK;
+}
+
+
+// return the RID of the next record that satisfies the scan.  records
+// are visited where they are physically stored: forwarding stubs are
+// skipped and a moved record is returned, under the RID of its stub,
+// when the scan reaches the page it moved to
+
+const Status HeapFileScan::scanNext(RID& outRid)
+{
+    Status 	status = OK;
+    RID		tmpRid, homeRid;
+    Record      rec;
+    short	flags;
+
+    if(curPage == NULL) return FILEEOF;
+
+    if(curRec.slotNo == -1)
+	status = curPage->firstRecord(tmpRid);
+    else
+	status = curPage->nextRecord(curRec, tmpRid);
+
+    while(true){
+	while(status == OK){
+	    curRec = tmpRid;
+	    status = curPage->getFlags(tmpRid, flags);
+	    if(status != OK) return status;
+	    if(!(flags & SLOTSTUB)){
+		status = curPage->getRecord(tmpRid, rec);
+		if(status != OK) return status;
+		homeRid = tmpRid;
+		if(flags & SLOTMOVED) unwrapMoved(rec, homeRid);
+		if((flags & SLOTOVFL) && !terms.empty()){
+		    status = readFilterPrefix(rec);
+		    if(status != OK) return status;
+		}
+		//check if match, if match, return the record
+		if(!((flags & SLOTMOVED) && movedByScan.count(
+			make_pair(homeRid.pageNo, homeRid.slotNo))) &&
+		   matchRec(rec)){
+		    outRid = homeRid;
+		    return OK;
+		}
+	    }
+	    status = curPage->nextRecord(curRec, tmpRid);
+	}
+	if((status != ENDOFPAGE) && (status != NORECORDS)) return status;
+
+	//all records on the page have been processed, move on to the next
+	status = nextScanPage();
+	if(status != OK) return status;
+	status = curPage->firstRecord(tmpRid);
+    }
+}
+
+// the same as scanNext for a whole batch: the live slots of the page
+// are fetched a run at a time and filtered in place in rids and recs.
+// the predicate is applied to the whole run at once by matchRun.  a
+// page without a match is passed over like scanNext does, but the
+// batch ends at the end of a page so that its records stay pinned
+
+const Status HeapFileScan::scanBatch(const int max, RID* rids, Record* recs,
+				     int & cnt)
+{
+    Status	status;
+    short	flags[MAXSLOTS];
+    RID		rid, homeRid;
+    Record	rec, stored;
+    int		base, want, n, k, from;
+    unsigned long long sel[SLOTMAPWORDS];
+    bool	filtered = !terms.empty();
+
+    cnt = 0;
+    if(max < 1) return BADSCANPARM;
+    if(curPage == NULL) return FILEEOF;
+
+    while(true){
+	base = cnt;
+	from = 0;
+	want = (max - cnt < (int) MAXSLOTS) ? max - cnt : MAXSLOTS;
+	status = curPage->getRecords(curRec.slotNo + 1, want, rids + base,
+				     recs + base, flags, n);
+	if(status != OK) return status;
+
+	// plain records are filtered here, the others by matchRec below
+	if(filtered){
+	    bool plain = matchRun(recs + base, flags, n, sel);
+
+	    // with no stubs, moved or large records in the run the
+	    // selection bitmap says it all: keep just the selected ones
+	    if(plain && n > 0){
+		rid = rids[base + n - 1];
+		for(int w = 0; w * 64 < n; w++){
+		    unsigned long long bits = sel[w];
+		    for(; bits != 0; bits &= bits - 1){
+			k = w * 64 + __builtin_ctzll(bits);
+			rids[cnt] = rids[base + k];
+			recs[cnt] = recs[base + k];
+			cnt++;
+		    }
+		}
+		curRec = rid;
+		from = n;
+	    }
+	}
+
+	for(k = from; k < n; k++){
+	    rid = rids[base + k];
+	    rec = recs[base + k];
+	    if(flags[k] & SLOTSTUB){
+		curRec = rid;
+		continue;
+	    }
+	    homeRid = rid;
+	    if(flags[k] & SLOTMOVED){
+		unwrapMoved(rec, homeRid);
+		if(movedByScan.count(make_pair(homeRid.pageNo, homeRid.slotNo))){
+		    curRec = rid;
+		    continue;
+		}
+	    }
+	    if(flags[k] & SLOTOVFL){
+		// a large record is read into ovflBuf, so it cannot share
+		// a batch with another one.  end the batch in front of it
+		if(cnt > 0) return OK;
+		stored = rec;
+		if(!terms.empty()){
+		    status = readFilterPrefix(rec);
+		    if(status != OK) return status;
+		}
+		curRec = rid;
+		if(!matchRec(rec)) continue;
+		status = readLargeRecord(stored, recs[0]);
+		if(status != OK) return status;
+		rids[0] = homeRid;
+		cnt = 1;
+		return OK;
+	    }
+	    curRec = rid;
+	    if((filtered && flags[k] == 0) ? sel[k / 64] >> (k % 64) & 1
+					   : matchRec(rec)){
+		rids[cnt] = homeRid;
+		recs[cnt] = rec;
+		cnt++;
+	    }
+	}
+
+	if(cnt == max) return OK;
+	if(n == want) continue;		// page not done yet
+	if(cnt > 0) return OK;
+
+	status = nextScanPage();
+	if(status != OK) return status;
+    }
+}
+
+// copy column col out of the n records of recs into the slots from
+// first onwards of array out.  the common 4-byte case gets a loop of
+// its own, which compiles to plain loads and stores
+
+static void copyColumn(const ScanColumn & col, const Record* recs,
+                       const int n, char* out, const int first)
+{
+    const int	end = col.offset + col.length;
+    char*	dst = out + first * col.length;
+
+    if (col.length == sizeof(int))
+    {
+	for (int k = 0; k < n; k++, dst += sizeof(int))
+	{
+	    if (end <= recs[k].length)
+		memcpy(dst, (char*)recs[k].data + col.offset, sizeof(int));
+	    else
+		memset(dst, 0, sizeof(int));
+	}
+	return;
+    }
+    for (int k = 0; k < n; k++, dst += col.length)
+    {
+	if (end <= recs[k].length)
+	    memcpy(dst, (char*)recs[k].data + col.offset, col.length);
+	else
+	    memset(dst, 0, col.length);
+    }
+}
+
+// batches of scanBatch are copied out a column at a time until max
+// records have been found or the file ends
+
+const Status HeapFileScan::scanColumns(const ScanColumn* cols,
+				       const int colCnt, char* const* out,
+				       const int max, RID* rids, int & cnt)
+{
+    Status	status;
+    RID		batchRids[MAXSLOTS];
+    Record	batchRecs[MAXSLOTS];
+    int		n, c;
+
+    cnt = 0;
+    if(max < 1 || colCnt < 0 || (colCnt > 0 && (!cols || !out)))
+	return BADSCANPARM;
+    for(c = 0; c < colCnt; c++)
+	if(cols[c].offset < 0 || cols[c].length < 1 || !out[c])
+	    return BADSCANPARM;
+
+    while(cnt < max){
+	status = scanBatch((max - cnt < (int) MAXSLOTS) ? max - cnt : MAXSLOTS,
+			   batchRids, batchRecs, n);
+	if(status == FILEEOF && cnt > 0) break;
+	if(status != OK) return status;
+
+	for(c = 0; c < colCnt; c++)
+	    copyColumn(cols[c], batchRecs, n, out[c], cnt);
+	if(rids) memcpy(rids + cnt, batchRids, n * sizeof(RID));
+	cnt += n;
+    }
+    return OK;
+}
+
+// unpin the current page of the scan and pin the one after it.
+// returns FILEEOF after the last page of the file
+
+const Status HeapFileScan::nextScanPage()
+{
+    Status	status;
+    int		nextPageNo, pageNo, idx;
+    Page*	newPage;
+    vector<int>	pageNos;
+    bool	skip;
+
+    if(curPageNo == headerPage->lastPage) return FILEEOF;
+    curPage->getNextPage(nextPageNo);
+
+    // getRecord may have moved curPage anywhere in the file.  the data
+    // pages are chained in directory order, so the scan goes on from
+    // there once the page is found in the directory
+    if(curPageMoved){
+	status = getPageNos(pageNos);
+	if(status != OK) return status;
+	curPageIdx = find(pageNos.begin(), pageNos.end(), curPageNo) -
+		     pageNos.begin();
+	curPageMoved = false;
+    }
+    idx = curPageIdx + 1;
+
+    // pages whose zones rule the predicate out are passed over without
+    // reading them, the pages after one being found in the directory
+    if(useZones && headerPage->zoneAttrCnt > 0){
+	while(true){
+	    status = zoneRulesOut(nextPageNo, skip);
+	    if(status != OK) return status;
+	    if(!skip) break;
+	    if(nextPageNo == headerPage->lastPage) return FILEEOF;
+	    status = getPageNo(++idx, nextPageNo);
+	    if(status != OK) return status;
+	}
+    }
+
+    status = bufMgr->unPinPage(filePtr, curPageNo, curDirtyFlag);
+    if(status != OK) return status;
+    status = bufMgr->readPage(filePtr, nextPageNo, newPage);
+    if(status != OK){
+	curPage = NULL;
+	return status;
+    }
+    curPageNo = nextPageNo;
+    curPage = newPage;
+    curDirtyFlag = false;
+    curRec = NULLRID;
+
+    // at the start of every window of readAhead pages ask for the
+    // window after it, so those are read while this one is scanned
+    pageNo = curPageIdx;
+    curPageIdx = idx;
+    if(readAhead > 0 && curPageIdx / readAhead != pageNo / readAhead)
+	return prefetchPages(curPageIdx / readAhead * readAhead + readAhead,
+			     readAhead);
+    return OK;
+}
+
+// can a record whose attribute lies in [lo, hi] pass term t.  the
+// bounds are compared as the records would be, so a NaN bound passes
+// over nothing it should not
+
+template <class T>
+static bool rangeMayPass(const ScanTerm & t, const T lo, const T hi)
+{
+    const char*	v = t.value.data();
+    T		a, b;
+    int		cnt, l = 0, h;
+
+    if(lo > hi) return false;		// no record has the attribute
+    memcpy(&a, v, sizeof(T));
+    switch(t.op){
+    case LT:	return lo < a;
+    case LTE:	return lo <= a;
+    case EQ:	return lo <= a && a <= hi;
+    case GTE:	return hi >= a;
+    case GT:	return hi > a;
+    case NE:	return !(lo == a && hi == a);
+    case BETWEEN:
+	memcpy(&b, v + sizeof(T), sizeof(T));
+	return lo <= b && a <= hi;
+    case IN:
+	// the first value not below lo, if any, must not be above hi
+	memcpy(&cnt, v, sizeof(int));
+	v += sizeof(int);
+	for(h = cnt; l < h; ){
+	    int mid = (l + h) / 2;
+	    memcpy(&b, v + mid * sizeof(T), sizeof(T));
+	    if(b < lo) l = mid + 1;
+	    else h = mid;
+	}
+	if(l == cnt) return false;
+	memcpy(&b, v + l * sizeof(T), sizeof(T));
+	return b <= hi;
+    default:
+	return true;
+    }
+}
+
+// every group must have a term that may pass.  a term on an attribute
+// without zones always may
+
+const bool HeapFileScan::zoneMayMatch(const char* zone) const
+{
+    int		i, g, a;
+    int		ilo, ihi;
+    float	flo, fhi;
+    bool	pass;
+
+    for(g = 0, i = 0; g < (int) groupEnd.size(); g++){
+	pass = false;
+	for(; i < groupEnd[g]; i++){
+	    if(pass) continue;
+	    a = zoneAttrOf(headerPage, terms[i]);
+	    if(a < 0) pass = true;
+	    else if(terms[i].type == INTEGER){
+		memcpy(&ilo, zone + 2 * a * sizeof(int), sizeof(int));
+		memcpy(&ihi, zone + (2 * a + 1) * sizeof(int), sizeof(int));
+		pass = rangeMayPass(terms[i], ilo, ihi);
+	    }
+	    else{
+		memcpy(&flo, zone + 2 * a * sizeof(int), sizeof(float));
+		memcpy(&fhi, zone + (2 * a + 1) * sizeof(int), sizeof(float));
+		pass = rangeMayPass(terms[i], flo, fhi);
+	    }
+	}
+	if(!pass) return false;
+    }
+    return true;
+}
+
+// a page beyond the zone maps, which cannot happen unless they were
+// declared while this scan's file was open elsewhere, is not skipped
+
+const Status HeapFileScan::zoneRulesOut(const int pageNo, bool & skip)
+{
+    Status	status;
+    Page*	zonePage;
+    int		zonePageNo;
+    char*	zone;
+
+    skip = false;
+    status = findZone(pageNo, false, zonePageNo, zonePage, zone);
+    if(status != OK || !zone) return status;
+    skip = !zoneMayMatch(zone);
+    return bufMgr->unPinPage(filePtr, zonePageNo, false);
+}
+
+
+// state shared by the threads of a parallelScan
+struct ParScanJob
+{
+  const HeapFileScan*	scan;
+  File*			file;
+  vector<int>		pageNos;	// the data pages of the file
+  atomic<int>		next;		// index of the next page to hand out
+  mutex			poolLock;	// BufMgr is not thread safe
+  ScanBatchFn		fn;
+  void*			arg;
+};
+
+// what a parallelScan thread returns
+struct ParScanResult
+{
+  Status		status;
+  vector<RID>		large;		// large records it came across
+};
+
+// the pages are handed out PARSCANGROUP at a time, so a thread that
+// gets pages with many matches does not hold up the others.  only
+// pinning and unpinning is done under the lock
+
+void HeapFileScan::scanWorker(ParScanJob* job, const int worker,
+			      ParScanResult* result)
+{
+    RID		rids[MAXSLOTS];
+    Record	recs[MAXSLOTS];
+    Page*	page;
+    Status	status = OK, unpinstatus;
+    const int	total = job->pageNos.size();
+    int		cnt;
+
+    while(status == OK){
+	int first = job->next.fetch_add(PARSCANGROUP);
+	if(first >= total) break;
+	int last = (first + PARSCANGROUP < total) ? first + PARSCANGROUP : total;
+	for(int i = first; i < last && status == OK; i++){
+	    int pageNo = job->pageNos[i];
+	    {
+		lock_guard<mutex> guard(job->poolLock);
+		status = bufMgr->readPage(job->file, pageNo, page);
+	    }
+	    if(status != OK) break;
+	    status = job->scan->matchPage(page, rids, recs, cnt, result->large);
+	    if(status == OK && cnt > 0) job->fn(job->arg, worker, rids, recs, cnt);
+	    {
+		lock_guard<mutex> guard(job->poolLock);
+		unpinstatus = bufMgr->unPinPage(job->file, pageNo, false);
+	    }
+	    if(status == OK) status = unpinstatus;
+	}
+    }
+    result->status = status;
+}
+
+// the page list is made up front so that the threads need not follow
+// the chain.  large records need a walk of their overflow chain through
+// the scan's own state, so they are left until the threads are done
+
+const Status HeapFileScan::parallelScan(const int nThreads, ScanBatchFn fn,
+					void* arg)
+{
+    ParScanJob	job;
+    Status	status;
+    Record	rec;
+    int		i;
+
+    if(nThreads < 1 || !fn) return BADSCANPARM;
+    if(curPage == NULL) return FILEEOF;
+
+    status = getPageNos(job.pageNos);
+    if(status != OK) return status;
+    job.scan = this;
+    job.file = filePtr;
+    job.next = 0;
+    job.fn = fn;
+    job.arg = arg;
+
+    ParScanResult* results = new ParScanResult[nThreads];
+    thread** threads = new thread*[nThreads];
+    for(i = 0; i < nThreads; i++)
+	threads[i] = new thread(scanWorker, &job, i, &results[i]);
+    for(i = 0; i < nThreads; i++){
+	threads[i]->join();
+	delete threads[i];
+	if(status == OK) status = results[i].status;
+    }
+    delete [] threads;
+
+    for(i = 0; i < nThreads && status == OK; i++)
+	for(unsigned k = 0; k < results[i].large.size() && status == OK; k++){
+	    RID rid = results[i].large[k];
+	    status = HeapFile::getRecord(rid, rec);
+	    if(status == OK && matchRec(rec)) fn(arg, 0, &rid, &rec, 1);
+	}
+    delete [] results;
+
+    Status endstatus = endScan();
+    return (status != OK) ? status : endstatus;
+}
+
+// scanBatch over a whole page at once, for any page of the file and
+// without touching the state of the scan
+
+const Status HeapFileScan::matchPage(Page* page, RID* rids, Record* recs,
+				     int & cnt, vector<RID> & large) const
+{
+    Status	status;
+    short	flags[MAXSLOTS];
+    unsigned long long sel[SLOTMAPWORDS];
+    RID		homeRid;
+    Record	rec;
+    int		n, k;
+
+    cnt = 0;
+    status = page->getRecords(0, MAXSLOTS, rids, recs, flags, n);
+    if(status != OK) return status;
+    if(!terms.empty()) matchRun(recs, flags, n, sel);
+    else{
+	memset(sel, 0, sizeof(sel));
+	for(k = 0; k < n; k++)
+	    if(flags[k] == 0) sel[k / 64] |= 1ULL << (k % 64);
+    }
+
+    for(k = 0; k < n; k++){
+	if(flags[k] == 0){
+	    if(sel[k / 64] >> (k % 64) & 1){
+		rids[cnt] = rids[k];
+		recs[cnt] = recs[k];
+		cnt++;
+	    }
+	    continue;
+	}
+	if(flags[k] & SLOTSTUB) continue;
+	homeRid = rids[k];
+	rec = recs[k];
+	if(flags[k] & SLOTMOVED) unwrapMoved(rec, homeRid);
+	if(flags[k] & SLOTOVFL) large.push_back(homeRid);
+	else if(matchRec(rec)){
+	    rids[cnt] = homeRid;
+	    recs[cnt] = rec;
+	    cnt++;
+	}
+    }
+    return OK;
+}
+
+// returns pointer to the current record.  page is left pinned
+// and the scan logic is required to unpin the page 
+
+const Status HeapFileScan::getRecord(Record & rec)
+{
+    Status	status;
+    short	flags;
+    RID		homeRid;
+
+    status = curPage->getFlags(curRec, flags);
+    if (status != OK) return status;
+    status = curPage->getRecord(curRec, rec);
+    if (status == OK && (flags & SLOTMOVED)) unwrapMoved(rec, homeRid);
+    if (status == OK && (flags & SLOTOVFL)) status = readLargeRecord(rec, rec);
+    return status;
+}
+
+// a large record is only read as far as the filter attribute goes.
+// rec holds its OvflDesc on entry and the record prefix, with the
+// full record length, on return.  enough for matchRec
+
+const Status HeapFileScan::readFilterPrefix(Record & rec)
+{
+    OvflDesc	desc;
+    int		n;
+
+    memcpy(&desc, rec.data, sizeof(OvflDesc));
+    n = prefixLen;
+    if (n > desc.length) n = desc.length;
+    ovflBuf.resize(n + 1);
+    rec.data = &ovflBuf[0];
+    rec.length = desc.length;
+    return readOverflow(desc, 0, &ovflBuf[0], n);
+}
+
+// delete record from fie. 
+const Status HeapFileScan::deleteRecord()
+{
+    Status	status, unpinstatus;
+    short	flags;
+    Record	rec;
+    RID		homeRid;
+    Page*	homePage;
+    OvflDesc	desc;
+    vector<char> oldBuf;
+
+    status = curPage->getFlags(curRec, flags);
+    if (status != OK) return status;
+    homeRid = curRec;
+    if (flags & SLOTMOVED)
+    {
+	curPage->getRecord(curRec, rec);
+	unwrapMoved(rec, homeRid);
+    }
+    if (!indexes.empty())
+    {
+	status = copyRecord(homeRid, oldBuf);
+	if (status != OK) return status;
+    }
+
+    // a moved record takes its forwarding stub with it
+    if (flags & SLOTMOVED)
+    {
+	status = bufMgr->readPage(filePtr, homeRid.pageNo, homePage);
+	if (status != OK) return status;
+	status = homePage->deleteRecord(homeRid);
+	unpinstatus = bufMgr->unPinPage(filePtr, homeRid.pageNo, true);
+	if (status != OK) return status;
+	if (unpinstatus != OK) return unpinstatus;
+    }
+
+    // a large record's overflow pages go as well
+    if (flags & SLOTOVFL)
+    {
+	curPage->getRecord(curRec, rec);
+	memcpy(&desc, rec.data, sizeof(OvflDesc));
+	status = freeOverflow(desc);
+	if (status != OK) return status;
+    }
+
+    // delete the "current" record from the page
+    status = curPage->deleteRecord(curRec);
+    curDirtyFlag = true;
+
+    // reduce count of number of records in the file
+    headerPage->recCnt--;
+    hdrDirtyFlag = true; 
+    if (status == OK) status = rezonePage(curPageNo, curPage);
+    if (status != OK || indexes.empty()) return status;
+    rec.data = oldBuf.data();
+    rec.length = oldBuf.size();
+    return notifyIndexes(rec, homeRid, false);
+}
+
+// records that are neither moved nor large are deleted from the page
+// as it goes by.  the others, whose stubs or overflow pages are on
+// other pages, are left to deleteRecords, large ones once getRecords
+// has read them in to be matched
+
+const Status HeapFileScan::deleteWhere(int & deleted)
+{
+    Status	status = OK;
+    RID		rids[MAXSLOTS], homeRid;
+    Record	recs[MAXSLOTS], rec;
+    short	flags[MAXSLOTS];
+    unsigned long long sel[SLOTMAPWORDS];
+    vector<RID>	others, large;
+    int		n, k, dropped;
+
+    deleted = 0;
+    if(curPage == NULL) return FILEEOF;
+
+    while(status == OK){
+	status = curPage->getRecords(curRec.slotNo + 1, MAXSLOTS, rids, recs,
+				     flags, n);
+	if(status != OK) break;
+	if(!terms.empty()) matchRun(recs, flags, n, sel);
+	else{
+	    memset(sel, 0, sizeof(sel));
+	    for(k = 0; k < n; k++)
+		if(flags[k] == 0) sel[k / 64] |= 1ULL << (k % 64);
+	}
+
+	dropped = 0;
+	for(k = 0; k < n && status == OK; k++){
+	    if(flags[k] == 0){
+		if(sel[k / 64] >> (k % 64) & 1){
+		    if(!indexes.empty()){
+			status = notifyIndexes(recs[k], rids[k], false);
+			if(status != OK) break;
+		    }
+		    status = curPage->deleteRecord(rids[k]);
+		    if(status == OK) dropped++;
+		}
+		continue;
+	    }
+	    if(flags[k] & SLOTSTUB) continue;
+	    homeRid = rids[k];
+	    rec = recs[k];
+	    if(flags[k] & SLOTMOVED){
+		unwrapMoved(rec, homeRid);
+		if(movedByScan.count(make_pair(homeRid.pageNo, homeRid.slotNo)))
+		    continue;
+	    }
+	    if(flags[k] & SLOTOVFL) large.push_back(homeRid);
+	    else if(matchRec(rec)) others.push_back(homeRid);
+	}
+	if(dropped > 0){
+	    curDirtyFlag = true;
+	    headerPage->recCnt -= dropped;
+	    hdrDirtyFlag = true;
+	    deleted += dropped;
+	    if(status == OK) status = rezonePage(curPageNo, curPage);
+	}
+	if(status != OK) break;
+	status = nextScanPage();
+    }
+    if(status != FILEEOF) return status;
+
+    if(!large.empty()){
+	vector<Record> lrecs(large.size());
+	status = getRecords(&large[0], large.size(), &lrecs[0]);
+	if(status != OK) return status;
+	for(unsigned i = 0; i < large.size(); i++)
+	    if(matchRec(lrecs[i])) others.push_back(large[i]);
+    }
+    if(!others.empty()){
+	status = deleteRecords(&others[0], others.size(), dropped);
+	deleted += dropped;
+	if(status != OK) return status;
+    }
+    return endScan();
+}
+
+// the records of the current page are matched a run at a time, as in
+// deleteWhere.  a record fn changes in place stays where it is.  any
+// other goes through updateRecord, which may rearrange the page, so
+// the rest of the page is fetched again after it.  large records are
+// read in whole to be matched and are always written back
+
+const Status HeapFileScan::updateWhere(UpdateFn fn, void* arg, int & updated)
+{
+    Status	status = OK;
+    RID		rids[MAXSLOTS], homeRid;
+    Record	recs[MAXSLOTS], rec, newRec;
+    short	flags[MAXSLOTS];
+    unsigned long long sel[SLOTMAPWORDS];
+    vector<char> largeBuf, oldBuf;
+    Record	old;
+    int		n, k;
+    bool	refetch;
+    bool	inPlace = false;	// records of the page changed in place
+
+    updated = 0;
+    if(!fn) return BADSCANPARM;
+    if(curPage == NULL) return FILEEOF;
+
+    while(status == OK){
+	status = curPage->getRecords(curRec.slotNo + 1, MAXSLOTS, rids, recs,
+				     flags, n);
+	if(status != OK) break;
+	if(!terms.empty()) matchRun(recs, flags, n, sel);
+	else{
+	    memset(sel, 0, sizeof(sel));
+	    for(k = 0; k < n; k++)
+		if(flags[k] == 0) sel[k / 64] |= 1ULL << (k % 64);
+	}
+
+	refetch = false;
+	for(k = 0; k < n && !refetch && status == OK; k++){
+	    curRec = rids[k];
+	    homeRid = rids[k];
+	    rec = recs[k];
+	    if(flags[k] == 0){
+		if(!(sel[k / 64] >> (k % 64) & 1)) continue;
+	    }
+	    else{
+		if(flags[k] & SLOTSTUB) continue;
+		if(flags[k] & SLOTMOVED){
+		    unwrapMoved(rec, homeRid);
+		    if(movedByScan.count(make_pair(homeRid.pageNo,
+						   homeRid.slotNo)))
+			continue;
+		}
+		if(flags[k] & SLOTOVFL){
+		    status = readLargeRecord(rec, rec);
+		    if(status != OK) break;
+		    largeBuf.assign((char*) rec.data,
+				    (char*) rec.data + rec.length);
+		    rec.data = &largeBuf[0];
+		}
+		if(!matchRec(rec)) continue;
+	    }
+
+	    updated++;
+	    if(!indexes.empty())
+		oldBuf.assign((char*) rec.data, (char*) rec.data + rec.length);
+	    if(fn(arg, rec, newRec)){
+		status = updateRecord(newRec);
+		refetch = true;
+	    }
+	    else if(flags[k] & SLOTOVFL){
+		status = updateRecord(rec);
+		refetch = true;
+	    }
+	    else{
+		curDirtyFlag = true;
+		inPlace = true;
+		if(indexes.empty()) continue;
+		// updateRecord tells the indexes itself, this does not
+		old.data = oldBuf.data();
+		old.length = oldBuf.size();
+		status = notifyIndexes(old, homeRid, false);
+		if(status == OK) status = notifyIndexes(rec, homeRid, true);
+	    }
+	}
+	if(status != OK || refetch) continue;
+	// the zone of the page is redone once for all of them
+	if(inPlace) status = rezonePage(curPageNo, curPage);
+	inPlace = false;
+	if(status == OK) status = nextScanPage();
+    }
+    if(status != FILEEOF) return status;
+    return endScan();
+}
+
+// state of the assignments an updateWhere applies
+struct ScanSetJob
+{
+  const ScanSet*	sets;
+  int			setCnt;
+  int			end;		// the longest record they need
+  vector<char>		buf;		// a record that had to grow
+};
+
+static bool applySets(void* arg, const Record & rec, Record & newRec)
+{
+    ScanSetJob*	job = (ScanSetJob*) arg;
+    char*	data = (char*) rec.data;
+    int		i;
+
+    if(rec.length < job->end){
+	job->buf.assign(job->end, 0);
+	memcpy(&job->buf[0], rec.data, rec.length);
+	data = &job->buf[0];
+    }
+    for(i = 0; i < job->setCnt; i++)
+	memcpy(data + job->sets[i].offset, job->sets[i].value,
+	       job->sets[i].length);
+    if(data == rec.data) return false;
+    newRec.data = data;
+    newRec.length = job->end;
+    return true;
+}
+
+const Status HeapFileScan::updateWhere(const ScanSet* sets, const int setCnt,
+				       int & updated)
+{
+    ScanSetJob	job;
+    int		i;
+
+    updated = 0;
+    if(setCnt < 1 || !sets) return BADSCANPARM;
+    job.sets = sets;
+    job.setCnt = setCnt;
+    job.end = 0;
+    for(i = 0; i < setCnt; i++){
+	if(sets[i].offset < 0 || sets[i].length < 1 || !sets[i].value)
+	    return BADSCANPARM;
+	if(sets[i].offset + sets[i].length > job.end)
+	    job.end = sets[i].offset + sets[i].length;
+    }
+    return updateWhere(applySets, &job, updated);
+}
+
+// update the current record through HeapFile::updateRecord.  a
+// record that leaves for another page is remembered so that the
+// scan skips it when it gets to its new page
+
+const Status HeapFileScan::updateRecord(const Record & rec)
+{
+    Status	status;
+    short	flags;
+    Record	old;
+    RID		homeRid;
+
+    status = curPage->getFlags(curRec, flags);
+    if (status != OK) return status;
+    homeRid = curRec;
+    if (flags & SLOTMOVED)
+    {
+	curPage->getRecord(curRec, old);
+	unwrapMoved(old, homeRid);
+    }
+
+    status = HeapFile::updateRecord(homeRid, rec);
+    if (status != OK) return status;
+    curDirtyFlag = true;
+
+    if ((flags & SLOTMOVED) ||
+        (curPage->getFlags(curRec, flags) == OK && (flags & SLOTSTUB)))
+	movedByScan.insert(make_pair(homeRid.pageNo, homeRid.slotNo));
+    return OK;
+}
+
+
+// mark current page of scan dirty
+const Status HeapFileScan::markDirty()
+{
+    curDirtyFlag = true;
+    return OK;
+}
+
+// does rec have the attribute of term t and does it pass t
+static inline bool matchTerm(const ScanTerm & t, const Record & rec)
+{
+    // see if offset + length is beyond end of record
+    // maybe this should be an error???
+    if ((t.offset + t.length - 1) >= rec.length)
+	return false;
+
+    return t.match((char *)rec.data + t.offset, t.value.data(), t.length);
+}
+
+const bool HeapFileScan::matchRec(const Record & rec) const
+{
+    int i = 0;
+
+    // every group needs one term that passes.  the remaining terms of a
+    // group and, once one group fails, the remaining groups are skipped
+    for (unsigned g = 0; g < groupEnd.size(); g++)
+    {
+	while (i < groupEnd[g] && !matchTerm(terms[i], rec)) i++;
+	if (i == groupEnd[g]) return false;
+	i = groupEnd[g];
+    }
+    return true;
+}
+
+// the predicate a run at a time.  sel starts out as the plain records
+// and each group narrows it down in turn.  a term is only evaluated
+// for the records still in sel that no earlier term of its group has
+// passed, except that a vector kernel compares the attributes of the
+// whole run, gathered into one array, as that is cheaper than picking
+// records out.  the array is reused by the terms that follow on the
+// same attribute
+
+const bool HeapFileScan::matchRun(const Record* recs, const short* flags,
+				  const int n, unsigned long long* sel) const
+{
+    union { int i[MAXSLOTS]; float f[MAXSLOTS]; } vals;
+    unsigned long long pass[SLOTMAPWORDS], todo[SLOTMAPWORDS];
+    unsigned long long bits[SLOTMAPWORDS], fits[SLOTMAPWORDS];
+    unsigned long long high[SLOTMAPWORDS];
+    bool	plain = true, left;
+    int		i = 0, k, w, gathered = -1;
+    const int	words = (n + 63) / 64;
+
+    memset(sel, 0, SLOTMAPWORDS * sizeof(unsigned long long));
+    for (k = 0; k < n; k++)
+    {
+	if (flags[k] == 0) sel[k / 64] |= 1ULL << (k % 64);
+	else plain = false;
+    }
+
+    for (unsigned g = 0; g < groupEnd.size(); g++)
+    {
+	memset(pass, 0, sizeof(pass));
+	for (; i < groupEnd[g]; i++)
+	{
+	    const ScanTerm & t = terms[i];
+
+	    left = false;
+	    for (w = 0; w < words; w++)
+	    {
+		todo[w] = sel[w] & ~pass[w];
+		left |= (todo[w] != 0);
+	    }
+	    if (!left) break;
+
+	    if (t.pageFilter)
+	    {
+		if (gathered != t.offset)
+		{
+		    memset(fits, 0, sizeof(fits));
+		    for (k = 0; k < n; k++)
+		    {
+			vals.i[k] = 0;
+			if (flags[k] == 0 && t.offset + t.length <= recs[k].length)
+			{
+			    memcpy(&vals.i[k], (char*)recs[k].data + t.offset,
+				   sizeof(int));
+			    fits[k / 64] |= 1ULL << (k % 64);
+			}
+		    }
+		    gathered = t.offset;
+		}
+		t.pageFilter(&vals, n, t.value.data(), bits);
+		if (t.pageFilter2)
+		{
+		    // BETWEEN: the high bound as well
+		    t.pageFilter2(&vals, n, t.value.data() + t.length, high);
+		    for (w = 0; w < words; w++) bits[w] &= high[w];
+		}
+		for (w = 0; w < words; w++) pass[w] |= bits[w] & fits[w] & todo[w];
+	    }
+	    else
+	    {
+		for (w = 0; w < words; w++)
+		    for (; todo[w] != 0; todo[w] &= todo[w] - 1)
+		    {
+			k = w * 64 + __builtin_ctzll(todo[w]);
+			if (matchTerm(t, recs[k])) pass[w] |= 1ULL << (k % 64);
+		    }
+	    }
+	}
+	i = groupEnd[g];
+
+	left = false;
+	for (w = 0; w < words; w++)
+	{
+	    sel[w] &= pass[w];
+	    left |= (sel[w] != 0);
+	}
+	if (!left) break;
+    }
+    return plain;
+}
+
+InsertFileScan::InsertFileScan(const string & name,
+                               Status & status) : HeapFile(name, status)
+{
+  //Do nothing. Heapfile constructor will read the header page and the first
+  // data page of the file into the buffer pool
+}
+
+InsertFileScan::~InsertFileScan()
+{
+    Status status;
+    // unpin last page of the scan
+    if (curPage != NULL)
+    {
+        status = bufMgr->unPinPage(filePtr, curPageNo, true);
+        curPage = NULL;
+        curPageNo = 0;
+        if (status != OK) cerr << "error in unpin of data page\n";
+    }
+}
+
+// Insert a record into the file
+const Status InsertFileScan::insertRecord(const Record & rec, RID& outRid)
+{
+    Page*	newPage;
+    int		newPageNo;
+    Status	status, unpinstatus;
+    RID		rid;
+    Record	stored = rec;	// what goes on the data page
+    short	flags = 0;
+    OvflDesc	desc;
+
+    if (rec.length < 0) return INVALIDRECLEN;
+
+    // a record too large for a data page goes to overflow pages and
+    // only its descriptor is stored on the data page.  if it then does
+    // not make it onto a data page, the chain is freed again
+    if ((unsigned int) rec.length > MAXINLINERECLEN)
+    {
+        status = writeOverflow(rec, desc);
+        if (status != OK) return status;
+        stored.data = &desc;
+        stored.length = sizeof(OvflDesc);
+        flags = SLOTOVFL;
+    }
+
+    //the current page is not the last page of the file, unpin it and bring in the last page
+    if(curPageNo != headerPage->lastPage){
+	//unpin the current page
 	unpinstatus = bufMgr->unPinPage(filePtr, curPageNo, curDirtyFlag);
-	if(unpinstatus != OK) cerr<<"error in unpin of data page during insertion\n";
+	if(unpinstatus != OK) cerr<<"error in unpin insertion\n";
+	//bring in the last page
+	status = bufMgr->readPage(filePtr, headerPage->lastPage, newPage);
+	if(status != OK){
+	    if(flags != 0) freeOverflow(desc);
+	    return status;
+	}
+	//update cur para
+	curPage = newPage;
+	curPageNo = headerPage->lastPage;
+	curDirtyFlag = false;
+	curRec = NULLRID;	
+    }
+    //try to insert
+    status = curPage->insertRecord(stored, rid);
+    //if full, alloc a new page and insert the record into the new page
+    if(status == NOSPACE){
 	//alloc a new page in the file
 	status = bufMgr->allocPage(filePtr, newPageNo, newPage);
-	if(status != OK) return status;
+	if(status != OK){
+	    if(flags != 0) freeOverflow(desc);
+	    return status;
+	}
 	//init the page
 	newPage->init(newPageNo);
 	//set the next page parameter to link the new page together
 	curPage->setNextPage(newPageNo);
-	//update header page and current para
+	//unpin the last page
+	unpinstatus = bufMgr->unPinPage(filePtr, curPageNo, true);
+	if(unpinstatus != OK) cerr<<"error in unpin of data page during insertion\n";
+	//update header page, page directory and current para
 	headerPage->lastPage = newPageNo;
 	headerPage->pageCnt++;
 	hdrDirtyFlag = true;
 	curPage = newPage;
 	curPageNo = newPageNo;
 	curRec = NULLRID;
+	status = addDirEntry(newPageNo);
+	if(status != OK){
+	    if(flags != 0) freeOverflow(desc);
+	    return status;
+	}
 	//insert the record to the new page
-	status = curPage->insertRecord(rec, rid);
-	if(status != OK) cerr<<"New page is full, which is weird!"<<endl;
+	status = curPage->insertRecord(stored, rid);
+    }
+    if(status != OK){
+	if(flags != 0) freeOverflow(desc);
+	return status;
     }
+    if(flags != 0) curPage->setFlags(rid, flags);
     outRid = rid;
     curRec = outRid;
     curDirtyFlag = true;
-    if((status != OK) && (status != NOSPACE))	cerr<<"There is other status in insertion!";
 	//record count addition
     headerPage->recCnt++;
 
+    status = widenZone(curPageNo, rec);
+    if(status != OK) return status;
+    if(!indexes.empty()) return notifyIndexes(rec, outRid, true);
     return OK;
 }
 
+
+// Insert a batch of records into the file.  Pages are filled one after
+// the other with the free space of the page tracked locally, new pages
+// are allocated from the file in groups and the header is updated once
+// for the whole batch.  On error the records before the failing one
+// have been inserted
+
+const Status InsertFileScan::insertRecords(const Record* recs,
+                                           const int count, RID* outRids)
+{
+    Page*	newPage;
+    int		newPageNo;
+    Status	status = OK, unpinstatus, ixstatus, releasestatus;
+    Record	stored;
+    short	flags = 0;	// SLOTOVFL while desc is not yet on a page
+    OvflDesc	desc;
+    int		i, space, avail;
+    int		inserted = 0;
+    int		groupFirst = 0, groupLeft = 0;	// unused allocated pages
+    long	needLeft = 0;	// data page bytes the rest of the batch takes
+    const int	pageSpace = PAGESIZE - DPFIXED;	// free space of an empty page
+
+    if (count < 0) return INVALIDRECLEN;
+    if (count > 0 && (recs == NULL || outRids == NULL)) return BADRECPTR;
+    for (i = 0; i < count; i++)
+    {
+        if (recs[i].length < 0) return INVALIDRECLEN;
+        space = ((unsigned int) recs[i].length > MAXINLINERECLEN) ?
+                sizeof(OvflDesc) : recs[i].length;
+        needLeft += Page::recSpace(space) + sizeof(slot_t);
+    }
+
+    //the current page is not the last page of the file, unpin it and bring in the last page
+    if(curPageNo != headerPage->lastPage){
+	unpinstatus = bufMgr->unPinPage(filePtr, curPageNo, curDirtyFlag);
+	if(unpinstatus != OK) cerr<<"error in unpin insertion\n";
+	status = bufMgr->readPage(filePtr, headerPage->lastPage, newPage);
+	if(status != OK) return status;
+	curPage = newPage;
+	curPageNo = headerPage->lastPage;
+	curDirtyFlag = false;
+	curRec = NULLRID;	
+    }
+    avail = curPage->getFreeSpace();
+
+    for (i = 0; i < count; i++)
+    {
+        stored = recs[i];
+        flags = 0;
+        if ((unsigned int) recs[i].length > MAXINLINERECLEN)
+        {
+            status = writeOverflow(recs[i], desc);
+            if (status != OK) break;
+            stored.data = &desc;
+            stored.length = sizeof(OvflDesc);
+            flags = SLOTOVFL;
+        }
+        space = Page::recSpace(stored.length) + sizeof(slot_t);
+
+        if (space > avail)
+        {
+            // the page is full.  the rest of the batch needs at least
+            // needLeft/pageSpace fresh pages, so a group of that many
+            // is never more than the batch will use
+            if (groupLeft == 0)
+            {
+                groupLeft = (needLeft + pageSpace - 1) / pageSpace;
+                if (groupLeft > ALLOCGROUPSIZE) groupLeft = ALLOCGROUPSIZE;
+                status = filePtr->allocatePages(groupFirst, groupLeft, true);
+                if (status != OK) break;
+            }
+            newPageNo = groupFirst;
+            status = bufMgr->pinNewPage(filePtr, newPageNo, newPage);
+            if (status != OK) break;
+            groupFirst++;
+            groupLeft--;
+            newPage->init(newPageNo);
+            curPage->setNextPage(newPageNo);
+            unpinstatus = bufMgr->unPinPage(filePtr, curPageNo, true);
+            if (unpinstatus != OK) cerr<<"error in unpin of data page during insertion\n";
+            headerPage->lastPage = newPageNo;
+            headerPage->pageCnt++;
+            curPage = newPage;
+            curPageNo = newPageNo;
+            avail = curPage->getFreeSpace();
+            status = addDirEntry(newPageNo);
+            if (status != OK) break;
+        }
+
+        status = curPage->insertRecord(stored, outRids[i]);
+        if (status != OK) break;
+        if (flags != 0) curPage->setFlags(outRids[i], flags);
+        flags = 0;
+        curDirtyFlag = true;
+        curRec = outRids[i];
+        avail -= space;
+        needLeft -= space;
+        inserted++;
+        status = widenZone(curPageNo, recs[i]);
+        if (status != OK) break;
+    }
+
+    // the overflow chain of a record that did not make it onto a page
+    // would be unreachable, as would pages of the group not linked in
+    if (flags != 0) freeOverflow(desc);
+    if (groupLeft > 0)
+    {
+        releasestatus = filePtr->releasePages(groupFirst, groupLeft);
+        if (status == OK) status = releasestatus;
+    }
+
+    headerPage->recCnt += inserted;
+    hdrDirtyFlag = true;
+    // the records that made it in are indexed even if the rest failed
+    for(i = 0; i < inserted && !indexes.empty(); i++){
+	ixstatus = notifyIndexes(recs[i], outRids[i], true);
+	if(ixstatus != OK) return ixstatus;
+    }
+    return status;
+}
+
+// Open file name for a bulk load.  Any of its pages still in the buffer
+// pool are written out first so the pages read and written directly
+// below cannot go stale; this fails with PAGEPINNED if the file is
+// open through a HeapFile.  New records go after the ones already in
+// the file, starting on its last data page.
+
+HeapFileLoader::HeapFileLoader(const string & name, Status & status,
+                               const int stagePages)
+{
+    finished = true;
+    stage = NULL;
+    filePtr = NULL;
+
+    status = db.openFile(name, filePtr);
+    if(status != OK) return;
+
+    if((status = bufMgr->flushFile(filePtr)) != OK ||
+       (status = filePtr->getFirstPage(headerPageNo)) != OK ||
+       (status = filePtr->readPage(headerPageNo, &hdrBuf)) != OK){
+	db.closeFile(filePtr);
+	return;
+    }
+    headerPage = (FileHdrPage*) &hdrBuf;
+
+    if((status = filePtr->readPage(headerPage->lastPage, &tail)) != OK ||
+       (status = filePtr->readPage(headerPage->dirLast, &dirBuf)) != OK){
+	db.closeFile(filePtr);
+	return;
+    }
+    tailWritten = false;
+    curPage = &tail;
+    emptyZone(headerPage, curZone);
+
+    this->stagePages = (stagePages > 0) ? stagePages : 1;
+    stage = new Page[this->stagePages];
+    stageFirst = -1;
+    stageCnt = 0;
+    finished = false;
+}
+
+HeapFileLoader::~HeapFileLoader()
+{
+    Status status = finish();
+    if(status != OK) cerr << "error in HeapFileLoader destructor\n";
+}
+
+// Write out the staged pages, give back the part of the last chunk
+// that was not used, then write the last data page, the zone map pages
+// and the header.  The loader cannot be used afterwards.
+
+const Status HeapFileLoader::finish()
+{
+    Status	status;
+
+    if(finished) return OK;
+    finished = true;
+
+    status = saveZone();
+    if(status == OK) status = flushStage();
+    if(status == OK && stageFirst != -1)
+	status = filePtr->releasePages(stageFirst + stageCnt,
+				       stagePages - stageCnt);
+    if(status == OK && !tailWritten)
+	status = filePtr->writePage(headerPage->lastPage, &tail);
+    for(unsigned i = 0; i < zonePages.size(); i++){
+	if(status == OK)
+	    status = filePtr->writePage(zonePageNos[i], zonePages[i]);
+	delete zonePages[i];
+    }
+    zonePages.clear();
+    if(status == OK)
+	status = filePtr->writePage(headerPage->dirLast, &dirBuf);
+    if(status == OK)
+	status = filePtr->writePage(headerPageNo, &hdrBuf);
+
+    delete [] stage;
+    stage = NULL;
+    Status closestatus = db.closeFile(filePtr);
+    if(status != OK) return status;
+    return closestatus;
+}
+
+// Add a record to the page being filled, starting a new page when it
+// is full.  Records too large for a data page go to overflow pages that
+// are written right away, as with InsertFileScan::insertRecord
+
+const Status HeapFileLoader::insertRecord(const Record & rec, RID & outRid)
+{
+    Status	status;
+    Record	stored = rec;
+    OvflDesc	desc;
+
+    if(finished) return BADFILE;
+    if(rec.length < 0) return INVALIDRECLEN;
+
+    if((unsigned) rec.length > MAXINLINERECLEN){
+	status = writeOverflow(rec, desc);
+	if(status != OK) return status;
+	stored.data = &desc;
+	stored.length = sizeof(OvflDesc);
+    }
+
+    status = curPage->insertRecord(stored, outRid);
+    if(status == NOSPACE){
+	status = newDataPage();
+	if(status == OK) status = curPage->insertRecord(stored, outRid);
+    }
+    if(status != OK){
+	// the overflow pages of a record that did not make it in go back
+	if(stored.data == &desc)
+	    filePtr->releasePages(desc.firstPage,
+				  (rec.length + OVFLDATASIZE - 1) / OVFLDATASIZE);
+	return status;
+    }
+    if(stored.data == &desc) curPage->setFlags(outRid, SLOTOVFL);
+    widenZoneRec(headerPage, curZone, rec);
+
+    headerPage->recCnt++;
+    return OK;
+}
+
+// Each page is copied over a fresh page from newDataPage() so it takes
+// that page's number and place in the chain, and its zone is built
+// from its records
+
+const Status HeapFileLoader::insertPages(const Page* pages, const int count,
+                                         const int recCnt)
+{
+    Status	status;
+    RID		rids[MAXSLOTS];
+    Record	recs[MAXSLOTS];
+    short	flags[MAXSLOTS];
+    int		n;
+
+    if(finished) return BADFILE;
+    for(int i = 0; i < count; i++){
+	status = newDataPage();
+	if(status != OK) return status;
+	*curPage = pages[i];
+	curPage->setPageNo(headerPage->lastPage);
+	curPage->setNextPage(-1);
+	if(headerPage->zoneAttrCnt == 0) continue;
+	status = curPage->getRecords(0, MAXSLOTS, rids, recs, flags, n);
+	if(status != OK) return status;
+	for(int k = 0; k < n; k++) widenZoneRec(headerPage, curZone, recs[k]);
+    }
+    headerPage->recCnt += recCnt;
+    return OK;
+}
+
+// Link a fresh page after curPage and make it current.  Page numbers
+// are taken from the file a stage-full at a time, and the stage is
+// written out once all of its pages have been handed out.  curPage is
+// linked before it is written, so every page goes out exactly once
+
+const Status HeapFileLoader::newDataPage()
+{
+    Status	status;
+    int		newPageNo;
+    bool	newChunk = (stageFirst == -1 || stageCnt == stagePages);
+
+    status = saveZone();
+    if(status != OK) return status;
+    if(newChunk){
+	status = filePtr->allocatePages(newPageNo, stagePages, false);
+	if(status != OK) return status;
+    }
+    else newPageNo = stageFirst + stageCnt;
+
+    curPage->setNextPage(newPageNo);
+    if(curPage == &tail){
+	status = filePtr->writePage(headerPage->lastPage, &tail);
+	if(status != OK) return status;
+	tailWritten = true;
+    }
+    if(newChunk){
+	status = flushStage();
+	if(status != OK) return status;
+	stageFirst = newPageNo;
+	stageCnt = 0;
+    }
+
+    curPage = &stage[stageCnt++];
+    curPage->init(newPageNo);
+    headerPage->lastPage = newPageNo;
+    headerPage->pageCnt++;
+    return addDirEntry(newPageNo);
+}
+
+// as HeapFile::addDirEntry, on the private copy of the last directory
+// page.  a full one is written out as soon as the next one is started
+
+const Status HeapFileLoader::addDirEntry(const int pageNo)
+{
+    Status	status;
+    int		newPageNo;
+    DirPage*	dir = (DirPage*) &dirBuf;
+
+    if(dir->cnt == DIRPAGESIZE){
+	status = filePtr->allocatePages(newPageNo, 1, false);
+	if(status != OK) return status;
+	dir->nextPage = newPageNo;
+	status = filePtr->writePage(headerPage->dirLast, &dirBuf);
+	if(status != OK) return status;
+	headerPage->dirLast = newPageNo;
+	dir->nextPage = -1;
+	dir->cnt = 0;
+    }
+    dir->pageNos[dir->cnt++] = pageNo;
+    return OK;
+}
+
+// as HeapFile::findZone, on private copies of the zone map pages.
+// they are read as the chain is followed and written by finish()
+
+const Status HeapFileLoader::saveZone()
+{
+    Status	status;
+    Page*	page;
+    int		nextPageNo;
+    int		pageNo = headerPage->lastPage;
+    int		size = headerPage->zoneAttrCnt * 2 * sizeof(int);
+
+    if(size == 0) return OK;
+    int per = ZONEDATASIZE / size;
+    while((int) zonePageNos.size() <= pageNo / per){
+	if(zonePages.empty()) nextPageNo = headerPage->zoneFirst;
+	else nextPageNo = ((ZonePage*) zonePages.back())->nextPage;
+	page = new Page;
+	if(nextPageNo == -1){
+	    status = filePtr->allocatePages(nextPageNo, 1, false);
+	    if(status != OK){
+		delete page;
+		return status;
+	    }
+	    ((ZonePage*) page)->nextPage = -1;
+	    for(int i = 0; i < per; i++)
+		emptyZone(headerPage, ((ZonePage*) page)->data + i * size);
+	    if(zonePages.empty()) headerPage->zoneFirst = nextPageNo;
+	    else ((ZonePage*) zonePages.back())->nextPage = nextPageNo;
+	}
+	else{
+	    status = filePtr->readPage(nextPageNo, page);
+	    if(status != OK){
+		delete page;
+		return status;
+	    }
+	}
+	zonePageNos.push_back(nextPageNo);
+	zonePages.push_back(page);
+    }
+
+    widenZoneZone(headerPage,
+		  ((ZonePage*) zonePages[pageNo / per])->data + pageNo % per * size,
+		  curZone);
+    emptyZone(headerPage, curZone);
+    return OK;
+}
+
+const Status HeapFileLoader::flushStage()
+{
+    if(stageCnt == 0) return OK;
+    return filePtr->writePages(stageFirst, stage, stageCnt);
+}
+
+// Overflow pages of one record are allocated together and written
+// with a single write
+
+const Status HeapFileLoader::writeOverflow(const Record & rec,
+                                           OvflDesc & desc)
+{
+    Status	status;
+    int		count = (rec.length + OVFLDATASIZE - 1) / OVFLDATASIZE;
+    const char*	src = (const char*) rec.data;
+    int		left = rec.length;
+
+    status = filePtr->allocatePages(desc.firstPage, count, false);
+    if(status != OK) return status;
+    desc.length = rec.length;
+
+    Page* pages = new Page[count];
+    for(int i = 0; i < count; i++){
+	OvflPage* ovflPage = (OvflPage*) &pages[i];
+	ovflPage->length = (left < (int) OVFLDATASIZE) ? left : OVFLDATASIZE;
+	ovflPage->nextPage = (i + 1 < count) ? desc.firstPage + i + 1 : -1;
+	memcpy(ovflPage->data, src, ovflPage->length);
+	src += ovflPage->length;
+	left -= ovflPage->length;
+    }
+    status = filePtr->writePages(desc.firstPage, pages, count);
+    delete [] pages;
+    if(status != OK) filePtr->releasePages(desc.firstPage, count);
+    return status;
+}
+
+// the loader is finished even if fn fails, so what was loaded up to
+// then is left in the file
+
+const Status loadHeapFile(const string & name, RecordSourceFn fn, void* arg,
+                          const int stagePages)
+{
+    Status	status, finishstatus;
+    Record	rec;
+    RID		rid;
+
+    status = createHeapFile(name);
+    if(status != OK) return status;
+    HeapFileLoader* loader = new HeapFileLoader(name, status, stagePages);
+    while(status == OK && (status = fn(arg, rec)) == OK)
+	status = loader->insertRecord(rec, rid);
+    finishstatus = loader->finish();
+    delete loader;
+    if(status != FILEEOF) return status;
+    return finishstatus;
+}
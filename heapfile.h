@@ -5,6 +5,7 @@
 #include <functional>
 #include <iostream>
 #include <vector>
+#include <set>
 #include <string.h>
 using namespace std;
 
@@ -19,8 +20,165 @@ extern DB db;
 // Some constant definitions
 const unsigned MAXNAMESIZE = 50;
 
+// longest record that can still be moved to another page by an update.
+// a moved record carries the RID of its forwarding stub in front of it
+const unsigned MAXFWDRECLEN = PAGESIZE - DPFIXED - sizeof(slot_t) - sizeof(RID);
+
 enum Datatype { STRING, INTEGER, FLOAT };    // attribute data types
-enum Operator { LT, LTE, EQ, GTE, GT, NE };  // scan operators
+enum Operator { LT, LTE, EQ, GTE, GT, NE,   // scan operators
+                PREFIX, CONTAINS, LIKE,     // STRING only, see startScan
+                BETWEEN, IN };              // see ScanCond
+
+// compares the attribute of a record at attr against a scan filter of
+// the given length.  startScan picks one for the filter's type and op
+typedef bool (*MatchFn)(const char* attr, const char* filter,
+                        const int length);
+
+// page-at-a-time form of a MatchFn for INTEGER and FLOAT, see filter.h.
+// sets bit i of sel, for i < n, if vals[i] op filter holds, and clears
+// it otherwise.  vals holds ints or floats, n is at most MAXSLOTS
+typedef void (*FilterFn)(const void* vals, const int n, const void* filter,
+                         unsigned long long* sel);
+
+// one comparison of a scan predicate.  startScan ORs together the
+// conditions that have the same group number and ANDs the groups.
+// filter is as for a single-condition scan, except that for BETWEEN it
+// holds an inclusive low and high bound and for IN valCnt values, each
+// of them length bytes (a STRING one NUL padded if shorter)
+struct ScanCond
+{
+  int		offset;		// byte offset of the attribute
+  int		length;		// length of the attribute
+  Datatype	type;		// datatype of the attribute
+  Operator	op;		// comparison operator
+  const char*	filter;		// value(s) compared against
+  int		valCnt;		// number of values of an IN list
+  int		group;		// conditions of a group are ORed
+};
+
+// one attribute copied out of the records by HeapFileScan::scanColumns
+struct ScanColumn
+{
+  int		offset;		// byte offset of the attribute
+  int		length;		// length of the attribute
+  Datatype	type;		// datatype of the attribute
+};
+
+// a ScanCond as startScan compiles it
+struct ScanTerm
+{
+  int		offset;
+  int		length;
+  Datatype	type;
+  Operator	op;
+  string	value;		// padded copy of the filter
+  MatchFn	match;		// comparison for type and op
+  FilterFn	pageFilter;	// vector comparison, NULL if there is none
+  FilterFn	pageFilter2;	// upper bound test of a vector BETWEEN
+  double	sel;		// estimated fraction of records passing
+  double	cost;		// estimated relative cost of one test
+};
+
+// check c and compile it into t, as startScan does.  an attribute at
+// attr satisfies c if t.match(attr, t.value.data(), t.length) holds
+extern const Status compileCond(const ScanCond & c, ScanTerm & t);
+
+// longest record that is stored on a data page.  anything larger is
+// kept in a chain of overflow pages and the data page holds an OvflDesc
+const unsigned MAXINLINERECLEN = MAXFWDRECLEN;
+
+// what a data page slot holds for a record stored in overflow pages
+struct OvflDesc
+{
+  int		firstPage;	// pageNo of first overflow page
+  int		length;		// total length of the record
+};
+
+// layout of an overflow page, overlaid on a Page like FileHdrPage
+struct OvflPage
+{
+  int		nextPage;	// next page of the chain, -1 on the last one
+  int		length;		// number of bytes of the record on this page
+  char		data[PAGESIZE - 2*sizeof(int)];
+};
+
+const unsigned OVFLDATASIZE = PAGESIZE - 2*sizeof(int);
+
+// layout of a page of the page directory, overlaid on a Page.  the
+// directory lists the data pages of a heap file in chain order, so
+// the Nth data page is found by reading one directory page
+struct DirPage
+{
+  int		nextPage;	// next directory page, -1 on the last one
+  int		cnt;		// number of entries in use
+  int		pageNos[(PAGESIZE - 2*sizeof(int)) / sizeof(int)];
+};
+
+const int DIRPAGESIZE = (PAGESIZE - 2*sizeof(int)) / sizeof(int);
+
+// most pages a batch insert allocates from the file in one go
+const int ALLOCGROUPSIZE = 64;
+
+// default number of pages a HeapFileLoader stages before writing them
+const int LOADSTAGEPAGES = 256;
+
+// data pages a parallelScan worker takes at a time
+const int PARSCANGROUP = 8;
+
+// called by HeapFileScan::parallelScan with the cnt matching records
+// of one page that worker number 'worker' found.  the records are only
+// valid during the call.  calls from different workers overlap
+typedef void (*ScanBatchFn)(void* arg, const int worker, const RID* rids,
+                            const Record* recs, const int cnt);
+
+// called by HeapFileScan::updateWhere on every record to update.  it
+// may change the rec.length bytes at rec.data in place and return
+// false, or point newRec at a new version, of any length, and return
+// true.  newRec need only stay valid until the call after
+typedef bool (*UpdateFn)(void* arg, const Record & rec, Record & newRec);
+
+// an assignment for HeapFileScan::updateWhere: the length bytes at
+// offset are set to value.  a record too short for it is lengthened,
+// with zeros in any gap
+struct ScanSet
+{
+  int		offset;
+  int		length;
+  const char*	value;
+};
+
+// called by a HeapFile with every record inserted into or deleted
+// from it, see HeapFile::attachIndex.  an update comes as the delete
+// of the old version followed by the insert of the new one.  rid is
+// the RID the record is known by, as insertRecord returned it
+typedef const Status (*IndexFn)(void* index, const Record & rec,
+                                const RID & rid, const bool inserted);
+
+// most attributes a heap file keeps zone maps for
+const int MAXZONEATTRS = 4;
+
+// an attribute the zone maps of a heap file cover, see
+// HeapFile::declareZones.  only INTEGER and FLOAT ones qualify
+struct ZoneAttr
+{
+  int		offset;		// byte offset of the attribute
+  Datatype	type;		// INTEGER or FLOAT
+};
+
+// layout of a page of zone maps, overlaid on a Page.  the zone of a
+// data page holds the smallest and the largest value of each attribute
+// declared over the records on it, a (min, max) pair of the attribute's
+// type each.  the zones are kept by pageNo: that of data page p is zone
+// p % zonesPerPage of the (p / zonesPerPage)-th zone map page, so
+// one zone map page covers many data pages.  a zone whose min is
+// above its max has no values
+struct ZonePage
+{
+  int		nextPage;	// next zone map page, -1 on the last one
+  char		data[PAGESIZE - sizeof(int)];
+};
+
+const int ZONEDATASIZE = PAGESIZE - sizeof(int);
 
 struct FileHdrPage
 {
@@ -29,6 +187,11 @@ struct FileHdrPage
   int		lastPage;	// pageNo of last data page in file
   int		pageCnt;	// number of pages
   int		recCnt;		// record count
+  int		dirFirst;	// pageNo of first page directory page
+  int		dirLast;	// pageNo of last page directory page
+  int		zoneAttrCnt;	// attributes with zone maps, 0 if none
+  ZoneAttr	zoneAttrs[MAXZONEATTRS];
+  int		zoneFirst;	// pageNo of first zone map page, -1 if none
 };
 
 
@@ -44,6 +207,124 @@ protected:
    int   	curPageNo;	// page number of pinned page
    bool  	curDirtyFlag;   // true if page has been updated
    RID   	curRec;         // rid of last record returned
+   bool		curPageMoved;	// true once switchPage has moved curPage
+
+   // unpin curPage and make page pageNo the current page
+   const Status switchPage(const int pageNo);
+
+   // make the page holding rid current and return the record's flags
+   // and contents, following a stub to the moved version.  for a record
+   // kept in overflow pages rec holds its OvflDesc
+   const Status fetchRecord(const RID & rid, short & flags, Record & rec);
+
+   // buffer that large records are assembled in by getRecord
+   vector<char> ovflBuf;
+
+   // buffer that getRecords copies the records to
+   vector<char> fetchBuf;
+
+   // copy the records of the RIDs in 'order', (pageNo, slotNo, index)
+   // sorted by page, to fetchBuf, noting the offset and length of each
+   // under its index.  RIDs of stubs are replaced by those of their
+   // moved records and added to moved
+   const Status fetchRecords(vector<pair<pair<int,int>,int> > & order,
+                             vector<long> & offsets, vector<int> & lengths,
+                             vector<pair<pair<int,int>,int> > & moved);
+
+   // delete the records of the RIDs in 'order', sorted by page.  with
+   // homes they must be the RIDs records are known by, and the moved
+   // records their stubs lead to are added to moved; otherwise they are
+   // the moved records themselves.  records deleted are counted in
+   // deleted, the moved ones with their stubs
+   const Status dropRecords(const vector<pair<int,int> > & order,
+                            const bool homes,
+                            vector<pair<int,int> > & moved, int & deleted);
+
+   // position of the last readOverflow call, so that reading a large
+   // record front to back does not walk its chain from the start
+   // each time
+   int		ovflFirst;	// first page of the chain being read
+   int		ovflPageNo;	// page reached in that chain
+   int		ovflPagePos;	// offset in the record of that page's data
+
+   // store rec in a new chain of overflow pages described by desc
+   const Status writeOverflow(const Record & rec, OvflDesc & desc);
+
+   // release the overflow pages of a large record
+   const Status freeOverflow(const OvflDesc & desc);
+
+   // copy len bytes of a large record, starting at offset, into buf
+   const Status readOverflow(const OvflDesc & desc, const int offset,
+                             char* buf, const int len);
+
+   // assemble the large record described by descRec in ovflBuf
+   const Status readLargeRecord(const Record & descRec, Record & rec);
+
+   // pageNos of the directory pages, as far as they have been needed.
+   // directory pages are only ever added at the end, so the list
+   // cannot go stale, only short
+   vector<int>	dirPageNos;
+
+   // make dirPageNos long enough to hold the directory page of data
+   // page number idx
+   const Status loadDirectory(const int idx);
+
+   // add data page pageNo at the end of the page directory
+   const Status addDirEntry(const int pageNo);
+
+   // insert rec on the last page of the file, adding a new last page
+   // if it is full, and give it the SLOT flags 'flags'.  curPage is
+   // not affected
+   const Status appendRecord(const Record & rec, const short flags,
+                             RID & outRid);
+
+   // store rec on another page as the moved version of the record
+   // whose stub is homeRid, returning where it went in newRid
+   const Status forwardRecord(const RID & homeRid, const Record & rec,
+                              RID & newRid);
+
+   // replace the moved version 'target' of the record whose stub is
+   // homeRid by rec. newTarget is where the new version ended up; if
+   // that is not target, the caller points the stub at it and then
+   // deletes target
+   const Status updateMoved(const RID & homeRid, const RID & target,
+                            const Record & rec, RID & newTarget);
+
+   // indexes to keep up to date, see attachIndex
+   vector<pair<IndexFn, void*> > indexes;
+
+   // pass the insert or delete of rec to every index attached
+   const Status notifyIndexes(const Record & rec, const RID & rid,
+                              const bool inserted);
+
+   // pageNos of the zone map pages, as far as they have been needed.
+   // like the directory they are only ever added at the end
+   vector<int>	zonePageNos;
+
+   // bytes of one zone and zones a zone map page holds
+   const int zoneSize() const;
+   const int zonesPerPage() const;
+
+   // pin the zone map page holding the zone of data page pageNo, in
+   // zonePage numbered zonePageNo, and point zone at the zone.  with
+   // add, zone map pages are added as needed; otherwise zone is NULL
+   // and nothing is pinned if the zone maps do not reach that far
+   const Status findZone(const int pageNo, const bool add, int & zonePageNo,
+                         Page* & zonePage, char* & zone);
+
+   // widen the zone of data page pageNo to take in the values of rec
+   const Status widenZone(const int pageNo, const Record & rec);
+
+   // set the zone of data page pageNo afresh from the records on page
+   const Status rezonePage(const int pageNo, Page* page);
+
+   // free the zone map pages and declare no attributes
+   const Status dropZones();
+
+   // copy the current version of the record with RID rid into buf.
+   // its pages are pinned only for the call and curPage, ovflBuf and
+   // fetchBuf are left alone
+   const Status copyRecord(const RID & rid, vector<char> & buf);
 
 public:
 
@@ -56,11 +337,73 @@ public:
   // return number of records in file
   const int getRecCnt() const;
 
-  // given a RID, read record from file, returning pointer and length
+  // number of data pages in the file
+  const int getPageCnt() const;
+
+  // name the file was created with
+  const string getFileName() const;
+
+  // page numbers of the data pages, in the order of the page chain
+  const Status getPageNos(vector<int> & pageNos);
+
+  // page number of data page idx, counting from 0 in chain order
+  const Status getPageNo(const int idx, int & pageNo);
+
+  // ask the OS to start reading data pages idx to idx+count-1 ahead
+  // of their use.  only a hint: the buffer pool is not touched
+  const Status prefetchPages(const int idx, const int count);
+
+  // given a RID, read record from file, returning pointer and length.
+  // a record kept in overflow pages is assembled in a buffer owned by
+  // the HeapFile and stays valid until the next getRecord call
   const Status getRecord(const RID &rid, Record & rec);
+
+  // read the records of cnt RIDs, in any order, pinning every page they
+  // are on once.  recs[i] is the record of rids[i].  the records are
+  // copied to a buffer owned by the HeapFile and stay valid until the
+  // next getRecords call.  with prefetch the OS is first asked to read
+  // in all the pages
+  const Status getRecords(const RID* rids, const int cnt, Record* recs,
+                          const bool prefetch = false);
+
+  // delete the records with RIDs rids[0] .. rids[cnt-1], as returned by
+  // insertRecord or scanNext, in any order.  every page they are on is
+  // pinned once and the header is updated once.  a RID given twice is
+  // deleted once.  deleted is set to the number of records deleted
+  const Status deleteRecords(const RID* rids, const int cnt, int & deleted);
+
+  // copy up to len bytes of the record with RID rid, starting at byte
+  // offset, into buf.  reading a large record in consecutive pieces
+  // only reads each of its overflow pages once
+  const Status readRecord(const RID & rid, const int offset, char* buf,
+                          const int len, int & bytesRead);
+
+  // replace the record with RID rid by rec. The record is rewritten in
+  // place if its page has room; otherwise it moves to another page and
+  // a forwarding stub is left behind, so rid remains valid either way
+  const Status updateRecord(const RID & rid, const Record & rec);
+
+  // have fn(index, ...) called on every record inserted, deleted or
+  // updated through this HeapFile from now on.  a HeapFileLoader does
+  // not call it.  an index must be detached before it goes away
+  const Status attachIndex(IndexFn fn, void* index);
+  const Status detachIndex(void* index);
+
+  // keep zone maps for the cnt attributes of attrs, replacing those
+  // kept so far; cnt 0 drops them.  they are built from the records in
+  // the file now and from then on widened by every insert and update
+  // and narrowed again by deletes.  a HeapFileScan passes over the data
+  // pages whose zones rule its predicate out.  a HeapFileLoader widens
+  // them as well, but a change made in place through markDirty is not
+  // seen.  no other HeapFile may have the file open while they are
+  // declared
+  const Status declareZones(const ZoneAttr* attrs, const int cnt);
 };
 
 
+struct ParScanJob;		// see heapfile.cpp
+struct ParScanResult;
+
 class HeapFileScan : public HeapFile
 {
 public:
@@ -70,34 +413,97 @@ public:
     // end filtered scan
     ~HeapFileScan();
 
+    // filter holds length bytes compared against the attribute.  for
+    // PREFIX, CONTAINS and LIKE it is a NUL-terminated pattern instead;
+    // a LIKE pattern may use % for any run of bytes and _ for any byte.
+    // a STRING attribute ends at its first NUL, as for strncmp.  a
+    // BETWEEN filter is as for ScanCond; IN needs the ScanCond form
     const Status startScan(const int offset, 
                            const int length,  
                            const Datatype type, 
                            const char* filter, 
                            const Operator op);
 
+    // scan for the records that satisfy condCnt conditions, see
+    // ScanCond.  none means no filtering
+    const Status startScan(const ScanCond* conds, const int condCnt);
+
     const Status endScan(); // terminate the scan
     const Status markScan(); // save current position of scan
     const Status resetScan(); // reset scan to last marked location
 
+    // move the scan to the start of data page idx, see getPageNo
+    const Status seekPage(const int idx);
+
+    // have the scan prefetch the next pages data pages whenever it has
+    // gone through that many.  0, the default, turns it off
+    const Status setReadAhead(const int pages);
+
     // return RID of next record that satisfies the scan 
     const Status scanNext(RID& outRid);
 
+    // return up to max records that satisfy the scan, all from one page,
+    // in rids and recs and their number in cnt.  Records point into the
+    // pinned page (a large record into the file's own buffer, and it is
+    // returned on its own) until the scan moves on.  The current record
+    // is left at the last one looked at, so getRecord, deleteRecord and
+    // updateRecord are meant for use with scanNext
+    const Status scanBatch(const int max, RID* rids, Record* recs,
+                           int & cnt);
+
+    // the same, but instead of pointers to the records the colCnt
+    // attributes of cols are copied out of them into one array each:
+    // column c of the k-th record goes cols[c].length * k bytes into
+    // out[c].  a record too short to hold a column gets zeros there.
+    // nothing points into the file, so a batch may span pages.  rids
+    // may be NULL
+    const Status scanColumns(const ScanColumn* cols, const int colCnt,
+                             char* const* out, const int max, RID* rids,
+                             int & cnt);
+
+    // run the scan over the whole file on nThreads threads, each
+    // passing what it finds to fn.  the records come a page at a time,
+    // in no particular order; large records come last, one at a time,
+    // from the calling thread as worker 0.  the buffer pool is shared by
+    // the threads under a lock, so nothing else may use it until
+    // parallelScan returns.  afterwards the scan is at its end
+    const Status parallelScan(const int nThreads, ScanBatchFn fn,
+                              void* arg);
+
     // read current record, returning pointer and length
     const Status getRecord(Record & rec);
 
     // delete current record 
     const Status deleteRecord();
 
+    // delete every record scanNext has yet to return, a page at a time,
+    // setting deleted to their number.  the scan is ended afterwards,
+    // as by endScan
+    const Status deleteWhere(int & deleted);
+
+    // pass every record scanNext has yet to return to fn, a page at a
+    // time, setting updated to their number.  records changed in place
+    // cost no more than marking their page dirty.  the scan is ended
+    // afterwards, as by endScan
+    const Status updateWhere(UpdateFn fn, void* arg, int & updated);
+
+    // the same, applying the setCnt assignments of sets to the records
+    const Status updateWhere(const ScanSet* sets, const int setCnt,
+                             int & updated);
+
+    // replace current record by rec, see HeapFile::updateRecord
+    const Status updateRecord(const Record & rec);
+
     // marks current page of scan dirty
     const Status markDirty();
 
 private:
-    int   offset;            // byte offset of filter attribute
-    int   length;            // length of filter attribute
-    Datatype type;           // datatype of filter attribute
-    const char* filter;      // comparison value of filter
-    Operator op;             // comparison operator of filter
+    // the predicate of the scan, empty if there is none.  the terms of
+    // group g are terms[groupEnd[g-1]] up to terms[groupEnd[g]], in the
+    // order they are tried in
+    vector<ScanTerm> terms;
+    vector<int> groupEnd;
+    int   prefixLen;         // bytes of a record the predicate looks at
 
      // The following variables are used to preserve the state
     // of the scan when the method markScan() is invoked.
@@ -105,8 +511,52 @@ private:
     // scan to be rolled back to the following
     int   markedPageNo;	// page number of pinned page
     RID   markedRec;         // rid of last record returned
+    int   markedPageIdx;     // curPageIdx at the mark
+    bool  markedPageMoved;   // curPageMoved at the mark
+
+    // index in the page directory of curPage, unless curPageMoved
+    int   curPageIdx;
+    int   readAhead;         // pages prefetched at a time, 0 for none
+
+    // records this scan has moved to another page by updating them.
+    // the scan must not return them a second time when it reaches
+    // their new location
+    set<pair<int,int> > movedByScan;
+
+    // true if some group of the predicate consists only of terms
+    // the zone maps can rule out, see zoneMayMatch
+    bool  useZones;
+
+    // unpin the current page and pin the next one of the file whose
+    // zone does not rule the predicate out
+    const Status nextScanPage();
+
+    // false if no record with values in zone can satisfy the predicate
+    const bool zoneMayMatch(const char* zone) const;
+
+    // set skip if the zone of data page pageNo rules the predicate out
+    const Status zoneRulesOut(const int pageNo, bool & skip);
+
+    // read just enough of a large record for matchRec
+    const Status readFilterPrefix(Record & rec);
 
     const bool matchRec(const Record & rec) const;
+
+    // the records of page that satisfy the predicate, as
+    // scanBatch would return them.  large records are left out and their
+    // RIDs added to large instead.  the scan itself is not affected
+    const Status matchPage(Page* page, RID* rids, Record* recs, int & cnt,
+                           vector<RID> & large) const;
+
+    // set the bit in sel of every one of the n records of a run of
+    // getRecords that has no SLOT flags and satisfies the predicate.
+    // returns false if some record does have flags
+    const bool matchRun(const Record* recs, const short* flags,
+                        const int n, unsigned long long* sel) const;
+
+    // body of a parallelScan thread
+    static void scanWorker(ParScanJob* job, const int worker,
+                           ParScanResult* result);
 };
 
 
@@ -121,6 +571,103 @@ public:
 
     // insert record into file, returning its RID
     const Status insertRecord(const Record & rec, RID& outRid); 
+
+    // insert count records into file, returning their RIDs in outRids
+    const Status insertRecords(const Record* recs, const int count,
+                               RID* outRids);
+};
+
+
+// Bulk loader for heap files.  Records are packed into pages held in a
+// private staging buffer, and the pages are written straight to the
+// file in large sequential chunks without going through the buffer
+// pool.  The file header is brought up to date by finish().  The file
+// must not be opened through a HeapFile until the load is finished.
+class HeapFileLoader
+{
+public:
+
+    HeapFileLoader(const string & name, Status & status,
+                   const int stagePages = LOADSTAGEPAGES);
+
+    // finishes the load if finish() has not been called
+    ~HeapFileLoader();
+
+    // add record to the file, returning its RID
+    const Status insertRecord(const Record & rec, RID & outRid);
+
+    // add count pages filled elsewhere, holding recCnt records between
+    // them, to the file.  They are renumbered and linked in order; their
+    // records must be stored inline
+    const Status insertPages(const Page* pages, const int count,
+                             const int recCnt);
+
+    // write out the staged pages and install the file header
+    const Status finish();
+
+private:
+    File*	filePtr;	// underlying DB File object
+    Page	hdrBuf;		// private copy of the header page
+    FileHdrPage* headerPage;	// hdrBuf as a FileHdrPage
+    int		headerPageNo;	// page number of header page
+
+    Page	tail;		// last data page when the load started
+    bool	tailWritten;	// true once tail is back in the file
+
+    Page*	stage;		// pages not yet written to the file
+    int		stagePages;	// size of stage
+    int		stageFirst;	// pageNo of stage[0], -1 before the first
+    int		stageCnt;	// number of pages of stage in use
+
+    Page*	curPage;	// data page records are added to
+    bool	finished;	// true once finish() has been called
+
+    Page	dirBuf;		// last page of the page directory
+
+    // zones of the page being filled, not yet in the zone maps
+    char	curZone[MAXZONEATTRS * 2 * sizeof(int)];
+    vector<int>	zonePageNos;	// the zone map chain as far as followed
+    vector<Page*> zonePages;	// copies of those pages
+
+    // start a new data page after curPage
+    const Status newDataPage();
+
+    // widen the zone of data page lastPage by curZone and empty it
+    const Status saveZone();
+
+    // write the pages in stage to the file
+    const Status flushStage();
+
+    // list data page pageNo at the end of the page directory
+    const Status addDirEntry(const int pageNo);
+
+    // store a large record in a chain of overflow pages
+    const Status writeOverflow(const Record & rec, OvflDesc & desc);
 };
 
+// hands out the next record of a stream in rec, FILEEOF after the
+// last.  rec need only stay valid until the call after
+typedef const Status (*RecordSourceFn)(void* arg, Record & rec);
+
+// create the heap file name and load the records fn hands out into it
+// with a HeapFileLoader of stagePages pages
+extern const Status loadHeapFile(const string & name, RecordSourceFn fn,
+                                 void* arg,
+                                 const int stagePages = LOADSTAGEPAGES);
+
+// hash of the n bytes at p: FNV-1a, with the bits mixed at the end so
+// that the low ones depend on all of the bytes
+static inline unsigned hashBytes(const char* p, const int n)
+{
+    unsigned	h = 2166136261u;
+
+    for(int i = 0; i < n; i++) h = (h ^ (unsigned char) p[i]) * 16777619u;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
 #endif
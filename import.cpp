@@ -0,0 +1,259 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <thread>
+#include <mutex>
+#include "import.h"
+#include "error.h"
+
+// state shared by the threads of one import
+struct ImportJob
+{
+  ImportFormat		format;
+  const ImportAttr*	attrs;
+  int			attrCnt;
+  int			recLen;		// length of the records built
+  HeapFileLoader*	loader;
+  mutex			loaderLock;	// HeapFileLoader is not thread safe
+};
+
+// what one thread works on and what it returns
+struct ImportChunk
+{
+  const char*	begin;		// first byte of the chunk
+  const char*	end;		// one past its last byte
+  int		rowCnt;		// rows imported from the chunk
+  Status	status;
+};
+
+// fill rec from the CSV row [begin, end) according to job.attrs
+
+static const Status parseRow(const ImportJob & job, const char* begin,
+                             const char* end, char* rec)
+{
+    char	field[64];
+    const char*	p = begin;
+
+    for(int i = 0; i < job.attrCnt; i++){
+	const char* q = p;
+	while(q < end && *q != ',') q++;
+	if((q == end) != (i == job.attrCnt - 1)) return BADIMPORTFMT;
+
+	int len = q - p;
+	char* stop;
+	switch(job.attrs[i].type){
+	case STRING:
+	    if(len > job.attrs[i].len) return ATTRTOOLONG;
+	    memcpy(rec, p, len);
+	    memset(rec + len, 0, job.attrs[i].len - len);
+	    rec += job.attrs[i].len;
+	    break;
+
+	case INTEGER: {
+	    if(len == 0 || len >= (int) sizeof(field)) return BADIMPORTFMT;
+	    memcpy(field, p, len);
+	    field[len] = '\0';
+	    errno = 0;
+	    long lval = strtol(field, &stop, 10);
+	    if(*stop != '\0' || errno == ERANGE || lval < INT_MIN ||
+	       lval > INT_MAX) return BADIMPORTFMT;
+	    int ival = lval;
+	    memcpy(rec, &ival, sizeof(int));
+	    rec += sizeof(int);
+	    break;
+	}
+
+	case FLOAT: {
+	    if(len == 0 || len >= (int) sizeof(field)) return BADIMPORTFMT;
+	    memcpy(field, p, len);
+	    field[len] = '\0';
+	    errno = 0;
+	    float fval = strtof(field, &stop);
+	    if(*stop != '\0' || errno == ERANGE) return BADIMPORTFMT;
+	    memcpy(rec, &fval, sizeof(float));
+	    rec += sizeof(float);
+	    break;
+	}
+	}
+	p = q + 1;
+    }
+    return OK;
+}
+
+// hand the pages filled so far over to the loader and start again
+// with an empty batch
+
+static const Status flushBatch(ImportJob & job, Page* batch, int & pageCnt,
+                               int & recCnt)
+{
+    Status status;
+
+    if(recCnt == 0) return OK;
+    {
+	lock_guard<mutex> guard(job.loaderLock);
+	status = job.loader->insertPages(batch, pageCnt, recCnt);
+    }
+    pageCnt = 1;
+    recCnt = 0;
+    batch[0].init(0);
+    return status;
+}
+
+// body of an import thread: parse the rows of chunk into records and
+// pack them into a private batch of pages
+
+static void importChunk(ImportJob * job, ImportChunk * chunk)
+{
+    Page*	batch = new Page[IMPORTBATCHPAGES];
+    int		pageCnt = 1;
+    int		recCnt = 0;
+    char*	buf = new char[job->recLen];
+    Record	rec;
+    RID		rid;
+    Status	status = OK;
+    const char*	p = chunk->begin;
+
+    batch[0].init(0);
+    rec.length = job->recLen;
+    chunk->rowCnt = 0;
+    while(p < chunk->end){
+	if(job->format == BINARY){
+	    rec.data = (void*) p;
+	    p += job->recLen;
+	}
+	else{
+	    const char* eol = (const char*) memchr(p, '\n', chunk->end - p);
+	    if(!eol) eol = chunk->end;
+	    const char* next = eol + 1;
+	    if(eol > p && eol[-1] == '\r') eol--;
+	    if(eol == p){
+		// skip blank lines
+		p = next;
+		continue;
+	    }
+	    status = parseRow(*job, p, eol, buf);
+	    if(status != OK) break;
+	    rec.data = buf;
+	    p = next;
+	}
+
+	status = batch[pageCnt - 1].insertRecord(rec, rid);
+	if(status == NOSPACE){
+	    if(pageCnt == IMPORTBATCHPAGES){
+		status = flushBatch(*job, batch, pageCnt, recCnt);
+		if(status != OK) break;
+	    }
+	    else batch[pageCnt++].init(0);
+	    status = batch[pageCnt - 1].insertRecord(rec, rid);
+	}
+	if(status != OK) break;
+	recCnt++;
+	chunk->rowCnt++;
+    }
+    if(status == OK) status = flushBatch(*job, batch, pageCnt, recCnt);
+    else chunk->rowCnt -= recCnt;
+
+    chunk->status = status;
+    delete [] buf;
+    delete [] batch;
+}
+
+const Status importFile(const string & inName, const string & relName,
+                        const ImportFormat format,
+                        const ImportAttr* attrs, const int attrCnt,
+                        const int nThreads, int & rowCnt)
+{
+    ImportJob	job;
+    Status	status;
+    struct stat	st;
+    int		i;
+
+    rowCnt = 0;
+    if(!attrs || attrCnt < 1 || nThreads < 1) return BADIMPORTFMT;
+
+    job.format = format;
+    job.attrs = attrs;
+    job.attrCnt = attrCnt;
+    job.recLen = 0;
+    for(i = 0; i < attrCnt; i++){
+	if(attrs[i].type == STRING){
+	    if(attrs[i].len < 1) return BADIMPORTFMT;
+	    job.recLen += attrs[i].len;
+	}
+	else job.recLen += (attrs[i].type == INTEGER) ? sizeof(int)
+						     : sizeof(float);
+    }
+    if(job.recLen > (int) MAXINLINERECLEN) return ATTRTOOLONG;
+
+    int fd = open(inName.c_str(), O_RDONLY);
+    if(fd < 0) return UNIXERR;
+    if(fstat(fd, &st) < 0){
+	close(fd);
+	return UNIXERR;
+    }
+    long size = st.st_size;
+    if(format == BINARY && size % job.recLen != 0){
+	close(fd);
+	return BADIMPORTFMT;
+    }
+
+    const char* input = NULL;
+    if(size > 0){
+	input = (const char*) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(input == (const char*) MAP_FAILED){
+	    close(fd);
+	    return UNIXERR;
+	}
+    }
+    close(fd);
+
+    job.loader = new HeapFileLoader(relName, status);
+    if(status != OK){
+	delete job.loader;
+	if(input) munmap((void*) input, size);
+	return status;
+    }
+
+    // cut the input into chunks of about the same size, ending binary
+    // chunks on a record boundary and CSV chunks on a line boundary
+    ImportChunk* chunks = new ImportChunk[nThreads];
+    const char* p = input;
+    for(i = 0; i < nThreads; i++){
+	long cut = size * (i + 1) / nThreads;
+	if(format == BINARY) cut -= cut % job.recLen;
+	const char* end = input + cut;
+	if(format == CSV && i < nThreads - 1){
+	    if(end < p) end = p;
+	    const char* eol = (const char*) memchr(end, '\n', input + size - end);
+	    end = eol ? eol + 1 : input + size;
+	}
+	if(end < p) end = p;
+	chunks[i].begin = p;
+	chunks[i].end = end;
+	p = end;
+    }
+
+    thread** threads = new thread*[nThreads];
+    for(i = 0; i < nThreads; i++)
+	threads[i] = new thread(importChunk, &job, &chunks[i]);
+    status = OK;
+    for(i = 0; i < nThreads; i++){
+	threads[i]->join();
+	delete threads[i];
+	rowCnt += chunks[i].rowCnt;
+	if(status == OK) status = chunks[i].status;
+    }
+    delete [] threads;
+    delete [] chunks;
+
+    Status finishstatus = job.loader->finish();
+    delete job.loader;
+    if(input) munmap((void*) input, size);
+    if(status != OK) return status;
+    return finishstatus;
+}
@@ -0,0 +1,35 @@
+#ifndef IMPORT_H
+#define IMPORT_H
+
+#include "heapfile.h"
+
+// number of pages an import worker fills before handing them over
+const int IMPORTBATCHPAGES = 64;
+
+// input formats understood by importFile()
+enum ImportFormat { CSV, BINARY };
+
+// one attribute of the records an import builds.  Attributes are laid
+// out one after the other with no padding: a STRING takes len bytes,
+// padded with zeros, an INTEGER sizeof(int) and a FLOAT sizeof(float)
+struct ImportAttr
+{
+  Datatype	type;
+  int		len;		// length of a STRING attribute
+};
+
+// Import the rows of file inName into the existing heap file relName.
+// CSV input has one row per line, with fields separated by commas;
+// BINARY input is a sequence of records already in the layout given by
+// attrs.  The input is split into nThreads chunks that are parsed in
+// parallel, each thread filling pages of its own which are then linked
+// into the file by a HeapFileLoader.  Rows from different threads are
+// interleaved a batch of pages at a time.  rowCnt returns the number of
+// rows imported; on error the ones already imported stay in the file
+extern const Status importFile(const string & inName,
+                               const string & relName,
+                               const ImportFormat format,
+                               const ImportAttr* attrs, const int attrCnt,
+                               const int nThreads, int & rowCnt);
+
+#endif
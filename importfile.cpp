@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <thread>
+#include "import.h"
+#include "error.h"
+#include "stdlib.h"
+
+// Command line front end for importFile():
+//
+//   importfile [-b] [-t threads] input relation attr ...
+//
+// where each attr is i (INTEGER), f (FLOAT) or sN (STRING of N bytes).
+// Input is CSV unless -b is given.  relation is created if it does not
+// exist yet; otherwise the rows are added to it.
+
+extern Status createHeapFile(string FileName);
+
+// globals
+DB db;
+BufMgr* bufMgr;
+
+static void usage()
+{
+    cerr << "usage: importfile [-b] [-t threads] input relation attr ...\n"
+	 << "       attr is i, f or sN for a string of N bytes" << endl;
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    Error	error;
+    Status	status;
+    ImportFormat format = CSV;
+    int		nThreads = thread::hardware_concurrency();
+    int		c;
+
+    while((c = getopt(argc, argv, "bt:")) != -1){
+	switch(c){
+	case 'b': format = BINARY; break;
+	case 't': nThreads = atoi(optarg); break;
+	default: usage();
+	}
+    }
+    if(nThreads < 1) nThreads = 1;
+    if(argc - optind < 3) usage();
+
+    string inName = argv[optind];
+    string relName = argv[optind + 1];
+    int attrCnt = argc - optind - 2;
+    ImportAttr* attrs = new ImportAttr[attrCnt];
+    for(int i = 0; i < attrCnt; i++){
+	const char* spec = argv[optind + 2 + i];
+	attrs[i].len = 0;
+	if(!strcmp(spec, "i")) attrs[i].type = INTEGER;
+	else if(!strcmp(spec, "f")) attrs[i].type = FLOAT;
+	else if(spec[0] == 's' && atoi(spec + 1) > 0){
+	    attrs[i].type = STRING;
+	    attrs[i].len = atoi(spec + 1);
+	}
+	else usage();
+    }
+
+    bufMgr = new BufMgr(100);
+
+    status = createHeapFile(relName);
+    if(status != OK && status != FILEEXISTS){
+	error.print(status);
+	return 1;
+    }
+
+    struct timeval start, stop;
+    int rowCnt;
+    gettimeofday(&start, NULL);
+    status = importFile(inName, relName, format, attrs, attrCnt, nThreads,
+			rowCnt);
+    gettimeofday(&stop, NULL);
+    double secs = (stop.tv_sec - start.tv_sec)
+		  + (stop.tv_usec - start.tv_usec) / 1e6;
+
+    printf("%d rows imported into %s by %d threads in %.3f s, %.0f rows/s\n",
+	   rowCnt, relName.c_str(), nThreads, secs,
+	   secs > 0 ? rowCnt / secs : 0.0);
+    if(status != OK) error.print(status);
+
+    delete [] attrs;
+    delete bufMgr;
+    return (status == OK) ? 0 : 1;
+}
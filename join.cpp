@@ -0,0 +1,357 @@
+#include "join.h"
+#include "error.h"
+
+#include <stdio.h>
+
+extern const Status createHeapFile(const string fileName);
+extern const Status destroyHeapFile(const string fileName);
+
+// a build record in the hash table
+struct JoinEntry
+{
+  unsigned	hash;		// hash of its attribute
+  int		next;		// next entry of the chain, -1 at the end
+  Record	rec;		// the record, in arena
+};
+
+// hash of the attribute attr of rec in h.  false if rec is too short to
+// hold it or it is a NaN, which nothing joins with.  a STRING is hashed
+// up to its first NUL and -0 as 0, so values that compare equal hash
+// the same
+
+static bool hashAttr(const ScanColumn & attr, const Record & rec,
+                     unsigned & h)
+{
+    const char*	p;
+    int		n = attr.length;
+    float	f;
+
+    if(rec.length < attr.offset + attr.length) return false;
+    p = (const char*) rec.data + attr.offset;
+    if(attr.type == STRING) n = strnlen(p, n);
+    else if(attr.type == FLOAT){
+	memcpy(&f, p, sizeof(float));
+	if(f != f) return false;
+	if(f == 0) f = 0;
+	p = (const char*) &f;
+    }
+    h = hashBytes(p, n);
+    return true;
+}
+
+// the joined records of HashJoin::next, for writeTo
+
+static const Status nextJoined(void* join, Record & rec)
+{
+    return ((HashJoin*) join)->next(rec);
+}
+
+// true if the attributes of a and b are equal, as a scan with EQ has it
+
+static bool sameAttr(const ScanColumn & attrA, const Record & a,
+                     const ScanColumn & attrB, const Record & b)
+{
+    const char*	pa = (const char*) a.data + attrA.offset;
+    const char*	pb = (const char*) b.data + attrB.offset;
+    float	fa, fb;
+
+    if(attrA.type == STRING) return strncmp(pa, pb, attrA.length) == 0;
+    if(attrA.type == INTEGER) return memcmp(pa, pb, sizeof(int)) == 0;
+    memcpy(&fa, pa, sizeof(float));
+    memcpy(&fb, pb, sizeof(float));
+    return fa == fb;
+}
+
+// partition of a record with hash h.  the hash is mixed again so the
+// partition does not follow from the bits that pick the chain
+
+static int partOf(const unsigned h, const int partCnt)
+{
+    return (int) (((unsigned long long) (h * 2654435761u) * partCnt) >> 32);
+}
+
+HashJoin::HashJoin(const string & buildName, const ScanColumn & buildAttr,
+                   const string & probeName, const ScanColumn & probeAttr,
+                   const int memPages, Status & status)
+{
+    static int	joinCnt = 0;	// tells the partitions of different joins apart
+    char	buf[32];
+    int		pages;
+
+    partCnt = 0;
+    part = 0;
+    buildScan = NULL;
+    buildDone = false;
+    hasPending = false;
+    arena = NULL;
+    arenaUsed = 0;
+    probeScan = NULL;
+    match = -1;
+    this->buildAttr = buildAttr;
+    this->probeAttr = probeAttr;
+    this->memPages = memPages;
+
+    if(buildAttr.type != probeAttr.type ||
+       buildAttr.length != probeAttr.length ||
+       buildAttr.offset < 0 || probeAttr.offset < 0 || buildAttr.length < 1 ||
+       (buildAttr.type != STRING && buildAttr.type != INTEGER &&
+        buildAttr.type != FLOAT) ||
+       (buildAttr.type != STRING && buildAttr.length != sizeof(int))){
+	status = BADSCANPARM;
+	return;
+    }
+    if(memPages < 2){
+	status = INSUFMEM;
+	return;
+    }
+    sprintf(buf, ".join%d.", joinCnt++);
+    partPrefix = buildName + buf;
+    arena = new char[memPages * PAGESIZE];
+
+    // try to hash the whole build file, unless it is plainly too big
+    buildScan = new HeapFileScan(buildName, status);
+    if(status != OK) return;
+    pages = buildScan->getPageCnt();
+    if(pages <= memPages){
+	status = buildScan->startScan(NULL, 0);
+	if(status == OK) status = loadChunk();
+	if(status != OK) return;
+	if(buildDone){
+	    probeScan = new HeapFileScan(probeName, status);
+	    if(status == OK) status = probeScan->startScan(NULL, 0);
+	    return;
+	}
+    }
+    closePart();
+    hasPending = false;
+
+    // two partitions for every memPages pages of the build file, so
+    // that most fit with the hash table overhead on top
+    partCnt = 2 * pages / memPages + 1;
+    if(partCnt > MAXJOINPARTS) partCnt = MAXJOINPARTS;
+    if(partCnt < 2) partCnt = 2;
+    status = partition(buildName, buildAttr, "b");
+    if(status == OK) status = partition(probeName, probeAttr, "p");
+    if(status == OK) status = openPart(0);
+}
+
+HashJoin::~HashJoin()
+{
+    closePart();
+    delete [] arena;
+    for(unsigned i = 0; i < partFiles.size(); i++)
+	destroyHeapFile(partFiles[i]);
+}
+
+// the chain of the probe record is walked first; when the probe scan
+// ends the next chunk of the build side is hashed and the probe scan
+// goes round again, and when the build side is used up as well the
+// next partition follows
+
+const Status HashJoin::next(Record & buildRec, Record & probeRec)
+{
+    Status	status;
+    RID		rid;
+
+    while(true){
+	while(match != -1){
+	    const JoinEntry & e = entries[match];
+	    match = e.next;
+	    if(e.hash == probeHash &&
+	       sameAttr(buildAttr, e.rec, probeAttr, this->probeRec)){
+		buildRec = e.rec;
+		probeRec = this->probeRec;
+		return OK;
+	    }
+	}
+	if(!probeScan) return FILEEOF;
+
+	// an empty table matches nothing, so the probe side is not read
+	if(entries.empty() && buildDone) status = FILEEOF;
+	else status = probeScan->scanNext(rid);
+	if(status == OK){
+	    status = probeScan->getRecord(this->probeRec);
+	    if(status != OK) return status;
+	    if(hashAttr(probeAttr, this->probeRec, probeHash))
+		match = heads[probeHash & (heads.size() - 1)];
+	    continue;
+	}
+	if(status != FILEEOF) return status;
+
+	if(!buildDone){
+	    status = loadChunk();
+	    if(status == OK) status = probeScan->seekPage(0);
+	    if(status != OK) return status;
+	    continue;
+	}
+	if(part + 1 >= partCnt) return FILEEOF;
+	status = openPart(part + 1);
+	if(status != OK) return status;
+    }
+}
+
+const Status HashJoin::next(Record & joined)
+{
+    Status	status;
+    Record	b, p;
+
+    status = next(b, p);
+    if(status != OK) return status;
+    joinBuf.resize(b.length + p.length);
+    memcpy(joinBuf.data(), b.data, b.length);
+    memcpy(joinBuf.data() + b.length, p.data, p.length);
+    joined.data = joinBuf.data();
+    joined.length = joinBuf.size();
+    return OK;
+}
+
+const Status HashJoin::writeTo(const string & outName)
+{
+    return loadHeapFile(outName, nextJoined, this);
+}
+
+const int HashJoin::getPartCnt() const
+{
+    return partCnt;
+}
+
+// the budget covers the records, their entries and their chain heads.
+// the record that would go over it is kept for the next chunk.  the
+// entries are chained in reverse so every chain is in input order
+
+const Status HashJoin::loadChunk()
+{
+    Status	status;
+    Record	rec;
+    RID		rid;
+    long	budget = (long) memPages * PAGESIZE;
+    long	used = 0, cost;
+    JoinEntry	e;
+    unsigned	size;
+    int		i;
+
+    entries.clear();
+    arenaUsed = 0;
+    match = -1;
+    if(hasPending){
+	rec.data = pending.data();
+	rec.length = pending.size();
+	hasPending = false;
+    }
+    else rec.data = NULL;
+
+    while(true){
+	if(!rec.data){
+	    status = buildScan->scanNext(rid);
+	    if(status == FILEEOF){
+		buildDone = true;
+		break;
+	    }
+	    if(status == OK) status = buildScan->getRecord(rec);
+	    if(status != OK) return status;
+	}
+	if(hashAttr(buildAttr, rec, e.hash)){
+	    cost = rec.length + (long) (sizeof(JoinEntry) + sizeof(int));
+	    if(cost > budget) return INSUFMEM;
+	    if(used + cost > budget){
+		pending.assign((char*) rec.data, (char*) rec.data + rec.length);
+		hasPending = true;
+		break;
+	    }
+	    e.rec.data = arena + arenaUsed;
+	    e.rec.length = rec.length;
+	    memcpy(e.rec.data, rec.data, rec.length);
+	    arenaUsed += rec.length;
+	    used += cost;
+	    entries.push_back(e);
+	}
+	rec.data = NULL;
+    }
+
+    for(size = 1; size < entries.size(); size *= 2) ;
+    heads.assign(size, -1);
+    for(i = entries.size() - 1; i >= 0; i--){
+	entries[i].next = heads[entries[i].hash & (size - 1)];
+	heads[entries[i].hash & (size - 1)] = i;
+    }
+    return OK;
+}
+
+// every partition gets a HeapFileLoader of its own, and all of them
+// are filled in one pass over the file
+
+const Status HashJoin::partition(const string & name, const ScanColumn & attr,
+                                 const char* side)
+{
+    Status	status = OK, finishstatus;
+    RID		rids[MAXSLOTS], rid;
+    Record	recs[MAXSLOTS];
+    unsigned	h;
+    int		n, k, p;
+
+    vector<HeapFileLoader*> loaders(partCnt, (HeapFileLoader*) NULL);
+    for(p = 0; p < partCnt && status == OK; p++){
+	status = createHeapFile(partName(side, p));
+	if(status != OK) break;
+	partFiles.push_back(partName(side, p));
+	loaders[p] = new HeapFileLoader(partName(side, p), status,
+					JOINSTAGEPAGES);
+    }
+
+    if(status == OK){
+	HeapFileScan* scan = new HeapFileScan(name, status);
+	if(status == OK) status = scan->startScan(NULL, 0);
+	while(status == OK &&
+	      (status = scan->scanBatch(MAXSLOTS, rids, recs, n)) == OK)
+	    for(k = 0; k < n && status == OK; k++)
+		if(hashAttr(attr, recs[k], h))
+		    status = loaders[partOf(h, partCnt)]->insertRecord(recs[k],
+								       rid);
+	delete scan;
+	if(status == FILEEOF) status = OK;
+    }
+
+    for(p = 0; p < partCnt; p++){
+	if(!loaders[p]) continue;
+	finishstatus = loaders[p]->finish();
+	if(status == OK) status = finishstatus;
+	delete loaders[p];
+    }
+    return status;
+}
+
+const Status HashJoin::openPart(const int p)
+{
+    Status	status;
+
+    closePart();
+    part = p;
+    buildDone = false;
+    hasPending = false;
+    buildScan = new HeapFileScan(partName("b", p), status);
+    if(status == OK) status = buildScan->startScan(NULL, 0);
+    if(status == OK) status = loadChunk();
+    if(status != OK) return status;
+    probeScan = new HeapFileScan(partName("p", p), status);
+    if(status == OK) status = probeScan->startScan(NULL, 0);
+    return status;
+}
+
+void HashJoin::closePart()
+{
+    delete buildScan;
+    buildScan = NULL;
+    delete probeScan;
+    probeScan = NULL;
+    entries.clear();
+    arenaUsed = 0;
+    match = -1;
+}
+
+const string HashJoin::partName(const char* side, const int p) const
+{
+    char	buf[16];
+
+    sprintf(buf, "%s%d", side, p);
+    return partPrefix + buf;
+}
@@ -0,0 +1,104 @@
+#ifndef JOIN_H
+#define JOIN_H
+
+#include "heapfile.h"
+
+// Equi-join of two heap files by hashing.  The records of the build
+// file are read into memory up to a budget and hashed on their join
+// attribute, and a scan of the probe file looks every one of its
+// records up.  When the build file does not fit, both files are first
+// split into partitions, temporary heap files, by the hash of the join
+// attribute, in the manner of the Grace hash join, and each pair of
+// partitions is joined in turn.  A build partition that still does not
+// fit, as when one value is very common, is taken in pieces, with the
+// probe partition scanned once for each.  Attributes compare as a scan
+// with EQ compares them: a STRING ends at its first NUL and a FLOAT
+// NaN equals nothing.  Records too short to hold the attribute join
+// with nothing.
+
+// most partitions a file is split into
+const int MAXJOINPARTS = 64;
+
+// pages the HeapFileLoader of each partition stages its records in
+const int JOINSTAGEPAGES = 4;
+
+struct JoinEntry;		// see join.cpp
+
+class HashJoin
+{
+public:
+  // join the records of heap file buildName whose attribute buildAttr
+  // equals attribute probeAttr of records of heap file probeName.  the
+  // two must have the same type and length, else BADSCANPARM.  the
+  // records hashed in memory, with about 24 bytes for each on top,
+  // take up to memPages pages; INSUFMEM if memPages is below 2 or a
+  // build record does not fit
+  HashJoin(const string & buildName, const ScanColumn & buildAttr,
+           const string & probeName, const ScanColumn & probeAttr,
+           const int memPages, Status & status);
+
+  // destroys the partitions
+  ~HashJoin();
+
+  // the next pair of matching records, FILEEOF after the last one.
+  // they stay valid until the next call.  the pairs come in the order
+  // of the probe records, partition by partition
+  const Status next(Record & buildRec, Record & probeRec);
+
+  // the same, as one record: the build record followed by the probe one
+  const Status next(Record & joined);
+
+  // write the pairs next has yet to return, as one record each, to the
+  // new heap file outName
+  const Status writeTo(const string & outName);
+
+  // number of partitions each file was split into, 0 if the build
+  // file fit in memory
+  const int getPartCnt() const;
+
+private:
+  ScanColumn	buildAttr;
+  ScanColumn	probeAttr;
+  int		memPages;
+  string	partPrefix;	// partition n is partPrefix + "b" or "p" + n
+  int		partCnt;	// 0 if there are none
+  int		part;		// partition being joined
+  vector<string> partFiles;	// the partitions made so far
+
+  HeapFileScan*	buildScan;	// build input of the partition
+  bool		buildDone;	// true once all of it has been hashed
+  vector<char>	pending;	// build record that did not fit last time
+  bool		hasPending;
+
+  // the hash table: the build records in arena, chained in entries
+  // from heads, which is indexed by the low bits of their hashes
+  char*		arena;
+  int		arenaUsed;
+  vector<JoinEntry> entries;
+  vector<int>	heads;
+
+  HeapFileScan*	probeScan;	// probe input of the partition
+  Record	probeRec;	// probe record being looked up
+  unsigned	probeHash;	// and the hash of its attribute
+  int		match;		// entry to look at next for it, -1 if none
+
+  vector<char>	joinBuf;	// the last record next(joined) returned
+
+  // hash the next records of buildScan until the budget is used up
+  // or buildScan is, setting buildDone then
+  const Status loadChunk();
+
+  // split heap file name into partCnt partitions by the hash of attr
+  const Status partition(const string & name, const ScanColumn & attr,
+                         const char* side);
+
+  // start on partition p: scans for its two halves and the first chunk
+  const Status openPart(const int p);
+
+  // end the scans of the partition being joined
+  void closePart();
+
+  const string partName(const char* side, const int p) const;
+};
+
+#endif
@@ -12,6 +12,8 @@ void Page::init(int pageNo)
     slotCnt = 0; // no slots in use
     curPage = pageNo;
     freePtr=0; // offset of free space in data array
+    freeSlots = 0;
+    memset(liveMap, 0, sizeof(liveMap));
 //    freeSpace=PAGESIZE-DPFIXED + sizeof(slot_t); // amount of space available
     freeSpace=PAGESIZE-DPFIXED; // amount of space available
 }
@@ -36,6 +38,14 @@ const Status Page::setNextPage(int pageNo)
     return OK;
 }
 
+// a page may be filled before its place in a file is known, as by
+// importFile().  RIDs of its records take their pageNo from curPage
+const Status Page::setPageNo(const int pageNo)
+{
+    curPage = pageNo;
+    return OK;
+}
+
 const Status Page::getNextPage(int& pageNo) const
 {
     pageNo = nextPage;
@@ -54,7 +64,8 @@ const short Page::getFreeSpace() const
 const Status Page::insertRecord(const Record & rec, RID& rid)
 {
     RID tmpRid;
-    int spaceNeeded = rec.length + sizeof(slot_t);
+    int space = recSpace(rec.length);
+    int spaceNeeded = space + sizeof(slot_t);
 //	cout<<spaceNeeded<<", "<<freeSpace<<endl;
     // Start by checking if sufficient space exists
     // This is an upper bound check. may not actually need a slot
@@ -62,16 +73,19 @@ const Status Page::insertRecord(const Record & rec, RID& rid)
     if (spaceNeeded > freeSpace) return NOSPACE;
     else
     {
-        int i=0;
-    	// look for an empty slot
-    	while (i > slotCnt)
-    	{
-	    if (slot[i].length == -1) break;
-	    else i--;
-    	}
-	// at this point we have either found an empty slot 
-	// or i will be equal to slotCnt.  In either case,
+        int i = slotCnt;
+	// reuse an empty slot if there is one.  In either case,
 	// we can just use i as the slot index
+	if (freeSlots > 0)
+	{
+	    i = -firstFreeSlot();
+	    freeSlots--;
+	}
+
+	// freeSpace may be made up of holes left by earlier deletions.
+	// squeeze them out only now that contiguous space is needed
+	if (i != slotCnt) spaceNeeded = space;
+	if (spaceNeeded > getContiguousSpace()) compact();
 
 	// adjust free space
 	if (i == slotCnt) 
@@ -83,7 +97,7 @@ const Status Page::insertRecord(const Record & rec, RID& rid)
 	else 
 	{
 	    // reusing an existing slot 
-	    freeSpace -= rec.length;
+	    freeSpace -= space;
 	}
 
 	// use existing value of slotCnt as the index into slot array
@@ -91,9 +105,10 @@ const Status Page::insertRecord(const Record & rec, RID& rid)
 	// value to 0
 	slot[i].offset = freePtr;
 	slot[i].length = rec.length;
+	liveMap[-i / 64] |= 1ULL << (-i % 64);
 
 	memcpy(&data[freePtr], rec.data, rec.length); // copy data on to the data page
-	freePtr += rec.length; // adjust freePtr 
+	freePtr += space; // adjust freePtr 
 
 	tmpRid.pageNo = curPage;
 	tmpRid.slotNo = -i; // make a positive slot number
@@ -104,8 +119,9 @@ const Status Page::insertRecord(const Record & rec, RID& rid)
 }
 
 // delete a record from a page. Returns OK if everything went OK
-// compacts remaining records but leaves hole in slot array
-// use bcopy and not memcpy to do the compaction
+// the record's bytes are left in place as a hole that is accounted
+// for in freeSpace and reclaimed by compact() when an insert needs it.
+// Also leaves a hole in slot array unless the slot is the last one
 
 const Status Page::deleteRecord(const RID & rid)
 {
@@ -115,127 +131,200 @@ const Status Page::deleteRecord(const RID & rid)
     if ((slotNo > slotCnt) && (slot[slotNo].length > 0))
     {
 	// valid slot
+	// space taken by record being deleted
+	int recLen = recSpace(slot[slotNo].length);
 
-	// two major cases.  case (i) is the case that the record
-	// being deleted is the "last" record on the page.  This
-	// case is identified by the fact that slotNo == slotCnt+1;
-	// In this case the records do not need to be compacted.
-	// case (ii) occurs when the record being deleted has one
-	// or more records after it.  This case requires compaction.
-	// It is identified by the condition slotNo > slotCnt+1
-
-#if 0
-        // this doesn't work if last slot is not last physical
-        // record
-	if (slotNo == (slotCnt+1))
-	{
-	    // case (i) - no compaction required
-	    freePtr -= slot[slotNo].length;
-	    freeSpace += sizeof(slot_t)+ slot[slotNo].length;
+	// if the record is the last one physically, the hole can be
+	// given back to the contiguous free area right away
+	if ((slot[slotNo].offset & SLOTOFFMASK) + recLen == freePtr)
+	    freePtr -= recLen;
+	freeSpace += recLen;  // increase freespace by size of hole
+	liveMap[-slotNo / 64] &= ~(1ULL << (-slotNo % 64));
+
+	// Now there are two cases:
+	if (slotNo == slotCnt + 1)
+
+	  // Case 1 : Slot being freed is at end of slot array. In this
+	  //          case we can compact the slot array. Note that we
+	  //          should even compact slots that might have been
+	  //          emptied previously.
+	  {
 	    slotCnt++;
-	    return OK;
-	}
+	    freeSpace += sizeof(slot_t);
+	    while (slotCnt < 0 && slot[slotCnt + 1].length == -1)
+	    {
+	      slotCnt++;
+	      freeSlots--;
+	      freeSpace += sizeof(slot_t);
+	    }
+	  }
+
 	else
-#endif
-	{
-	    // case (ii) - compaction required
-            int offset = slot[slotNo].offset; // offset of record being deleted
-	    int recLen = slot[slotNo].length; // length of record being deleted
-            char* recPtr = &data[offset];  // get a pointer to the record
-
-	    // get handle on next record
-	    int nextOffset = offset + recLen;
-	    char* nextRec = &data[nextOffset];
-
-	    int cnt = freePtr-nextOffset; // calculate number of bytes to move
-	    bcopy(nextRec, recPtr, cnt); // shift bytes to the left
-
-	    // now need to adjust offsets of all valid slots to the
-	    // 'right' of slot being removed by recLen (size of the hole)
-
-	    for(int i = 0; i > slotCnt; i--)
-	      if (slot[i].length >= 0 && slot[i].offset > slot[slotNo].offset)
-		slot[i].offset -= recLen;
-		
-	    freePtr -= recLen;  // back up free pointer
-	    freeSpace += recLen;  // increase freespace by size of hole
-
-	    // Now there are two cases:
-	    if (slotNo == slotCnt + 1)
-
-	      // Case 1 : Slot being freed is at end of slot array. In this
-	      //          case we can compact the slot array. Note that we
-	      //          should even compact slots that might have been
-	      //          emptied previously.
-	      do
-		{
-		  slotCnt++;
-		  freeSpace += sizeof(slot_t);
-		}
-	      while (slotCnt < 0 && slot[slotCnt + 1].length == -1);
-
-	    else
-	      {
-		// Case 2: Slot being freed is in middle of slot array. No
-		//         compaction can be done.
-		slot[slotNo].length = -1; // mark slot free
-		slot[slotNo].offset = 0;  // mark slot free
-	      }
-	      return OK;
-	}
+	  {
+	    // Case 2: Slot being freed is in middle of slot array. No
+	    //         compaction can be done.
+	    slot[slotNo].length = -1; // mark slot free
+	    slot[slotNo].offset = 0;  // mark slot free
+	    freeSlots++;
+	  }
+
+	// no record left, so whatever holes remain are garbage
+	if (slotCnt == 0) freePtr = 0;
+	return OK;
     }
     else return INVALIDSLOTNO;
 }
 
-// returns RID of first record on page
-const Status Page::firstRecord(RID& firstRid) const
+// replace the record with RID rid by rec.  The record stays in place
+// when the new version is not longer than the space it already has or
+// when it is the last record physically and can grow into the free
+// area.  Otherwise it is rewritten at freePtr, compacting the page
+// first if needed. The slot and its flags are kept in all cases.
+// returns NOSPACE if the page cannot hold the new version, in which
+// case the page is left unchanged
+
+const Status Page::updateRecord(const RID & rid, const Record & rec)
 {
-    RID tmpRid;
-    int i=0;
+    int	slotNo = -rid.slotNo;
+
+    if ((slotNo <= slotCnt) || (slot[slotNo].length <= 0))
+	return INVALIDSLOTNO;
+
+    int offset = slot[slotNo].offset & SLOTOFFMASK;
+    short flags = slot[slotNo].offset & ~SLOTOFFMASK;
+    int oldSpace = recSpace(slot[slotNo].length);
+    int newSpace = recSpace(rec.length);
+    bool last = (offset + oldSpace == freePtr);
 
-    // find the first non-empty slot
-    while (i > slotCnt)
+    if (newSpace - oldSpace > freeSpace) return NOSPACE;
+
+    if (newSpace <= oldSpace ||
+        (last && newSpace - oldSpace <= getContiguousSpace()))
     {
-	if (slot[i].length == -1) i--;
-	else break;
+	// rec.data may point into this page, hence memmove
+	memmove(&data[offset], rec.data, rec.length);
+	if (last) freePtr = offset + newSpace;
     }
-	//cout<<curPage<<": "<<i<<" ==? "<<slotCnt<<endl;
-    if ((i == slotCnt) || (slot[i].length == -1)) return NORECORDS;
     else
-    {	//cout<<"didn't return norecords!\n";
-	// found a non-empty slot
-        tmpRid.pageNo = curPage;
-        tmpRid.slotNo = -i;
-	firstRid = tmpRid;
-	return OK;
+    {
+	// the record has to move within the page. stage the new version
+	// since rec.data may point at the old one, then turn the old one
+	// into a hole before looking for contiguous space
+	char buf[PAGESIZE];
+	memcpy(buf, rec.data, rec.length);
+	slot[slotNo].length = -1;
+	if (newSpace > getContiguousSpace() + oldSpace * last) compact();
+	else if (last) freePtr = offset;
+	offset = freePtr;
+	memcpy(&data[offset], buf, rec.length);
+	freePtr += newSpace;
     }
+    slot[slotNo].offset = offset | flags;
+    slot[slotNo].length = rec.length;
+    freeSpace -= newSpace - oldSpace;
+    return OK;
 }
 
-// returns RID of next record on the page
-// returns ENDOFPAGE if no more records exist on the page; otherwise OK
-const Status Page::nextRecord (const RID &curRid, RID& nextRid) const
+// returns the SLOT flags of the record with RID rid
+const Status Page::getFlags(const RID & rid, short & flags) const
 {
-    RID tmpRid;
-    int i; 
+    int	slotNo = -rid.slotNo;
+
+    if ((slotNo <= slotCnt) || (slot[slotNo].length <= 0))
+	return INVALIDSLOTNO;
+    flags = slot[slotNo].offset & ~SLOTOFFMASK;
+    return OK;
+}
+
+// sets the SLOT flags of the record with RID rid
+const Status Page::setFlags(const RID & rid, const short flags)
+{
+    int	slotNo = -rid.slotNo;
 
-    i = -curRid.slotNo; // get current slot number
-    i--; // back up one position
-    // find the first non-empty slot
-    while (i > slotCnt)
+    if ((slotNo <= slotCnt) || (slot[slotNo].length <= 0))
+	return INVALIDSLOTNO;
+    slot[slotNo].offset = (slot[slotNo].offset & SLOTOFFMASK) | flags;
+    return OK;
+}
+
+// returns the number of bytes between freePtr and the start of
+// the slot array. Like freeSpace, it charges a slot_t for slot[0]
+const short Page::getContiguousSpace() const
+{
+    return (int) (PAGESIZE - DPFIXED) - freePtr + slotCnt * (int) sizeof(slot_t);
+}
+
+// slide all records down to the start of data[] so that every
+// hole is merged into the free area at freePtr. Single pass over
+// the slot array through a scratch copy of the record area
+void Page::compact()
+{
+    char	buf[PAGESIZE];
+    int		ptr = 0;
+
+    for (int i = 0; i > slotCnt; i--)
     {
-	if (slot[i].length == -1) i--;
-	else break;
+	if (slot[i].length == -1) continue;
+	int space = recSpace(slot[i].length);
+	memcpy(&buf[ptr], &data[slot[i].offset & SLOTOFFMASK], space);
+	slot[i].offset = ptr | (slot[i].offset & ~SLOTOFFMASK);
+	ptr += space;
     }
-	//cout<<curRid.pageNo<<", "<<curRid.slotNo<<": "<<slotCnt<<"; "<<slot[i].length<<endl;
-    if ((i <= slotCnt) || (slot[i].length == -1)) return ENDOFPAGE;
-    else
+    memcpy(data, buf, ptr);
+    freePtr = ptr;
+}
+
+// returns the number of the first slot at or after slotNo whose
+// bit is set in liveMap, or -1 if there is none.  Bits past the end
+// of the slot array are always clear
+const int Page::nextLiveSlot(const int slotNo) const
+{
+    if (slotNo < 0 || slotNo >= -slotCnt) return -1;
+
+    int w = slotNo / 64;
+    unsigned long long bits = liveMap[w] & (~0ULL << (slotNo % 64));
+    while (bits == 0)
     {
-	// found a non-empty slot
-        tmpRid.pageNo = curPage;
-        tmpRid.slotNo = -i;
-	nextRid = tmpRid;
-	return OK;
+	if (++w == (int) SLOTMAPWORDS) return -1;
+	bits = liveMap[w];
     }
+    return w * 64 + __builtin_ctzll(bits);
+}
+
+// returns the number of the first unused slot below slotCnt, or -1
+const int Page::firstFreeSlot() const
+{
+    for (int w = 0; w * 64 < -slotCnt; w++)
+    {
+	unsigned long long bits = ~liveMap[w];
+	if (bits == 0) continue;
+	int i = w * 64 + __builtin_ctzll(bits);
+	return (i < -slotCnt) ? i : -1;
+    }
+    return -1;
+}
+
+// returns RID of first record on page
+const Status Page::firstRecord(RID& firstRid) const
+{
+    int i = nextLiveSlot(0);
+
+    if (i == -1) return NORECORDS;
+    firstRid.pageNo = curPage;
+    firstRid.slotNo = i;
+    return OK;
+}
+
+// returns RID of next record on the page
+// returns ENDOFPAGE if no more records exist on the page; otherwise OK
+const Status Page::nextRecord (const RID &curRid, RID& nextRid) const
+{
+    int i = nextLiveSlot(curRid.slotNo + 1);
+
+    if (i == -1) return ENDOFPAGE;
+    nextRid.pageNo = curPage;
+    nextRid.slotNo = i;
+    return OK;
 }
 
 // returns length and pointer to record with RID rid
@@ -246,10 +335,38 @@ const Status Page::getRecord(const RID & rid, Record & rec)
 
     if (((-slotNo) > slotCnt) && (slot[-slotNo].length > 0))
     {
-        offset = slot[-slotNo].offset; // extract offset in data[]
+        offset = slot[-slotNo].offset & SLOTOFFMASK; // extract offset in data[]
         rec.data = &data[offset];  // return pointer to actual record
         rec.length = slot[-slotNo].length; // return length of record
 	return OK;
     }
     else return INVALIDSLOTNO;
 }
+
+// returns the live records from slot slotNo onwards, max at most, for
+// callers that go through a page in one go.  forwarding stubs are
+// included; their flags tell them apart
+const Status Page::getRecords(const int slotNo, const int max, RID* rids,
+                              Record* recs, short* flags, int & cnt)
+{
+    cnt = 0;
+    if (slotNo < 0) return OK;
+
+    // walk the set bits of liveMap directly rather than through
+    // nextLiveSlot, one word at a time
+    for (int w = slotNo / 64; w < (int) SLOTMAPWORDS && cnt < max; w++)
+    {
+	unsigned long long bits = liveMap[w];
+	if (w == slotNo / 64) bits &= ~0ULL << (slotNo % 64);
+	for (; bits != 0 && cnt < max; bits &= bits - 1, cnt++)
+	{
+	    int i = w * 64 + __builtin_ctzll(bits);
+	    rids[cnt].pageNo = curPage;
+	    rids[cnt].slotNo = i;
+	    recs[cnt].data = &data[slot[-i].offset & SLOTOFFMASK];
+	    recs[cnt].length = slot[-i].length;
+	    flags[cnt] = slot[-i].offset & ~SLOTOFFMASK;
+	}
+    }
+    return OK;
+}
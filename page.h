@@ -19,19 +19,36 @@ struct Record
 
 // slot structure
 struct slot_t {
-        short	offset;  
+        short	offset;  // low bits: offset in data[], high bits: SLOT flags
         short	length;  // equals -1 if slot is not in use
 };
 
+// flags kept in the high bits of slot_t.offset.  They are set by the
+// heap file layer when a record has to leave its page on update
+const short SLOTOFFMASK = 0x0fff; // bits holding the offset itself
+const short SLOTSTUB = 0x4000;    // record moved; data is the RID it moved to
+const short SLOTMOVED = 0x2000;   // record moved here; data starts with
+                                  // the RID of its stub
+const short SLOTOVFL = 0x1000;    // record too large for a page; data
+                                  // locates its chain of overflow pages
+
 const unsigned PAGESIZE = 1024;
-const unsigned DPFIXED= sizeof(slot_t)+4*sizeof(short)+2*sizeof(int);
+const unsigned MAXSLOTS = 256;  // upper bound on the size of the slot array
+const unsigned SLOTMAPWORDS = MAXSLOTS / 64;
+const unsigned DPFIXED= sizeof(slot_t)+4*sizeof(short)+2*sizeof(int)
+                        +SLOTMAPWORDS*sizeof(unsigned long long);
 const unsigned PAGEDATASIZE = PAGESIZE-DPFIXED+sizeof(slot_t);
 // size of the data area of a page
 
+// every record occupies at least this many bytes of data[] so that
+// it can always be replaced in place by a forwarding stub
+const unsigned MINRECSPACE = sizeof(RID);
+
 // Class definition for a minirel data page.   
-// The design assumes that records are kept compacted when
-// deletions are performed. Notice, however, that the slot
-// array cannot be compacted.  Notice, this class does not keep
+// Deletions only free the slot and account for the hole left in
+// data[]; the records are compacted lazily, when insertRecord needs
+// more contiguous space than is available at freePtr. Notice that
+// the slot array cannot be compacted.  Notice, this class does not keep
 // the records align, relying instead on upper levels to take
 // care of non-aligned attributes
 
@@ -41,17 +58,37 @@ private:
     slot_t 	slot[1]; // first element of slot array - grows backwards!
     short	slotCnt; // number of slots in use;
     short	freePtr; // offset of first free byte in data[]
-    short	freeSpace; // number of bytes free in data[]
-    short	dummy;	// for alignment purposes
+    short	freeSpace; // number of bytes free in data[], holes included
+    short	freeSlots; // number of unused slots in the slot array
     int		nextPage; // forwards pointer
     int		curPage;  // page number of current pointer
+    unsigned long long liveMap[SLOTMAPWORDS]; // bit i set if slot i in use
+
+    // returns the first slot >= slotNo that holds a record, or -1
+    const int nextLiveSlot(const int slotNo) const;
+
+    // returns the first unused slot below slotCnt, or -1
+    const int firstFreeSlot() const;
+
+    // number of bytes available between freePtr and the slot array
+    const short getContiguousSpace() const;
+
+    // squeeze the holes left by deleted records out of data[]
+    void compact();
 
 public:
+    // bytes of data[] taken by a record of length len
+    static const int recSpace(const int len)
+    {
+        return (len < (int) MINRECSPACE) ? MINRECSPACE : len;
+    }
+
     void init(const int pageNo); // initialize a new page
     void dumpPage() const;       // dump contents of a page
 
     const Status getNextPage(int& pageNo) const; // returns value of nextPage
     const Status setNextPage(const int pageNo); // sets value of nextPage to pageNo
+    const Status setPageNo(const int pageNo); // renumbers a page built off-file
     const short getFreeSpace() const; // returns amount of free space
 
     // inserts a new record (rec) into the page, returns RID of record 
@@ -60,6 +97,14 @@ public:
     // delete the record with the specified rid
     const Status deleteRecord(const RID & rid);
 
+    // replace the record with the specified rid by rec, keeping its rid.
+    // returns NOSPACE if the new version does not fit on this page
+    const Status updateRecord(const RID & rid, const Record & rec);
+
+    // get and set the SLOT flags of the record with the specified rid
+    const Status getFlags(const RID & rid, short & flags) const;
+    const Status setFlags(const RID & rid, const short flags);
+
     // returns RID of first record on page
     // returns  NORECORDS if page contains no records.  Otherwise, returns OK
     const Status firstRecord(RID& firstRid) const;
@@ -70,6 +115,11 @@ public:
 
     // returns reference to record with RID rid
     const Status getRecord(const RID & rid, Record & rec);
+
+    // returns up to max records, with their RIDs and SLOT flags, from
+    // slot slotNo onwards in cnt.  cnt is 0 past the last record
+    const Status getRecords(const int slotNo, const int max, RID* rids,
+                            Record* recs, short* flags, int & cnt);
 };
 
 #endif
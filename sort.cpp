@@ -0,0 +1,400 @@
+#include "sort.h"
+#include "error.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <thread>
+
+extern const Status destroyHeapFile(const string fileName);
+
+// a sequence of sorted records being merged: a slice of the records in
+// memory or a run read with a scan of its own
+struct SortSource
+{
+  HeapFileScan*	scan;		// the run read, NULL for a slice
+  int		pos;		// position in recs of a slice
+  int		end;		// and its end
+  Record	cur;		// record the source is at
+  bool		done;		// true once past its last record
+};
+
+// SortedFile::next, to hand to loadHeapFile
+
+static const Status nextSorted(void* sorted, Record & rec)
+{
+    return ((SortedFile*) sorted)->next(rec);
+}
+
+// -1, 0 or 1 as record a sorts before, the same as, or after record b
+
+static int compareRecs(const vector<SortKey> & keys, const Record & a,
+                       const Record & b)
+{
+    int		c, ia, ib;
+    float	fa, fb;
+    bool	ha, hb;
+
+    for(unsigned k = 0; k < keys.size(); k++){
+	const SortKey & key = keys[k];
+	ha = a.length >= key.offset + key.length;
+	hb = b.length >= key.offset + key.length;
+	if(!ha || !hb){
+	    if(ha != hb) return ha ? 1 : -1;
+	    continue;
+	}
+	const char* pa = (const char*) a.data + key.offset;
+	const char* pb = (const char*) b.data + key.offset;
+	if(key.type == STRING){
+	    c = strncmp(pa, pb, key.length);
+	    if(c != 0) return (c < 0) ? -1 : 1;
+	}
+	else if(key.type == INTEGER){
+	    memcpy(&ia, pa, sizeof(int));
+	    memcpy(&ib, pb, sizeof(int));
+	    if(ia != ib) return (ia < ib) ? -1 : 1;
+	}
+	else{
+	    memcpy(&fa, pa, sizeof(float));
+	    memcpy(&fb, pb, sizeof(float));
+	    if(fa != fa || fb != fb){
+		if((fa != fa) != (fb != fb)) return (fa != fa) ? 1 : -1;
+	    }
+	    else if(fa != fb) return (fa < fb) ? -1 : 1;
+	}
+    }
+    return 0;
+}
+
+// the order stable_sort puts a slice in
+struct RecBefore
+{
+  const vector<SortKey>* keys;
+
+  bool operator()(const Record & a, const Record & b) const
+  {
+      return compareRecs(*keys, a, b) < 0;
+  }
+};
+
+// body of a run generation thread
+static void sortSlice(const vector<SortKey>* keys, Record* first,
+                      Record* last)
+{
+    RecBefore	before;
+
+    before.keys = keys;
+    stable_sort(first, last, before);
+}
+
+SortedFile::SortedFile(const string & fileName, const SortKey* keys,
+                       const int keyCnt, const int memPages,
+                       const int nThreads, Status & status)
+{
+    static int	sortCnt = 0;	// tells the runs of different sorts apart
+    char	buf[32];
+    vector<string> newRuns;
+    int		i, n;
+
+    chunk = NULL;
+    chunkUsed = 0;
+    runCnt = 0;
+    last = -1;
+    this->memPages = memPages;
+    this->nThreads = nThreads;
+
+    if(keyCnt < 1 || !keys || nThreads < 1){
+	status = BADSORTPARM;
+	return;
+    }
+    for(i = 0; i < keyCnt; i++)
+	if(keys[i].offset < 0 || keys[i].length < 1 ||
+	   (keys[i].type != STRING && keys[i].type != INTEGER &&
+	    keys[i].type != FLOAT) ||
+	   (keys[i].type != STRING && keys[i].length != sizeof(int))){
+	    status = BADSORTPARM;
+	    return;
+	}
+    if(memPages < 4){
+	status = INSUFMEM;
+	return;
+    }
+    this->keys.assign(keys, keys + keyCnt);
+    sprintf(buf, ".sort%d.", sortCnt++);
+    runPrefix = fileName + buf;
+
+    chunk = new char[memPages * PAGESIZE];
+    status = readInput(fileName);
+    if(status != OK) return;
+    if(runs.empty()){
+	status = openSlices();
+	return;
+    }
+    delete [] chunk;
+    chunk = NULL;
+
+    // merge MAXSORTFANIN neighbouring runs at a time, which keeps equal
+    // records in input order
+    while((int) runs.size() > MAXSORTFANIN){
+	newRuns.clear();
+	for(i = 0; i < (int) runs.size(); i += MAXSORTFANIN){
+	    n = min(MAXSORTFANIN, (int) runs.size() - i);
+	    if(n == 1){
+		newRuns.push_back(runs[i]);
+		continue;
+	    }
+	    newRuns.push_back(newRunName());
+	    status = openRuns(i, n);
+	    if(status == OK) status = mergeTo(newRuns.back(), SORTSTAGEPAGES);
+	    closeSources();
+	    if(status != OK){
+		// leave every run still there for the destructor
+		newRuns.insert(newRuns.end(), runs.begin() + i, runs.end());
+		runs = newRuns;
+		return;
+	    }
+	    for(int j = i; j < i + n; j++) destroyHeapFile(runs[j]);
+	}
+	runs = newRuns;
+    }
+    status = openRuns(0, runs.size());
+}
+
+SortedFile::~SortedFile()
+{
+    closeSources();
+    delete [] chunk;
+    for(unsigned i = 0; i < runs.size(); i++) destroyHeapFile(runs[i]);
+}
+
+const Status SortedFile::next(Record & rec)
+{
+    return pull(rec);
+}
+
+const Status SortedFile::writeTo(const string & outName)
+{
+    return mergeTo(outName, LOADSTAGEPAGES);
+}
+
+const int SortedFile::getRunCnt() const
+{
+    return runCnt;
+}
+
+const string SortedFile::newRunName()
+{
+    char	buf[16];
+
+    sprintf(buf, "%d", runCnt++);
+    return runPrefix + buf;
+}
+
+// the budget covers the records and the Record of each of them.  a
+// chunk that is full is sorted and written out at once; the last one
+// is only written if others were
+
+const Status SortedFile::readInput(const string & fileName)
+{
+    Status	status;
+    RID		rids[MAXSLOTS];
+    Record	batch[MAXSLOTS], rec;
+    long	budget = (long) memPages * PAGESIZE;
+    int		n, k;
+
+    HeapFileScan* scan = new HeapFileScan(fileName, status);
+    if(status == OK) status = scan->startScan(NULL, 0);
+    while(status == OK &&
+	  (status = scan->scanBatch(MAXSLOTS, rids, batch, n)) == OK){
+	for(k = 0; k < n; k++){
+	    if(batch[k].length + (long) sizeof(Record) > budget){
+		status = INSUFMEM;
+		break;
+	    }
+	    if(chunkUsed + batch[k].length +
+	       (long) ((recs.size() + 1) * sizeof(Record)) > budget){
+		sortChunk();
+		status = writeRun();
+		if(status != OK) break;
+	    }
+	    rec.data = chunk + chunkUsed;
+	    rec.length = batch[k].length;
+	    memcpy(rec.data, batch[k].data, rec.length);
+	    chunkUsed += rec.length;
+	    recs.push_back(rec);
+	}
+    }
+    delete scan;
+    if(status != FILEEOF) return status;
+
+    sortChunk();
+    if(runs.empty()) return OK;
+    return writeRun();
+}
+
+// recs is cut into nThreads slices of about the same size, each sorted
+// on a thread of its own.  the slices are merged when they are read
+
+void SortedFile::sortChunk()
+{
+    int		cnt = recs.size();
+    int		slices = (nThreads < cnt) ? nThreads : cnt;
+    int		i;
+
+    sliceEnd.clear();
+    if(slices < 1) slices = 1;
+    for(i = 1; i <= slices; i++)
+	sliceEnd.push_back((long) cnt * i / slices);
+    if(slices == 1){
+	sortSlice(&keys, recs.data(), recs.data() + cnt);
+	return;
+    }
+
+    thread** threads = new thread*[slices];
+    for(i = 0; i < slices; i++)
+	threads[i] = new thread(sortSlice, &keys,
+				recs.data() + (i ? sliceEnd[i-1] : 0),
+				recs.data() + sliceEnd[i]);
+    for(i = 0; i < slices; i++){
+	threads[i]->join();
+	delete threads[i];
+    }
+    delete [] threads;
+}
+
+const Status SortedFile::writeRun()
+{
+    Status	status;
+
+    runs.push_back(newRunName());
+    status = openSlices();
+    if(status == OK) status = mergeTo(runs.back(), SORTSTAGEPAGES);
+    closeSources();
+    recs.clear();
+    chunkUsed = 0;
+    return status;
+}
+
+const Status SortedFile::mergeTo(const string & name, const int stagePages)
+{
+    return loadHeapFile(name, nextSorted, this, stagePages);
+}
+
+const Status SortedFile::openSlices()
+{
+    SortSource*	src;
+
+    closeSources();
+    for(unsigned i = 0; i < sliceEnd.size(); i++){
+	src = new SortSource;
+	src->scan = NULL;
+	src->pos = (i ? sliceEnd[i-1] : 0) - 1;
+	src->end = sliceEnd[i];
+	src->done = false;
+	sources.push_back(src);
+	advance(i);
+    }
+    tree.assign(sources.size() + 1, sources.size());
+    for(int s = sources.size() - 1; s >= 0; s--) replay(s);
+    return OK;
+}
+
+const Status SortedFile::openRuns(const int first, const int cnt)
+{
+    Status	status = OK;
+    SortSource*	src;
+    int		i;
+
+    closeSources();
+    for(i = 0; i < cnt && status == OK; i++){
+	src = new SortSource;
+	src->scan = new HeapFileScan(runs[first + i], status);
+	src->done = false;
+	sources.push_back(src);
+	if(status == OK) status = src->scan->startScan(NULL, 0);
+	if(status == OK) status = advance(i);
+    }
+    if(status != OK) return status;
+    tree.assign(sources.size() + 1, sources.size());
+    for(int s = sources.size() - 1; s >= 0; s--) replay(s);
+    return OK;
+}
+
+void SortedFile::closeSources()
+{
+    for(unsigned i = 0; i < sources.size(); i++){
+	delete sources[i]->scan;
+	delete sources[i];
+    }
+    sources.clear();
+    last = -1;
+}
+
+const Status SortedFile::advance(const int s)
+{
+    Status	status;
+    SortSource*	src = sources[s];
+    RID		rid;
+
+    if(!src->scan){
+	if(++src->pos < src->end) src->cur = recs[src->pos];
+	else src->done = true;
+	return OK;
+    }
+    status = src->scan->scanNext(rid);
+    if(status == FILEEOF){
+	src->done = true;
+	return OK;
+    }
+    if(status != OK) return status;
+    return src->scan->getRecord(src->cur);
+}
+
+// ties go to the source that comes first, so the merge is stable
+
+const bool SortedFile::before(const int a, const int b) const
+{
+    int		size = sources.size();
+    int		c;
+
+    if(a == size) return true;
+    if(b == size) return false;
+    if(sources[a]->done) return false;
+    if(sources[b]->done) return true;
+    c = compareRecs(keys, sources[a]->cur, sources[b]->cur);
+    return (c != 0) ? c < 0 : a < b;
+}
+
+// the winner of every match goes on up, the loser stays at the node.
+// set up with size at every node, the tree is filled by playing every
+// source in from the last one down
+
+void SortedFile::replay(const int s)
+{
+    int		w = s;
+
+    for(int t = (s + sources.size()) / 2; t > 0; t /= 2)
+	if(before(tree[t], w)) swap(tree[t], w);
+    tree[0] = w;
+}
+
+// the source whose record was handed out last is only moved on now,
+// so that the record stays valid until this call
+
+const Status SortedFile::pull(Record & rec)
+{
+    Status	status;
+
+    if(sources.empty()) return FILEEOF;
+    if(last >= 0){
+	status = advance(last);
+	if(status != OK) return status;
+	replay(last);
+    }
+    last = tree[0];
+    if(sources[last]->done){
+	last = -1;
+	return FILEEOF;
+    }
+    rec = sources[last]->cur;
+    return OK;
+}
@@ -0,0 +1,118 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include "heapfile.h"
+
+// External merge sort of the records of a heap file.  The records are
+// read into memory as far as a budget allows, sorted there on several
+// threads at once, and written out as a sorted run, a temporary heap
+// file.  The runs are merged with a loser tree, in passes while there
+// are more than MAXSORTFANIN of them, and the last merge hands the
+// records out one at a time or writes them to a heap file of their own.
+// Input that fits in the budget is never written out.  Records that
+// compare equal stay in the order the input scan returns them.
+
+// most runs merged at once.  every run being merged keeps two buffer
+// pool pages pinned, its header page and the page it is at
+const int MAXSORTFANIN = 32;
+
+// pages a run is staged in by its HeapFileLoader
+const int SORTSTAGEPAGES = 32;
+
+// an attribute records are sorted on.  a record too short to hold it
+// comes before those that do, a FLOAT NaN after every number, and a
+// STRING ends at its first NUL, as for strncmp
+struct SortKey
+{
+  int		offset;		// byte offset of the attribute
+  int		length;		// length of the attribute
+  Datatype	type;		// datatype of the attribute
+};
+
+struct SortSource;		// see sort.cpp
+
+class SortedFile
+{
+public:
+  // sort the records of heap file fileName on keys[0], those equal on
+  // it on keys[1], and so on.  a run holds up to memPages pages worth of
+  // records and is sorted on nThreads threads.  BADSORTPARM if a key is
+  // not valid, INSUFMEM if a record does not fit in memPages pages or
+  // memPages is below 4
+  SortedFile(const string & fileName, const SortKey* keys, const int keyCnt,
+             const int memPages, const int nThreads, Status & status);
+
+  // destroys the runs
+  ~SortedFile();
+
+  // the next record in sorted order, FILEEOF after the last one.  the
+  // record stays valid until the next call
+  const Status next(Record & rec);
+
+  // write the records next has yet to return to the new heap file
+  // outName, in sorted order
+  const Status writeTo(const string & outName);
+
+  // number of runs written, those of merge passes included; 0 if the
+  // input fit in memory
+  const int getRunCnt() const;
+
+private:
+  vector<SortKey> keys;
+  int		memPages;
+  int		nThreads;
+  string	runPrefix;	// run n is named runPrefix + n
+  int		runCnt;		// runs written so far, including merged ones
+  vector<string> runs;		// runs not yet merged, in input order
+
+  char*		chunk;		// memPages pages for the records of a run
+  int		chunkUsed;	// bytes of chunk in use
+  vector<Record> recs;		// the records in chunk
+  vector<int>	sliceEnd;	// end in recs of every slice sorted apart
+
+  // the sequences being merged and the loser tree over them.  tree[0]
+  // is the source with the smallest record and tree[t], for t > 0, the
+  // loser of the match at node t; source i plays from leaf i + size
+  vector<SortSource*> sources;
+  vector<int>	tree;
+  int		last;		// source next returned a record of, or -1
+
+  // read the input into runs, leaving the last one in memory if it is
+  // the only one
+  const Status readInput(const string & fileName);
+
+  // sort recs on nThreads threads, a slice each
+  void sortChunk();
+
+  // merge the sorted slices of recs into a new run, emptying chunk
+  const Status writeRun();
+
+  // merge the sources into a new heap file called name
+  const Status mergeTo(const string & name, const int stagePages);
+
+  // name for the next run
+  const string newRunName();
+
+  // make the slices of recs, or runs[first] .. runs[first+cnt-1], the
+  // sources and set up the tree over them
+  const Status openSlices();
+  const Status openRuns(const int first, const int cnt);
+
+  // close the sources
+  void closeSources();
+
+  // move source s to its next record
+  const Status advance(const int s);
+
+  // true if source a's record comes before source b's.  size stands
+  // for a source before every other, one that is done for one after
+  const bool before(const int a, const int b) const;
+
+  // play source s up the tree after its record changed
+  void replay(const int s);
+
+  // the smallest record of the sources, FILEEOF if all are done
+  const Status pull(Record & rec);
+};
+
+#endif
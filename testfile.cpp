@@ -1,6 +1,19 @@
 #include <stdio.h>
 #include "heapfile.h"
+#include "import.h"
+#include "filter.h"
+#include "btree.h"
+#include "hashindex.h"
+#include "bitmap.h"
+#include "sort.h"
+#include "join.h"
+#include "aggregate.h"
 #include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <math.h>
+#include <algorithm>
+#include <map>
 #include "stdlib.h"
 
 extern Status createHeapFile(string FileName);
@@ -10,6 +23,370 @@ extern Status destroyHeapFile(string FileName);
 DB db;
 BufMgr* bufMgr;
 
+// reference LIKE matcher for the first n bytes of s
+static bool likeRef(const char* s, const int n, const char* p)
+{
+    if (*p == '\0') return n == 0;
+    if (*p == '%') {
+        for (int i = 0; i <= n; i++)
+            if (likeRef(s + i, n - i, p + 1)) return true;
+        return false;
+    }
+    return n > 0 && (*p == '_' || *p == *s) && likeRef(s + 1, n - 1, p + 1);
+}
+
+// what parallelScan hands to collectRecords, kept per worker
+typedef vector<vector<pair<RID, string> > > FoundRecs;
+
+static void collectRecords(void* arg, const int worker, const RID* rids,
+                           const Record* recs, const int cnt)
+{
+    FoundRecs* found = (FoundRecs*) arg;
+    for (int k = 0; k < cnt; k++)
+        (*found)[worker].push_back(make_pair(rids[k],
+                                   string((char*)recs[k].data, recs[k].length)));
+}
+
+// UpdateFn adding 1 to the f field of a record in place
+static bool bumpFloat(void* arg, const Record & rec, Record & newRec)
+{
+    float f;
+    memcpy(&f, (char*) rec.data + sizeof(int), sizeof(float));
+    f += 1;
+    memcpy((char*) rec.data + sizeof(int), &f, sizeof(float));
+    return false;
+}
+
+static bool ridLess(const pair<RID, string> & a, const pair<RID, string> & b)
+{
+    return a.first.pageNo < b.first.pageNo ||
+           (a.first.pageNo == b.first.pageNo && a.first.slotNo < b.first.slotNo);
+}
+
+static bool ridBefore(const RID & a, const RID & b)
+{
+    return a.pageNo < b.pageNo || (a.pageNo == b.pageNo && a.slotNo < b.slotNo);
+}
+
+// check that index finds the same records of relation rel as a scan
+// with cond does
+static bool indexAgrees(BTreeIndex* index, const string & rel,
+                        const ScanCond & cond)
+{
+    vector<RID> byIndex, byScan;
+    RID rid;
+    Status status;
+
+    status = index->startScan(cond.filter, cond.op, cond.valCnt);
+    while (status == OK && (status = index->scanNext(rid)) == OK)
+        byIndex.push_back(rid);
+    index->endScan();
+    if (status != NOMORERECS) return false;
+    HeapFileScan* scan = new HeapFileScan(rel, status);
+    scan->startScan(&cond, 1);
+    while (scan->scanNext(rid) == OK) byScan.push_back(rid);
+    delete scan;
+
+    sort(byIndex.begin(), byIndex.end(), ridBefore);
+    sort(byScan.begin(), byScan.end(), ridBefore);
+    if (byIndex.size() != byScan.size()) return false;
+    for (unsigned k = 0; k < byIndex.size(); k++)
+        if (byIndex[k].pageNo != byScan[k].pageNo ||
+            byIndex[k].slotNo != byScan[k].slotNo) return false;
+    return true;
+}
+
+// check that index finds the same records of relation rel as a scan
+// for attribute (offset, length, type) EQ key does
+static bool hashAgrees(HashIndex* index, const string & rel, const int offset,
+                       const int length, const Datatype type, const char* key)
+{
+    vector<RID> byIndex, byScan;
+    RID rid;
+    Status status;
+
+    status = index->startScan(key);
+    while (status == OK && (status = index->scanNext(rid)) == OK)
+        byIndex.push_back(rid);
+    index->endScan();
+    if (status != NOMORERECS) return false;
+    HeapFileScan* scan = new HeapFileScan(rel, status);
+    scan->startScan(offset, length, type, key, EQ);
+    while (scan->scanNext(rid) == OK) byScan.push_back(rid);
+    delete scan;
+
+    sort(byIndex.begin(), byIndex.end(), ridBefore);
+    sort(byScan.begin(), byScan.end(), ridBefore);
+    if (byIndex.size() != byScan.size()) return false;
+    for (unsigned k = 0; k < byIndex.size(); k++)
+        if (byIndex[k].pageNo != byScan[k].pageNo ||
+            byIndex[k].slotNo != byScan[k].slotNo) return false;
+    return true;
+}
+
+// check that bitmap b holds the records of relation rel that a scan
+// with the condCnt conditions conds finds
+static bool bitmapAgrees(const Bitmap & b, const string & rel,
+                         const ScanCond* conds, const int condCnt)
+{
+    vector<RID> byIndex, byScan;
+    RID rid, rids[100];
+    unsigned from = 0;
+    int n;
+    Status status;
+
+    while ((n = b.nextRids(from, rids, 100)) > 0)
+        byIndex.insert(byIndex.end(), rids, rids + n);
+    HeapFileScan* scan = new HeapFileScan(rel, status);
+    scan->startScan(conds, condCnt);
+    while (scan->scanNext(rid) == OK) byScan.push_back(rid);
+    delete scan;
+
+    sort(byScan.begin(), byScan.end(), ridBefore);
+    if (byIndex.size() != byScan.size() || byIndex.size() != b.count())
+        return false;
+    for (unsigned k = 0; k < byIndex.size(); k++)
+        if (byIndex[k].pageNo != byScan[k].pageNo ||
+            byIndex[k].slotNo != byScan[k].slotNo) return false;
+    return true;
+}
+
+// scan rel for conds with its zone maps and again with them dropped,
+// and check both return the same records.  the zone maps of attrs are
+// declared afresh afterwards.  accesses is set to the buffer pool
+// accesses of the first scan
+static bool zonesAgree(const string & rel, const ScanCond* conds,
+                       const int condCnt, const ZoneAttr* attrs,
+                       const int attrCnt, int & accesses)
+{
+    vector<RID> zoned, plain;
+    RID rid;
+    Status status;
+
+    HeapFileScan* scan = new HeapFileScan(rel, status);
+    bufMgr->clearBufStats();
+    scan->startScan(conds, condCnt);
+    while (scan->scanNext(rid) == OK) zoned.push_back(rid);
+    accesses = bufMgr->getBufStats().accesses;
+    status = scan->declareZones(NULL, 0);
+    delete scan;
+    if (status != OK) return false;
+
+    scan = new HeapFileScan(rel, status);
+    scan->startScan(conds, condCnt);
+    while (scan->scanNext(rid) == OK) plain.push_back(rid);
+    status = scan->declareZones(attrs, attrCnt);
+    delete scan;
+    if (status != OK || zoned.size() != plain.size()) return false;
+    for (unsigned k = 0; k < zoned.size(); k++)
+        if (zoned[k].pageNo != plain[k].pageNo ||
+            zoned[k].slotNo != plain[k].slotNo) return false;
+    return true;
+}
+
+// the order the sort test expects: on the INTEGER at 0, then the
+// STRING of 64 bytes at 8, a record too short for a key first
+struct ByIntString
+{
+    bool operator()(const string & a, const string & b) const
+    {
+        int ia, ib;
+        if ((a.size() >= 4) != (b.size() >= 4)) return a.size() < 4;
+        if (a.size() >= 4) {
+            memcpy(&ia, a.data(), sizeof(int));
+            memcpy(&ib, b.data(), sizeof(int));
+            if (ia != ib) return ia < ib;
+        }
+        if ((a.size() >= 72) != (b.size() >= 72)) return a.size() < 72;
+        if (a.size() < 72) return false;
+        return strncmp(a.data() + 8, b.data() + 8, 64) < 0;
+    }
+};
+
+// on the FLOAT at 4, NaNs last
+struct ByFloat
+{
+    bool operator()(const string & a, const string & b) const
+    {
+        float fa, fb;
+        memcpy(&fa, a.data() + 4, sizeof(float));
+        memcpy(&fb, b.data() + 4, sizeof(float));
+        if (fa != fa || fb != fb) return fb != fb && fa == fa;
+        return fa < fb;
+    }
+};
+
+// check that the records sf hands out are expected, in that order
+static bool sortAgrees(SortedFile* sf, const vector<string> & expected)
+{
+    Record rec;
+    unsigned k = 0;
+
+    while (sf->next(rec) == OK) {
+        if (k == expected.size() ||
+            string((char*) rec.data, rec.length) != expected[k]) return false;
+        k++;
+    }
+    return k == expected.size();
+}
+
+// the pairs of build and probe records, one after the other, whose
+// attributes at offset are equal, by nested loops and sorted
+static void joinPairs(const vector<string> & build,
+                      const vector<string> & probe, const int offset,
+                      const int length, const Datatype type,
+                      vector<string> & pairs)
+{
+    float fa, fb;
+
+    pairs.clear();
+    for (unsigned p = 0; p < probe.size(); p++)
+        for (unsigned b = 0; b < build.size(); b++) {
+            const string & x = build[b];
+            const string & y = probe[p];
+            if ((int) x.size() < offset + length ||
+                (int) y.size() < offset + length) continue;
+            if (type == STRING) {
+                if (strncmp(x.data() + offset, y.data() + offset, length))
+                    continue;
+            }
+            else if (type == INTEGER) {
+                if (memcmp(x.data() + offset, y.data() + offset, length))
+                    continue;
+            }
+            else {
+                memcpy(&fa, x.data() + offset, sizeof(float));
+                memcpy(&fb, y.data() + offset, sizeof(float));
+                if (!(fa == fb)) continue;
+            }
+            pairs.push_back(x + y);
+        }
+    sort(pairs.begin(), pairs.end());
+}
+
+// check that hj returns the pairs expected, in any order
+static bool joinAgrees(HashJoin* hj, const vector<string> & expected)
+{
+    vector<string> got;
+    Record b, p;
+
+    while (hj->next(b, p) == OK)
+        got.push_back(string((char*) b.data, b.length) +
+                      string((char*) p.data, p.length));
+    sort(got.begin(), got.end());
+    return got == expected;
+}
+
+// running aggregates of a group for the aggregation test
+struct RefGroup
+{
+    long long cnt, isum, fcnt;
+    double fsum, fmin, fmax;
+};
+
+// what the aggregation test expects, as next returns it: COUNT, SUM of
+// the INTEGER at 0 and MIN, MAX and AVG of the FLOAT at 4 of every
+// record whose INTEGER is below bound, grouped on nothing (keys 0), on
+// the INTEGER (1) or on the STRING at 8 and the INTEGER (2), sorted
+static void aggRef(const vector<string> & input, const int keys,
+                   const int bound, vector<string> & expected)
+{
+    map<string, RefGroup> groups;
+    int ival;
+    float fval;
+    double v[5];
+
+    for (unsigned k = 0; k < input.size(); k++) {
+        const string & r = input[k];
+        if (r.size() < 4 || (keys == 2 && r.size() < 72)) continue;
+        memcpy(&ival, r.data(), sizeof(int));
+        if (ival >= bound) continue;
+        string key = (keys == 2) ? string(r.data() + 8, 64) : string();
+        if (keys) key += r.substr(0, 4);
+        if (groups.find(key) == groups.end()) {
+            RefGroup g = { 0, 0, 0, 0, 0, 0 };
+            groups[key] = g;
+        }
+        RefGroup & g = groups[key];
+        g.cnt++;
+        g.isum += ival;
+        if (r.size() < 8) continue;
+        memcpy(&fval, r.data() + 4, sizeof(float));
+        if (fval != fval) continue;
+        if (g.fcnt == 0 || fval < g.fmin) g.fmin = fval;
+        if (g.fcnt == 0 || fval > g.fmax) g.fmax = fval;
+        g.fsum += fval;
+        g.fcnt++;
+    }
+    expected.clear();
+    for (map<string, RefGroup>::iterator it = groups.begin();
+         it != groups.end(); ++it) {
+        const RefGroup & g = it->second;
+        v[0] = g.cnt;
+        v[1] = g.isum;
+        v[2] = g.fcnt ? g.fmin : NAN;
+        v[3] = g.fcnt ? g.fmax : NAN;
+        v[4] = g.fcnt ? g.fsum / g.fcnt : NAN;
+        expected.push_back(it->first + string((char*) v, sizeof(v)));
+    }
+    sort(expected.begin(), expected.end());
+}
+
+// check that ha returns the groups expected, in any order
+static bool aggAgrees(HashAggregate* ha, const vector<string> & expected)
+{
+    vector<string> got;
+    Record rec;
+
+    while (ha->next(rec) == OK)
+        got.push_back(string((char*) rec.data, rec.length));
+    sort(got.begin(), got.end());
+    return got == expected;
+}
+
+// scan file name once with scanNext and once with scanBatch, max
+// records at a time, and check both return the same records
+static bool sameBatchScan(const string & name, const int max,
+                          const char* filter, const Operator op)
+{
+    Status status;
+    HeapFileScan* scan;
+    RID rid;
+    Record rec;
+    vector<RID> rids;
+    vector<string> recs;
+    RID* batchRids = new RID[max];
+    Record* batchRecs = new Record[max];
+    int cnt, n = 0;
+    bool same = true;
+
+    scan = new HeapFileScan(name, status);
+    scan->startScan(0, sizeof(int), INTEGER, filter, op);
+    while ((status = scan->scanNext(rid)) == OK &&
+           (status = scan->getRecord(rec)) == OK)
+    {
+        rids.push_back(rid);
+        recs.push_back(string((char*)rec.data, rec.length));
+    }
+    delete scan;
+
+    scan = new HeapFileScan(name, status);
+    scan->startScan(0, sizeof(int), INTEGER, filter, op);
+    while ((status = scan->scanBatch(max, batchRids, batchRecs, cnt)) == OK)
+    {
+        if (cnt < 1 || cnt > max) same = false;
+        for (int k = 0; k < cnt && same; k++, n++)
+            same = n < (int) rids.size() &&
+                   batchRids[k].pageNo == rids[n].pageNo &&
+                   batchRids[k].slotNo == rids[n].slotNo &&
+                   recs[n] == string((char*)batchRecs[k].data, batchRecs[k].length);
+    }
+    delete scan;
+    delete [] batchRids;
+    delete [] batchRecs;
+    return same && status == FILEEOF && n == (int) rids.size();
+}
+
 int main(int argc, char **argv)
 {
     cout << "Testing the relation interface" << endl << endl;
@@ -678,26 +1055,52 @@ cout<<"--------------------------------------------ISOLATION--------------------
         error.print(status);
     }
     
-    // add insert for bigger than pagesized record
+    // add insert for bigger than pagesized record.  it goes to
+    // overflow pages and must come back intact
     iScan = new InsertFileScan("dummy.04", status);
     if (status != OK) error.print(status);
     char bigdata[8192];
+    for (i = 0; i < (int) sizeof(bigdata); i++) bigdata[i] = 'a' + i % 23;
     sprintf(bigdata, "big record");
     dbrec1.data = (void *) &bigdata;
     dbrec1.length = 8192;
     status = iScan->insertRecord(dbrec1, rec2Rid);
-    if ((status == INVALIDRECLEN) || (status == NOSPACE))
-    {
-        cout << endl << "passed large record insert test" << endl;
-    }
-    else
+    if (status != OK)
     {
         cout << "got err0r status return from insert record " << endl;
         error.print(status);
-        cout << "expected INVALIDRECLEN or NOSPACE" << endl;
     }
+    dbrec1.length = -1;
+    if (iScan->insertRecord(dbrec1, newRid) != INVALIDRECLEN)
+        cout << "Err0r.   insert of negative length record should fail" << endl;
     delete iScan;
 
+    file1 = new HeapFile("dummy.04", status);
+    if (status != OK) error.print(status);
+    status = file1->getRecord(rec2Rid, dbrec2);
+    if (status != OK) error.print(status);
+    if (dbrec2.length != 8192 || memcmp(dbrec2.data, bigdata, 8192) != 0)
+        cout << "err0r reading large record back" << endl;
+    char bigchunk[1000];
+    int got;
+    for (i = 0; i < 8192; i += got)
+    {
+        status = file1->readRecord(rec2Rid, i, bigchunk, sizeof(bigchunk), got);
+        if (status != OK || got == 0) { error.print(status); break; }
+        if (memcmp(bigchunk, bigdata + i, got) != 0)
+            cout << "err0r reading large record at offset " << i << endl;
+    }
+    // shrink it back onto the data page
+    dbrec1.data = (void *) &bigdata;
+    dbrec1.length = 100;
+    status = file1->updateRecord(rec2Rid, dbrec1);
+    if (status != OK) error.print(status);
+    status = file1->getRecord(rec2Rid, dbrec2);
+    if (status != OK || dbrec2.length != 100 || memcmp(dbrec2.data, bigdata, 100) != 0)
+        cout << "err0r reading shrunk large record back" << endl;
+    delete file1;
+    cout << endl << "passed large record insert test" << endl;
+
     delete scan1;
 
     // MORE ERROR HANDLING TESTS HERE
@@ -707,6 +1110,2323 @@ cout<<"--------------------------------------------ISOLATION--------------------
         cout << endl << "got err0r status return from destroy file" << endl;
         error.print(status);
     }
+
+    // deletes leave holes in a page that are only squeezed out when an
+    // insert needs more room than is left at the end of the page.  the
+    // records that stay must keep their bytes and the free space must
+    // add up all along
+    {
+        bool agree = true;
+        Page page;
+        RID rids[MAXSLOTS];
+        char buf[PAGESIZE];
+        int cnt, expectFree, bigLen;
+
+        page.init(1);
+        for (cnt = 0; ; cnt++) {
+            memset(buf, 'a' + cnt % 26, 20 + cnt % 40);
+            dbrec1.data = buf;
+            dbrec1.length = 20 + cnt % 40;
+            if (page.insertRecord(dbrec1, rids[cnt]) != OK) break;
+        }
+        // every other record but the last, so the slot array stays
+        expectFree = page.getFreeSpace();
+        for (i = 0; i < cnt - 1; i += 2) {
+            if (page.deleteRecord(rids[i]) != OK) agree = false;
+            expectFree += Page::recSpace(20 + i % 40);
+        }
+        if (page.getFreeSpace() != expectFree) {
+            cout << "err0r. " << page.getFreeSpace() << " bytes free after "
+                 << "deletes, not " << expectFree << endl;
+            agree = false;
+        }
+
+        // far larger than any hole, and reusing a slot.  the free space
+        // check allows for a new slot all the same
+        bigLen = expectFree - sizeof(slot_t);
+        memset(buf, 'Z', bigLen);
+        dbrec1.data = buf;
+        dbrec1.length = bigLen;
+        if (page.insertRecord(dbrec1, newRid) != OK ||
+            page.getFreeSpace() != expectFree - bigLen) {
+            cout << "err0r. record of " << bigLen << " bytes not inserted "
+                 << "into " << expectFree << " free bytes" << endl;
+            agree = false;
+        }
+        for (i = 1; i < cnt && agree; i += (i < cnt - 2) ? 2 : 1) {
+            if (page.getRecord(rids[i], dbrec2) != OK ||
+                dbrec2.length != 20 + i % 40) agree = false;
+            else
+                for (j = 0; j < dbrec2.length; j++)
+                    if (((char*) dbrec2.data)[j] != 'a' + i % 26) agree = false;
+            if (!agree) cout << "err0r. record " << i << " changed" << endl;
+        }
+        if (agree && (page.getRecord(newRid, dbrec2) != OK ||
+                      dbrec2.length != bigLen ||
+                      memcmp(dbrec2.data, buf, bigLen) != 0)) {
+            cout << "err0r. compacted record reads back wrong" << endl;
+            agree = false;
+        }
+        if (agree) cout << "passed lazy compaction test" << endl;
+    }
+
+    // slots freed by deletes are handed out again, lowest first, and
+    // walking the records of a page or scanning a file passes over them
+    {
+        bool agree = true;
+        Page page;
+        RID rids[40], rid;
+        const int freed[4] = { 3, 17, 18, 30 };
+        vector<int> slots;
+
+        page.init(1);
+        for (i = 0; i < 40; i++) {
+            dbrec1.data = &i;
+            dbrec1.length = sizeof(int);
+            page.insertRecord(dbrec1, rids[i]);
+        }
+        for (j = 0; j < 4; j++) page.deleteRecord(rids[freed[j]]);
+        for (status = page.firstRecord(rid); status == OK;
+             status = page.nextRecord(rid, rid))
+            slots.push_back(rid.slotNo);
+        for (i = 0, j = 0; i < 40 && agree; i++) {
+            if (j < 4 && i == freed[j]) j++;
+            else if (slots.size() <= (unsigned) (i - j) || slots[i - j] != i)
+                agree = false;
+        }
+        if (!agree || slots.size() != 36) {
+            cout << "err0r. page walk returned " << slots.size()
+                 << " records, freed slots among them" << endl;
+            agree = false;
+        }
+        for (j = 0; j < 5 && agree; j++) {
+            dbrec1.data = &j;
+            dbrec1.length = sizeof(int);
+            page.insertRecord(dbrec1, rid);
+            if (rid.slotNo != ((j < 4) ? freed[j] : 40)) {
+                cout << "err0r. insert " << j << " took slot " << rid.slotNo
+                     << endl;
+                agree = false;
+            }
+        }
+
+        // a file with two of every three records deleted
+        vector<RID> all, gone;
+        createHeapFile("dummy.26");
+        iScan = new InsertFileScan("dummy.26", status);
+        for (i = 0; i < 3000; i++) {
+            dbrec1.data = &i;
+            dbrec1.length = sizeof(int);
+            iScan->insertRecord(dbrec1, newRid);
+            all.push_back(newRid);
+            if (i % 3 != 0) gone.push_back(newRid);
+        }
+        delete iScan;
+        file1 = new HeapFile("dummy.26", status);
+        status = file1->deleteRecords(&gone[0], gone.size(), deleted);
+        if (status != OK) error.print(status);
+        delete file1;
+        scan1 = new HeapFileScan("dummy.26", status);
+        scan1->startScan(0, 0, INTEGER, NULL, EQ);
+        for (i = 0; scan1->scanNext(newRid) == OK; i += 3) {
+            scan1->getRecord(dbrec2);
+            memcpy(&j, dbrec2.data, sizeof(int));
+            if (j != i || newRid.pageNo != all[i].pageNo ||
+                newRid.slotNo != all[i].slotNo) {
+                cout << "err0r. scan returned record " << j << " in place of "
+                     << i << endl;
+                agree = false;
+                break;
+            }
+        }
+        if (agree && i != 3000) {
+            cout << "err0r. scan stopped at record " << i << endl;
+            agree = false;
+        }
+        delete scan1;
+        destroyHeapFile("dummy.26");
+        if (agree) cout << "passed free slot reuse test" << endl;
+    }
+
+    // grow records with updateRecord until they no longer fit on
+    // their page.  their RIDs must keep working
+    status = createHeapFile("dummy.05");
+    if (status != OK) 
+    {
+	cerr << "got err0r status return from  createHeapFile" << endl;
+    	error.print(status);
+    }
+    ridArray = new RID[num];
+    iScan = new InsertFileScan("dummy.05", status);
+    if (status != OK) error.print(status);
+    cout << endl << "inserting " << num << " short records into dummy.05" << endl;
+    for(i = 0; i < num; i++) {
+        sprintf(rec1.s, "%05d", i);
+        rec1.i = i;
+        rec1.f = i;
+        dbrec1.data = &rec1;
+        dbrec1.length = sizeof(rec1.i) + sizeof(rec1.f) + 6;
+        status = iScan->insertRecord(dbrec1, ridArray[i]);
+        if (status != OK) error.print(status);
+    }
+    delete iScan;
+
+    cout << "growing every third record of dummy.05 with updateRecord" << endl;
+    file1 = new HeapFile("dummy.05", status);
+    if (status != OK) error.print(status);
+    for(i = 0; i < num; i += 3) {
+        sprintf(rec1.s, "This is updated record %05d", i);
+        rec1.i = i;
+        rec1.f = i;
+        dbrec1.data = &rec1;
+        dbrec1.length = sizeof(RECORD);
+        status = file1->updateRecord(ridArray[i], dbrec1);
+        if (status != OK) error.print(status);
+    }
+    for(i = 0; i < num; i++) {
+        status = file1->getRecord(ridArray[i], dbrec2);
+        if (status != OK) error.print(status);
+        if (i % 3 == 0) sprintf(rec1.s, "This is updated record %05d", i);
+        else sprintf(rec1.s, "%05d", i);
+        rec1.i = i;
+        rec1.f = i;
+        if (memcmp(&rec1, dbrec2.data, dbrec2.length) != 0 ||
+            dbrec2.length != (int) (8 + strlen(rec1.s) + ((i % 3) ? 1 : 64 - strlen(rec1.s))))
+            cout << "err0r reading updated record " << i << " back" << endl;
+    }
+    if (file1->getRecCnt() != num)
+        cout << "Err0r.   updates changed the record count to "
+             << file1->getRecCnt() << endl;
+    delete file1;
+
+    // batched scans see the moved records the same way scanNext does
+    j = num / 2;
+    if (!sameBatchScan("dummy.05", 1, NULL, EQ) ||
+        !sameBatchScan("dummy.05", 7, NULL, EQ) ||
+        !sameBatchScan("dummy.05", 1000, NULL, EQ) ||
+        !sameBatchScan("dummy.05", 50, (char*)&j, LT) ||
+        !sameBatchScan("dummy.05", 50, (char*)&j, EQ))
+        cout << "err0r. scanBatch and scanNext disagree on dummy.05" << endl;
+    else cout << "passed batched scan test" << endl;
+
+    // update every record through a scan, each must be seen once
+    cout << "scan dummy.05 shrinking every record back" << endl;
+    scan1 = new HeapFileScan("dummy.05", status);
+    if (status != OK) error.print(status);
+    scan1->startScan(0, 0, STRING, NULL, EQ);
+    i = 0;
+    while ((status = scan1->scanNext(rec2Rid)) == OK)
+    {
+        status = scan1->getRecord(dbrec2);
+        if (status != OK) break;
+        memcpy(&rec1, dbrec2.data, dbrec2.length);
+        if (rec2Rid.pageNo != ridArray[rec1.i].pageNo ||
+            rec2Rid.slotNo != ridArray[rec1.i].slotNo)
+            cout << "err0r. scan returned wrong rid for record " << rec1.i << endl;
+        rec1.f = -rec1.f;
+        dbrec1.data = &rec1;
+        dbrec1.length = sizeof(rec1.i) + sizeof(rec1.f);
+        status = scan1->updateRecord(dbrec1);
+        if (status != OK) error.print(status);
+        i++;
+    }
+    if (status != FILEEOF) error.print(status);
+    cout << "scan saw " << i << " records" << endl;
+    if (i != num)
+        cout << "Err0r.   scan should have updated " << num << " records!" << endl;
+    delete scan1;
+
+    file1 = new HeapFile("dummy.05", status);
+    if (status != OK) error.print(status);
+    for(i = 0; i < num; i++) {
+        status = file1->getRecord(ridArray[i], dbrec2);
+        if (status != OK) error.print(status);
+        memcpy(&rec1, dbrec2.data, dbrec2.length);
+        if (dbrec2.length != 8 || rec1.i != i || rec1.f != -i)
+            cout << "err0r reading shrunk record " << i << " back" << endl;
+    }
+    delete file1;
+    cout << "passed record update test" << endl;
+    delete [] ridArray;
+
+    if ((status = destroyHeapFile("dummy.05")) != OK) {
+        cout << endl << "got err0r status return from destroy file" << endl;
+        error.print(status);
+    }
+    // load a file with the batch insert interface, mixing in a few
+    // records that need overflow pages
+    status = createHeapFile("dummy.06");
+    if (status != OK) 
+    {
+	cerr << "got err0r status return from  createHeapFile" << endl;
+    	error.print(status);
+    }
+    cout << endl << "batch insert " << num << " variable-size records into dummy.06" << endl;
+    ridArray = new RID[num];
+    Record* recArray = new Record[num];
+    char* recData = new char[num * 100 + 3 * 3000];
+    char* recPtr = recData;
+    for(i = 0; i < num; i++) {
+        recArray[i].data = recPtr;
+        recArray[i].length = (i % 5000 == 1) ? 3000 : 8 + i % 90;
+        memset(recPtr, 'a' + i % 26, recArray[i].length);
+        memcpy(recPtr, &i, sizeof(int));
+        recPtr += recArray[i].length;
+    }
+    iScan = new InsertFileScan("dummy.06", status);
+    if (status != OK) error.print(status);
+    // bad arguments are turned down before anything is inserted
+    if (iScan->insertRecords(recArray, -1, ridArray) != INVALIDRECLEN ||
+        iScan->insertRecords(NULL, 10, ridArray) != BADRECPTR ||
+        iScan->insertRecords(recArray, 10, NULL) != BADRECPTR)
+        cout << "err0r. insertRecords took bad arguments" << endl;
+    for(i = 0; i < num; i += 1000) {
+        status = iScan->insertRecords(recArray + i, (num - i < 1000) ? num - i : 1000,
+                                      ridArray + i);
+        if (status != OK) error.print(status);
+    }
+    delete iScan;
+
+    file1 = new HeapFile("dummy.06", status);
+    if (status != OK) error.print(status);
+    for(i = 0; i < num; i++) {
+        status = file1->getRecord(ridArray[i], dbrec2);
+        if (status != OK) error.print(status);
+        if (dbrec2.length != recArray[i].length ||
+            memcmp(dbrec2.data, recArray[i].data, dbrec2.length) != 0)
+            cout << "err0r reading batch inserted record " << i << " back" << endl;
+    }
+    if (file1->getRecCnt() != num)
+        cout << "Err0r.   record count is " << file1->getRecCnt()
+             << " after batch insert" << endl;
+    delete file1;
+
+    scan1 = new HeapFileScan("dummy.06", status);
+    if (status != OK) error.print(status);
+    scan1->startScan(0, 0, STRING, NULL, EQ);
+    i = 0;
+    while ((status = scan1->scanNext(rec2Rid)) == OK)
+    {
+        status = scan1->getRecord(dbrec2);
+        if (status != OK) break;
+        memcpy(&j, dbrec2.data, sizeof(int));
+        if (j != i) cout << "err0r. scan returned record " << j << " in place of " << i << endl;
+        i++;
+    }
+    if (status != FILEEOF) error.print(status);
+    delete scan1;
+    if (i != num)
+        cout << "Err0r.   scan should have returned " << num << " records!" << endl;
+    else cout << "passed batch insert test" << endl;
+    delete [] recData;
+    delete [] recArray;
+    delete [] ridArray;
+
+    if ((status = destroyHeapFile("dummy.06")) != OK) {
+        cout << endl << "got err0r status return from destroy file" << endl;
+        error.print(status);
+    }
+
+    // bulk load, staging only a few pages at a time so that several
+    // chunks are written and the last one is only partly used
+    status = createHeapFile("dummy.07");
+    if (status != OK) 
+    {
+	cerr << "got err0r status return from  createHeapFile" << endl;
+    	error.print(status);
+    }
+    cout << endl << "bulk load " << num << " variable-size records into dummy.07" << endl;
+    ridArray = new RID[num];
+    bufMgr->clearBufStats();
+    {
+        HeapFileLoader loader("dummy.07", status, 16);
+        if (status != OK) error.print(status);
+        char big[3000];
+        for(i = 0; i < num; i++) {
+            dbrec1.data = big;
+            dbrec1.length = (i % 5000 == 1) ? 3000 : 8 + i % 90;
+            memset(big, 'a' + i % 26, dbrec1.length);
+            memcpy(big, &i, sizeof(int));
+            status = loader.insertRecord(dbrec1, ridArray[i]);
+            if (status != OK) error.print(status);
+        }
+        status = loader.finish();
+        if (status != OK) error.print(status);
+    }
+    if (bufMgr->getBufStats().accesses != 0)
+        cout << "err0r. bulk load went through the buffer pool" << endl;
+
+    scan1 = new HeapFileScan("dummy.07", status);
+    if (status != OK) error.print(status);
+    scan1->startScan(0, 0, STRING, NULL, EQ);
+    i = 0;
+    while ((status = scan1->scanNext(rec2Rid)) == OK)
+    {
+        status = scan1->getRecord(dbrec2);
+        if (status != OK) break;
+        memcpy(&j, dbrec2.data, sizeof(int));
+        if (j != i || rec2Rid.pageNo != ridArray[i].pageNo ||
+            rec2Rid.slotNo != ridArray[i].slotNo ||
+            dbrec2.length != ((i % 5000 == 1) ? 3000 : 8 + i % 90) ||
+            ((char*)dbrec2.data)[dbrec2.length - 1] != 'a' + i % 26)
+            cout << "err0r. scan returned wrong record for " << i << endl;
+        i++;
+    }
+    if (status != FILEEOF) error.print(status);
+    if (scan1->getRecCnt() != num)
+        cout << "Err0r.   record count is " << scan1->getRecCnt()
+             << " after bulk load" << endl;
+    delete scan1;
+    j = 5001;
+    if (!sameBatchScan("dummy.07", 100, NULL, EQ) ||
+        !sameBatchScan("dummy.07", 100, (char*)&j, LTE))
+        cout << "err0r. scanBatch and scanNext disagree on dummy.07" << endl;
+    delete [] ridArray;
+
+    // the loaded file takes ordinary inserts afterwards
+    iScan = new InsertFileScan("dummy.07", status);
+    if (status != OK) error.print(status);
+    dbrec1.data = &rec1;
+    dbrec1.length = sizeof(RECORD);
+    for(j = 0; j < 100 && status == OK; j++)
+        status = iScan->insertRecord(dbrec1, newRid);
+    if (status != OK) error.print(status);
+    if (iScan->getRecCnt() != num + 100)
+        cout << "Err0r.   record count is " << iScan->getRecCnt() << endl;
+    delete iScan;
+    if (i != num)
+        cout << "Err0r.   scan should have returned " << num << " records!" << endl;
+    else cout << "passed bulk load test" << endl;
+
+    if ((status = destroyHeapFile("dummy.07")) != OK) {
+        cout << endl << "got err0r status return from destroy file" << endl;
+        error.print(status);
+    }
+
+    // integer filters must be exact over the whole int range, where
+    // a difference of two attributes can overflow or lose bits as a float
+    {
+        const int ints[] = { INT_MIN, INT_MIN + 1, -16777217, -1, 0, 1,
+                             16777216, 16777217, 16777218, INT_MAX - 1, INT_MAX };
+        const int nInts = sizeof(ints) / sizeof(int);
+        bool exact = true;
+
+        createHeapFile("dummy.09");
+        iScan = new InsertFileScan("dummy.09", status);
+        if (status != OK) error.print(status);
+        for (i = 0; i < nInts; i++) {
+            rec1.i = ints[i];
+            rec1.f = ints[i];
+            dbrec1.data = &rec1;
+            dbrec1.length = sizeof(rec1.i) + sizeof(rec1.f);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+        }
+        delete iScan;
+
+        for (int op = LT; op <= NE; op++)
+            for (int t = INTEGER; t <= FLOAT; t++)
+                for (j = 0; j < nInts; j++) {
+                    float f = ints[j];
+                    int expect = 0, got = 0;
+                    for (i = 0; i < nInts; i++) {
+                        int c = (t == INTEGER) ? (ints[i] > ints[j]) - (ints[i] < ints[j])
+                                : ((float)ints[i] > f) - ((float)ints[i] < f);
+                        expect += (op == LT && c < 0) || (op == LTE && c <= 0) ||
+                                  (op == EQ && c == 0) || (op == GTE && c >= 0) ||
+                                  (op == GT && c > 0) || (op == NE && c != 0);
+                    }
+                    scan1 = new HeapFileScan("dummy.09", status);
+                    status = scan1->startScan(t == INTEGER ? 0 : sizeof(int), 4, (Datatype)t,
+                                              t == INTEGER ? (char*)&ints[j] : (char*)&f,
+                                              (Operator)op);
+                    if (status != OK) error.print(status);
+                    while (scan1->scanNext(rec2Rid) == OK) got++;
+                    delete scan1;
+                    if (got != expect) {
+                        cout << "err0r. " << (t == INTEGER ? "integer" : "float")
+                             << " filter op " << op << " against " << ints[j]
+                             << " matched " << got << " records, not " << expect << endl;
+                        exact = false;
+                    }
+                }
+        if (exact) cout << "passed large integer filter test" << endl;
+        destroyHeapFile("dummy.09");
+    }
+
+    // every filter kernel level must agree with compareOp, including
+    // for NaN and for runs that do not fill a whole vector
+    {
+        union { int i[MAXSLOTS]; float f[MAXSLOTS]; } vals;
+        unsigned long long sel[SLOTMAPWORDS];
+        bool agree = true;
+
+        createHeapFile("dummy.10");
+        iScan = new InsertFileScan("dummy.10", status);
+        for (i = 0; i < num; i++) {
+            rec1.i = (i * 7919) % num;
+            rec1.f = i;
+            dbrec1.data = &rec1;
+            dbrec1.length = (i % 11 == 3) ? 2 : sizeof(rec1.i) + sizeof(rec1.f);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+        }
+        delete iScan;
+
+        srand(7);
+        for (int level = FILTERSCALAR; level <= bestFilterLevel(); level++) {
+            setFilterLevel((FilterLevel) level);
+            for (int t = INTEGER; t <= FLOAT; t++)
+                for (int op = LT; op <= NE; op++)
+                    for (int n = 0; n <= (int) MAXSLOTS; n += (n < 20) ? 1 : 37) {
+                        for (i = 0; i < n; i++) {
+                            vals.i[i] = (rand() % 3 == 0) ? INT_MIN + rand() % 3
+                                      : (rand() % 2) ? INT_MAX - rand() % 3 : rand() % 9 - 4;
+                            if (t == FLOAT) vals.f[i] = (i % 17 == 5) ? NAN : vals.i[i] % 5;
+                        }
+                        int ifltr = rand() % 9 - 4;
+                        float ffltr = (n % 7 == 3) ? NAN : ifltr;
+                        FilterFn fn = pickFilter((Datatype) t, (Operator) op);
+                        fn(&vals, n, t == INTEGER ? (void*)&ifltr : (void*)&ffltr, sel);
+                        for (i = 0; i < (int) MAXSLOTS; i++) {
+                            bool want = false;
+                            if (i < n && t == INTEGER) {
+                                int a = vals.i[i];
+                                want = (op == LT && a < ifltr) || (op == LTE && a <= ifltr) ||
+                                       (op == EQ && a == ifltr) || (op == GTE && a >= ifltr) ||
+                                       (op == GT && a > ifltr) || (op == NE && a != ifltr);
+                            }
+                            else if (i < n) {
+                                float a = vals.f[i];
+                                want = (op == LT && a < ffltr) || (op == LTE && a <= ffltr) ||
+                                       (op == EQ && a == ffltr) || (op == GTE && a >= ffltr) ||
+                                       (op == GT && a > ffltr) || (op == NE && a != ffltr);
+                            }
+                            if (((sel[i / 64] >> (i % 64)) & 1) != want) agree = false;
+                        }
+                    }
+            j = num / 3;
+            if (!sameBatchScan("dummy.10", 300, (char*)&j, GTE) ||
+                !sameBatchScan("dummy.10", 300, (char*)&j, NE))
+                agree = false;
+        }
+        setFilterLevel(bestFilterLevel());
+        destroyHeapFile("dummy.10");
+        if (!agree) cout << "err0r. filter kernels disagree with compareOp" << endl;
+        else cout << "passed filter kernel test" << endl;
+    }
+
+    // STRING operators at every kernel level against a reference, over
+    // values of many lengths that end in a NUL or fill the whole field
+    {
+        const char* patterns[] = { "ab", "abab", "b", "", "aab", "_b", "a_a",
+                                   "%", "%%", "a%", "%b", "%ab%", "a%b%a",
+                                   "%a_b%", "_%_", "%b_", "abab%abab", "a%%b" };
+        const int nPatterns = sizeof(patterns) / sizeof(char*);
+        const Operator ops[] = { EQ, NE, PREFIX, CONTAINS, LIKE };
+        const int attrLen = 40;
+        vector<string> vals;
+        bool agree = true;
+
+        createHeapFile("dummy.11");
+        iScan = new InsertFileScan("dummy.11", status);
+        srand(11);
+        for (i = 0; i < 2000; i++) {
+            int n = rand() % (attrLen + 1);
+            for (j = 0; j < attrLen; j++) rec1.s[j] = "ab"[rand() % 2];
+            if (n < attrLen) rec1.s[n] = '\0';
+            vals.push_back(string(rec1.s, n));
+            dbrec1.data = rec1.s;
+            dbrec1.length = attrLen;
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+        }
+        delete iScan;
+
+        for (int level = FILTERSCALAR; level <= bestFilterLevel(); level++) {
+            setFilterLevel((FilterLevel) level);
+            for (int o = 0; o < 5; o++)
+                for (int k = 0; k < nPatterns; k++) {
+                    string p = patterns[k];
+                    int expect = 0, got = 0;
+                    for (i = 0; i < (int) vals.size(); i++)
+                        expect += (ops[o] == EQ) ? vals[i] == p
+                                : (ops[o] == NE) ? vals[i] != p
+                                : (ops[o] == PREFIX) ? vals[i].compare(0, p.size(), p) == 0
+                                : (ops[o] == CONTAINS) ? vals[i].find(p) != string::npos
+                                : likeRef(vals[i].data(), vals[i].size(), p.c_str());
+                    scan1 = new HeapFileScan("dummy.11", status);
+                    status = scan1->startScan(0, attrLen, STRING, patterns[k], ops[o]);
+                    if (status != OK) error.print(status);
+                    while (scan1->scanNext(rec2Rid) == OK) got++;
+                    delete scan1;
+                    if (got != expect) {
+                        cout << "err0r. operator " << ops[o] << " with \"" << p
+                             << "\" matched " << got << " records, not " << expect << endl;
+                        agree = false;
+                    }
+                }
+        }
+        setFilterLevel(bestFilterLevel());
+
+        scan1 = new HeapFileScan("dummy.11", status);
+        if (scan1->startScan(0, sizeof(int), INTEGER, "a", PREFIX) != BADSCANPARM) {
+            cout << "err0r. PREFIX accepted for an INTEGER attribute" << endl;
+            agree = false;
+        }
+        delete scan1;
+        if (agree) cout << "passed string operator test" << endl;
+        destroyHeapFile("dummy.11");
+    }
+
+    // random AND/OR predicates over i, f and s, with BETWEEN and IN,
+    // against a reference evaluation, with scanNext and with scanBatch.
+    // short records lack some of the attributes and large ones keep
+    // them in overflow pages
+    {
+        const int nRecs = 3000;
+        vector<RECORD> recs(nRecs);
+        vector<int> lens(nRecs);
+        char big[3000];
+        bool agree = true;
+
+        createHeapFile("dummy.12");
+        iScan = new InsertFileScan("dummy.12", status);
+        srand(12);
+        for (i = 0; i < nRecs; i++) {
+            memset(&recs[i], 0, sizeof(RECORD));
+            recs[i].i = rand() % 40 - 20;
+            recs[i].f = (i % 97 == 5) ? NAN : (rand() % 40) / 2.0;
+            sprintf(recs[i].s, "v%d", rand() % 30);
+            lens[i] = (i % 13 == 4) ? 6 : (i % 31 == 7) ? 3000 : sizeof(RECORD);
+            memset(big, 'x', sizeof(big));
+            memcpy(big, &recs[i], sizeof(RECORD));
+            dbrec1.data = big;
+            dbrec1.length = lens[i];
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+        }
+        delete iScan;
+
+        RID* batchRids = new RID[100];
+        Record* batchRecs = new Record[100];
+        for (int trial = 0; trial < 300 && agree; trial++) {
+            ScanCond conds[5];
+            string vals[5];
+            int nConds = 1 + rand() % 5;
+            for (int c = 0; c < nConds; c++) {
+                ScanCond & cond = conds[c];
+                int attr = rand() % 3;
+                int nv = 1;
+                cond.op = (Operator) (rand() % 8);
+                if (cond.op == PREFIX) cond.op = (attr == 0) ? PREFIX : EQ;
+                else if (cond.op == CONTAINS) cond.op = BETWEEN;
+                else if (cond.op == LIKE) cond.op = IN;
+                if (cond.op == BETWEEN) nv = 2;
+                if (cond.op == IN) nv = 1 + rand() % 6;
+                cond.type = (attr == 0) ? STRING : (attr == 1) ? INTEGER : FLOAT;
+                cond.offset = (attr == 0) ? 8 : (attr == 1) ? 0 : 4;
+                cond.length = (attr == 0) ? 64 : 4;
+                vals[c].clear();
+                for (int v = 0; v < nv; v++) {
+                    char sv[64];
+                    int iv = rand() % 40 - 20;
+                    float fv = (rand() % 40) / 2.0;
+                    memset(sv, 0, sizeof(sv));
+                    sprintf(sv, "v%d", rand() % 30);
+                    if (cond.op == PREFIX) sv[1 + rand() % 2] = '\0';
+                    vals[c].append(attr == 0 ? sv : attr == 1 ? (char*)&iv : (char*)&fv,
+                                   cond.length);
+                }
+                cond.filter = vals[c].data();
+                cond.valCnt = nv;
+                cond.group = rand() % 3;
+            }
+
+            int expect = 0, got = 0, gotBatch = 0;
+            for (i = 0; i < nRecs; i++) {
+                bool all = true;
+                for (int g = 0; g < 3; g++) {
+                    bool any = false, used = false;
+                    for (int c = 0; c < nConds; c++) {
+                        const ScanCond & cond = conds[c];
+                        if (cond.group != g) continue;
+                        used = true;
+                        if (cond.offset + cond.length > lens[i]) continue;
+                        for (int v = 0; v < (cond.op == IN ? cond.valCnt : 1); v++) {
+                            const char* f = cond.filter + v * cond.length;
+                            int cmp, cmp2 = 0;
+                            if (cond.type == STRING) {
+                                cmp = strncmp(recs[i].s, f, 64);
+                                if (cond.op == BETWEEN) cmp2 = strncmp(recs[i].s, f + 64, 64);
+                                if (cond.op == PREFIX) cmp = strncmp(recs[i].s, f, strlen(f));
+                            }
+                            else if (cond.type == INTEGER) {
+                                int a = recs[i].i, x, y = 0;
+                                memcpy(&x, f, 4);
+                                if (cond.op == BETWEEN) memcpy(&y, f + 4, 4);
+                                cmp = (a > x) - (a < x);
+                                cmp2 = (a > y) - (a < y);
+                            }
+                            else {
+                                float a = recs[i].f, x, y = 0;
+                                memcpy(&x, f, 4);
+                                if (cond.op == BETWEEN) memcpy(&y, f + 4, 4);
+                                if (a != a) continue;   // NaN passes nothing but NE
+                                cmp = (a > x) - (a < x);
+                                cmp2 = (a > y) - (a < y);
+                            }
+                            switch (cond.op) {
+                            case LT:  any |= cmp < 0; break;
+                            case LTE: any |= cmp <= 0; break;
+                            case EQ:  any |= cmp == 0; break;
+                            case GTE: any |= cmp >= 0; break;
+                            case GT:  any |= cmp > 0; break;
+                            case NE:  any |= cmp != 0; break;
+                            case PREFIX: any |= cmp == 0; break;
+                            case BETWEEN: any |= cmp >= 0 && cmp2 <= 0; break;
+                            case IN:  any |= cmp == 0; break;
+                            default: break;
+                            }
+                        }
+                        if (cond.type == FLOAT && cond.op == NE &&
+                            recs[i].f != recs[i].f && cond.offset + cond.length <= lens[i])
+                            any = true;
+                    }
+                    if (used && !any) all = false;
+                }
+                expect += all;
+            }
+
+            scan1 = new HeapFileScan("dummy.12", status);
+            status = scan1->startScan(conds, nConds);
+            if (status != OK) error.print(status);
+            while (scan1->scanNext(rec2Rid) == OK) got++;
+            delete scan1;
+            scan1 = new HeapFileScan("dummy.12", status);
+            status = scan1->startScan(conds, nConds);
+            int cnt;
+            while (scan1->scanBatch(100, batchRids, batchRecs, cnt) == OK) gotBatch += cnt;
+            delete scan1;
+            if (got != expect || gotBatch != expect) {
+                cout << "err0r. predicate " << trial << " matched " << got << " and "
+                     << gotBatch << " records, not " << expect << endl;
+                agree = false;
+            }
+        }
+        delete [] batchRids;
+        delete [] batchRecs;
+
+        ScanCond bad = { 0, 4, INTEGER, IN, (char*)&j, 0, 0 };
+        scan1 = new HeapFileScan("dummy.12", status);
+        if (scan1->startScan(&bad, 1) != BADSCANPARM ||
+            scan1->startScan(0, 4, INTEGER, (char*)&j, IN) != BADSCANPARM) {
+            cout << "err0r. IN accepted without a value list" << endl;
+            agree = false;
+        }
+        delete scan1;
+        destroyHeapFile("dummy.12");
+        if (agree) cout << "passed multi-attribute predicate test" << endl;
+    }
+
+    // columns copied out by scanColumns must be those of the records
+    // scanNext returns, zeros where a record is too short, for batches
+    // of every size and with and without a filter
+    {
+        const int nRecs = 2000;
+        char big[3000];
+        ScanColumn cols[3] = { { 4, 4, FLOAT }, { 8, 20, STRING }, { 0, 4, INTEGER } };
+        bool agree = true;
+
+        createHeapFile("dummy.13");
+        iScan = new InsertFileScan("dummy.13", status);
+        for (i = 0; i < nRecs; i++) {
+            memset(big, 'x', sizeof(big));
+            rec1.i = i;
+            rec1.f = i / 2.0;
+            memset(rec1.s, 0, sizeof(rec1.s));
+            sprintf(rec1.s, "record %d", i);
+            memcpy(big, &rec1, sizeof(RECORD));
+            dbrec1.data = big;
+            dbrec1.length = (i % 17 == 3) ? 4 : (i % 17 == 5) ? 12
+                          : (i % 53 == 9) ? 3000 : sizeof(RECORD);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+        }
+        delete iScan;
+
+        const int sizes[] = { 1, 7, 300, 1000 };
+        for (int f = 0; f < 2; f++)
+            for (int m = 0; m < 4; m++) {
+                const int max = sizes[m];
+                vector<string> want[3], got[3];
+                vector<RID> wantRids, gotRids;
+                float* fcol = new float[max];
+                char* scol = new char[max * 20];
+                int* icol = new int[max];
+                char* out[3] = { (char*)fcol, scol, (char*)icol };
+                RID* rids = new RID[max];
+                int cnt;
+
+                j = nRecs / 3;
+                scan1 = new HeapFileScan("dummy.13", status);
+                scan1->startScan(0, sizeof(int), INTEGER, f ? (char*)&j : NULL, GT);
+                while (scan1->scanNext(rec2Rid) == OK &&
+                       scan1->getRecord(dbrec2) == OK) {
+                    wantRids.push_back(rec2Rid);
+                    for (int c = 0; c < 3; c++) {
+                        string v(cols[c].length, '\0');
+                        if (cols[c].offset + cols[c].length <= dbrec2.length)
+                            v.assign((char*)dbrec2.data + cols[c].offset, cols[c].length);
+                        want[c].push_back(v);
+                    }
+                }
+                delete scan1;
+
+                scan1 = new HeapFileScan("dummy.13", status);
+                scan1->startScan(0, sizeof(int), INTEGER, f ? (char*)&j : NULL, GT);
+                while ((status = scan1->scanColumns(cols, 3, out, max, rids, cnt)) == OK) {
+                    if (cnt < 1 || cnt > max) agree = false;
+                    for (int k = 0; k < cnt; k++) {
+                        gotRids.push_back(rids[k]);
+                        for (int c = 0; c < 3; c++)
+                            got[c].push_back(string(out[c] + k * cols[c].length,
+                                                    cols[c].length));
+                    }
+                }
+                delete scan1;
+
+                if (status != FILEEOF || gotRids.size() != wantRids.size())
+                    agree = false;
+                for (i = 0; agree && i < (int) wantRids.size(); i++)
+                    agree = gotRids[i].pageNo == wantRids[i].pageNo &&
+                            gotRids[i].slotNo == wantRids[i].slotNo &&
+                            got[0][i] == want[0][i] && got[1][i] == want[1][i] &&
+                            got[2][i] == want[2][i];
+                delete [] fcol;
+                delete [] scol;
+                delete [] icol;
+                delete [] rids;
+            }
+
+        scan1 = new HeapFileScan("dummy.13", status);
+        scan1->startScan(0, 0, INTEGER, NULL, EQ);
+        int cnt;
+        if (scan1->scanColumns(cols, 3, NULL, 10, NULL, cnt) != BADSCANPARM) {
+            cout << "err0r. scanColumns accepted no output arrays" << endl;
+            agree = false;
+        }
+        delete scan1;
+        destroyHeapFile("dummy.13");
+        if (!agree) cout << "err0r. scanColumns disagrees with scanNext" << endl;
+        else cout << "passed column projection test" << endl;
+    }
+
+    // parallelScan on any number of threads finds the records scanNext
+    // does, over a file with moved, large, short and deleted records
+    {
+        char big[3000];
+        bool agree = true;
+
+        createHeapFile("dummy.14");
+        iScan = new InsertFileScan("dummy.14", status);
+        for (i = 0; i < 3000; i++) {
+            memset(big, 'y', sizeof(big));
+            rec1.i = i;
+            rec1.f = i;
+            sprintf(rec1.s, "record %d", i);
+            memcpy(big, &rec1, sizeof(RECORD));
+            dbrec1.data = big;
+            dbrec1.length = (i % 29 == 3) ? 2 : (i % 61 == 7) ? 2500 : sizeof(RECORD);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+        }
+        delete iScan;
+
+        // grow every 7th record so that it has to move, drop every 11th
+        scan1 = new HeapFileScan("dummy.14", status);
+        scan1->startScan(0, 0, INTEGER, NULL, EQ);
+        for (i = 0; scan1->scanNext(rec2Rid) == OK; i++) {
+            if (i % 11 == 5) status = scan1->deleteRecord();
+            else if (i % 7 == 2) {
+                scan1->getRecord(dbrec2);
+                if (dbrec2.length < (int) sizeof(RECORD)) continue;
+                memcpy(big, dbrec2.data, sizeof(RECORD));
+                dbrec1.data = big;
+                dbrec1.length = 400;
+                status = scan1->updateRecord(dbrec1);
+            }
+            if (status != OK) error.print(status);
+        }
+        delete scan1;
+
+        j = 1000;
+        for (int f = 0; f < 2; f++) {
+            vector<pair<RID, string> > want;
+            scan1 = new HeapFileScan("dummy.14", status);
+            scan1->startScan(0, sizeof(int), INTEGER, f ? (char*)&j : NULL, GTE);
+            while (scan1->scanNext(rec2Rid) == OK && scan1->getRecord(dbrec2) == OK)
+                want.push_back(make_pair(rec2Rid, string((char*)dbrec2.data, dbrec2.length)));
+            delete scan1;
+            sort(want.begin(), want.end(), ridLess);
+
+            for (int nThreads = 1; nThreads <= 8; nThreads += 3) {
+                FoundRecs found(nThreads);
+                vector<pair<RID, string> > got;
+                scan1 = new HeapFileScan("dummy.14", status);
+                scan1->startScan(0, sizeof(int), INTEGER, f ? (char*)&j : NULL, GTE);
+                status = scan1->parallelScan(nThreads, collectRecords, &found);
+                if (status != OK) error.print(status);
+                if (scan1->scanNext(rec2Rid) != FILEEOF) agree = false;
+                delete scan1;
+                for (i = 0; i < nThreads; i++)
+                    got.insert(got.end(), found[i].begin(), found[i].end());
+                sort(got.begin(), got.end(), ridLess);
+                if (got.size() != want.size()) agree = false;
+                for (i = 0; agree && i < (int) got.size(); i++)
+                    agree = !ridLess(got[i], want[i]) && !ridLess(want[i], got[i]) &&
+                            got[i].second == want[i].second;
+            }
+        }
+        destroyHeapFile("dummy.14");
+        if (!agree) cout << "err0r. parallelScan disagrees with scanNext" << endl;
+        else cout << "passed parallel scan test" << endl;
+    }
+
+    // the page directory must list the page chain, whether the pages
+    // were added by insertRecord, insertRecords, moved records or the
+    // bulk loader, and seekPage must resume a scan at any page
+    {
+        bool agree = true;
+        RID rids[100];
+        Record recs[100];
+
+        createHeapFile("dummy.15");
+        iScan = new InsertFileScan("dummy.15", status);
+        for (i = 0; i < 6000; i++) {
+            rec1.i = i;
+            rec1.f = i;
+            sprintf(rec1.s, "record %d", i);
+            recs[i % 100].data = &rec1;
+            recs[i % 100].length = sizeof(RECORD);
+            if (i < 2000) status = iScan->insertRecord(recs[0], newRid);
+            else if (i % 100 == 99) status = iScan->insertRecords(recs, 100, rids);
+            if (status != OK) error.print(status);
+        }
+        delete iScan;
+        scan1 = new HeapFileScan("dummy.15", status);
+        scan1->startScan(0, 0, INTEGER, NULL, EQ);
+        for (i = 0; scan1->scanNext(rec2Rid) == OK; i++)
+            if (i % 5 == 1) {
+                char grown[300];
+                scan1->getRecord(dbrec2);
+                memcpy(grown, dbrec2.data, sizeof(RECORD));
+                dbrec1.data = grown;
+                dbrec1.length = sizeof(grown);
+                status = scan1->updateRecord(dbrec1);
+                if (status != OK) error.print(status);
+            }
+        delete scan1;
+
+        HeapFileLoader* loader = new HeapFileLoader("dummy.15", status);
+        for (i = 0; i < 4000 && status == OK; i++)
+            status = loader->insertRecord(recs[0], newRid);
+        if (status != OK) error.print(status);
+        delete loader;
+
+        File* file;
+        vector<int> pageNos;
+        scan1 = new HeapFileScan("dummy.15", status);
+        scan1->startScan(0, 0, INTEGER, NULL, EQ);
+        scan1->getPageNos(pageNos);
+        db.openFile("dummy.15", file);
+        if ((int) pageNos.size() != scan1->getPageCnt() || pageNos.size() < 2 * DIRPAGESIZE)
+            agree = false;
+        for (i = 0; agree && i < (int) pageNos.size(); i++) {
+            Page* page;
+            int next, pageNo;
+            bufMgr->readPage(file, pageNos[i], page);
+            page->getNextPage(next);
+            bufMgr->unPinPage(file, pageNos[i], false);
+            if (i + 1 < (int) pageNos.size() && next != pageNos[i + 1]) agree = false;
+            if (scan1->getPageNo(i, pageNo) != OK || pageNo != pageNos[i]) agree = false;
+        }
+        db.closeFile(file);
+        if (scan1->getPageNo(pageNos.size(), j) != BADPAGENO ||
+            scan1->getPageNo(-1, j) != BADPAGENO)
+            agree = false;
+
+        vector<pair<int, int> > all;
+        while (scan1->scanNext(rec2Rid) == OK)
+            all.push_back(make_pair(rec2Rid.pageNo, rec2Rid.slotNo));
+        size_t prevLen = all.size() + 1;
+        for (int k = 0; agree && k < (int) pageNos.size(); k += 37) {
+            vector<pair<int, int> > rest;
+            if (scan1->seekPage(k) != OK) agree = false;
+            scan1->setReadAhead(k % 2 ? 16 : 0);
+            while (scan1->scanNext(rec2Rid) == OK)
+                rest.push_back(make_pair(rec2Rid.pageNo, rec2Rid.slotNo));
+            if (rest.size() >= prevLen || (k == 0 && rest.size() != all.size()) ||
+                !equal(rest.begin(), rest.end(), all.end() - rest.size()))
+                agree = false;
+            prevLen = rest.size();
+        }
+        delete scan1;
+        destroyHeapFile("dummy.15");
+        if (!agree) cout << "err0r. page directory does not match the page chain" << endl;
+        else cout << "passed page directory test" << endl;
+    }
+
+    // getRecords must return the same records as getRecord, in the
+    // order asked for, whether they are inline, moved or large, and
+    // with RIDs repeated
+    {
+        const int cnt = 3000;
+        bool agree = true;
+        char big[3000];
+        vector<RID> all;
+
+        createHeapFile("dummy.16");
+        iScan = new InsertFileScan("dummy.16", status);
+        for (i = 0; i < cnt; i++) {
+            rec1.i = i;
+            rec1.f = i;
+            sprintf(rec1.s, "record %d", i);
+            dbrec1.data = &rec1;
+            dbrec1.length = sizeof(RECORD);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+            all.push_back(newRid);
+        }
+        delete iScan;
+
+        file1 = new HeapFile("dummy.16", status);
+        for (i = 0; i < cnt; i += 5) {
+            // every 5th record moves, every 50th becomes large
+            memset(big, 'a' + i % 26, sizeof(big));
+            sprintf(big, "grown %d", i);
+            dbrec1.data = big;
+            dbrec1.length = (i % 50 == 0) ? sizeof(big) : 300;
+            status = file1->updateRecord(all[i], dbrec1);
+            if (status != OK) error.print(status);
+        }
+
+        vector<RID> want;
+        for (i = 0; i < cnt; i += 7) want.push_back(all[i]);
+        for (i = 0; i < 2000; i++) want.push_back(all[(i * 7919) % cnt]);
+        want.push_back(all[0]);
+        want.push_back(all[0]);
+        for (int pass = 0; pass < 2; pass++) {
+            vector<Record> got(want.size());
+            status = file1->getRecords(&want[0], want.size(), &got[0], pass == 1);
+            if (status != OK) { error.print(status); agree = false; }
+            for (j = 0; agree && j < (int) want.size(); j++) {
+                string copy((char*) got[j].data, got[j].length);
+                status = file1->getRecord(want[j], dbrec2);
+                if (status != OK || dbrec2.length != (int) copy.size() ||
+                    memcmp(dbrec2.data, copy.data(), copy.size()) != 0) {
+                    cout << "err0r. getRecords differs from getRecord at " << j << endl;
+                    agree = false;
+                }
+            }
+        }
+
+        RID bad = all[1];
+        bad.slotNo = MAXSLOTS - 1;
+        want.push_back(bad);
+        vector<Record> got(want.size());
+        if (file1->getRecords(&want[0], want.size(), &got[0]) == OK) {
+            cout << "err0r. getRecords accepted an unused slot" << endl;
+            agree = false;
+        }
+        delete file1;
+        destroyHeapFile("dummy.16");
+        if (agree) cout << "passed batched lookup test" << endl;
+    }
+
+    // deleteRecords and deleteWhere must delete just the records asked
+    // for, moved and large ones included, and keep the record count
+    {
+        const int cnt = 3000;
+        bool agree = true;
+        char big[3000];
+        vector<RID> all, gone;
+        int deleted;
+
+        createHeapFile("dummy.17");
+        iScan = new InsertFileScan("dummy.17", status);
+        for (i = 0; i < cnt; i++) {
+            rec1.i = i;
+            rec1.f = i;
+            sprintf(rec1.s, "record %d", i);
+            dbrec1.data = &rec1;
+            dbrec1.length = sizeof(RECORD);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+            all.push_back(newRid);
+        }
+        delete iScan;
+
+        file1 = new HeapFile("dummy.17", status);
+        for (i = 0; i < cnt; i += 5) {
+            // every 5th record moves, every 50th becomes large
+            memset(big, 0, sizeof(big));
+            memcpy(big, &i, sizeof(int));
+            dbrec1.data = big;
+            dbrec1.length = (i % 50 == 0) ? sizeof(big) : 300;
+            status = file1->updateRecord(all[i], dbrec1);
+            if (status != OK) error.print(status);
+        }
+
+        // every 3rd record, backwards and some twice
+        for (i = cnt - 1; i >= 0; i--)
+            if (i % 3 == 0) gone.push_back(all[i]);
+        gone.push_back(all[0]);
+        gone.push_back(all[15]);
+        status = file1->deleteRecords(&gone[0], gone.size(), deleted);
+        if (status != OK) error.print(status);
+        if (deleted != cnt / 3 || file1->getRecCnt() != cnt - cnt / 3) {
+            cout << "err0r. deleteRecords deleted " << deleted << endl;
+            agree = false;
+        }
+        if (file1->deleteRecords(&all[3], 1, deleted) == OK || deleted != 0) {
+            cout << "err0r. deleteRecords deleted a record twice" << endl;
+            agree = false;
+        }
+        // a bad RID among good ones, moved ones too, deletes none of them
+        {
+            RID mixed[4] = { all[1], all[5], all[3], all[10] };
+            if (file1->deleteRecords(mixed, 4, deleted) == OK ||
+                deleted != 0 || file1->getRecCnt() != cnt - cnt / 3 ||
+                file1->getRecord(all[5], dbrec2) != OK) {
+                cout << "err0r. deleteRecords with a bad RID deleted "
+                     << deleted << endl;
+                agree = false;
+            }
+        }
+        delete file1;
+
+        // then all records with i below 1000 or at least 2500
+        ScanCond conds[2] = { { 0, sizeof(int), INTEGER, LT, NULL, 1, 0 },
+                              { 0, sizeof(int), INTEGER, GTE, NULL, 1, 0 } };
+        int low = 1000, high = 2500;
+        conds[0].filter = (char*) &low;
+        conds[1].filter = (char*) &high;
+        scan1 = new HeapFileScan("dummy.17", status);
+        scan1->startScan(conds, 2);
+        status = scan1->deleteWhere(deleted);
+        if (status != OK) error.print(status);
+        int expect = 0;
+        for (i = 0; i < cnt; i++)
+            if (i % 3 != 0 && (i < low || i >= high)) expect++;
+        if (deleted != expect || scan1->scanNext(rec2Rid) != FILEEOF) {
+            cout << "err0r. deleteWhere deleted " << deleted << " of " << expect << endl;
+            agree = false;
+        }
+
+        char* seen = new char[cnt];
+        memset(seen, 0, cnt);
+        delete scan1;
+        scan1 = new HeapFileScan("dummy.17", status);
+        scan1->startScan(0, 0, INTEGER, NULL, EQ);
+        j = 0;
+        while (scan1->scanNext(rec2Rid) == OK) {
+            scan1->getRecord(dbrec2);
+            memcpy(&i, dbrec2.data, sizeof(int));
+            if (i < low || i >= high || i % 3 == 0 || seen[i]) agree = false;
+            else seen[i] = 1;
+            j++;
+        }
+        if (!agree || j != scan1->getRecCnt() || j != cnt - cnt / 3 - expect) {
+            cout << "err0r. " << j << " records left after deleteWhere" << endl;
+            agree = false;
+        }
+        delete [] seen;
+        delete scan1;
+        destroyHeapFile("dummy.17");
+        if (agree) cout << "passed batched delete test" << endl;
+    }
+
+    // updateWhere must change just the records that match, in place or
+    // by growing them, and whether they are moved or large
+    {
+        const int cnt = 3000;
+        bool agree = true;
+        char big[3000];
+        int updated;
+
+        createHeapFile("dummy.18");
+        iScan = new InsertFileScan("dummy.18", status);
+        for (i = 0; i < cnt; i++) {
+            rec1.i = i;
+            rec1.f = i;
+            sprintf(rec1.s, "record %d", i);
+            dbrec1.data = &rec1;
+            dbrec1.length = sizeof(RECORD);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+        }
+        delete iScan;
+
+        // every 5th record moves, every 50th becomes large; their f is 0
+        scan1 = new HeapFileScan("dummy.18", status);
+        scan1->startScan(0, 0, INTEGER, NULL, EQ);
+        while (scan1->scanNext(rec2Rid) == OK) {
+            scan1->getRecord(dbrec2);
+            memcpy(&i, dbrec2.data, sizeof(int));
+            if (i % 5) continue;
+            memset(big, 0, sizeof(big));
+            memcpy(big, &i, sizeof(int));
+            dbrec1.data = big;
+            dbrec1.length = (i % 50 == 0) ? sizeof(big) : 300;
+            status = scan1->updateRecord(dbrec1);
+            if (status != OK) error.print(status);
+        }
+        delete scan1;
+
+        ScanCond conds[2] = { { 0, sizeof(int), INTEGER, GTE, NULL, 0, 0 },
+                              { 0, sizeof(int), INTEGER, LT, NULL, 0, 1 } };
+        int low = 1000, high = 2000;
+        conds[0].filter = (char*) &low;
+        conds[1].filter = (char*) &high;
+        scan1 = new HeapFileScan("dummy.18", status);
+        scan1->startScan(conds, 2);
+        status = scan1->updateWhere(bumpFloat, NULL, updated);
+        if (status != OK) error.print(status);
+        if (updated != high - low) {
+            cout << "err0r. updateWhere updated " << updated << " records" << endl;
+            agree = false;
+        }
+        delete scan1;
+
+        // grow the first 500 records to hold a field at offset 400
+        ScanSet set = { 400, 8, "assigned" };
+        int limit = 500;
+        scan1 = new HeapFileScan("dummy.18", status);
+        scan1->startScan(0, sizeof(int), INTEGER, (char*) &limit, LT);
+        status = scan1->updateWhere(&set, 1, updated);
+        if (status != OK) error.print(status);
+        if (updated != limit) {
+            cout << "err0r. updateWhere assigned " << updated << " records" << endl;
+            agree = false;
+        }
+        delete scan1;
+
+        char* seen = new char[cnt];
+        memset(seen, 0, cnt);
+        scan1 = new HeapFileScan("dummy.18", status);
+        scan1->startScan(0, 0, INTEGER, NULL, EQ);
+        j = 0;
+        while (agree && scan1->scanNext(rec2Rid) == OK) {
+            float f;
+            int len;
+            scan1->getRecord(dbrec2);
+            memcpy(&i, dbrec2.data, sizeof(int));
+            memcpy(&f, (char*) dbrec2.data + sizeof(int), sizeof(float));
+            len = (i % 50 == 0) ? sizeof(big) : (i % 5 == 0) ? 300 : sizeof(RECORD);
+            if (i < limit && len < 408) len = 408;
+            if (i < 0 || i >= cnt || seen[i] || dbrec2.length != len ||
+                f != (i % 5 ? i : 0) + (i >= low && i < high) ||
+                (i < limit && memcmp((char*) dbrec2.data + 400, "assigned", 8))) {
+                cout << "err0r. record " << i << " updated wrongly" << endl;
+                agree = false;
+            }
+            else seen[i] = 1;
+            j++;
+        }
+        if (agree && j != cnt) {
+            cout << "err0r. " << j << " records after updateWhere" << endl;
+            agree = false;
+        }
+        delete [] seen;
+        delete scan1;
+        destroyHeapFile("dummy.18");
+        if (agree) cout << "passed set update test" << endl;
+    }
+
+    // B+tree indexes on an INTEGER, a FLOAT and a STRING attribute must
+    // find the same records as filtered scans, for every operator, after
+    // being built from the file and after inserts and deletes
+    {
+        const int cnt = 5000;
+        bool agree = true;
+        string intName, floatName, strName;
+        vector<RID> all;
+
+        createHeapFile("dummy.19");
+        iScan = new InsertFileScan("dummy.19", status);
+        for (i = 0; i < cnt; i++) {
+            memset(&rec1, 0, sizeof(rec1));
+            rec1.i = (i * 37) % (cnt / 2);
+            rec1.f = rec1.i / 4.0;
+            sprintf(rec1.s, "key %d", rec1.i % 700);
+            dbrec1.data = &rec1;
+            dbrec1.length = sizeof(RECORD);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+            all.push_back(newRid);
+        }
+        delete iScan;
+
+        BTreeIndex* ix = new BTreeIndex("dummy.19", 0, sizeof(int), INTEGER,
+                                        intName, status);
+        if (status != OK) error.print(status);
+        BTreeIndex* fx = new BTreeIndex("dummy.19", sizeof(int), sizeof(float),
+                                        FLOAT, floatName, status);
+        if (status != OK) error.print(status);
+        BTreeIndex* sx = new BTreeIndex("dummy.19", 2 * sizeof(int), 64, STRING,
+                                        strName, status);
+        if (status != OK) error.print(status);
+        if (ix->getEntryCnt() != cnt || sx->getEntryCnt() != cnt ||
+            ix->getHeight() < 2 || sx->getHeight() < 3) {
+            cout << "err0r. index built with " << ix->getEntryCnt()
+                 << " entries" << endl;
+            agree = false;
+        }
+
+        int ivals[4] = { 100, 2000, 7, 2499 };
+        float fvals[2] = { 25.5, 300 };
+        char svals[3][64];
+        memset(svals, 0, sizeof(svals));
+        strcpy(svals[0], "key 100");
+        strcpy(svals[1], "key 300");
+        strcpy(svals[2], "key 12");
+        const char* patterns[6] = { "key 5", "key 1%", "%y 6_", "key 6_", "y 69",
+                                    "key 650" };
+        const Operator patternOps[6] = { PREFIX, LIKE, LIKE, LIKE, CONTAINS, GT };
+
+        for (int pass = 0; pass < 2 && agree; pass++) {
+            ScanCond c = { 0, sizeof(int), INTEGER, LT, (char*) &ivals[1], 0, 0 };
+            for (int op = LT; op <= NE; op++) {
+                c.op = (Operator) op;
+                agree = agree && indexAgrees(ix, "dummy.19", c);
+            }
+            c.op = BETWEEN;
+            c.filter = (char*) ivals;
+            agree = agree && indexAgrees(ix, "dummy.19", c);
+            c.op = IN;
+            c.valCnt = 4;
+            agree = agree && indexAgrees(ix, "dummy.19", c);
+
+            ScanCond fc = { sizeof(int), sizeof(float), FLOAT, LT, (char*) fvals, 0, 0 };
+            agree = agree && indexAgrees(fx, "dummy.19", fc);
+            fc.op = NE;
+            agree = agree && indexAgrees(fx, "dummy.19", fc);
+            fc.op = BETWEEN;
+            agree = agree && indexAgrees(fx, "dummy.19", fc);
+
+            ScanCond sc = { 2 * sizeof(int), 64, STRING, BETWEEN, (char*) svals, 0, 0 };
+            agree = agree && indexAgrees(sx, "dummy.19", sc);
+            sc.op = IN;
+            sc.valCnt = 3;
+            agree = agree && indexAgrees(sx, "dummy.19", sc);
+            sc.op = EQ;
+            sc.filter = svals[2];
+            agree = agree && indexAgrees(sx, "dummy.19", sc);
+            sc.valCnt = 0;
+            for (j = 0; j < 6; j++) {
+                sc.op = patternOps[j];
+                sc.filter = patterns[j];
+                agree = agree && indexAgrees(sx, "dummy.19", sc);
+            }
+            if (!agree) {
+                cout << "err0r. index and scan disagree in pass " << pass << endl;
+                break;
+            }
+            if (pass == 1) break;
+
+            // many records with a few keys, which splits the leaves holding
+            // them, and every third of the first ones deleted
+            iScan = new InsertFileScan("dummy.19", status);
+            for (i = 0; i < 3000; i++) {
+                memset(&rec1, 0, sizeof(rec1));
+                rec1.i = 1000 + i % 50;
+                rec1.f = rec1.i / 4.0;
+                sprintf(rec1.s, "key %d", rec1.i % 700);
+                dbrec1.data = &rec1;
+                dbrec1.length = sizeof(RECORD);
+                status = iScan->insertRecord(dbrec1, newRid);
+                if (status == OK) status = ix->insertEntry((char*) &rec1.i, newRid);
+                if (status == OK) status = fx->insertEntry((char*) &rec1.f, newRid);
+                if (status == OK) status = sx->insertEntry(rec1.s, newRid);
+                if (status != OK) error.print(status);
+            }
+            delete iScan;
+            if (ix->insertEntry((char*) &rec1.i, newRid) != NONUNIQUEENTRY) {
+                cout << "err0r. duplicate index entry accepted" << endl;
+                agree = false;
+            }
+
+            vector<RID> gone;
+            for (i = 0; i < cnt; i += 3) {
+                memset(&rec1, 0, sizeof(rec1));
+                rec1.i = (i * 37) % (cnt / 2);
+                rec1.f = rec1.i / 4.0;
+                sprintf(rec1.s, "key %d", rec1.i % 700);
+                status = ix->deleteEntry((char*) &rec1.i, all[i]);
+                if (status == OK) status = fx->deleteEntry((char*) &rec1.f, all[i]);
+                if (status == OK) status = sx->deleteEntry(rec1.s, all[i]);
+                if (status != OK) error.print(status);
+                gone.push_back(all[i]);
+            }
+            if (ix->deleteEntry((char*) &rec1.i, gone.back()) != RECNOTFOUND) {
+                cout << "err0r. deleted index entry found again" << endl;
+                agree = false;
+            }
+            file1 = new HeapFile("dummy.19", status);
+            status = file1->deleteRecords(&gone[0], gone.size(), deleted);
+            if (status != OK) error.print(status);
+            delete file1;
+
+            // and the INTEGER index read back from its file
+            delete ix;
+            ix = new BTreeIndex("dummy.19", 0, sizeof(int), INTEGER, intName, status);
+            if (status != OK) error.print(status);
+            if (ix->getEntryCnt() != cnt + 3000 - (int) gone.size()) {
+                cout << "err0r. reopened index has " << ix->getEntryCnt()
+                     << " entries" << endl;
+                agree = false;
+            }
+        }
+        delete ix;
+        delete fx;
+        delete sx;
+        db.destroyFile(intName);
+        db.destroyFile(floatName);
+        db.destroyFile(strName);
+        destroyHeapFile("dummy.19");
+        if (agree) cout << "passed B+tree index test" << endl;
+    }
+
+    // extendible hash indexes on an INTEGER, a FLOAT and a STRING
+    // attribute must find the same records as EQ scans, after being
+    // built from the file and after being kept up to date by the
+    // inserts, deletes and updates of the scans they are attached to
+    {
+        const int cnt = 4000;
+        bool agree = true;
+        string intName, floatName, strName;
+        int updated;
+
+        createHeapFile("dummy.20");
+        iScan = new InsertFileScan("dummy.20", status);
+        for (i = 0; i < cnt; i++) {
+            memset(&rec1, 0, sizeof(rec1));
+            // a tenth of the records share one key, which takes
+            // overflow pages
+            rec1.i = (i % 10 == 0) ? 7777 : (i * 37) % 900;
+            rec1.f = (i % 100 == 1) ? -0.0 : rec1.i / 4.0;
+            sprintf(rec1.s, "key %d", rec1.i % 700);
+            dbrec1.data = &rec1;
+            dbrec1.length = sizeof(RECORD);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+        }
+        delete iScan;
+
+        HashIndex* ix = new HashIndex("dummy.20", 0, sizeof(int), INTEGER,
+                                      intName, status);
+        if (status != OK) error.print(status);
+        HashIndex* fx = new HashIndex("dummy.20", sizeof(int), sizeof(float),
+                                      FLOAT, floatName, status);
+        if (status != OK) error.print(status);
+        HashIndex* sx = new HashIndex("dummy.20", 2 * sizeof(int), 64, STRING,
+                                      strName, status);
+        if (status != OK) error.print(status);
+        if (ix->getEntryCnt() != cnt || sx->getEntryCnt() != cnt ||
+            ix->getDepth() < 3 || sx->getDepth() < 6) {
+            cout << "err0r. hash index built with " << ix->getEntryCnt()
+                 << " entries, depth " << ix->getDepth() << endl;
+            agree = false;
+        }
+
+        int ivals[7] = { 7777, 0, 37, 899, 4242, 10037, -5 };
+        float fvals[4] = { 0.0, -0.0, 9.25, 1944.25 };
+        char svals[4][64];
+        memset(svals, 0, sizeof(svals));
+        strcpy(svals[0], "key 77");
+        strcpy(svals[1], "key 12");
+        strcpy(svals[2], "key 699");
+        strcpy(svals[3], "key");
+
+        for (int pass = 0; pass < 2 && agree; pass++) {
+            for (j = 0; j < 7; j++)
+                agree = agree && hashAgrees(ix, "dummy.20", 0, sizeof(int),
+                                            INTEGER, (char*) &ivals[j]);
+            for (j = 0; j < 4; j++)
+                agree = agree && hashAgrees(fx, "dummy.20", sizeof(int),
+                                            sizeof(float), FLOAT,
+                                            (char*) &fvals[j]);
+            for (j = 0; j < 4; j++)
+                agree = agree && hashAgrees(sx, "dummy.20", 2 * sizeof(int), 64,
+                                            STRING, svals[j]);
+            if (ix->getEntryCnt() != sx->getEntryCnt() ||
+                sx->getEntryCnt() != fx->getEntryCnt()) agree = false;
+            if (!agree) {
+                cout << "err0r. hash index and scan disagree in pass " << pass
+                     << endl;
+                break;
+            }
+            if (pass == 1) break;
+
+            // the indexes follow what the scans they are attached to do
+            iScan = new InsertFileScan("dummy.20", status);
+            ix->attachTo(*iScan);
+            fx->attachTo(*iScan);
+            sx->attachTo(*iScan);
+            for (i = 0; i < 500; i++) {
+                memset(&rec1, 0, sizeof(rec1));
+                rec1.i = (i % 2) ? 7777 : 10000 + i;
+                rec1.f = rec1.i / 4.0;
+                sprintf(rec1.s, "key %d", rec1.i % 700);
+                dbrec1.data = &rec1;
+                dbrec1.length = sizeof(RECORD);
+                status = iScan->insertRecord(dbrec1, newRid);
+                if (status != OK) error.print(status);
+            }
+            delete iScan;
+
+            int low = 100, lows[2] = { 200, 260 }, high = 37;
+            scan1 = new HeapFileScan("dummy.20", status);
+            ix->attachTo(*scan1);
+            fx->attachTo(*scan1);
+            sx->attachTo(*scan1);
+            scan1->startScan(0, sizeof(int), INTEGER, (char*) &high, LT);
+            while (scan1->scanNext(rec2Rid) == OK) {
+                status = scan1->deleteRecord();
+                if (status != OK) error.print(status);
+            }
+            scan1->startScan(0, sizeof(int), INTEGER, (char*) &low, LT);
+            while (scan1->scanNext(rec2Rid) == OK) {
+                status = scan1->getRecord(dbrec2);
+                memcpy(&rec1, dbrec2.data, sizeof(RECORD));
+                rec1.i += 10000;
+                sprintf(rec1.s, "key %d", rec1.i % 700);
+                dbrec1.data = &rec1;
+                dbrec1.length = sizeof(RECORD);
+                if (status == OK) status = scan1->updateRecord(dbrec1);
+                if (status != OK) error.print(status);
+            }
+            delete scan1;
+
+            scan1 = new HeapFileScan("dummy.20", status);
+            ix->attachTo(*scan1);
+            fx->attachTo(*scan1);
+            sx->attachTo(*scan1);
+            ScanCond c = { 0, sizeof(int), INTEGER, BETWEEN, (char*) lows, 0, 0 };
+            scan1->startScan(&c, 1);
+            status = scan1->updateWhere(bumpFloat, NULL, updated);
+            if (status != OK) error.print(status);
+            delete scan1;
+
+            scan1 = new HeapFileScan("dummy.20", status);
+            ix->attachTo(*scan1);
+            fx->attachTo(*scan1);
+            sx->attachTo(*scan1);
+            ScanSet set = { 0, sizeof(int), (char*) &ivals[4] };
+            lows[0] = 300;
+            lows[1] = 320;
+            scan1->startScan(&c, 1);
+            status = scan1->updateWhere(&set, 1, updated);
+            if (status != OK) error.print(status);
+            delete scan1;
+
+            scan1 = new HeapFileScan("dummy.20", status);
+            ix->attachTo(*scan1);
+            fx->attachTo(*scan1);
+            sx->attachTo(*scan1);
+            lows[0] = 500;
+            lows[1] = 600;
+            scan1->startScan(&c, 1);
+            status = scan1->deleteWhere(deleted);
+            if (status != OK) error.print(status);
+            if (ix->getEntryCnt() != scan1->getRecCnt() ||
+                fx->getEntryCnt() != scan1->getRecCnt()) {
+                cout << "err0r. hash index has " << ix->getEntryCnt()
+                     << " entries for " << scan1->getRecCnt() << " records"
+                     << endl;
+                agree = false;
+            }
+            delete scan1;
+
+            if (ix->insertEntry((char*) &ivals[0], newRid) != NONUNIQUEENTRY ||
+                ix->deleteEntry((char*) &ivals[6], newRid) != RECNOTFOUND) {
+                cout << "err0r. hash index accepted a bad insert or delete" << endl;
+                agree = false;
+            }
+
+            // and the INTEGER index read back from its file
+            i = ix->getEntryCnt();
+            delete ix;
+            ix = new HashIndex("dummy.20", 0, sizeof(int), INTEGER, intName,
+                               status);
+            if (status != OK) error.print(status);
+            if (ix->getEntryCnt() != i) {
+                cout << "err0r. reopened hash index has " << ix->getEntryCnt()
+                     << " entries" << endl;
+                agree = false;
+            }
+        }
+        delete ix;
+        delete fx;
+        delete sx;
+        db.destroyFile(intName);
+        db.destroyFile(floatName);
+        db.destroyFile(strName);
+        destroyHeapFile("dummy.20");
+        if (agree) cout << "passed hash index test" << endl;
+    }
+
+    // bitmap operations against sets, then bitmap indexes on an
+    // INTEGER and a STRING attribute combined with AND, OR and NOT must
+    // find the same records as scans, before and after changes made
+    // through the scans they are attached to
+    {
+        bool agree = true;
+        Bitmap a, b, c;
+        set<unsigned> sa, sb, sc;
+        vector<char> buf;
+        const char* p;
+        RID rids[64];
+        unsigned pos, from;
+        int n;
+
+        // a has containers 0 and 1 dense enough to be bits, b 0 and 2,
+        // so that every pair of forms meets.  the others are arrays
+        srand(21);
+        for (i = 0; i < 30000; i++) {
+            pos = (i < 20000) ? rand() % 131072 : rand() % (1 << 22);
+            a.add(pos);
+            sa.insert(pos);
+            if (i < 8000) pos = rand() % 65536;
+            else if (i < 16000) pos = 131072 + rand() % 65536;
+            else pos = rand() % (1 << 22);
+            b.add(pos);
+            sb.insert(pos);
+        }
+        for (i = 0; i < 5000; i++) {
+            pos = rand() % 140000;
+            if (a.remove(pos) != (sa.erase(pos) == 1)) agree = false;
+        }
+
+        c = a;
+        c.intersect(b);
+        sc.clear();
+        set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(),
+                         inserter(sc, sc.begin()));
+        for (int op = 0; op < 3 && agree; op++) {
+            if (op == 1) {
+                c = a;
+                c.unite(b);
+                sc = sa;
+                sc.insert(sb.begin(), sb.end());
+            }
+            if (op == 2) {
+                c = a;
+                c.subtract(b);
+                sc.clear();
+                set_difference(sa.begin(), sa.end(), sb.begin(), sb.end(),
+                               inserter(sc, sc.begin()));
+            }
+            // through save and load, a batch of RIDs at a time
+            buf.clear();
+            c.save(buf);
+            p = buf.data();
+            c.clear();
+            c.load(p);
+            set<unsigned>::iterator it = sc.begin();
+            from = 0;
+            while ((n = c.nextRids(from, rids, 64)) > 0)
+                for (j = 0; j < n; j++, ++it)
+                    if (it == sc.end() || ridToPos(rids[j]) != *it)
+                        agree = false;
+            if (it != sc.end() || c.count() != sc.size() ||
+                p != buf.data() + buf.size()) agree = false;
+            if (!agree)
+                cout << "err0r. bitmap operation " << op << " is wrong" << endl;
+        }
+
+        const char* colors[3] = { "red", "green", "blue" };
+        string intName, strName;
+        int two = 2, seven = 7;
+        char red[64], blue[64];
+        memset(red, 0, sizeof(red));
+        memset(blue, 0, sizeof(blue));
+        strcpy(red, "red");
+        strcpy(blue, "blue");
+
+        createHeapFile("dummy.21");
+        iScan = new InsertFileScan("dummy.21", status);
+        for (i = 0; i < 3000; i++) {
+            memset(&rec1, 0, sizeof(rec1));
+            rec1.i = i % 5;
+            rec1.f = i;
+            strcpy(rec1.s, colors[i % 3]);
+            dbrec1.data = &rec1;
+            dbrec1.length = sizeof(RECORD);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+        }
+        delete iScan;
+
+        BitmapIndex* ix = new BitmapIndex("dummy.21", 0, sizeof(int), INTEGER,
+                                          intName, status);
+        if (status != OK) error.print(status);
+        BitmapIndex* sx = new BitmapIndex("dummy.21", 2 * sizeof(int), 64,
+                                          STRING, strName, status);
+        if (status != OK) error.print(status);
+        if (ix->getEntryCnt() != 3000 || ix->getValueCnt() != 5 ||
+            sx->getValueCnt() != 3) {
+            cout << "err0r. bitmap index built with " << ix->getEntryCnt()
+                 << " entries" << endl;
+            agree = false;
+        }
+
+        ScanCond iEq = { 0, sizeof(int), INTEGER, EQ, (char*) &two, 0, 0 };
+        ScanCond sEq = { 2 * sizeof(int), 64, STRING, EQ, red, 0, 1 };
+        for (int pass = 0; pass < 2 && agree; pass++) {
+            // i = 2 AND s = red
+            ScanCond conds[2] = { iEq, sEq };
+            ix->select((char*) &two, EQ, a);
+            sx->select(red, EQ, b);
+            agree = agree && bitmapAgrees(a, "dummy.21", conds, 1);
+            a.intersect(b);
+            agree = agree && bitmapAgrees(a, "dummy.21", conds, 2);
+
+            // i >= 2 AND (s = red OR s = blue)
+            conds[0].op = GTE;
+            ix->select((char*) &two, GTE, a);
+            sx->select(blue, EQ, c);
+            b.unite(c);
+            a.intersect(b);
+            ScanCond three[3] = { conds[0], sEq, sEq };
+            three[2].filter = blue;
+            agree = agree && bitmapAgrees(a, "dummy.21", three, 3);
+
+            // NOT i = 2, and an absent value
+            ix->select((char*) &two, EQ, a);
+            ix->complement(a);
+            conds[0].op = NE;
+            agree = agree && bitmapAgrees(a, "dummy.21", conds, 1);
+            ix->select((char*) &seven, EQ, a);
+            if (a.count() != 0) agree = false;
+            if (!agree) {
+                cout << "err0r. bitmap index and scan disagree in pass " << pass
+                     << endl;
+                break;
+            }
+            if (pass == 1) break;
+
+            iScan = new InsertFileScan("dummy.21", status);
+            ix->attachTo(*iScan);
+            sx->attachTo(*iScan);
+            for (i = 0; i < 500; i++) {
+                memset(&rec1, 0, sizeof(rec1));
+                rec1.i = i % 4;
+                rec1.f = i;
+                strcpy(rec1.s, colors[i % 2]);
+                dbrec1.data = &rec1;
+                dbrec1.length = sizeof(RECORD);
+                status = iScan->insertRecord(dbrec1, newRid);
+                if (status != OK) error.print(status);
+            }
+            delete iScan;
+
+            float fmax = 1000;
+            scan1 = new HeapFileScan("dummy.21", status);
+            ix->attachTo(*scan1);
+            sx->attachTo(*scan1);
+            scan1->startScan(sizeof(int), sizeof(float), FLOAT, (char*) &fmax, LT);
+            status = scan1->deleteWhere(deleted);
+            if (status != OK) error.print(status);
+            delete scan1;
+
+            // and the INTEGER index read back from its file
+            n = ix->getEntryCnt();
+            delete ix;
+            ix = new BitmapIndex("dummy.21", 0, sizeof(int), INTEGER, intName,
+                                 status);
+            if (status != OK) error.print(status);
+            if (ix->getEntryCnt() != n || n != 3000 + 500 - 1000 - 500) {
+                cout << "err0r. reopened bitmap index has " << ix->getEntryCnt()
+                     << " entries" << endl;
+                agree = false;
+            }
+        }
+        delete ix;
+        delete sx;
+        db.destroyFile(intName);
+        db.destroyFile(strName);
+        destroyHeapFile("dummy.21");
+        if (agree) cout << "passed bitmap index test" << endl;
+    }
+
+    // zone maps on an INTEGER and a FLOAT attribute of records inserted
+    // in order: range scans must return what scans without them do and
+    // pass over most pages, and stay right as records are inserted out
+    // of order, updated, moved, deleted and bulk loaded
+    {
+        bool agree = true;
+        ZoneAttr zattrs[2] = { { 0, INTEGER }, { sizeof(int), FLOAT } };
+        ZoneAttr bad = { 2 * sizeof(int), STRING };
+        int lohi[2] = { 1000, 1099 }, ten = 10, k;
+        int inList[3] = { 5, 2500, 3999 };
+        float fmin = 1990, fhigh = 1995;
+        int accesses, allAccesses, updated;
+        RID firstRid;
+        char z[64];
+        memset(z, 0, sizeof(z));
+        strcpy(z, "z");
+
+        createHeapFile("dummy.22");
+        iScan = new InsertFileScan("dummy.22", status);
+        for (i = 0; i < 4000; i++) {
+            memset(&rec1, 0, sizeof(rec1));
+            rec1.i = i;
+            rec1.f = i * 0.5;
+            strcpy(rec1.s, "z");
+            dbrec1.data = &rec1;
+            dbrec1.length = sizeof(RECORD);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+            if (i == 0) firstRid = newRid;
+        }
+        if (iScan->declareZones(&bad, 1) != BADINDEXPARM) {
+            cout << "err0r. zones declared on a STRING attribute" << endl;
+            agree = false;
+        }
+        status = iScan->declareZones(zattrs, 2);
+        if (status != OK) error.print(status);
+        delete iScan;
+
+        ScanCond between = { 0, sizeof(int), INTEGER, BETWEEN,
+                             (char*) lohi, 0, 0 };
+        ScanCond conds[7][2] = {
+            { between },
+            { { 0, sizeof(int), INTEGER, LT, (char*) &ten, 0, 0 } },
+            { { sizeof(int), sizeof(float), FLOAT, GTE, (char*) &fmin, 0, 0 } },
+            { { 0, sizeof(int), INTEGER, IN, (char*) inList, 3, 0 } },
+            { { 0, sizeof(int), INTEGER, LT, (char*) &ten, 0, 0 },
+              { sizeof(int), sizeof(float), FLOAT, GT, (char*) &fhigh, 0, 0 } },
+            { between, { 2 * sizeof(int), 64, STRING, EQ, z, 0, 1 } },
+            { { 0, sizeof(int), INTEGER, NE, (char*) &ten, 0, 0 } }
+        };
+        const int condCnts[7] = { 1, 1, 1, 1, 2, 2, 1 };
+
+        for (int step = 0; step < 7 && agree; step++) {
+            for (j = 0; j < 7 && agree; j++) {
+                if (!zonesAgree("dummy.22", conds[j], condCnts[j], zattrs, 2,
+                                accesses)) {
+                    cout << "err0r. zone maps lose records for scan " << j
+                         << " at step " << step << endl;
+                    agree = false;
+                }
+                if (j == 0) k = accesses;
+                if (j == 6) allAccesses = accesses;
+            }
+            // the range takes up a few pages of hundreds, after the
+            // bulk load as well
+            if (agree && (step == 0 || step == 6) && k * 10 > allAccesses) {
+                cout << "err0r. zoned scan made " << k << " accesses, "
+                     << allAccesses << " without zones" << endl;
+                agree = false;
+            }
+
+            // fetching a record from elsewhere moves the scan there, and
+            // the pages after it are still passed over
+            if (agree && step == 0) {
+                scan1 = new HeapFileScan("dummy.22", status);
+                scan1->startScan(0, sizeof(int), INTEGER, (char*) lohi,
+                                 BETWEEN);
+                scan1->scanNext(newRid);
+                scan1->HeapFile::getRecord(firstRid, dbrec2);
+                bufMgr->clearBufStats();
+                for (j = 0; scan1->scanNext(newRid) == OK; j++) ;
+                accesses = bufMgr->getBufStats().accesses;
+                delete scan1;
+                if (j != 100 || accesses * 10 > allAccesses) {
+                    cout << "err0r. scan moved by getRecord returned " << j
+                         << " records with " << accesses << " accesses"
+                         << endl;
+                    agree = false;
+                }
+            }
+
+            if (step == 0) {
+                // out of order, a large record, and a NaN
+                iScan = new InsertFileScan("dummy.22", status);
+                char big[MAXINLINERECLEN + 500];
+                memset(big, 0, sizeof(big));
+                rec1.i = 1050;
+                rec1.f = 1999;
+                memcpy(big, &rec1, sizeof(RECORD));
+                dbrec1.data = big;
+                dbrec1.length = sizeof(big);
+                iScan->insertRecord(dbrec1, newRid);
+                rec1.i = 1051;
+                rec1.f = NAN;
+                dbrec1.data = &rec1;
+                dbrec1.length = sizeof(RECORD);
+                iScan->insertRecord(dbrec1, newRid);
+                delete iScan;
+            }
+            else if (step == 1) {
+                // in place, and grown so that it has to move
+                scan1 = new HeapFileScan("dummy.22", status);
+                scan1->startScan(0, sizeof(int), INTEGER, (char*) &ten, LT);
+                char big[sizeof(RECORD) + 300];
+                while (scan1->scanNext(newRid) == OK) {
+                    scan1->getRecord(dbrec2);
+                    memcpy(&rec2, dbrec2.data, sizeof(RECORD));
+                    rec2.i += 1060;
+                    memset(big, 0, sizeof(big));
+                    memcpy(big, &rec2, sizeof(RECORD));
+                    dbrec1.data = big;
+                    dbrec1.length = (rec2.i % 2) ? sizeof(big) : sizeof(RECORD);
+                    status = scan1->updateRecord(dbrec1);
+                    if (status != OK) error.print(status);
+                }
+                delete scan1;
+            }
+            else if (step == 2) {
+                float f = 1998;
+                int range[2] = { 500, 509 };
+                ScanSet set = { sizeof(int), sizeof(float), (char*) &f };
+                scan1 = new HeapFileScan("dummy.22", status);
+                scan1->startScan(0, sizeof(int), INTEGER, (char*) range,
+                                 BETWEEN);
+                status = scan1->updateWhere(&set, 1, updated);
+                if (status != OK) error.print(status);
+                delete scan1;
+            }
+            else if (step == 3) {
+                scan1 = new HeapFileScan("dummy.22", status);
+                scan1->startScan(0, sizeof(int), INTEGER, (char*) lohi,
+                                 BETWEEN);
+                status = scan1->deleteWhere(deleted);
+                if (status != OK) error.print(status);
+                delete scan1;
+            }
+            else if (step == 4) {
+                // from a page that had none left
+                iScan = new InsertFileScan("dummy.22", status);
+                rec1.i = 1070;
+                rec1.f = 0;
+                dbrec1.data = &rec1;
+                dbrec1.length = sizeof(RECORD);
+                for (i = 0; i < 20; i++) iScan->insertRecord(dbrec1, newRid);
+                delete iScan;
+            }
+            else if (step == 5) {
+                // the loader keeps the zones
+                HeapFileLoader* loader = new HeapFileLoader("dummy.22", status);
+                if (status != OK) error.print(status);
+                rec1.i = 1080;
+                for (i = 0; i < 20; i++) loader->insertRecord(dbrec1, newRid);
+                delete loader;
+            }
+        }
+        destroyHeapFile("dummy.22");
+        if (agree) cout << "passed zone map test" << endl;
+    }
+
+    // external sort: on two keys with runs and merge passes, on a FLOAT
+    // in memory, and written to a heap file, with short, large and NaN
+    // records, against stable_sort of the records in scan order
+    {
+        bool agree = true;
+        SortKey byIntString[2] = { { 0, sizeof(int), INTEGER },
+                                   { 2 * sizeof(int), 64, STRING } };
+        SortKey byFloat = { sizeof(int), sizeof(float), FLOAT };
+        SortKey badKey = { 0, 2, INTEGER };
+        vector<string> input, expected;
+        char big[MAXINLINERECLEN + 500];
+        SortedFile* sf;
+
+        createHeapFile("dummy.23");
+        iScan = new InsertFileScan("dummy.23", status);
+        srand(23);
+        for (i = 0; i < 3000; i++) {
+            memset(&rec1, 0, sizeof(rec1));
+            rec1.i = rand() % 100;
+            rec1.f = (i % 97 == 0) ? NAN : rand() % 1000;
+            sprintf(rec1.s, "%d", rand() % 50);
+            dbrec1.data = &rec1;
+            dbrec1.length = sizeof(RECORD);
+            if (i % 501 == 0) {
+                memset(big, 'x', sizeof(big));
+                memcpy(big, &rec1, sizeof(RECORD));
+                dbrec1.data = big;
+                dbrec1.length = sizeof(big);
+            }
+            else if (i % 301 == 0) dbrec1.length = sizeof(int) + sizeof(float);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+        }
+        delete iScan;
+        scan1 = new HeapFileScan("dummy.23", status);
+        scan1->startScan(NULL, 0);
+        while (scan1->scanNext(newRid) == OK) {
+            scan1->getRecord(dbrec2);
+            input.push_back(string((char*) dbrec2.data, dbrec2.length));
+        }
+        delete scan1;
+
+        // about 60 runs of 4 pages, so one merge pass
+        expected = input;
+        stable_sort(expected.begin(), expected.end(), ByIntString());
+        sf = new SortedFile("dummy.23", byIntString, 2, 4, 3, status);
+        if (status != OK) error.print(status);
+        if (sf->getRunCnt() <= MAXSORTFANIN || !sortAgrees(sf, expected)) {
+            cout << "err0r. sort with " << sf->getRunCnt()
+                 << " runs is out of order" << endl;
+            agree = false;
+        }
+        delete sf;
+
+        expected = input;
+        stable_sort(expected.begin(), expected.end(), ByFloat());
+        sf = new SortedFile("dummy.23", &byFloat, 1, 1000, 2, status);
+        if (status != OK) error.print(status);
+        if (sf->getRunCnt() != 0 || !sortAgrees(sf, expected)) {
+            cout << "err0r. in memory sort is out of order" << endl;
+            agree = false;
+        }
+        delete sf;
+
+        // a few runs, straight to a file
+        sf = new SortedFile("dummy.23", &byFloat, 1, 40, 1, status);
+        if (status != OK) error.print(status);
+        status = sf->writeTo("dummy.23s");
+        if (status != OK) error.print(status);
+        delete sf;
+        scan1 = new HeapFileScan("dummy.23s", status);
+        scan1->startScan(NULL, 0);
+        for (j = 0; scan1->scanNext(newRid) == OK; j++) {
+            scan1->getRecord(dbrec2);
+            if (j >= (int) expected.size() ||
+                string((char*) dbrec2.data, dbrec2.length) != expected[j])
+                break;
+        }
+        if (j != (int) expected.size() || scan1->getRecCnt() != j) {
+            cout << "err0r. sorted file differs at record " << j << endl;
+            agree = false;
+        }
+        delete scan1;
+
+        sf = new SortedFile("dummy.23", &badKey, 1, 40, 1, status);
+        if (status != BADSORTPARM) agree = false;
+        delete sf;
+        sf = new SortedFile("dummy.23", byIntString, 0, 40, 1, status);
+        if (status != BADSORTPARM) agree = false;
+        delete sf;
+        sf = new SortedFile("dummy.23", &byFloat, 1, 2, 1, status);
+        if (status != INSUFMEM) agree = false;
+        delete sf;
+        if (!agree) cout << "err0r. bad sort parameters accepted" << endl;
+
+        destroyHeapFile("dummy.23s");
+        destroyHeapFile("dummy.23");
+        if (agree) cout << "passed external sort test" << endl;
+    }
+
+    // hash join on each type, in memory and in partitions, with one
+    // value common enough that its partition is joined in pieces, and
+    // with short and NaN records, against nested loops
+    {
+        bool agree = true;
+        ScanColumn byInt = { 0, sizeof(int), INTEGER };
+        ScanColumn byFloat = { sizeof(int), sizeof(float), FLOAT };
+        ScanColumn byString = { 2 * sizeof(int), 64, STRING };
+        ScanColumn badAttr = { 0, sizeof(int), FLOAT };
+        vector<string> build, probe, expected;
+        const char* names[2] = { "dummy.24", "dummy.24p" };
+        HashJoin* hj;
+        int k;
+
+        srand(24);
+        for (j = 0; j < 2; j++) {
+            createHeapFile(names[j]);
+            iScan = new InsertFileScan(names[j], status);
+            for (i = 0; i < 1500 + 500 * j; i++) {
+                memset(&rec1, 0, sizeof(rec1));
+                rec1.i = (i % 4 == 0) ? 7 : rand() % 300;
+                rec1.f = (i % 89 == 0) ? NAN : rand() % 200;
+                if (i % 101 == 0) rec1.f = j ? -0.0 : 0.0;
+                sprintf(rec1.s, "%d", rand() % 500);
+                dbrec1.data = &rec1;
+                dbrec1.length = sizeof(RECORD);
+                if (i % 211 == 0) dbrec1.length = sizeof(int);
+                status = iScan->insertRecord(dbrec1, newRid);
+                if (status != OK) error.print(status);
+            }
+            delete iScan;
+            scan1 = new HeapFileScan(names[j], status);
+            scan1->startScan(NULL, 0);
+            while (scan1->scanNext(newRid) == OK) {
+                scan1->getRecord(dbrec2);
+                (j ? probe : build).push_back(string((char*) dbrec2.data,
+                                                     dbrec2.length));
+            }
+            delete scan1;
+        }
+
+        ScanColumn* attrs[3] = { &byInt, &byFloat, &byString };
+        for (j = 0; j < 3; j++) {
+            joinPairs(build, probe, attrs[j]->offset, attrs[j]->length,
+                      attrs[j]->type, expected);
+            // in memory, then in partitions, the one of 7 in pieces
+            for (k = 0; k < 2; k++) {
+                hj = new HashJoin("dummy.24", *attrs[j], "dummy.24p",
+                                  *attrs[j], k ? 4 : 1000, status);
+                if (status != OK) error.print(status);
+                if ((hj->getPartCnt() == 0) != (k == 0) ||
+                    !joinAgrees(hj, expected)) {
+                    cout << "err0r. join on attribute " << j << " with "
+                         << hj->getPartCnt() << " partitions is wrong"
+                         << endl;
+                    agree = false;
+                }
+                delete hj;
+            }
+        }
+
+        // joined records, to a heap file
+        joinPairs(build, probe, 0, sizeof(int), INTEGER, expected);
+        hj = new HashJoin("dummy.24", byInt, "dummy.24p", byInt, 8, status);
+        if (status != OK) error.print(status);
+        status = hj->writeTo("dummy.24j");
+        if (status != OK) error.print(status);
+        delete hj;
+        vector<string> got;
+        scan1 = new HeapFileScan("dummy.24j", status);
+        scan1->startScan(NULL, 0);
+        while (scan1->scanNext(newRid) == OK) {
+            scan1->getRecord(dbrec2);
+            got.push_back(string((char*) dbrec2.data, dbrec2.length));
+        }
+        delete scan1;
+        sort(got.begin(), got.end());
+        if (got != expected) {
+            cout << "err0r. joined file has " << got.size() << " records, not "
+                 << expected.size() << endl;
+            agree = false;
+        }
+
+        hj = new HashJoin("dummy.24", byInt, "dummy.24p", badAttr, 8, status);
+        if (status != BADSCANPARM) agree = false;
+        delete hj;
+        hj = new HashJoin("dummy.24", byInt, "dummy.24p", byInt, 1, status);
+        if (status != INSUFMEM) agree = false;
+        delete hj;
+        if (!agree) cout << "err0r. bad join parameters accepted" << endl;
+
+        destroyHeapFile("dummy.24j");
+        destroyHeapFile("dummy.24p");
+        destroyHeapFile("dummy.24");
+        if (agree) cout << "passed hash join test" << endl;
+    }
+
+    // hash aggregation on one and two attributes and on none with a
+    // filter, on one thread and several, with the groups fitting and
+    // with tables so small that partitions are split again, with short
+    // and NaN records, against a map of the records
+    {
+        bool agree = true;
+        ScanColumn byInt = { 0, sizeof(int), INTEGER };
+        ScanColumn byStringInt[2] = { { 2 * sizeof(int), 64, STRING },
+                                      { 0, sizeof(int), INTEGER } };
+        ScanColumn badCol = { 0, 2, INTEGER };
+        ScanColumn bigCol = { 0, 2000, STRING };
+        AggSpec aggs[5] = { { COUNT, 0, INTEGER },
+                            { SUM, 0, INTEGER },
+                            { MIN, sizeof(int), FLOAT },
+                            { MAX, sizeof(int), FLOAT },
+                            { AVG, sizeof(int), FLOAT } };
+        AggSpec badAgg = { SUM, 8, STRING };
+        vector<string> input, expected;
+        HashAggregate* ha;
+        int bound = 25;
+
+        createHeapFile("dummy.25");
+        iScan = new InsertFileScan("dummy.25", status);
+        srand(25);
+        for (i = 0; i < 3000; i++) {
+            memset(&rec1, 0, sizeof(rec1));
+            rec1.i = rand() % 50 - 5;
+            rec1.f = (i % 83 == 0) ? NAN : rand() % 1000 - 100;
+            if (i % 97 == 0) rec1.f = -0.0;
+            sprintf(rec1.s, "%d", rand() % 7);
+            dbrec1.data = &rec1;
+            dbrec1.length = sizeof(RECORD);
+            if (i % 131 == 0) dbrec1.length = sizeof(int);
+            status = iScan->insertRecord(dbrec1, newRid);
+            if (status != OK) error.print(status);
+        }
+        delete iScan;
+        scan1 = new HeapFileScan("dummy.25", status);
+        scan1->startScan(NULL, 0);
+        while (scan1->scanNext(newRid) == OK) {
+            scan1->getRecord(dbrec2);
+            input.push_back(string((char*) dbrec2.data, dbrec2.length));
+        }
+        delete scan1;
+
+        // {keys, memPages, threads, partitions expected}
+        int runs[6][4] = { { 1, 100, 1, 0 }, { 1, 100, 3, 0 },
+                           { 2, 1000, 2, 0 }, { 2, 1, 1, 1 },
+                           { 2, 3, 3, 1 }, { 0, 1, 2, 0 } };
+        for (j = 0; j < 6; j++) {
+            int keys = runs[j][0];
+            aggRef(input, keys, keys ? INT_MAX : bound, expected);
+            scan1 = new HeapFileScan("dummy.25", status);
+            if (keys) scan1->startScan(NULL, 0);
+            else scan1->startScan(0, sizeof(int), INTEGER, (char*) &bound, LT);
+            ha = new HashAggregate(scan1, (keys == 2) ? byStringInt : &byInt,
+                                   keys, aggs, 5, runs[j][1], runs[j][2],
+                                   status);
+            if (status != OK) error.print(status);
+            if ((ha->getPartCnt() > 0) != (runs[j][3] > 0) ||
+                !aggAgrees(ha, expected)) {
+                cout << "err0r. aggregation " << j << " with "
+                     << ha->getPartCnt() << " partitions is wrong" << endl;
+                agree = false;
+            }
+            delete ha;
+            delete scan1;
+        }
+
+        // to a heap file
+        aggRef(input, 1, INT_MAX, expected);
+        scan1 = new HeapFileScan("dummy.25", status);
+        scan1->startScan(NULL, 0);
+        ha = new HashAggregate(scan1, &byInt, 1, aggs, 5, 1, 1, status);
+        if (status != OK) error.print(status);
+        status = ha->writeTo("dummy.25g");
+        if (status != OK) error.print(status);
+        delete ha;
+        delete scan1;
+        vector<string> got;
+        scan1 = new HeapFileScan("dummy.25g", status);
+        scan1->startScan(NULL, 0);
+        while (scan1->scanNext(newRid) == OK) {
+            scan1->getRecord(dbrec2);
+            got.push_back(string((char*) dbrec2.data, dbrec2.length));
+        }
+        delete scan1;
+        sort(got.begin(), got.end());
+        if (got != expected) {
+            cout << "err0r. aggregated file has " << got.size()
+                 << " groups, not " << expected.size() << endl;
+            agree = false;
+        }
+
+        scan1 = new HeapFileScan("dummy.25", status);
+        scan1->startScan(NULL, 0);
+        ha = new HashAggregate(scan1, &badCol, 1, aggs, 5, 10, 1, status);
+        if (status != BADSCANPARM) agree = false;
+        delete ha;
+        ha = new HashAggregate(scan1, &byInt, 1, &badAgg, 1, 10, 1, status);
+        if (status != BADSCANPARM) agree = false;
+        delete ha;
+        ha = new HashAggregate(scan1, &byInt, 1, aggs, 0, 10, 1, status);
+        if (status != BADSCANPARM) agree = false;
+        delete ha;
+        ha = new HashAggregate(scan1, &bigCol, 1, aggs, 5, 1, 1, status);
+        if (status != INSUFMEM) agree = false;
+        delete ha;
+        delete scan1;
+        if (!agree) cout << "err0r. bad aggregation parameters accepted"
+                         << endl;
+
+        destroyHeapFile("dummy.25g");
+        destroyHeapFile("dummy.25");
+        if (agree) cout << "passed hash aggregation test" << endl;
+    }
+
+    // parallel import of a CSV file and of the same rows in binary form
+    {
+        ImportAttr attrs[3] = { { INTEGER, 0 }, { FLOAT, 0 }, { STRING, 12 } };
+        const int recLen = sizeof(int) + sizeof(float) + 12;
+        FILE* csv = fopen("import.csv", "w");
+        FILE* bin = fopen("import.bin", "w");
+        for(i = 0; i < num; i++) {
+            char row[recLen];
+            float f = i / 2.0;
+            memset(row, 0, recLen);
+            memcpy(row, &i, sizeof(int));
+            memcpy(row + sizeof(int), &f, sizeof(float));
+            sprintf(row + 2 * sizeof(int), "row%d", i);
+            fprintf(csv, "%d,%.1f,%s\n", i, f, row + 2 * sizeof(int));
+            fwrite(row, recLen, 1, bin);
+        }
+        fclose(csv);
+        fclose(bin);
+
+        for(int pass = 0; pass < 2; pass++) {
+            int rowCnt;
+            createHeapFile("dummy.08");
+            cout << endl << "import " << num << " rows into dummy.08 from "
+                 << (pass ? "import.bin" : "import.csv") << endl;
+            status = importFile(pass ? "import.bin" : "import.csv", "dummy.08",
+                                pass ? BINARY : CSV, attrs, 3, 4, rowCnt);
+            if (status != OK) error.print(status);
+
+            // threads interleave their pages, so check every row turns
+            // up exactly once rather than the order
+            char* seen = new char[num];
+            memset(seen, 0, num);
+            scan1 = new HeapFileScan("dummy.08", status);
+            if (status != OK) error.print(status);
+            scan1->startScan(0, 0, STRING, NULL, EQ);
+            j = 0;
+            while ((status = scan1->scanNext(rec2Rid)) == OK)
+            {
+                char expect[12];
+                float f;
+                status = scan1->getRecord(dbrec2);
+                if (status != OK) break;
+                memcpy(&i, dbrec2.data, sizeof(int));
+                memcpy(&f, (char*)dbrec2.data + sizeof(int), sizeof(float));
+                sprintf(expect, "row%d", i);
+                if (dbrec2.length != recLen || i < 0 || i >= num || seen[i] ||
+                    f != i / 2.0 || strcmp((char*)dbrec2.data + 2 * sizeof(int), expect))
+                    cout << "err0r. bad imported row " << j << endl;
+                else seen[i] = 1;
+                j++;
+            }
+            if (status != FILEEOF) error.print(status);
+            if (j != num || rowCnt != num || scan1->getRecCnt() != num)
+                cout << "Err0r.   imported " << rowCnt << " rows, scan returned "
+                     << j << endl;
+            delete scan1;
+            delete [] seen;
+            destroyHeapFile("dummy.08");
+        }
+
+        // a field that is not a number, or is out of the range of its type
+        const char* badRows[3] = { "1,1.0,one\n2,two,two\n",
+                                   "1,1.0,one\n3000000000,1.5,big\n",
+                                   "1,1.0,one\n3,1e99,huge\n" };
+        bool rejected = true;
+        for (int b = 0; b < 3; b++) {
+            csv = fopen("import.csv", "w");
+            fprintf(csv, "%s", badRows[b]);
+            fclose(csv);
+            createHeapFile("dummy.08");
+            int rowCnt;
+            status = importFile("import.csv", "dummy.08", CSV, attrs, 3, 1,
+                                rowCnt);
+            if (status != BADIMPORTFMT) {
+                cout << "err0r. malformed row " << b << " was imported" << endl;
+                rejected = false;
+            }
+            destroyHeapFile("dummy.08");
+        }
+        if (rejected) cout << "passed parallel import test" << endl;
+        unlink("import.csv");
+        unlink("import.bin");
+    }
     delete bufMgr;
 
     cout << endl << "Done testing." << endl;